@@ -0,0 +1,327 @@
+#define GL_GLEXT_PROTOTYPES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <bench.h>
+#include <wrap-egl.h>
+
+/* Fixed sizes and timings keep the numbers comparable between drivers. Every
+ * test is timed in batches that end with glFinish; the batch grows until it
+ * takes BENCH_RUN_SECONDS, and the median of BENCH_RUNS batches is kept. */
+#define BENCH_WIDTH             512
+#define BENCH_HEIGHT            512
+#define BENCH_RUNS              5
+#define BENCH_RUN_SECONDS       0.1
+#define TEXTURE_SIZE            1024
+#define SETUP_TRIANGLES         65536
+#define FILL_QUADS              8
+#define DRAW_CALLS              1000
+
+/* Plain GLSL 1.10 / GLSL ES 1.00, so the same source builds on both APIs. */
+static const char* vertex_source =
+    "attribute vec2 position;\n"
+    "void main() { gl_Position = vec4(position, 0.0, 1.0); }\n";
+
+static const char* fragment_format =
+    "#ifdef GL_ES\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "uniform vec4 color;\n"
+    "void main() { gl_FragColor = color * %d.0 / 65536.0; }\n";
+
+static GLuint program;
+static GLuint quad_buffer;
+static GLuint setup_buffer;
+static GLuint texture;
+static unsigned char* pixels;
+static int compile_serial;
+
+typedef double (*bench_step)(void);
+
+static double
+now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int
+compare_doubles(const void* a, const void* b)
+{
+    double x = *(const double*) a, y = *(const double*) b;
+    return x < y ? -1 : x > y;
+}
+
+/* Work done per second. */
+static double
+measure(bench_step step)
+{
+    double rates[BENCH_RUNS];
+    double work, start, elapsed;
+    long batch = 1, i;
+    int run;
+
+    step();
+    glFinish();
+    for (;;)
+    {
+        work = 0;
+        start = now_seconds();
+        for (i = 0; i < batch; i++)
+            work += step();
+        glFinish();
+        elapsed = now_seconds() - start;
+        if (elapsed >= BENCH_RUN_SECONDS)
+            break;
+        batch *= 2;
+    }
+
+    rates[0] = work / elapsed;
+    for (run = 1; run < BENCH_RUNS; run++)
+    {
+        work = 0;
+        start = now_seconds();
+        for (i = 0; i < batch; i++)
+            work += step();
+        glFinish();
+        rates[run] = work / (now_seconds() - start);
+    }
+    qsort(rates, BENCH_RUNS, sizeof(rates[0]), compare_doubles);
+    return rates[BENCH_RUNS / 2];
+}
+
+static GLuint
+build_program(int serial)
+{
+    char fragment_source[256];
+    const char* source = fragment_source;
+    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
+    GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
+    GLuint prog = glCreateProgram();
+    GLint status = GL_FALSE;
+
+    snprintf(fragment_source, sizeof(fragment_source), fragment_format, serial);
+    glShaderSource(vs, 1, &vertex_source, NULL);
+    glCompileShader(vs);
+    glShaderSource(fs, 1, &source, NULL);
+    glCompileShader(fs);
+    glAttachShader(prog, vs);
+    glAttachShader(prog, fs);
+    glBindAttribLocation(prog, 0, "position");
+    glLinkProgram(prog);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    /* asking for the status waits for the compiler */
+    glGetProgramiv(prog, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        fprintf(stderr, "bench program link failure!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return prog;
+}
+
+static void
+use_buffer(GLuint buffer)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(0);
+}
+
+/* Full-screen additive quads, pixels per second. Blending keeps drivers from
+ * dropping quads that an opaque one covers later on. */
+static double
+step_fill()
+{
+    int i;
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    for (i = 0; i < FILL_QUADS; i++)
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+    glDisable(GL_BLEND);
+    return (double) FILL_QUADS * BENCH_WIDTH * BENCH_HEIGHT;
+}
+
+/* Triangles smaller than a pixel, so that setup rather than fill dominates. */
+static double
+step_setup()
+{
+    glDrawArrays(GL_TRIANGLES, 0, SETUP_TRIANGLES * 3);
+    return SETUP_TRIANGLES;
+}
+
+static double
+step_upload()
+{
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, TEXTURE_SIZE, TEXTURE_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    return TEXTURE_SIZE * TEXTURE_SIZE * 4.0;
+}
+
+static double
+step_readback()
+{
+    glReadPixels(0, 0, BENCH_WIDTH, BENCH_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    return BENCH_WIDTH * BENCH_HEIGHT * 4.0;
+}
+
+/* Single-triangle draws that touch no pixel: what one call costs. */
+static double
+step_draw_calls()
+{
+    int i;
+    for (i = 0; i < DRAW_CALLS; i++)
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    return DRAW_CALLS;
+}
+
+/* Every program differs in a constant, and the constants start at a per-run
+ * seed, so neither the in-memory nor the on-disk shader cache of the driver
+ * has seen the source before. Draws once because some drivers only finish
+ * compiling on first use. */
+static double
+step_compile()
+{
+    GLuint prog = build_program(compile_serial++);
+    glUseProgram(prog);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glFinish();
+    glUseProgram(program);
+    glDeleteProgram(prog);
+    return 1;
+}
+
+static void
+init_resources()
+{
+    static const GLfloat quad[] =
+    {
+        -1, -1,  1, -1,  1,  1,
+        -1, -1,  1,  1, -1,  1,
+    };
+    GLfloat* setup = malloc(SETUP_TRIANGLES * 6 * sizeof(GLfloat));
+    GLfloat cell = 2.0f / 256;
+    int i;
+
+    program = build_program(0);
+    glUseProgram(program);
+    glUniform4f(glGetUniformLocation(program, "color"), 1, 0.5f, 0.25f, 1);
+
+    glGenBuffers(1, &quad_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, quad_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+
+    /* a 256 x 256 grid of triangles a quarter pixel across */
+    for (i = 0; i < SETUP_TRIANGLES; i++)
+    {
+        GLfloat x = -1 + (i % 256) * cell;
+        GLfloat y = -1 + (i / 256) * cell;
+        GLfloat size = 0.25f * 2.0f / BENCH_WIDTH;
+        GLfloat* v = setup + i * 6;
+        v[0] = x;        v[1] = y;
+        v[2] = x + size; v[3] = y;
+        v[4] = x;        v[5] = y + size;
+    }
+    glGenBuffers(1, &setup_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, setup_buffer);
+    glBufferData(GL_ARRAY_BUFFER, SETUP_TRIANGLES * 6 * sizeof(GLfloat), setup, GL_STATIC_DRAW);
+    free(setup);
+
+    pixels = malloc(TEXTURE_SIZE * TEXTURE_SIZE * 4);
+    memset(pixels, 0x80, TEXTURE_SIZE * TEXTURE_SIZE * 4);
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, TEXTURE_SIZE, TEXTURE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glViewport(0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+}
+
+static void
+print_string(FILE* out, const char* name, const GLubyte* value)
+{
+    const char* c;
+    fprintf(out, "    \"%s\": \"", name);
+    for (c = (const char*) value; c && *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            fputc('\\', out);
+        fputc(*c, out);
+    }
+    fprintf(out, "\",\n");
+}
+
+static void
+print_result(FILE* out, const char* name, double value, const char* unit, int last)
+{
+    fprintf(out, "        \"%s\": { \"value\": %.3f, \"unit\": \"%s\" }%s\n",
+            name, value, unit, last ? "" : ",");
+}
+
+int
+glinfo_bench(const char* out_path)
+{
+    EGLDisplay dpy = w_eglOpenDisplay();
+    EGLSurface surface;
+    int gles = 0;
+    EGLContext ctx = w_eglCreatePbufferContext(dpy, BENCH_WIDTH, BENCH_HEIGHT, &surface, &gles);
+    double fill, setup, upload, readback, draws, compile;
+
+    /* below 2^23 so that every serial of this run stays exact as a float */
+    compile_serial = 1 + (int) (((unsigned) time(NULL) * 2654435761u ^ (unsigned) getpid()) % (1u << 23));
+    init_resources();
+
+    use_buffer(quad_buffer);
+    fill = measure(step_fill);
+    use_buffer(setup_buffer);
+    setup = measure(step_setup);
+    upload = measure(step_upload);
+    readback = measure(step_readback);
+    use_buffer(setup_buffer);
+    draws = measure(step_draw_calls);
+    compile = measure(step_compile);
+
+    FILE* out = out_path ? fopen(out_path, "w") : stdout;
+    if (out == NULL)
+    {
+        printf("%s: cannot write!\n", out_path);
+        return EXIT_FAILURE;
+    }
+    fprintf(out, "{\n");
+    print_string(out, "vendor", glGetString(GL_VENDOR));
+    print_string(out, "renderer", glGetString(GL_RENDERER));
+    print_string(out, "version", glGetString(GL_VERSION));
+    fprintf(out, "    \"api\": \"%s\",\n", gles ? "gles" : "gl");
+    fprintf(out, "    \"width\": %d,\n    \"height\": %d,\n", BENCH_WIDTH, BENCH_HEIGHT);
+    fprintf(out, "    \"results\": {\n");
+    print_result(out, "fill_rate", fill / 1e6, "Mpixel/s", 0);
+    print_result(out, "triangle_setup", setup / 1e6, "Mtriangle/s", 0);
+    print_result(out, "texture_upload", upload / (1024 * 1024), "MB/s", 0);
+    print_result(out, "read_pixels", readback / (1024 * 1024), "MB/s", 0);
+    print_result(out, "draw_call_overhead", 1e6 / draws, "us/call", 0);
+    print_result(out, "shader_compile", 1e3 / compile, "ms/program", 1);
+    fprintf(out, "    },\n");
+    fprintf(out, "    \"gl_error\": %s\n}\n", glGetError() == GL_NO_ERROR ? "false" : "true");
+    if (out != stdout)
+        fclose(out);
+
+    free(pixels);
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroySurface(dpy, surface);
+    eglDestroyContext(dpy, ctx);
+    eglTerminate(dpy);
+
+    return EXIT_SUCCESS;
+}
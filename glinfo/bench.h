@@ -0,0 +1,9 @@
+#ifndef __BENCH_H
+#define __BENCH_H
+
+/* Runs the microbenchmarks on an off-screen context and writes the results
+ * as JSON to out_path, or to stdout when it is NULL. */
+int
+glinfo_bench(const char* out_path);
+
+#endif // __BENCH_H
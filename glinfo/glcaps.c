@@ -0,0 +1,546 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glcaps.h>
+
+#define MAX_STRINGS             16
+#define MAX_LIMIT_VALUES        4
+#define MAX_SEED                (1 << 22)
+
+/* Hash and displace: a first hash picks a bucket, and each bucket gets the
+ * seed for a second hash that sends all of its keys to empty slots. Buckets
+ * are placed largest first, while the table is still mostly empty. */
+struct phf
+{
+    const char** keys;
+    unsigned size;
+    unsigned bucket_count;
+    unsigned* seeds;
+    int* slots;
+};
+
+struct limit
+{
+    int count;
+    double values[MAX_LIMIT_VALUES];
+};
+
+struct glcaps
+{
+    char* text;                 /* the file; every string points into it */
+    const char* string_names[MAX_STRINGS];
+    const char* strings[MAX_STRINGS];
+    int string_count;
+    const char** extensions;
+    int extension_count;
+    const char** limit_names;
+    struct limit* limits;
+    int limit_count;
+    struct phf extension_set;
+    struct phf limit_set;
+};
+
+static unsigned
+hash(const char* s, unsigned seed)
+{
+    unsigned h = 2166136261u ^ (seed * 0x9e3779b9u);
+    while (*s)
+    {
+        h ^= (unsigned char) *s++;
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    return h;
+}
+
+static int
+phf_build(struct phf* phf, const char** keys, int n)
+{
+    unsigned* first = malloc((n + 1) * sizeof(unsigned));
+    int* members = malloc((n + 1) * sizeof(int));
+    int* chosen = malloc((n + 1) * sizeof(int));
+    int* order;
+    int* start;
+    int max_members = 0, placed = 0, next, result = 0;
+    unsigned b, i, size;
+
+    phf->keys = keys;
+    phf->bucket_count = n / 4 + 1;
+    phf->size = n + n / 4 + 1;
+    phf->seeds = calloc(phf->bucket_count, sizeof(unsigned));
+    phf->slots = malloc(phf->size * sizeof(int));
+    for (i = 0; i < phf->size; i++)
+        phf->slots[i] = -1;
+
+    /* the keys of every bucket, bucket after bucket */
+    start = calloc(phf->bucket_count + 1, sizeof(int));
+    order = malloc(phf->bucket_count * sizeof(int));
+    for (i = 0; i < (unsigned) n; i++)
+    {
+        first[i] = hash(keys[i], 0) % phf->bucket_count;
+        start[first[i] + 1]++;
+    }
+    for (b = 0; b < phf->bucket_count; b++)
+    {
+        if (start[b + 1] > max_members)
+            max_members = start[b + 1];
+        start[b + 1] += start[b];
+    }
+    for (i = 0; i < (unsigned) n; i++)
+        members[start[first[i]]++] = i;
+    for (b = phf->bucket_count; b > 0; b--)
+        start[b] = start[b - 1];
+    start[0] = 0;
+
+    for (size = max_members; size > 0; size--)
+        for (b = 0; b < phf->bucket_count; b++)
+            if (start[b + 1] - start[b] == (int) size)
+                order[placed++] = b;
+
+    for (next = 0; next < placed; next++)
+    {
+        int* member = members + start[order[next]];
+        int count = start[order[next] + 1] - start[order[next]];
+        unsigned seed;
+        int j, k;
+
+        /* a repeated key would never fit, and equal keys share a bucket */
+        for (j = 1; j < count; j++)
+            for (k = 0; k < j; k++)
+                if (member[k] >= 0 && strcmp(keys[member[j]], keys[member[k]]) == 0)
+                {
+                    member[j] = -1;
+                    break;
+                }
+
+        for (seed = 1; seed < MAX_SEED; seed++)
+        {
+            for (j = 0; j < count; j++)
+            {
+                if (member[j] < 0)
+                {
+                    chosen[j] = -1;
+                    continue;
+                }
+                chosen[j] = hash(keys[member[j]], seed) % phf->size;
+                if (phf->slots[chosen[j]] >= 0)
+                    break;
+                for (k = 0; k < j; k++)
+                    if (chosen[k] == chosen[j])
+                        break;
+                if (k < j)
+                    break;
+            }
+            if (j == count)
+                break;
+        }
+        if (seed == MAX_SEED)
+        {
+            result = -1;
+            break;
+        }
+
+        phf->seeds[order[next]] = seed;
+        for (j = 0; j < count; j++)
+            if (chosen[j] >= 0)
+                phf->slots[chosen[j]] = member[j];
+    }
+
+    free(first);
+    free(members);
+    free(chosen);
+    free(order);
+    free(start);
+    return result;
+}
+
+static int
+phf_find(const struct phf* phf, const char* key)
+{
+    unsigned b, slot;
+    int index;
+
+    if (phf->size == 0)
+        return -1;
+    b = hash(key, 0) % phf->bucket_count;
+    slot = hash(key, phf->seeds[b]) % phf->size;
+    index = phf->slots[slot];
+    return index >= 0 && strcmp(phf->keys[index], key) == 0 ? index : -1;
+}
+
+static void
+phf_free(struct phf* phf)
+{
+    free(phf->seeds);
+    free(phf->slots);
+}
+
+/* Just enough JSON for the snapshots glinfo writes: strings are unescaped
+ * in place, so the text itself holds them afterwards. */
+static void
+skip_space(char** p)
+{
+    while (**p == ' ' || **p == '\t' || **p == '\n' || **p == '\r')
+        (*p)++;
+}
+
+static int
+expect(char** p, char c)
+{
+    skip_space(p);
+    if (**p != c)
+        return 0;
+    (*p)++;
+    return 1;
+}
+
+static char*
+parse_string(char** p)
+{
+    char* start;
+    char* out;
+
+    if (!expect(p, '"'))
+        return NULL;
+    start = out = *p;
+    while (**p != '"')
+    {
+        if (**p == '\0')
+            return NULL;
+        if (**p == '\\')
+        {
+            (*p)++;
+            switch (**p)
+            {
+            case 'n': *out++ = '\n'; break;
+            case 't': *out++ = '\t'; break;
+            case 'r': *out++ = '\r'; break;
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'u':
+                if (strlen(*p) < 5)
+                    return NULL;
+                *out++ = '?';
+                *p += 4;
+                break;
+            case '\0':
+                return NULL;
+            default: *out++ = **p; break;
+            }
+            (*p)++;
+        }
+        else
+            *out++ = *(*p)++;
+    }
+    (*p)++;
+    *out = '\0';
+    return start;
+}
+
+static int
+parse_number(char** p, double* value)
+{
+    char* end;
+    skip_space(p);
+    *value = strtod(*p, &end);
+    if (end == *p)
+        return 0;
+    *p = end;
+    return 1;
+}
+
+static int
+skip_value(char** p)
+{
+    double number;
+
+    skip_space(p);
+    switch (**p)
+    {
+    case '"':
+        return parse_string(p) != NULL;
+    case '{':
+    case '[':
+    {
+        char close = **p == '{' ? '}' : ']';
+        (*p)++;
+        if (expect(p, close))
+            return 1;
+        do
+        {
+            if (close == '}' && (!parse_string(p) || !expect(p, ':')))
+                return 0;
+            if (!skip_value(p))
+                return 0;
+        }
+        while (expect(p, ','));
+        return expect(p, close);
+    }
+    case 't':
+        return strncmp(*p, "true", 4) == 0 ? (*p += 4, 1) : 0;
+    case 'f':
+        return strncmp(*p, "false", 5) == 0 ? (*p += 5, 1) : 0;
+    case 'n':
+        return strncmp(*p, "null", 4) == 0 ? (*p += 4, 1) : 0;
+    default:
+        return parse_number(p, &number);
+    }
+}
+
+static int
+parse_extensions(char** p, glcaps* caps)
+{
+    int capacity = 0;
+
+    if (!expect(p, '['))
+        return 0;
+    if (expect(p, ']'))
+        return 1;
+    do
+    {
+        char* name = parse_string(p);
+        if (name == NULL)
+            return 0;
+        if (caps->extension_count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 256;
+            caps->extensions = realloc(caps->extensions, capacity * sizeof(char*));
+        }
+        caps->extensions[caps->extension_count++] = name;
+    }
+    while (expect(p, ','));
+    return expect(p, ']');
+}
+
+/* "GL_MAX_TEXTURE_SIZE": 16384 or "GL_MAX_VIEWPORT_DIMS": [16384, 16384] */
+static int
+parse_limits(char** p, glcaps* caps)
+{
+    int capacity = 0;
+
+    if (!expect(p, '{'))
+        return 0;
+    if (expect(p, '}'))
+        return 1;
+    do
+    {
+        struct limit* limit;
+        char* name = parse_string(p);
+        if (name == NULL || !expect(p, ':'))
+            return 0;
+        if (caps->limit_count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 128;
+            caps->limit_names = realloc(caps->limit_names, capacity * sizeof(char*));
+            caps->limits = realloc(caps->limits, capacity * sizeof(struct limit));
+        }
+        caps->limit_names[caps->limit_count] = name;
+        limit = &caps->limits[caps->limit_count++];
+        limit->count = 0;
+
+        if (expect(p, '['))
+        {
+            if (expect(p, ']'))
+                continue;
+            do
+            {
+                double value;
+                if (!parse_number(p, &value))
+                    return 0;
+                if (limit->count < MAX_LIMIT_VALUES)
+                    limit->values[limit->count] = value;
+                limit->count++;
+            }
+            while (expect(p, ','));
+            if (!expect(p, ']'))
+                return 0;
+        }
+        else
+        {
+            if (!parse_number(p, &limit->values[0]))
+                return 0;
+            limit->count = 1;
+        }
+    }
+    while (expect(p, ','));
+    return expect(p, '}');
+}
+
+static int
+parse_snapshot(char* text, glcaps* caps)
+{
+    char* p = text;
+
+    if (!expect(&p, '{'))
+        return 0;
+    if (expect(&p, '}'))
+        return 1;
+    do
+    {
+        char* name = parse_string(&p);
+        if (name == NULL || !expect(&p, ':'))
+            return 0;
+        skip_space(&p);
+
+        if (strcmp(name, "extensions") == 0)
+        {
+            if (!parse_extensions(&p, caps))
+                return 0;
+        }
+        else if (strcmp(name, "limits") == 0)
+        {
+            if (!parse_limits(&p, caps))
+                return 0;
+        }
+        else if (*p == '"' && caps->string_count < MAX_STRINGS)
+        {
+            caps->string_names[caps->string_count] = name;
+            caps->strings[caps->string_count] = parse_string(&p);
+            if (caps->strings[caps->string_count++] == NULL)
+                return 0;
+        }
+        else if (!skip_value(&p))
+            return 0;
+    }
+    while (expect(&p, ','));
+    return expect(&p, '}');
+}
+
+int
+glcaps_cache_path(char* path, size_t size, const char* vendor, const char* renderer, const char* version)
+{
+    const char* parts[] = { vendor, "\n", renderer, "\n", version };
+    const char* cache = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    unsigned long long key = 14695981039346656037ull;
+    unsigned i;
+    int length;
+
+    for (i = 0; i < sizeof(parts) / sizeof(parts[0]); i++)
+    {
+        const char* c;
+        for (c = parts[i]; *c; c++)
+        {
+            key ^= (unsigned char) *c;
+            key *= 1099511628211ull;
+        }
+    }
+
+    if (cache && *cache)
+        length = snprintf(path, size, "%s/glinfo/%016llx.json", cache, key);
+    else if (home && *home)
+        length = snprintf(path, size, "%s/.cache/glinfo/%016llx.json", home, key);
+    else
+        return -1;
+    return length < 0 || (size_t) length >= size ? -1 : length;
+}
+
+glcaps*
+glcaps_open(const char* vendor, const char* renderer, const char* version)
+{
+    char path[4096];
+    glcaps* caps;
+
+    if (glcaps_cache_path(path, sizeof(path), vendor, renderer, version) < 0)
+        return NULL;
+    caps = glcaps_load(path);
+    if (caps == NULL)
+        return NULL;
+
+    /* the key is a hash, and the snapshot may be older than the driver */
+    if (!glcaps_string(caps, "vendor") || strcmp(glcaps_string(caps, "vendor"), vendor) != 0 ||
+        !glcaps_string(caps, "renderer") || strcmp(glcaps_string(caps, "renderer"), renderer) != 0 ||
+        !glcaps_string(caps, "version") || strcmp(glcaps_string(caps, "version"), version) != 0)
+    {
+        glcaps_close(caps);
+        return NULL;
+    }
+    return caps;
+}
+
+glcaps*
+glcaps_load(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    glcaps* caps;
+    long size;
+
+    if (file == NULL)
+        return NULL;
+    caps = calloc(1, sizeof(glcaps));
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    caps->text = malloc(size + 1);
+    if (size < 0 || fread(caps->text, 1, size, file) != (size_t) size)
+    {
+        fclose(file);
+        glcaps_close(caps);
+        return NULL;
+    }
+    caps->text[size] = '\0';
+    fclose(file);
+
+    if (!parse_snapshot(caps->text, caps) ||
+        phf_build(&caps->extension_set, caps->extensions, caps->extension_count) < 0 ||
+        phf_build(&caps->limit_set, caps->limit_names, caps->limit_count) < 0)
+    {
+        glcaps_close(caps);
+        return NULL;
+    }
+    return caps;
+}
+
+void
+glcaps_close(glcaps* caps)
+{
+    if (caps == NULL)
+        return;
+    phf_free(&caps->extension_set);
+    phf_free(&caps->limit_set);
+    free(caps->extensions);
+    free(caps->limit_names);
+    free(caps->limits);
+    free(caps->text);
+    free(caps);
+}
+
+const char*
+glcaps_string(const glcaps* caps, const char* name)
+{
+    int i;
+    for (i = 0; i < caps->string_count; i++)
+        if (strcmp(caps->string_names[i], name) == 0)
+            return caps->strings[i];
+    return NULL;
+}
+
+int
+glcaps_has_extension(const glcaps* caps, const char* name)
+{
+    return phf_find(&caps->extension_set, name) >= 0;
+}
+
+int
+glcaps_extension_count(const glcaps* caps)
+{
+    return caps->extension_count;
+}
+
+int
+glcaps_limit(const glcaps* caps, const char* name, double* values, int count)
+{
+    int index = phf_find(&caps->limit_set, name);
+    const struct limit* limit;
+    int i;
+
+    if (index < 0)
+        return 0;
+    limit = &caps->limits[index];
+    for (i = 0; i < count && i < limit->count && i < MAX_LIMIT_VALUES; i++)
+        values[i] = limit->values[i];
+    return limit->count;
+}
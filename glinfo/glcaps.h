@@ -0,0 +1,46 @@
+#ifndef __GLCAPS_H
+#define __GLCAPS_H
+
+#include <stddef.h>
+
+/* Capability snapshots written by "glinfo --cache", so that an application
+ * can skip probing limits and extensions at startup. Snapshots are cached
+ * per driver: the key is made of the GL_VENDOR, GL_RENDERER and GL_VERSION
+ * strings, which any driver update changes. Extensions and limits are kept
+ * in perfect hash tables, so every lookup is two hashes of the name (one
+ * picks the bucket's displacement, the other the slot) and one compare. */
+
+typedef struct glcaps glcaps;
+
+/* $XDG_CACHE_HOME/glinfo/<key>.json, or ~/.cache/glinfo/<key>.json; returns
+ * -1 when it does not fit in size or no home directory is known. */
+int
+glcaps_cache_path(char* path, size_t size, const char* vendor, const char* renderer, const char* version);
+
+/* The cached snapshot for this driver, NULL when there is none or it was
+ * taken from another driver. */
+glcaps*
+glcaps_open(const char* vendor, const char* renderer, const char* version);
+
+/* NULL when the file cannot be read or parsed. */
+glcaps*
+glcaps_load(const char* path);
+
+void
+glcaps_close(glcaps* caps);
+
+const char*
+glcaps_string(const glcaps* caps, const char* name);
+
+int
+glcaps_has_extension(const glcaps* caps, const char* name);
+
+int
+glcaps_extension_count(const glcaps* caps);
+
+/* Stores up to count values of a limit, GL_MAX_TEXTURE_SIZE for instance;
+ * returns how many the limit has, 0 when the snapshot does not know it. */
+int
+glcaps_limit(const glcaps* caps, const char* name, double* values, int count);
+
+#endif // __GLCAPS_H
@@ -1,7 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
+#include <bench.h>
+#include <glcaps.h>
+#include <snapshot.h>
 #include <wrap-gl.h>
 #include <wrap-glx.h>
 
@@ -9,9 +14,62 @@
 #define DECNET_DISPLAY_NAME     "notebook/unix::0"
 #define DISPLAY_NAME            ":0"
 
+/* --json goes to path, or stdout when it is NULL; --cache goes to the file
+ * glcaps_open looks for. */
+static int
+write_snapshot(Display* dpy, int screen, int cache, const char* path)
+{
+    char cache_path[4096];
+    FILE* out = stdout;
+
+    if (cache)
+    {
+        char* slash;
+        if (glcaps_cache_path(cache_path,
+                              sizeof(cache_path),
+                              (const char*) glGetString(GL_VENDOR),
+                              (const char*) glGetString(GL_RENDERER),
+                              (const char*) glGetString(GL_VERSION)) < 0)
+        {
+            printf("no cache directory!\n");
+            return EXIT_FAILURE;
+        }
+        /* mkdir -p */
+        for (slash = strchr(cache_path + 1, '/'); slash; slash = strchr(slash + 1, '/'))
+        {
+            *slash = '\0';
+            mkdir(cache_path, 0755);
+            *slash = '/';
+        }
+        path = cache_path;
+    }
+
+    if (path != NULL)
+        out = fopen(path, "w");
+    if (out == NULL)
+    {
+        printf("%s: cannot write!\n", path);
+        return EXIT_FAILURE;
+    }
+    glinfo_snapshot(out, dpy, screen);
+    if (out != stdout)
+        fclose(out);
+    if (cache)
+        printf("%s\n", path);
+
+    return EXIT_SUCCESS;
+}
+
 int
 main(int argc, char** argv)
 {
+    /* glinfo --bench [FILE]: no X server needed, see bench.h */
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+        return glinfo_bench(argc > 2 ? argv[2] : NULL);
+
+    int json = argc > 1 && strcmp(argv[1], "--json") == 0;
+    int cache = argc > 1 && strcmp(argv[1], "--cache") == 0;
+
     char* display_name = DISPLAY_NAME;
 	Display* dpy = w_XOpenDisplay(display_name);
 
@@ -84,6 +142,14 @@ main(int argc, char** argv)
 
     glXMakeCurrent(dpy, win, ctx);
 
+    if (json || cache)
+    {
+        int status = write_snapshot(dpy, DefaultScreen(dpy), cache, json && argc > 2 ? argv[2] : NULL);
+        glXDestroyContext(dpy, ctx);
+        XCloseDisplay(dpy);
+        return status;
+    }
+
     printf("VENDOR:\n"
            "    %s\n"
            "RENDERER:\n"
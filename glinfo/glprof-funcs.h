@@ -0,0 +1,193 @@
+/* Entry points wrapped by glprof.c, one line each:
+ *
+ *   GLPROF_VOID(function, (parameters), (arguments), sync_if, redundant_if)
+ *   GLPROF_FUNC(type, function, (parameters), (arguments), sync_if, redundant_if)
+ *
+ * sync_if is true when the call makes the CPU wait for the GPU, or for the
+ * driver thread; redundant_if checks the call against the state shadowed in
+ * glprof.c, and has to update that state. Both see the arguments by name and
+ * are evaluated before the call. Add a line to profile another entry point. */
+
+/* draws */
+GLPROF_VOID(glDrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count), 0, 0)
+GLPROF_VOID(glDrawElements, (GLenum mode, GLsizei count, GLenum type, const void* indices), (mode, count, type, indices), 0, 0)
+GLPROF_VOID(glDrawRangeElements, (GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const void* indices), (mode, start, end, count, type, indices), 0, 0)
+GLPROF_VOID(glDrawArraysInstanced, (GLenum mode, GLint first, GLsizei count, GLsizei instancecount), (mode, first, count, instancecount), 0, 0)
+GLPROF_VOID(glDrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount), (mode, count, type, indices, instancecount), 0, 0)
+GLPROF_VOID(glDrawElementsBaseVertex, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLint basevertex), (mode, count, type, indices, basevertex), 0, 0)
+GLPROF_VOID(glMultiDrawArrays, (GLenum mode, const GLint* first, const GLsizei* count, GLsizei drawcount), (mode, first, count, drawcount), 0, 0)
+GLPROF_VOID(glMultiDrawElements, (GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawcount), (mode, count, type, indices, drawcount), 0, 0)
+GLPROF_VOID(glDrawArraysIndirect, (GLenum mode, const void* indirect), (mode, indirect), 0, 0)
+GLPROF_VOID(glDrawElementsIndirect, (GLenum mode, GLenum type, const void* indirect), (mode, type, indirect), 0, 0)
+GLPROF_VOID(glMultiDrawArraysIndirect, (GLenum mode, const void* indirect, GLsizei drawcount, GLsizei stride), (mode, indirect, drawcount, stride), 0, 0)
+GLPROF_VOID(glMultiDrawElementsIndirect, (GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride), (mode, type, indirect, drawcount, stride), 0, 0)
+GLPROF_VOID(glDispatchCompute, (GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z), (num_groups_x, num_groups_y, num_groups_z), 0, 0)
+GLPROF_VOID(glClear, (GLbitfield mask), (mask), 0, 0)
+GLPROF_VOID(glBlitFramebuffer, (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter), (srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter), 0, 0)
+GLPROF_VOID(glCallList, (GLuint list), (list), 0, 0)
+
+/* immediate mode and the fixed function matrix stack */
+GLPROF_VOID(glBegin, (GLenum mode), (mode), 0, 0)
+GLPROF_VOID(glEnd, (void), (), 0, 0)
+GLPROF_VOID(glVertex2f, (GLfloat x, GLfloat y), (x, y), 0, 0)
+GLPROF_VOID(glVertex3f, (GLfloat x, GLfloat y, GLfloat z), (x, y, z), 0, 0)
+GLPROF_VOID(glVertex3fv, (const GLfloat* v), (v), 0, 0)
+GLPROF_VOID(glNormal3f, (GLfloat nx, GLfloat ny, GLfloat nz), (nx, ny, nz), 0, 0)
+GLPROF_VOID(glNormal3fv, (const GLfloat* v), (v), 0, 0)
+GLPROF_VOID(glColor3f, (GLfloat red, GLfloat green, GLfloat blue), (red, green, blue), 0, 0)
+GLPROF_VOID(glColor4f, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha), 0, 0)
+GLPROF_VOID(glTexCoord2f, (GLfloat s, GLfloat t), (s, t), 0, 0)
+GLPROF_VOID(glMatrixMode, (GLenum mode), (mode), 0, 0)
+GLPROF_VOID(glLoadIdentity, (void), (), 0, 0)
+GLPROF_VOID(glLoadMatrixf, (const GLfloat* m), (m), 0, 0)
+GLPROF_VOID(glMultMatrixf, (const GLfloat* m), (m), 0, 0)
+GLPROF_VOID(glPushMatrix, (void), (), 0, 0)
+GLPROF_VOID(glPopMatrix, (void), (), 0, 0)
+GLPROF_VOID(glTranslatef, (GLfloat x, GLfloat y, GLfloat z), (x, y, z), 0, 0)
+GLPROF_VOID(glRotatef, (GLfloat angle, GLfloat x, GLfloat y, GLfloat z), (angle, x, y, z), 0, 0)
+GLPROF_VOID(glScalef, (GLfloat x, GLfloat y, GLfloat z), (x, y, z), 0, 0)
+GLPROF_VOID(glOrtho, (GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble zNear, GLdouble zFar), (left, right, bottom, top, zNear, zFar), 0, 0)
+GLPROF_VOID(glFrustum, (GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble zNear, GLdouble zFar), (left, right, bottom, top, zNear, zFar), 0, 0)
+GLPROF_VOID(glPushAttrib, (GLbitfield mask), (mask), 0, 0)
+GLPROF_VOID(glPopAttrib, (void), (), 0, forget_state())
+
+/* fixed state */
+GLPROF_VOID(glEnable, (GLenum cap), (cap), 0, same_cap(cap, 1))
+GLPROF_VOID(glDisable, (GLenum cap), (cap), 0, same_cap(cap, 0))
+GLPROF_VOID(glEnablei, (GLenum target, GLuint index), (target, index), 0, forget_cap(target))
+GLPROF_VOID(glDisablei, (GLenum target, GLuint index), (target, index), 0, forget_cap(target))
+GLPROF_VOID(glBlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor), 0, same(&state.blend_func, (long long) sfactor << 32 | dfactor))
+GLPROF_VOID(glBlendFuncSeparate, (GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha), (sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha), 0, forget(&state.blend_func))
+GLPROF_VOID(glBlendFunci, (GLuint buf, GLenum src, GLenum dst), (buf, src, dst), 0, forget(&state.blend_func))
+GLPROF_VOID(glBlendEquation, (GLenum mode), (mode), 0, same(&state.blend_equation, mode))
+GLPROF_VOID(glBlendEquationSeparate, (GLenum modeRGB, GLenum modeAlpha), (modeRGB, modeAlpha), 0, forget(&state.blend_equation))
+GLPROF_VOID(glDepthFunc, (GLenum func), (func), 0, same(&state.depth_func, func))
+GLPROF_VOID(glDepthMask, (GLboolean flag), (flag), 0, same(&state.depth_mask, !!flag))
+GLPROF_VOID(glColorMask, (GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha), (red, green, blue, alpha), 0, same(&state.color_mask, (red ? 1 : 0) | (green ? 2 : 0) | (blue ? 4 : 0) | (alpha ? 8 : 0)))
+GLPROF_VOID(glCullFace, (GLenum mode), (mode), 0, same(&state.cull_face, mode))
+GLPROF_VOID(glFrontFace, (GLenum mode), (mode), 0, same(&state.front_face, mode))
+GLPROF_VOID(glViewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height), 0, same_rect(state.viewport, x, y, width, height))
+GLPROF_VOID(glScissor, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height), 0, same_rect(state.scissor, x, y, width, height))
+GLPROF_VOID(glClearColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha), 0, 0)
+GLPROF_VOID(glClearDepth, (GLdouble depth), (depth), 0, 0)
+GLPROF_VOID(glPolygonMode, (GLenum face, GLenum mode), (face, mode), 0, 0)
+GLPROF_VOID(glPolygonOffset, (GLfloat factor, GLfloat units), (factor, units), 0, 0)
+GLPROF_VOID(glLineWidth, (GLfloat width), (width), 0, 0)
+GLPROF_VOID(glStencilFunc, (GLenum func, GLint ref, GLuint mask), (func, ref, mask), 0, 0)
+GLPROF_VOID(glStencilOp, (GLenum fail, GLenum zfail, GLenum zpass), (fail, zfail, zpass), 0, 0)
+GLPROF_VOID(glStencilMask, (GLuint mask), (mask), 0, 0)
+GLPROF_VOID(glPixelStorei, (GLenum pname, GLint param), (pname, param), 0, 0)
+
+/* buffers and vertex arrays */
+GLPROF_VOID(glGenBuffers, (GLsizei n, GLuint* buffers), (n, buffers), 0, 0)
+GLPROF_VOID(glDeleteBuffers, (GLsizei n, const GLuint* buffers), (n, buffers), 0, forget_buffers())
+GLPROF_VOID(glBindBuffer, (GLenum target, GLuint buffer), (target, buffer), 0, same_buffer(target, buffer))
+/* indexed bindings are not shadowed, so these are never redundant; they do rebind the generic target */
+GLPROF_VOID(glBindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer), 0, set_buffer(target, buffer))
+GLPROF_VOID(glBindBufferRange, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size), (target, index, buffer, offset, size), 0, set_buffer(target, buffer))
+GLPROF_VOID(glBufferData, (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage), 0, 0)
+GLPROF_VOID(glBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void* data), (target, offset, size, data), 0, 0)
+GLPROF_VOID(glBufferStorage, (GLenum target, GLsizeiptr size, const void* data, GLbitfield flags), (target, size, data, flags), 0, 0)
+GLPROF_VOID(glCopyBufferSubData, (GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size), (readTarget, writeTarget, readOffset, writeOffset, size), 0, 0)
+GLPROF_FUNC(void*, glMapBuffer, (GLenum target, GLenum access), (target, access), 1, 0)
+GLPROF_FUNC(void*, glMapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), (target, offset, length, access), !(access & GL_MAP_UNSYNCHRONIZED_BIT), 0)
+GLPROF_VOID(glFlushMappedBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length), (target, offset, length), 0, 0)
+GLPROF_FUNC(GLboolean, glUnmapBuffer, (GLenum target), (target), 0, 0)
+GLPROF_VOID(glGetBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, void* data), (target, offset, size, data), 1, 0)
+GLPROF_VOID(glGenVertexArrays, (GLsizei n, GLuint* arrays), (n, arrays), 0, 0)
+GLPROF_VOID(glDeleteVertexArrays, (GLsizei n, const GLuint* arrays), (n, arrays), 0, forget_vertex_arrays())
+GLPROF_VOID(glBindVertexArray, (GLuint array), (array), 0, same_vertex_array(array))
+GLPROF_VOID(glVertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer), (index, size, type, normalized, stride, pointer), 0, 0)
+GLPROF_VOID(glVertexAttribIPointer, (GLuint index, GLint size, GLenum type, GLsizei stride, const void* pointer), (index, size, type, stride, pointer), 0, 0)
+GLPROF_VOID(glEnableVertexAttribArray, (GLuint index), (index), 0, 0)
+GLPROF_VOID(glDisableVertexAttribArray, (GLuint index), (index), 0, 0)
+GLPROF_VOID(glVertexAttribDivisor, (GLuint index, GLuint divisor), (index, divisor), 0, 0)
+
+/* textures */
+GLPROF_VOID(glGenTextures, (GLsizei n, GLuint* textures), (n, textures), 0, 0)
+GLPROF_VOID(glDeleteTextures, (GLsizei n, const GLuint* textures), (n, textures), 0, forget_textures())
+GLPROF_VOID(glActiveTexture, (GLenum texture), (texture), 0, same(&state.active_texture, texture))
+GLPROF_VOID(glBindTexture, (GLenum target, GLuint texture), (target, texture), 0, same_texture(target, texture))
+GLPROF_VOID(glBindSampler, (GLuint unit, GLuint sampler), (unit, sampler), 0, 0)
+GLPROF_VOID(glTexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels), (target, level, internalformat, width, height, border, format, type, pixels), 0, 0)
+GLPROF_VOID(glTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels), (target, level, xoffset, yoffset, width, height, format, type, pixels), 0, 0)
+GLPROF_VOID(glTexImage3D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels), (target, level, internalformat, width, height, depth, border, format, type, pixels), 0, 0)
+GLPROF_VOID(glTexSubImage3D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels), (target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels), 0, 0)
+GLPROF_VOID(glCompressedTexImage2D, (GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void* data), (target, level, internalformat, width, height, border, imageSize, data), 0, 0)
+GLPROF_VOID(glTexStorage2D, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height), (target, levels, internalformat, width, height), 0, 0)
+GLPROF_VOID(glCopyTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height), (target, level, xoffset, yoffset, x, y, width, height), 0, 0)
+GLPROF_VOID(glTexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param), 0, 0)
+GLPROF_VOID(glTexParameterf, (GLenum target, GLenum pname, GLfloat param), (target, pname, param), 0, 0)
+GLPROF_VOID(glGenerateMipmap, (GLenum target), (target), 0, 0)
+GLPROF_VOID(glGetTexImage, (GLenum target, GLint level, GLenum format, GLenum type, void* pixels), (target, level, format, type, pixels), 1, 0)
+
+/* framebuffers */
+GLPROF_VOID(glGenFramebuffers, (GLsizei n, GLuint* framebuffers), (n, framebuffers), 0, 0)
+GLPROF_VOID(glDeleteFramebuffers, (GLsizei n, const GLuint* framebuffers), (n, framebuffers), 0, forget_framebuffers())
+GLPROF_VOID(glBindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer), 0, same_framebuffer(target, framebuffer))
+GLPROF_VOID(glFramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level), (target, attachment, textarget, texture, level), 0, 0)
+GLPROF_VOID(glFramebufferRenderbuffer, (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer), (target, attachment, renderbuffertarget, renderbuffer), 0, 0)
+GLPROF_FUNC(GLenum, glCheckFramebufferStatus, (GLenum target), (target), 0, 0)
+GLPROF_VOID(glBindRenderbuffer, (GLenum target, GLuint renderbuffer), (target, renderbuffer), 0, 0)
+GLPROF_VOID(glRenderbufferStorage, (GLenum target, GLenum internalformat, GLsizei width, GLsizei height), (target, internalformat, width, height), 0, 0)
+GLPROF_VOID(glRenderbufferStorageMultisample, (GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height), (target, samples, internalformat, width, height), 0, 0)
+GLPROF_VOID(glDrawBuffers, (GLsizei n, const GLenum* bufs), (n, bufs), 0, 0)
+GLPROF_VOID(glReadBuffer, (GLenum src), (src), 0, 0)
+GLPROF_VOID(glInvalidateFramebuffer, (GLenum target, GLsizei numAttachments, const GLenum* attachments), (target, numAttachments, attachments), 0, 0)
+
+/* shaders and uniforms */
+GLPROF_FUNC(GLuint, glCreateShader, (GLenum type), (type), 0, 0)
+GLPROF_VOID(glShaderSource, (GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length), (shader, count, string, length), 0, 0)
+GLPROF_VOID(glCompileShader, (GLuint shader), (shader), 0, 0)
+GLPROF_VOID(glDeleteShader, (GLuint shader), (shader), 0, 0)
+GLPROF_FUNC(GLuint, glCreateProgram, (void), (), 0, 0)
+GLPROF_VOID(glAttachShader, (GLuint program, GLuint shader), (program, shader), 0, 0)
+GLPROF_VOID(glBindAttribLocation, (GLuint program, GLuint index, const GLchar* name), (program, index, name), 0, 0)
+GLPROF_VOID(glLinkProgram, (GLuint program), (program), 0, 0)
+GLPROF_VOID(glDeleteProgram, (GLuint program), (program), 0, forget(&state.program))
+GLPROF_VOID(glUseProgram, (GLuint program), (program), 0, same(&state.program, program))
+GLPROF_VOID(glGetShaderiv, (GLuint shader, GLenum pname, GLint* params), (shader, pname, params), 1, 0)
+GLPROF_VOID(glGetProgramiv, (GLuint program, GLenum pname, GLint* params), (program, pname, params), 1, 0)
+GLPROF_VOID(glGetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog), (shader, bufSize, length, infoLog), 1, 0)
+GLPROF_VOID(glGetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog), (program, bufSize, length, infoLog), 1, 0)
+GLPROF_FUNC(GLint, glGetUniformLocation, (GLuint program, const GLchar* name), (program, name), 1, 0)
+GLPROF_FUNC(GLint, glGetAttribLocation, (GLuint program, const GLchar* name), (program, name), 1, 0)
+GLPROF_VOID(glUniformBlockBinding, (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding), (program, uniformBlockIndex, uniformBlockBinding), 0, 0)
+GLPROF_VOID(glUniform1i, (GLint location, GLint v0), (location, v0), 0, 0)
+GLPROF_VOID(glUniform1f, (GLint location, GLfloat v0), (location, v0), 0, 0)
+GLPROF_VOID(glUniform2f, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1), 0, 0)
+GLPROF_VOID(glUniform3f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2), (location, v0, v1, v2), 0, 0)
+GLPROF_VOID(glUniform4f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (location, v0, v1, v2, v3), 0, 0)
+GLPROF_VOID(glUniform1iv, (GLint location, GLsizei count, const GLint* value), (location, count, value), 0, 0)
+GLPROF_VOID(glUniform1fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value), 0, 0)
+GLPROF_VOID(glUniform2fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value), 0, 0)
+GLPROF_VOID(glUniform3fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value), 0, 0)
+GLPROF_VOID(glUniform4fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value), 0, 0)
+GLPROF_VOID(glUniformMatrix3fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value), 0, 0)
+GLPROF_VOID(glUniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value), 0, 0)
+
+/* queries and synchronisation */
+GLPROF_FUNC(GLenum, glGetError, (void), (), 1, 0)
+GLPROF_VOID(glFinish, (void), (), 1, 0)
+GLPROF_VOID(glFlush, (void), (), 0, 0)
+GLPROF_VOID(glReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels), (x, y, width, height, format, type, pixels), state.buffers[BUFFER_PIXEL_PACK] <= 0, 0)
+GLPROF_VOID(glGetBooleanv, (GLenum pname, GLboolean* data), (pname, data), 1, 0)
+GLPROF_VOID(glGetIntegerv, (GLenum pname, GLint* data), (pname, data), 1, 0)
+GLPROF_VOID(glGetInteger64v, (GLenum pname, GLint64* data), (pname, data), 1, 0)
+GLPROF_VOID(glGetFloatv, (GLenum pname, GLfloat* data), (pname, data), 1, 0)
+GLPROF_FUNC(const GLubyte*, glGetString, (GLenum name), (name), 0, 0)
+GLPROF_FUNC(const GLubyte*, glGetStringi, (GLenum name, GLuint index), (name, index), 0, 0)
+GLPROF_FUNC(GLsync, glFenceSync, (GLenum condition, GLbitfield flags), (condition, flags), 0, 0)
+GLPROF_FUNC(GLenum, glClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout), timeout != 0, 0)
+GLPROF_VOID(glWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout), 0, 0)
+GLPROF_VOID(glDeleteSync, (GLsync sync), (sync), 0, 0)
+GLPROF_VOID(glMemoryBarrier, (GLbitfield barriers), (barriers), 0, 0)
+GLPROF_VOID(glGenQueries, (GLsizei n, GLuint* ids), (n, ids), 0, 0)
+GLPROF_VOID(glDeleteQueries, (GLsizei n, const GLuint* ids), (n, ids), 0, 0)
+GLPROF_VOID(glBeginQuery, (GLenum target, GLuint id), (target, id), 0, 0)
+GLPROF_VOID(glEndQuery, (GLenum target), (target), 0, 0)
+GLPROF_VOID(glQueryCounter, (GLuint id, GLenum target), (id, target), 0, 0)
+GLPROF_VOID(glGetQueryObjectiv, (GLuint id, GLenum pname, GLint* params), (id, pname, params), pname != GL_QUERY_RESULT_AVAILABLE, 0)
+GLPROF_VOID(glGetQueryObjectuiv, (GLuint id, GLenum pname, GLuint* params), (id, pname, params), pname != GL_QUERY_RESULT_AVAILABLE, 0)
+GLPROF_VOID(glGetQueryObjecti64v, (GLuint id, GLenum pname, GLint64* params), (id, pname, params), pname != GL_QUERY_RESULT_AVAILABLE, 0)
+GLPROF_VOID(glGetQueryObjectui64v, (GLuint id, GLenum pname, GLuint64* params), (id, pname, params), pname != GL_QUERY_RESULT_AVAILABLE, 0)
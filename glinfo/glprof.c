@@ -0,0 +1,667 @@
+/* GL call profiler, preloaded into an unmodified binary:
+ *
+ *   LD_PRELOAD=./libglprof.so app
+ *
+ * Every entry point of glprof-funcs.h is counted and timed, whether the
+ * application links it or gets it from glXGetProcAddress or
+ * eglGetProcAddress. Calls that make the CPU wait are counted as sync points;
+ * binds and state changes that set what is already set are counted as
+ * redundant. Every glXSwapBuffers (or eglSwapBuffers) ends a frame and
+ * writes its summary; the totals are written at exit.
+ *
+ *   GLPROF_OUT=file     summaries go there instead of stderr
+ *   GLPROF_EVERY=n      one summary per n frames, 1 by default
+ *   GLPROF_TOP=n        entry points listed per summary, 10 by default
+ *
+ * Counters and shadowed state are per thread, as GL contexts are. */
+#define _GNU_SOURCE
+#define GL_GLEXT_PROTOTYPES
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GL/glx.h>
+#include <EGL/egl.h>
+
+#define UNKNOWN                 (-1LL)
+#define TEXTURE_UNITS           32
+
+enum function
+{
+#define GLPROF_VOID(function, parameters, arguments, sync_if, redundant_if) FUNC_##function,
+#define GLPROF_FUNC(type, function, parameters, arguments, sync_if, redundant_if) FUNC_##function,
+#include <glprof-funcs.h>
+#undef GLPROF_VOID
+#undef GLPROF_FUNC
+    FUNC_glXSwapBuffers,
+    FUNC_eglSwapBuffers,
+    FUNC_COUNT
+};
+
+static const char* function_names[] =
+{
+#define GLPROF_VOID(function, parameters, arguments, sync_if, redundant_if) #function,
+#define GLPROF_FUNC(type, function, parameters, arguments, sync_if, redundant_if) #function,
+#include <glprof-funcs.h>
+#undef GLPROF_VOID
+#undef GLPROF_FUNC
+    "glXSwapBuffers",
+    "eglSwapBuffers",
+};
+
+enum buffer_target
+{
+    BUFFER_ARRAY,
+    BUFFER_ELEMENT_ARRAY,
+    BUFFER_UNIFORM,
+    BUFFER_SHADER_STORAGE,
+    BUFFER_PIXEL_PACK,
+    BUFFER_PIXEL_UNPACK,
+    BUFFER_COPY_READ,
+    BUFFER_COPY_WRITE,
+    BUFFER_DRAW_INDIRECT,
+    BUFFER_TEXTURE,
+    BUFFER_TARGETS
+};
+
+static const GLenum texture_targets[] =
+{
+    GL_TEXTURE_1D,
+    GL_TEXTURE_2D,
+    GL_TEXTURE_3D,
+    GL_TEXTURE_CUBE_MAP,
+    GL_TEXTURE_2D_ARRAY,
+    GL_TEXTURE_RECTANGLE,
+    GL_TEXTURE_BUFFER,
+    GL_TEXTURE_2D_MULTISAMPLE,
+    GL_TEXTURE_CUBE_MAP_ARRAY,
+};
+
+static const GLenum tracked_caps[] =
+{
+    GL_BLEND,
+    GL_DEPTH_TEST,
+    GL_CULL_FACE,
+    GL_SCISSOR_TEST,
+    GL_STENCIL_TEST,
+    GL_POLYGON_OFFSET_FILL,
+    GL_MULTISAMPLE,
+    GL_SAMPLE_ALPHA_TO_COVERAGE,
+    GL_FRAMEBUFFER_SRGB,
+    GL_RASTERIZER_DISCARD,
+    GL_PRIMITIVE_RESTART,
+    GL_DITHER,
+    GL_LIGHTING,
+    GL_TEXTURE_2D,
+};
+
+#define COUNT(array)            (sizeof(array) / sizeof((array)[0]))
+
+/* What the application last set, UNKNOWN until then. It is forgotten when
+ * the current context changes, so binds are only redundant within one. */
+struct state
+{
+    int valid;
+    long long program;
+    long long vertex_array;
+    long long draw_framebuffer;
+    long long read_framebuffer;
+    long long active_texture;
+    long long buffers[BUFFER_TARGETS];
+    long long textures[TEXTURE_UNITS][COUNT(texture_targets)];
+    long long caps[COUNT(tracked_caps)];
+    long long blend_func;
+    long long blend_equation;
+    long long depth_func;
+    long long depth_mask;
+    long long color_mask;
+    long long cull_face;
+    long long front_face;
+    long long viewport[4];
+    long long scissor[4];
+};
+
+struct stats
+{
+    unsigned long long calls[FUNC_COUNT];
+    unsigned long long ns[FUNC_COUNT];
+    unsigned long long redundant[FUNC_COUNT];
+    unsigned long long syncs[FUNC_COUNT];
+    unsigned long frames;
+};
+
+static __thread struct state state;
+static __thread struct stats frame;
+static __thread long long frame_start;
+static __thread unsigned long frame_number;
+static __thread int thread_registered;
+
+static pthread_mutex_t totals_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t thread_key;
+static struct stats totals;
+static FILE* out;
+static long long start_ns;
+static int every = 1;
+static int top = 10;
+
+static long long
+now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* State shadowing for the redundant_if column. */
+static int
+forget_state()
+{
+    memset(&state, 0xff, sizeof(state));
+    state.valid = 1;
+    return 0;
+}
+
+static int
+forget(long long* slot)
+{
+    if (slot)
+        *slot = UNKNOWN;
+    return 0;
+}
+
+static int
+same(long long* slot, long long value)
+{
+    int redundant = *slot == value;
+    *slot = value;
+    return redundant;
+}
+
+static int
+same_rect(long long* rect, GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    int redundant = rect[0] == x && rect[1] == y && rect[2] == width && rect[3] == height;
+    rect[0] = x;
+    rect[1] = y;
+    rect[2] = width;
+    rect[3] = height;
+    return redundant;
+}
+
+static long long*
+cap_slot(GLenum cap)
+{
+    unsigned i;
+    for (i = 0; i < COUNT(tracked_caps); i++)
+        if (tracked_caps[i] == cap)
+            return &state.caps[i];
+    return NULL;
+}
+
+static int
+same_cap(GLenum cap, int enabled)
+{
+    long long* slot = cap_slot(cap);
+    return slot ? same(slot, enabled) : 0;
+}
+
+static int
+forget_cap(GLenum cap)
+{
+    return forget(cap_slot(cap));
+}
+
+static long long*
+buffer_slot(GLenum target)
+{
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER:               return &state.buffers[BUFFER_ARRAY];
+    case GL_ELEMENT_ARRAY_BUFFER:       return &state.buffers[BUFFER_ELEMENT_ARRAY];
+    case GL_UNIFORM_BUFFER:             return &state.buffers[BUFFER_UNIFORM];
+    case GL_SHADER_STORAGE_BUFFER:      return &state.buffers[BUFFER_SHADER_STORAGE];
+    case GL_PIXEL_PACK_BUFFER:          return &state.buffers[BUFFER_PIXEL_PACK];
+    case GL_PIXEL_UNPACK_BUFFER:        return &state.buffers[BUFFER_PIXEL_UNPACK];
+    case GL_COPY_READ_BUFFER:           return &state.buffers[BUFFER_COPY_READ];
+    case GL_COPY_WRITE_BUFFER:          return &state.buffers[BUFFER_COPY_WRITE];
+    case GL_DRAW_INDIRECT_BUFFER:       return &state.buffers[BUFFER_DRAW_INDIRECT];
+    case GL_TEXTURE_BUFFER:             return &state.buffers[BUFFER_TEXTURE];
+    default:                            return NULL;
+    }
+}
+
+static int
+same_buffer(GLenum target, GLuint buffer)
+{
+    long long* slot = buffer_slot(target);
+    return slot ? same(slot, buffer) : 0;
+}
+
+/* For binds that are never redundant but still move the generic binding. */
+static int
+set_buffer(GLenum target, GLuint buffer)
+{
+    long long* slot = buffer_slot(target);
+    if (slot)
+        *slot = buffer;
+    return 0;
+}
+
+/* Deleted names unbind and may come back from glGen*, so a delete forgets
+ * every binding of its kind. */
+static int
+forget_buffers()
+{
+    int i;
+    for (i = 0; i < BUFFER_TARGETS; i++)
+        state.buffers[i] = UNKNOWN;
+    return 0;
+}
+
+static int
+same_vertex_array(GLuint array)
+{
+    if (same(&state.vertex_array, array))
+        return 1;
+    /* the element array binding belongs to the vertex array */
+    return forget(&state.buffers[BUFFER_ELEMENT_ARRAY]);
+}
+
+static int
+forget_vertex_arrays()
+{
+    forget(&state.buffers[BUFFER_ELEMENT_ARRAY]);
+    return forget(&state.vertex_array);
+}
+
+static int
+same_texture(GLenum target, GLuint texture)
+{
+    long long unit = state.active_texture - GL_TEXTURE0;
+    unsigned i;
+
+    if (state.active_texture == UNKNOWN || unit < 0 || unit >= TEXTURE_UNITS)
+        return 0;
+    for (i = 0; i < COUNT(texture_targets); i++)
+        if (texture_targets[i] == target)
+            return same(&state.textures[unit][i], texture);
+    return 0;
+}
+
+static int
+forget_textures()
+{
+    memset(state.textures, 0xff, sizeof(state.textures));
+    return 0;
+}
+
+static int
+same_framebuffer(GLenum target, GLuint framebuffer)
+{
+    int draw, read;
+
+    switch (target)
+    {
+    case GL_DRAW_FRAMEBUFFER:
+        return same(&state.draw_framebuffer, framebuffer);
+    case GL_READ_FRAMEBUFFER:
+        return same(&state.read_framebuffer, framebuffer);
+    default:
+        draw = same(&state.draw_framebuffer, framebuffer);
+        read = same(&state.read_framebuffer, framebuffer);
+        return draw && read;
+    }
+}
+
+static int
+forget_framebuffers()
+{
+    forget(&state.draw_framebuffer);
+    return forget(&state.read_framebuffer);
+}
+
+/* Counters. */
+static void
+add_stats(struct stats* to, const struct stats* from)
+{
+    int i;
+    for (i = 0; i < FUNC_COUNT; i++)
+    {
+        to->calls[i] += from->calls[i];
+        to->ns[i] += from->ns[i];
+        to->redundant[i] += from->redundant[i];
+        to->syncs[i] += from->syncs[i];
+    }
+    to->frames += from->frames;
+}
+
+static void
+report(const char* title, const struct stats* stats, double wall_ms)
+{
+    unsigned long long calls = 0, ns = 0, redundant = 0, syncs = 0;
+    int listed[FUNC_COUNT] = { 0 };
+    const char* separator;
+    int i, n;
+
+    for (i = 0; i < FUNC_COUNT; i++)
+    {
+        calls += stats->calls[i];
+        ns += stats->ns[i];
+        redundant += stats->redundant[i];
+        syncs += stats->syncs[i];
+    }
+    if (calls == 0)
+        return;
+
+    flockfile(out);
+    fprintf(out, "glprof %s: %.3f ms, %llu calls in %.3f ms, %llu redundant, %llu sync\n",
+            title, wall_ms, calls, ns / 1e6, redundant, syncs);
+
+    /* the most expensive entry points first */
+    for (n = 0; n < top; n++)
+    {
+        int best = -1;
+        for (i = 0; i < FUNC_COUNT; i++)
+            if (!listed[i] && stats->calls[i] && (best < 0 || stats->ns[i] > stats->ns[best]))
+                best = i;
+        if (best < 0)
+            break;
+        listed[best] = 1;
+        fprintf(out, "    %-32s %10llu calls %10.3f ms %8.2f us/call\n",
+                function_names[best], stats->calls[best], stats->ns[best] / 1e6,
+                stats->ns[best] / 1e3 / stats->calls[best]);
+    }
+
+    if (redundant)
+    {
+        fprintf(out, "    redundant:");
+        for (i = 0, separator = " "; i < FUNC_COUNT; i++)
+            if (stats->redundant[i])
+            {
+                fprintf(out, "%s%s %llu", separator, function_names[i], stats->redundant[i]);
+                separator = ", ";
+            }
+        fprintf(out, "\n");
+    }
+    if (syncs)
+    {
+        fprintf(out, "    sync:");
+        for (i = 0, separator = " "; i < FUNC_COUNT; i++)
+            if (stats->syncs[i])
+            {
+                fprintf(out, "%s%s %llu", separator, function_names[i], stats->syncs[i]);
+                separator = ", ";
+            }
+        fprintf(out, "\n");
+    }
+    fflush(out);
+    funlockfile(out);
+}
+
+static void
+flush_thread(void* unused)
+{
+    pthread_mutex_lock(&totals_mutex);
+    add_stats(&totals, &frame);
+    pthread_mutex_unlock(&totals_mutex);
+    memset(&frame, 0, sizeof(frame));
+}
+
+static inline void
+enter()
+{
+    if (!state.valid)
+        forget_state();
+    if (!thread_registered)
+    {
+        /* threads that never swap still end up in the totals */
+        thread_registered = 1;
+        pthread_setspecific(thread_key, &frame);
+        frame_start = now_ns();
+    }
+}
+
+static inline void
+leave(enum function function, long long start)
+{
+    frame.ns[function] += now_ns() - start;
+    frame.calls[function]++;
+}
+
+static void
+end_frame(enum function function, long long start)
+{
+    char title[64];
+    long long now;
+
+    leave(function, start);
+    frame_number++;
+    if (++frame.frames < (unsigned long) every)
+        return;
+
+    now = now_ns();
+    if (every == 1)
+        snprintf(title, sizeof(title), "frame %lu", frame_number);
+    else
+        snprintf(title, sizeof(title), "frames %lu-%lu", frame_number - frame.frames + 1, frame_number);
+    report(title, &frame, (now - frame_start) / 1e6 / frame.frames);
+    flush_thread(NULL);
+    frame_start = now;
+}
+
+/* Real entry points come from the next library in the search order, and
+ * failing that from one the application opened itself. */
+static void*
+resolve(const char* name)
+{
+    static void* (*get_proc_address)(const GLubyte*);
+    void* function = dlsym(RTLD_NEXT, name);
+
+    if (function == NULL)
+    {
+        void* gl = dlopen("libGL.so.1", RTLD_LAZY | RTLD_NOLOAD);
+        if (gl)
+            get_proc_address = (void* (*)(const GLubyte*)) dlsym(gl, "glXGetProcAddressARB");
+        if (get_proc_address)
+            function = get_proc_address((const GLubyte*) name);
+    }
+    if (function == NULL)
+    {
+        fprintf(stderr, "glprof: %s not found!\n", name);
+        abort();
+    }
+    return function;
+}
+
+/* The parameters keep their names from the GL headers, hence the prefixed
+ * locals. */
+#define GLPROF_VOID(function, parameters, arguments, sync_if, redundant_if) \
+    void \
+    function parameters \
+    { \
+        static void (*real) parameters; \
+        long long glprof_start; \
+        if (real == NULL) \
+            real = (void (*) parameters) resolve(#function); \
+        enter(); \
+        if (sync_if) \
+            frame.syncs[FUNC_##function]++; \
+        if (redundant_if) \
+            frame.redundant[FUNC_##function]++; \
+        glprof_start = now_ns(); \
+        real arguments; \
+        leave(FUNC_##function, glprof_start); \
+    }
+#define GLPROF_FUNC(type, function, parameters, arguments, sync_if, redundant_if) \
+    type \
+    function parameters \
+    { \
+        static type (*real) parameters; \
+        long long glprof_start; \
+        type glprof_result; \
+        if (real == NULL) \
+            real = (type (*) parameters) resolve(#function); \
+        enter(); \
+        if (sync_if) \
+            frame.syncs[FUNC_##function]++; \
+        if (redundant_if) \
+            frame.redundant[FUNC_##function]++; \
+        glprof_start = now_ns(); \
+        glprof_result = real arguments; \
+        leave(FUNC_##function, glprof_start); \
+        return glprof_result; \
+    }
+#include <glprof-funcs.h>
+#undef GLPROF_VOID
+#undef GLPROF_FUNC
+
+struct wrapper
+{
+    const char* name;
+    void (*function)(void);
+};
+
+static const struct wrapper wrappers[] =
+{
+#define GLPROF_VOID(function, parameters, arguments, sync_if, redundant_if) { #function, (void (*)(void)) function },
+#define GLPROF_FUNC(type, function, parameters, arguments, sync_if, redundant_if) { #function, (void (*)(void)) function },
+#include <glprof-funcs.h>
+#undef GLPROF_VOID
+#undef GLPROF_FUNC
+};
+
+static void
+(*find_wrapper(const char* name))(void)
+{
+    unsigned i;
+    for (i = 0; i < COUNT(wrappers); i++)
+        if (strcmp(wrappers[i].name, name) == 0)
+            return wrappers[i].function;
+    return NULL;
+}
+
+/* GLX and EGL: frames, context changes and the proc address queries that
+ * would otherwise hand out unwrapped entry points. */
+void
+glXSwapBuffers(Display* dpy, GLXDrawable drawable)
+{
+    static void (*real)(Display*, GLXDrawable);
+    long long start;
+    if (real == NULL)
+        real = (void (*)(Display*, GLXDrawable)) resolve("glXSwapBuffers");
+    enter();
+    start = now_ns();
+    real(dpy, drawable);
+    end_frame(FUNC_glXSwapBuffers, start);
+}
+
+EGLBoolean
+eglSwapBuffers(EGLDisplay dpy, EGLSurface surface)
+{
+    static EGLBoolean (*real)(EGLDisplay, EGLSurface);
+    long long start;
+    EGLBoolean result;
+    if (real == NULL)
+        real = (EGLBoolean (*)(EGLDisplay, EGLSurface)) resolve("eglSwapBuffers");
+    enter();
+    start = now_ns();
+    result = real(dpy, surface);
+    end_frame(FUNC_eglSwapBuffers, start);
+    return result;
+}
+
+Bool
+glXMakeCurrent(Display* dpy, GLXDrawable drawable, GLXContext ctx)
+{
+    static Bool (*real)(Display*, GLXDrawable, GLXContext);
+    if (real == NULL)
+        real = (Bool (*)(Display*, GLXDrawable, GLXContext)) resolve("glXMakeCurrent");
+    state.valid = 0;
+    return real(dpy, drawable, ctx);
+}
+
+Bool
+glXMakeContextCurrent(Display* dpy, GLXDrawable draw, GLXDrawable read, GLXContext ctx)
+{
+    static Bool (*real)(Display*, GLXDrawable, GLXDrawable, GLXContext);
+    if (real == NULL)
+        real = (Bool (*)(Display*, GLXDrawable, GLXDrawable, GLXContext)) resolve("glXMakeContextCurrent");
+    state.valid = 0;
+    return real(dpy, draw, read, ctx);
+}
+
+EGLBoolean
+eglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx)
+{
+    static EGLBoolean (*real)(EGLDisplay, EGLSurface, EGLSurface, EGLContext);
+    if (real == NULL)
+        real = (EGLBoolean (*)(EGLDisplay, EGLSurface, EGLSurface, EGLContext)) resolve("eglMakeCurrent");
+    state.valid = 0;
+    return real(dpy, draw, read, ctx);
+}
+
+__GLXextFuncPtr
+glXGetProcAddressARB(const GLubyte* name)
+{
+    static __GLXextFuncPtr (*real)(const GLubyte*);
+    __GLXextFuncPtr wrapper = find_wrapper((const char*) name);
+    if (wrapper)
+        return wrapper;
+    if (real == NULL)
+        real = (__GLXextFuncPtr (*)(const GLubyte*)) resolve("glXGetProcAddressARB");
+    return real(name);
+}
+
+void
+(*glXGetProcAddress(const GLubyte* name))(void)
+{
+    return glXGetProcAddressARB(name);
+}
+
+__eglMustCastToProperFunctionPointerType
+eglGetProcAddress(const char* name)
+{
+    static __eglMustCastToProperFunctionPointerType (*real)(const char*);
+    __GLXextFuncPtr wrapper = find_wrapper(name);
+    if (wrapper)
+        return (__eglMustCastToProperFunctionPointerType) wrapper;
+    if (real == NULL)
+        real = (__eglMustCastToProperFunctionPointerType (*)(const char*)) resolve("eglGetProcAddress");
+    return real(name);
+}
+
+__attribute__((constructor))
+static void
+glprof_init()
+{
+    const char* path = getenv("GLPROF_OUT");
+
+    out = stderr;
+    if (path && *path && (out = fopen(path, "w")) == NULL)
+    {
+        fprintf(stderr, "glprof: %s: cannot write!\n", path);
+        out = stderr;
+    }
+    if (getenv("GLPROF_EVERY") && atoi(getenv("GLPROF_EVERY")) > 0)
+        every = atoi(getenv("GLPROF_EVERY"));
+    if (getenv("GLPROF_TOP"))
+        top = atoi(getenv("GLPROF_TOP"));
+    pthread_key_create(&thread_key, flush_thread);
+    start_ns = now_ns();
+}
+
+__attribute__((destructor))
+static void
+glprof_exit()
+{
+    char title[64];
+
+    flush_thread(NULL);
+    snprintf(title, sizeof(title), "total, %lu frames", totals.frames);
+    report(title, &totals, (now_ns() - start_ns) / 1e6);
+}
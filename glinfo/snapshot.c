@@ -0,0 +1,391 @@
+#define GL_GLEXT_PROTOTYPES
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <snapshot.h>
+
+enum limit_kind
+{
+    LIMIT_INTEGER,
+    LIMIT_INDEXED,              /* one value per index, glGetInteger64i_v */
+    LIMIT_FLOAT
+};
+
+struct limit
+{
+    const char* name;
+    GLenum pname;
+    int count;
+    enum limit_kind kind;
+};
+
+#define LIMIT(pname)            { #pname, pname, 1, LIMIT_INTEGER }
+#define LIMIT_N(pname, count)   { #pname, pname, count, LIMIT_INTEGER }
+#define LIMIT_I(pname, count)   { #pname, pname, count, LIMIT_INDEXED }
+#define LIMIT_F(pname)          { #pname, pname, 1, LIMIT_FLOAT }
+
+/* Queried whatever the context version: those it does not know raise
+ * GL_INVALID_ENUM and are left out. */
+static const struct limit limits[] =
+{
+    LIMIT(GL_MAX_TEXTURE_SIZE),
+    LIMIT(GL_MAX_3D_TEXTURE_SIZE),
+    LIMIT(GL_MAX_CUBE_MAP_TEXTURE_SIZE),
+    LIMIT(GL_MAX_ARRAY_TEXTURE_LAYERS),
+    LIMIT(GL_MAX_RECTANGLE_TEXTURE_SIZE),
+    LIMIT(GL_MAX_TEXTURE_BUFFER_SIZE),
+    LIMIT_F(GL_MAX_TEXTURE_LOD_BIAS),
+    LIMIT_F(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT),
+    LIMIT(GL_MAX_TEXTURE_IMAGE_UNITS),
+    LIMIT(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS),
+    LIMIT(GL_MAX_RENDERBUFFER_SIZE),
+    LIMIT_N(GL_MAX_VIEWPORT_DIMS, 2),
+    LIMIT(GL_MAX_VIEWPORTS),
+    LIMIT(GL_MAX_FRAMEBUFFER_WIDTH),
+    LIMIT(GL_MAX_FRAMEBUFFER_HEIGHT),
+    LIMIT(GL_MAX_FRAMEBUFFER_LAYERS),
+    LIMIT(GL_MAX_FRAMEBUFFER_SAMPLES),
+    LIMIT(GL_MAX_SAMPLES),
+    LIMIT(GL_MAX_COLOR_TEXTURE_SAMPLES),
+    LIMIT(GL_MAX_DEPTH_TEXTURE_SAMPLES),
+    LIMIT(GL_MAX_INTEGER_SAMPLES),
+    LIMIT(GL_MAX_SAMPLE_MASK_WORDS),
+    LIMIT(GL_MAX_COLOR_ATTACHMENTS),
+    LIMIT(GL_MAX_DRAW_BUFFERS),
+    LIMIT(GL_MAX_DUAL_SOURCE_DRAW_BUFFERS),
+    LIMIT(GL_MAX_CLIP_DISTANCES),
+    LIMIT(GL_MAX_CULL_DISTANCES),
+    LIMIT(GL_MAX_VERTEX_ATTRIBS),
+    LIMIT(GL_MAX_VERTEX_ATTRIB_BINDINGS),
+    LIMIT(GL_MAX_VERTEX_ATTRIB_RELATIVE_OFFSET),
+    LIMIT(GL_MAX_VERTEX_ATTRIB_STRIDE),
+    LIMIT(GL_MAX_ELEMENTS_VERTICES),
+    LIMIT(GL_MAX_ELEMENTS_INDICES),
+    LIMIT(GL_MAX_ELEMENT_INDEX),
+    LIMIT(GL_MAX_VERTEX_UNIFORM_COMPONENTS),
+    LIMIT(GL_MAX_VERTEX_UNIFORM_VECTORS),
+    LIMIT(GL_MAX_VERTEX_UNIFORM_BLOCKS),
+    LIMIT(GL_MAX_VERTEX_OUTPUT_COMPONENTS),
+    LIMIT(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS),
+    LIMIT(GL_MAX_PATCH_VERTICES),
+    LIMIT(GL_MAX_TESS_GEN_LEVEL),
+    LIMIT(GL_MAX_TESS_CONTROL_UNIFORM_COMPONENTS),
+    LIMIT(GL_MAX_TESS_EVALUATION_UNIFORM_COMPONENTS),
+    LIMIT(GL_MAX_GEOMETRY_OUTPUT_VERTICES),
+    LIMIT(GL_MAX_GEOMETRY_TOTAL_OUTPUT_COMPONENTS),
+    LIMIT(GL_MAX_GEOMETRY_UNIFORM_COMPONENTS),
+    LIMIT(GL_MAX_GEOMETRY_TEXTURE_IMAGE_UNITS),
+    LIMIT(GL_MAX_GEOMETRY_SHADER_INVOCATIONS),
+    LIMIT(GL_MAX_FRAGMENT_UNIFORM_COMPONENTS),
+    LIMIT(GL_MAX_FRAGMENT_UNIFORM_VECTORS),
+    LIMIT(GL_MAX_FRAGMENT_UNIFORM_BLOCKS),
+    LIMIT(GL_MAX_FRAGMENT_INPUT_COMPONENTS),
+    LIMIT(GL_MAX_VARYING_COMPONENTS),
+    LIMIT(GL_MAX_VARYING_VECTORS),
+    LIMIT(GL_MAX_PROGRAM_TEXEL_OFFSET),
+    LIMIT(GL_MAX_UNIFORM_LOCATIONS),
+    LIMIT(GL_MAX_UNIFORM_BUFFER_BINDINGS),
+    LIMIT(GL_MAX_UNIFORM_BLOCK_SIZE),
+    LIMIT(GL_MAX_COMBINED_UNIFORM_BLOCKS),
+    LIMIT(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS),
+    LIMIT(GL_MAX_SHADER_STORAGE_BLOCK_SIZE),
+    LIMIT(GL_MAX_COMBINED_SHADER_STORAGE_BLOCKS),
+    LIMIT(GL_MAX_ATOMIC_COUNTER_BUFFER_BINDINGS),
+    LIMIT(GL_MAX_COMBINED_ATOMIC_COUNTERS),
+    LIMIT(GL_MAX_IMAGE_UNITS),
+    LIMIT(GL_MAX_COMBINED_IMAGE_UNIFORMS),
+    LIMIT(GL_MAX_TRANSFORM_FEEDBACK_BUFFERS),
+    LIMIT(GL_MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS),
+    LIMIT(GL_MAX_TRANSFORM_FEEDBACK_SEPARATE_ATTRIBS),
+    LIMIT(GL_MAX_TRANSFORM_FEEDBACK_SEPARATE_COMPONENTS),
+    LIMIT_I(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 3),
+    LIMIT_I(GL_MAX_COMPUTE_WORK_GROUP_SIZE, 3),
+    LIMIT(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS),
+    LIMIT(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE),
+    LIMIT(GL_MAX_COMPUTE_UNIFORM_BLOCKS),
+    LIMIT(GL_MAX_COMPUTE_TEXTURE_IMAGE_UNITS),
+    LIMIT(GL_MAX_SUBROUTINES),
+    LIMIT(GL_MAX_DEBUG_MESSAGE_LENGTH),
+    LIMIT(GL_MAX_LABEL_LENGTH),
+    LIMIT(GL_MAX_SERVER_WAIT_TIMEOUT),
+};
+
+struct named
+{
+    const char* name;
+    GLenum value;
+};
+
+#define NAMED(value)            { #value, value }
+
+/* Sized formats whose multisample counts apps pick render targets by. */
+static const struct named render_formats[] =
+{
+    NAMED(GL_R8),
+    NAMED(GL_RG8),
+    NAMED(GL_RGBA8),
+    NAMED(GL_SRGB8_ALPHA8),
+    NAMED(GL_RGB10_A2),
+    NAMED(GL_R11F_G11F_B10F),
+    NAMED(GL_R16F),
+    NAMED(GL_RG16F),
+    NAMED(GL_RGBA16F),
+    NAMED(GL_R32F),
+    NAMED(GL_RG32F),
+    NAMED(GL_RGBA32F),
+    NAMED(GL_R8UI),
+    NAMED(GL_RGBA8UI),
+    NAMED(GL_R32UI),
+    NAMED(GL_RGBA32UI),
+    NAMED(GL_DEPTH_COMPONENT16),
+    NAMED(GL_DEPTH_COMPONENT24),
+    NAMED(GL_DEPTH_COMPONENT32F),
+    NAMED(GL_DEPTH24_STENCIL8),
+    NAMED(GL_DEPTH32F_STENCIL8),
+    NAMED(GL_STENCIL_INDEX8),
+};
+
+static const struct named fbconfig_attributes[] =
+{
+    NAMED(GLX_FBCONFIG_ID),
+    NAMED(GLX_VISUAL_ID),
+    NAMED(GLX_RENDER_TYPE),
+    NAMED(GLX_DRAWABLE_TYPE),
+    NAMED(GLX_X_RENDERABLE),
+    NAMED(GLX_CONFIG_CAVEAT),
+    NAMED(GLX_DOUBLEBUFFER),
+    NAMED(GLX_STEREO),
+    NAMED(GLX_RED_SIZE),
+    NAMED(GLX_GREEN_SIZE),
+    NAMED(GLX_BLUE_SIZE),
+    NAMED(GLX_ALPHA_SIZE),
+    NAMED(GLX_DEPTH_SIZE),
+    NAMED(GLX_STENCIL_SIZE),
+    NAMED(GLX_SAMPLE_BUFFERS),
+    NAMED(GLX_SAMPLES),
+    NAMED(GLX_FRAMEBUFFER_SRGB_CAPABLE_ARB),
+};
+
+#define COUNT(array)            (sizeof(array) / sizeof((array)[0]))
+
+static void
+clear_errors()
+{
+    while (glGetError() != GL_NO_ERROR)
+        ;
+}
+
+static void
+print_string(FILE* out, const char* value)
+{
+    const char* c;
+    fputc('"', out);
+    for (c = value ? value : ""; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            fputc('\\', out);
+        fputc(*c, out);
+    }
+    fputc('"', out);
+}
+
+static void
+print_field(FILE* out, const char* name, const GLubyte* value)
+{
+    fprintf(out, "    \"%s\": ", name);
+    print_string(out, (const char*) value);
+    fprintf(out, ",\n");
+}
+
+static void
+print_limits(FILE* out)
+{
+    const char* separator = "";
+    unsigned i;
+    int j;
+
+    fprintf(out, "    \"limits\": {");
+    for (i = 0; i < COUNT(limits); i++)
+    {
+        GLint64 values[4] = { 0 };
+        GLfloat value = 0;
+
+        clear_errors();
+        if (limits[i].kind == LIMIT_FLOAT)
+            glGetFloatv(limits[i].pname, &value);
+        else if (limits[i].kind == LIMIT_INDEXED)
+            for (j = 0; j < limits[i].count; j++)
+                glGetInteger64i_v(limits[i].pname, j, &values[j]);
+        else
+            glGetInteger64v(limits[i].pname, values);
+        if (glGetError() != GL_NO_ERROR)
+            continue;
+
+        fprintf(out, "%s\n        \"%s\": ", separator, limits[i].name);
+        separator = ",";
+        if (limits[i].kind == LIMIT_FLOAT)
+            fprintf(out, "%g", value);
+        else if (limits[i].count == 1)
+            fprintf(out, "%lld", (long long) values[0]);
+        else
+            for (j = 0; j < limits[i].count; j++)
+                fprintf(out, "%s%lld%s", j ? ", " : "[", (long long) values[j],
+                        j == limits[i].count - 1 ? "]" : "");
+    }
+    fprintf(out, "\n    },\n");
+}
+
+static void
+print_enum_list(FILE* out, const char* name, GLenum count_pname, GLenum list_pname)
+{
+    GLint count = 0;
+    GLint* values;
+    int i;
+
+    clear_errors();
+    glGetIntegerv(count_pname, &count);
+    if (glGetError() != GL_NO_ERROR || count < 0)
+        count = 0;
+    values = malloc((count + 1) * sizeof(GLint));
+    if (count > 0)
+        glGetIntegerv(list_pname, values);
+
+    fprintf(out, "        \"%s\": [", name);
+    for (i = 0; i < count; i++)
+        fprintf(out, "%s\"0x%04X\"", i ? ", " : "", (unsigned) values[i]);
+    fprintf(out, "]");
+    free(values);
+}
+
+static void
+print_formats(FILE* out, int major, int minor)
+{
+    unsigned i;
+    int j;
+
+    fprintf(out, "    \"formats\": {\n");
+    print_enum_list(out, "compressed_texture", GL_NUM_COMPRESSED_TEXTURE_FORMATS, GL_COMPRESSED_TEXTURE_FORMATS);
+    fprintf(out, ",\n");
+    print_enum_list(out, "program_binary", GL_NUM_PROGRAM_BINARY_FORMATS, GL_PROGRAM_BINARY_FORMATS);
+    fprintf(out, ",\n");
+    print_enum_list(out, "shader_binary", GL_NUM_SHADER_BINARY_FORMATS, GL_SHADER_BINARY_FORMATS);
+
+    /* glGetInternalformativ is GL 4.2 */
+    if (major > 4 || (major == 4 && minor >= 2))
+    {
+        fprintf(out, ",\n        \"renderbuffer_samples\": {");
+        for (i = 0; i < COUNT(render_formats); i++)
+        {
+            GLint count = 0;
+            GLint samples[32];
+
+            clear_errors();
+            glGetInternalformativ(GL_RENDERBUFFER, render_formats[i].value, GL_NUM_SAMPLE_COUNTS, 1, &count);
+            if (count > 32)
+                count = 32;
+            if (count > 0)
+                glGetInternalformativ(GL_RENDERBUFFER, render_formats[i].value, GL_SAMPLES, count, samples);
+            if (glGetError() != GL_NO_ERROR)
+                count = 0;
+
+            fprintf(out, "%s\n            \"%s\": [", i ? "," : "", render_formats[i].name);
+            for (j = 0; j < count; j++)
+                fprintf(out, "%s%d", j ? ", " : "", samples[j]);
+            fprintf(out, "]");
+        }
+        fprintf(out, "\n        }");
+    }
+    fprintf(out, "\n    },\n");
+}
+
+static void
+print_extensions(FILE* out, int major)
+{
+    GLint count = 0;
+    int i;
+
+    fprintf(out, "    \"extensions\": [");
+    if (major >= 3)
+    {
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (i = 0; i < count; i++)
+        {
+            fprintf(out, "%s\n        ", i ? "," : "");
+            print_string(out, (const char*) glGetStringi(GL_EXTENSIONS, i));
+        }
+    }
+    else
+    {
+        /* before 3.0 there is only the space separated string */
+        const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+        const char* c;
+        for (c = extensions; c && *c; )
+        {
+            int length = 0;
+            while (c[length] && c[length] != ' ')
+                length++;
+            if (length > 0)
+                fprintf(out, "%s\n        \"%.*s\"", count++ ? "," : "", length, c);
+            c += length;
+            while (*c == ' ')
+                c++;
+        }
+    }
+    fprintf(out, "\n    ],\n");
+}
+
+static void
+print_fbconfigs(FILE* out, Display* dpy, int screen)
+{
+    GLXFBConfig* configs = NULL;
+    int count = 0;
+    int i;
+    unsigned j;
+
+    if (dpy != NULL)
+        configs = glXGetFBConfigs(dpy, screen, &count);
+
+    fprintf(out, "    \"fbconfigs\": [");
+    for (i = 0; i < count; i++)
+    {
+        const char* separator = "";
+        fprintf(out, "%s\n        {", i ? "," : "");
+        for (j = 0; j < COUNT(fbconfig_attributes); j++)
+        {
+            int value;
+            if (glXGetFBConfigAttrib(dpy, configs[i], fbconfig_attributes[j].value, &value) != Success)
+                continue;
+            fprintf(out, "%s \"%s\": %d", separator, fbconfig_attributes[j].name, value);
+            separator = ",";
+        }
+        fprintf(out, " }");
+    }
+    fprintf(out, "\n    ]\n");
+    if (configs)
+        XFree(configs);
+}
+
+void
+glinfo_snapshot(FILE* out, Display* dpy, int screen)
+{
+    const GLubyte* version = glGetString(GL_VERSION);
+    int major = 0, minor = 0;
+
+    if (version)
+        sscanf((const char*) version, "%d.%d", &major, &minor);
+
+    fprintf(out, "{\n");
+    print_field(out, "vendor", glGetString(GL_VENDOR));
+    print_field(out, "renderer", glGetString(GL_RENDERER));
+    print_field(out, "version", version);
+    print_field(out, "shading_language_version", glGetString(GL_SHADING_LANGUAGE_VERSION));
+    print_limits(out);
+    print_formats(out, major, minor);
+    print_extensions(out, major);
+    print_fbconfigs(out, dpy, screen);
+    fprintf(out, "}\n");
+    clear_errors();
+}
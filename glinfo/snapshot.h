@@ -0,0 +1,15 @@
+#ifndef __SNAPSHOT_H
+#define __SNAPSHOT_H
+
+#include <stdio.h>
+
+#include <GL/glx.h>
+
+/* Writes everything an application would probe at startup as JSON: the
+ * strings, every GL_MAX_* limit, texture and binary formats, the extensions
+ * and, when dpy is not NULL, the GLX FBConfigs of screen. Needs a current
+ * context; glcaps.h reads the result back. */
+void
+glinfo_snapshot(FILE* out, Display* dpy, int screen);
+
+#endif // __SNAPSHOT_H
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <wrap-egl.h>
+#include <EGL/eglext.h>
+
+/* Prefers Mesa's surfaceless platform, which needs neither X nor a GPU
+ * device node, and falls back to the default display. */
+EGLDisplay
+w_eglOpenDisplay()
+{
+    EGLDisplay dpy = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    if (getPlatformDisplay)
+        dpy = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+#endif
+    if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, NULL, NULL))
+    {
+        dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, NULL, NULL))
+        {
+            printf("eglInitialize failure!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return dpy;
+}
+
+/* Desktop GL when the driver has it, OpenGL ES 2.0 otherwise; *gles tells
+ * which one was made current. */
+EGLContext
+w_eglCreatePbufferContext(EGLDisplay dpy, int width, int height, EGLSurface* surface, int* gles)
+{
+    int api;
+    for (api = 0; api < 2; api++)
+    {
+        EGLint config_list[] =
+        {
+            EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, api ? EGL_OPENGL_ES2_BIT : EGL_OPENGL_BIT,
+            EGL_RED_SIZE,        8,
+            EGL_GREEN_SIZE,      8,
+            EGL_BLUE_SIZE,       8,
+            EGL_ALPHA_SIZE,      8,
+            EGL_NONE
+        };
+        EGLint context_list[] =
+        {
+            EGL_CONTEXT_CLIENT_VERSION, 2,
+            EGL_NONE
+        };
+        EGLint surface_list[] =
+        {
+            EGL_WIDTH,  width,
+            EGL_HEIGHT, height,
+            EGL_NONE
+        };
+
+        EGLConfig config;
+        EGLint config_count = 0;
+        if (!eglBindAPI(api ? EGL_OPENGL_ES_API : EGL_OPENGL_API))
+            continue;
+        if (!eglChooseConfig(dpy, config_list, &config, 1, &config_count) || config_count < 1)
+            continue;
+
+        EGLContext ctx = eglCreateContext(dpy, config, EGL_NO_CONTEXT, api ? context_list : NULL);
+        if (ctx == EGL_NO_CONTEXT)
+            continue;
+
+        *surface = eglCreatePbufferSurface(dpy, config, surface_list);
+        if (*surface != EGL_NO_SURFACE && eglMakeCurrent(dpy, *surface, *surface, ctx))
+        {
+            *gles = api;
+            return ctx;
+        }
+        eglDestroyContext(dpy, ctx);
+    }
+
+    printf("eglCreateContext failure!\n");
+    exit(EXIT_FAILURE);
+}
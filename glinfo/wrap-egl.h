@@ -0,0 +1,12 @@
+#ifndef __WRAP_EGL_H
+#define __WRAP_EGL_H
+
+#include <EGL/egl.h>
+
+EGLDisplay
+w_eglOpenDisplay();
+
+EGLContext
+w_eglCreatePbufferContext(EGLDisplay dpy, int width, int height, EGLSurface* surface, int* gles);
+
+#endif // __WRAP_EGL_H
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <time.h>
+
+#include <GL/glew.h>
+
+#include "bench.h"
+
+unsigned long benchDrawCalls = 0;
+
+// The demos are linked with -Wl,--wrap for the GL 1.1 draw entry points, so
+// every draw they issue passes through here before reaching libGL.
+extern "C" {
+void __real_glDrawArrays(GLenum mode, GLint first, GLsizei count);
+void __real_glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices);
+void __real_glEnd();
+
+void __wrap_glDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    benchDrawCalls++;
+    __real_glDrawArrays(mode, first, count);
+}
+
+void __wrap_glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices) {
+    benchDrawCalls++;
+    __real_glDrawElements(mode, count, type, indices);
+}
+
+void __wrap_glEnd() {
+    benchDrawCalls++;
+    __real_glEnd();
+}
+}
+
+// Entry points newer than GL 1.1 are called through GLEW's function pointers,
+// which --wrap cannot see; swap in counting trampolines once glewInit has
+// filled them in.
+#ifdef GLEW_GET_FUN
+static PFNGLDRAWARRAYSINSTANCEDPROC realDrawArraysInstanced;
+static PFNGLDRAWELEMENTSINSTANCEDPROC realDrawElementsInstanced;
+static PFNGLMULTIDRAWARRAYSINDIRECTPROC realMultiDrawArraysIndirect;
+
+static void GLAPIENTRY CountDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    benchDrawCalls++;
+    realDrawArraysInstanced(mode, first, count, instances);
+}
+
+static void GLAPIENTRY CountDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
+                                                  const void *indices, GLsizei instances) {
+    benchDrawCalls++;
+    realDrawElementsInstanced(mode, count, type, indices, instances);
+}
+
+static void GLAPIENTRY CountMultiDrawArraysIndirect(GLenum mode, const void *indirect,
+                                                    GLsizei drawCount, GLsizei stride) {
+    benchDrawCalls++;
+    realMultiDrawArraysIndirect(mode, indirect, drawCount, stride);
+}
+
+void BenchHookGlew() {
+    if (__glewDrawArraysInstanced && !realDrawArraysInstanced) {
+        realDrawArraysInstanced = __glewDrawArraysInstanced;
+        __glewDrawArraysInstanced = CountDrawArraysInstanced;
+    }
+    if (__glewDrawElementsInstanced && !realDrawElementsInstanced) {
+        realDrawElementsInstanced = __glewDrawElementsInstanced;
+        __glewDrawElementsInstanced = CountDrawElementsInstanced;
+    }
+    if (__glewMultiDrawArraysIndirect && !realMultiDrawArraysIndirect) {
+        realMultiDrawArraysIndirect = __glewMultiDrawArraysIndirect;
+        __glewMultiDrawArraysIndirect = CountMultiDrawArraysIndirect;
+    }
+}
+#else
+void BenchHookGlew() {
+}
+#endif
+
+static double ClockMs(clockid_t clock) {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+double BenchWallMs() {
+    return ClockMs(CLOCK_MONOTONIC);
+}
+
+// Process time, so the worker threads of software rasterisers are included.
+double BenchCpuMs() {
+    return ClockMs(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+struct BenchStats {
+    double min, mean, p50, p90, p95, p99, max;
+    double cpuMs;
+    double drawCalls;
+    double fps;
+    double drawCallsPerSec;
+};
+
+static double Percentile(const vector<double> &sorted, double p) {
+    size_t rank = (size_t)(p / 100.0 * sorted.size() + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > sorted.size()) rank = sorted.size();
+    return sorted[rank - 1];
+}
+
+static BenchStats Summarize(const vector<BenchFrame> &frames, double elapsedMs) {
+    BenchStats st = BenchStats();
+    if (frames.empty()) return st;
+    vector<double> wall;
+    double sumWall = 0, sumCpu = 0, sumDraws = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        wall.push_back(frames[i].wallMs);
+        sumWall += frames[i].wallMs;
+        sumCpu += frames[i].cpuMs;
+        sumDraws += frames[i].drawCalls;
+    }
+    sort(wall.begin(), wall.end());
+    st.min = wall.front();
+    st.max = wall.back();
+    st.mean = sumWall / frames.size();
+    st.p50 = Percentile(wall, 50);
+    st.p90 = Percentile(wall, 90);
+    st.p95 = Percentile(wall, 95);
+    st.p99 = Percentile(wall, 99);
+    st.cpuMs = sumCpu / frames.size();
+    st.drawCalls = sumDraws / frames.size();
+    if (elapsedMs > 0) {
+        st.fps = frames.size() * 1000.0 / elapsedMs;
+        st.drawCallsPerSec = sumDraws * 1000.0 / elapsedMs;
+    }
+    return st;
+}
+
+static string Quote(const string &s) {
+    string out = "\"";
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '"' || s[i] == '\\') out += '\\';
+        if ((unsigned char)s[i] >= 0x20) out += s[i];
+    }
+    return out + "\"";
+}
+
+void BenchReport::BeginSection(const string &label) {
+    Section section;
+    section.label = label;
+    section.elapsedMs = 0;
+    sections.push_back(section);
+}
+
+void BenchReport::AddMetric(const string &name, double value) {
+    if (sections.empty()) return;
+    Metric &metric = sections.back().metrics[name];
+    metric.sum += value;
+    metric.count++;
+}
+
+void BenchReport::Print(ostream &out) const {
+    if (sections.empty()) return;
+    const Section &s = sections.back();
+    BenchStats st = Summarize(s.frames, s.elapsedMs);
+    out << fixed << setprecision(3)
+        << s.label << ": " << s.frames.size() << " frames, "
+        << st.fps << " fps, frame ms p50 " << st.p50 << " p90 " << st.p90
+        << " p99 " << st.p99 << ", cpu ms/frame " << st.cpuMs
+        << ", draws/sec " << st.drawCallsPerSec << endl;
+    for (map<string, Metric>::const_iterator it = s.metrics.begin(); it != s.metrics.end(); ++it)
+        out << "    " << it->first << " mean " << it->second.sum / it->second.count
+            << ", per sec " << (s.elapsedMs > 0 ? it->second.sum * 1000.0 / s.elapsedMs : 0) << endl;
+}
+
+bool BenchReport::Write(const string &fileName) const {
+    ofstream file(fileName.c_str(), ios::out | ios::trunc);
+    if (!file.is_open()) return false;
+    file << fixed << setprecision(4) << "{\n";
+    for (map<string, string>::const_iterator it = info.begin(); it != info.end(); ++it)
+        file << "  " << Quote(it->first) << ": " << Quote(it->second) << ",\n";
+    file << "  \"sections\": [";
+    for (size_t i = 0; i < sections.size(); i++) {
+        const Section &s = sections[i];
+        BenchStats st = Summarize(s.frames, s.elapsedMs);
+        file << (i ? "," : "") << "\n    {\n"
+             << "      \"label\": " << Quote(s.label) << ",\n"
+             << "      \"frames\": " << s.frames.size() << ",\n"
+             << "      \"elapsed_ms\": " << s.elapsedMs << ",\n"
+             << "      \"fps\": " << st.fps << ",\n"
+             << "      \"frame_ms\": { \"min\": " << st.min << ", \"mean\": " << st.mean
+             << ", \"p50\": " << st.p50 << ", \"p90\": " << st.p90 << ", \"p95\": " << st.p95
+             << ", \"p99\": " << st.p99 << ", \"max\": " << st.max << " },\n"
+             << "      \"cpu_ms_per_frame\": " << st.cpuMs << ",\n"
+             << "      \"draw_calls_per_frame\": " << st.drawCalls << ",\n"
+             << "      \"draw_calls_per_sec\": " << st.drawCallsPerSec;
+        if (!s.metrics.empty()) {
+            file << ",\n      \"metrics\": {";
+            for (map<string, Metric>::const_iterator it = s.metrics.begin(); it != s.metrics.end(); ++it) {
+                double perSec = s.elapsedMs > 0 ? it->second.sum * 1000.0 / s.elapsedMs : 0;
+                file << (it == s.metrics.begin() ? "" : ",") << "\n        " << Quote(it->first)
+                     << ": { \"mean\": " << it->second.sum / it->second.count
+                     << ", \"per_sec\": " << perSec << " }";
+            }
+            file << "\n      }";
+        }
+        file << "\n    }";
+    }
+    file << "\n  ]\n}\n";
+    return file.good();
+}
@@ -0,0 +1,46 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <map>
+#include <vector>
+#include <iostream>
+#include <string>
+using namespace std;
+
+struct BenchFrame {
+    double wallMs;
+    double cpuMs;
+    unsigned long drawCalls;
+};
+
+class BenchReport {
+    struct Metric {
+        double sum;
+        unsigned long count;
+    };
+    struct Section {
+        string label;
+        vector<BenchFrame> frames;
+        map<string, Metric> metrics;
+        double elapsedMs;
+    };
+    vector<Section> sections;
+    map<string, string> info;
+public:
+    void SetInfo(const string &key, const string &value) { info[key] = value; }
+    void BeginSection(const string &label);
+    void AddFrame(const BenchFrame &frame) { sections.back().frames.push_back(frame); }
+    void EndSection(double elapsedMs) { sections.back().elapsedMs = elapsedMs; }
+    void AddMetric(const string &name, double value);
+    void Print(ostream &out) const; // last section only
+    bool Write(const string &fileName) const;
+};
+
+double BenchWallMs();
+double BenchCpuMs();
+
+// Bumped by the --wrap'ed draw entry points, see bench.cpp.
+extern unsigned long benchDrawCalls;
+void BenchHookGlew();
+
+#endif // BENCH_H
@@ -0,0 +1,204 @@
+// Off-screen stand-in for the part of the GLUT API the demos use. The demos
+// are linked against this file instead of libglut: glutCreateWindow makes an
+// EGL pbuffer context, and glutMainLoop renders a fixed number of frames
+// through the registered display callback, recording frame times, and
+// returns. Every call to glutMainLoop becomes a report section labelled with
+// the current window title.
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/freeglut.h>
+
+#include "bench.h"
+
+static struct HeadlessState {
+    int frames;
+    int warmup;
+    bool finish;
+    string out;
+    unsigned int displayMode;
+    int width, height;
+    int major, minor, profile;
+    string title;
+    void (*display)();
+    EGLDisplay dpy;
+    EGLSurface surface;
+    EGLContext ctx;
+    BenchReport report;
+} hs = { 300, 30, true, "", GLUT_RGBA, 300, 300, 0, 0, 0, "", NULL,
+         EGL_NO_DISPLAY, EGL_NO_SURFACE, EGL_NO_CONTEXT, BenchReport() };
+
+static void Fail(const char *what) {
+    cerr << what << " [ ERROR ] (egl 0x" << hex << eglGetError() << dec << ")" << endl;
+    exit(EXIT_FAILURE);
+}
+
+// Consumes --frames N, --warmup N, --bench-out FILE and --no-finish, leaving
+// the remaining arguments for the demo, the same way glutInit strips -display.
+void glutInit(int *pargc, char **argv) {
+    int kept = 1;
+    for (int i = 1; i < *pargc; i++) {
+        bool hasValue = i + 1 < *pargc;
+        if (!strcmp(argv[i], "--frames") && hasValue) hs.frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--warmup") && hasValue) hs.warmup = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--bench-out") && hasValue) hs.out = argv[++i];
+        else if (!strcmp(argv[i], "--no-finish")) hs.finish = false;
+        else argv[kept++] = argv[i];
+    }
+    *pargc = kept;
+    argv[kept] = NULL;
+    if (hs.out.empty()) {
+        const char *name = strrchr(argv[0], '/');
+        hs.out = string(name ? name + 1 : argv[0]) + ".json";
+    }
+    if (hs.frames < 1) hs.frames = 1;
+    if (hs.warmup < 0) hs.warmup = 0;
+}
+
+void glutInitDisplayMode(unsigned int displayMode) {
+    hs.displayMode = displayMode;
+}
+
+void glutInitWindowPosition(int, int) {
+}
+
+void glutInitWindowSize(int width, int height) {
+    hs.width = width;
+    hs.height = height;
+}
+
+// Like freeglut, only honoured when called before glutCreateWindow.
+void glutInitContextVersion(int majorVersion, int minorVersion) {
+    hs.major = majorVersion;
+    hs.minor = minorVersion;
+}
+
+void glutInitContextProfile(int profile) {
+    hs.profile = profile;
+}
+
+static EGLDisplay OpenDisplay() {
+    EGLDisplay dpy = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+        dpy = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, NULL, NULL)) {
+        dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, NULL, NULL)) return EGL_NO_DISPLAY;
+    }
+    return dpy;
+}
+
+int glutCreateWindow(const char *title) {
+    hs.title = title;
+    hs.dpy = OpenDisplay();
+    if (hs.dpy == EGL_NO_DISPLAY) Fail("egl display");
+    if (!eglBindAPI(EGL_OPENGL_API)) Fail("egl bind api");
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, (hs.displayMode & GLUT_ALPHA) ? 8 : 0,
+        EGL_DEPTH_SIZE, (hs.displayMode & GLUT_DEPTH) ? 24 : 0,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(hs.dpy, configAttribs, &config, 1, &numConfigs) || numConfigs < 1)
+        Fail("egl config");
+
+    vector<EGLint> ctxAttribs;
+    if (hs.major > 0) {
+        ctxAttribs.push_back(EGL_CONTEXT_MAJOR_VERSION);
+        ctxAttribs.push_back(hs.major);
+        ctxAttribs.push_back(EGL_CONTEXT_MINOR_VERSION);
+        ctxAttribs.push_back(hs.minor);
+        ctxAttribs.push_back(EGL_CONTEXT_OPENGL_PROFILE_MASK);
+        ctxAttribs.push_back(hs.profile == GLUT_CORE_PROFILE ?
+                             EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT :
+                             EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT);
+    }
+    ctxAttribs.push_back(EGL_NONE);
+    hs.ctx = eglCreateContext(hs.dpy, config, EGL_NO_CONTEXT, &ctxAttribs[0]);
+    if (hs.ctx == EGL_NO_CONTEXT) Fail("egl context");
+
+    const EGLint surfaceAttribs[] = { EGL_WIDTH, hs.width, EGL_HEIGHT, hs.height, EGL_NONE };
+    hs.surface = eglCreatePbufferSurface(hs.dpy, config, surfaceAttribs);
+    if (hs.surface == EGL_NO_SURFACE) Fail("egl pbuffer");
+    if (!eglMakeCurrent(hs.dpy, hs.surface, hs.surface, hs.ctx)) Fail("egl make current");
+    glViewport(0, 0, hs.width, hs.height);
+
+    ostringstream size;
+    size << hs.width << "x" << hs.height;
+    hs.report.SetInfo("demo", hs.title);
+    hs.report.SetInfo("size", size.str());
+    hs.report.SetInfo("vendor", (const char *) glGetString(GL_VENDOR));
+    hs.report.SetInfo("renderer", (const char *) glGetString(GL_RENDERER));
+    hs.report.SetInfo("version", (const char *) glGetString(GL_VERSION));
+    cerr << "headless context [ OK ] " << glGetString(GL_RENDERER) << endl;
+    return 1;
+}
+
+void glutSetWindowTitle(const char *title) {
+    hs.title = title;
+}
+
+void glutDisplayFunc(void (*callback)()) {
+    hs.display = callback;
+}
+
+// Frames are driven by glutMainLoop, so idle and redisplay requests are moot.
+void glutIdleFunc(void (*)()) {
+}
+
+void glutPostRedisplay() {
+}
+
+// There is no window to close; glutMainLoop simply returns.
+void glutCloseFunc(void (*)()) {
+}
+
+void glutSwapBuffers() {
+    eglSwapBuffers(hs.dpy, hs.surface);
+}
+
+// Metrics reported during warm-up frames are dropped.
+static bool measuring = false;
+
+extern "C" void BenchMetric(const char *name, double value) {
+    if (measuring) hs.report.AddMetric(name, value);
+}
+
+static BenchFrame RunFrame() {
+    BenchFrame frame;
+    unsigned long draws = benchDrawCalls;
+    double wall = BenchWallMs();
+    double cpu = BenchCpuMs();
+    hs.display();
+    if (hs.finish) glFinish();
+    frame.wallMs = BenchWallMs() - wall;
+    frame.cpuMs = BenchCpuMs() - cpu;
+    frame.drawCalls = benchDrawCalls - draws;
+    return frame;
+}
+
+void glutMainLoop() {
+    if (!hs.display) Fail("display callback");
+    BenchHookGlew();
+    for (int i = 0; i < hs.warmup; i++) RunFrame();
+    hs.report.BeginSection(hs.title);
+    measuring = true;
+    double start = BenchWallMs();
+    for (int i = 0; i < hs.frames; i++) hs.report.AddFrame(RunFrame());
+    hs.report.EndSection(BenchWallMs() - start);
+    measuring = false;
+    hs.report.Print(cerr);
+    if (!hs.report.Write(hs.out)) cerr << hs.out << " write [ ERROR ]" << endl;
+}
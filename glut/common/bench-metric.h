@@ -0,0 +1,22 @@
+#ifndef BENCH_METRIC_H
+#define BENCH_METRIC_H
+
+#include <time.h>
+
+// Per-frame figures a demo wants in the benchmark report next to the frame
+// times. BenchMetric is provided by the headless harness in glut/bench; in a
+// normal build it is left unresolved and ReportMetric does nothing.
+extern "C" void BenchMetric(const char *name, double value) __attribute__((weak));
+
+inline void ReportMetric(const char *name, double value) {
+    if (BenchMetric) BenchMetric(name, value);
+}
+
+// For timing the CPU side of a step inside a frame.
+inline double MetricClockMs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+#endif // BENCH_METRIC_H
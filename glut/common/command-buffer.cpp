@@ -0,0 +1,179 @@
+#include <cstring>
+using namespace std;
+
+#include "command-buffer.h"
+#include "gl-state.h"
+
+enum CommandType {
+    CMD_USE_PROGRAM,
+    CMD_BIND_BUFFER,
+    CMD_ATTRIB_POINTER,
+    CMD_UNIFORM_1F,
+    CMD_UNIFORM_3F,
+    CMD_UNIFORM_4F,
+    CMD_DRAW_ARRAYS
+};
+
+static uint32_t FloatWord(GLfloat v) {
+    uint32_t word;
+    memcpy(&word, &v, sizeof(word));
+    return word;
+}
+
+static GLfloat WordFloat(uint32_t word) {
+    GLfloat v;
+    memcpy(&v, &word, sizeof(v));
+    return v;
+}
+
+// Returns room for length argument words after the header.
+uint32_t *CommandBuffer::Packet(int type, int length) {
+    size_t at = words.size();
+    words.resize(at + 1 + length);
+    words[at] = type | length << 8;
+    return &words[at + 1];
+}
+
+void CommandBuffer::UseProgram(GLuint program) {
+    Packet(CMD_USE_PROGRAM, 1)[0] = program;
+}
+
+void CommandBuffer::BindBuffer(GLenum target, GLuint buffer) {
+    uint32_t *args = Packet(CMD_BIND_BUFFER, 2);
+    args[0] = target;
+    args[1] = buffer;
+}
+
+void CommandBuffer::VertexAttribPointer(GLuint index, GLint size, GLenum type, GLsizei stride, GLuint offset) {
+    uint32_t *args = Packet(CMD_ATTRIB_POINTER, 5);
+    args[0] = index;
+    args[1] = size;
+    args[2] = type;
+    args[3] = stride;
+    args[4] = offset;
+}
+
+void CommandBuffer::Uniform1f(GLint location, GLfloat v) {
+    uint32_t *args = Packet(CMD_UNIFORM_1F, 2);
+    args[0] = location;
+    args[1] = FloatWord(v);
+}
+
+void CommandBuffer::Uniform3fv(GLint location, const GLfloat *v) {
+    uint32_t *args = Packet(CMD_UNIFORM_3F, 4);
+    args[0] = location;
+    for (int i = 0; i < 3; i++) args[1 + i] = FloatWord(v[i]);
+}
+
+void CommandBuffer::Uniform4fv(GLint location, const GLfloat *v) {
+    uint32_t *args = Packet(CMD_UNIFORM_4F, 5);
+    args[0] = location;
+    for (int i = 0; i < 4; i++) args[1 + i] = FloatWord(v[i]);
+}
+
+void CommandBuffer::DrawArrays(GLenum mode, GLint first, GLsizei count) {
+    uint32_t *args = Packet(CMD_DRAW_ARRAYS, 3);
+    args[0] = mode;
+    args[1] = first;
+    args[2] = count;
+}
+
+void CommandBuffer::Execute() const {
+    const uint32_t *word = words.data();
+    const uint32_t *end = word + words.size();
+    while (word < end) {
+        int type = *word & 0xFF;
+        int length = *word >> 8;
+        const uint32_t *args = word + 1;
+        switch (type) {
+        case CMD_USE_PROGRAM:
+            glState.UseProgram(args[0]);
+            break;
+        case CMD_BIND_BUFFER:
+            glState.BindBuffer(args[0], args[1]);
+            break;
+        case CMD_ATTRIB_POINTER:
+            glState.EnableVertexAttribArray(args[0]);
+            glState.VertexAttribPointer(args[0], args[1], args[2], GL_FALSE, args[3], (const GLvoid *) (uintptr_t) args[4]);
+            break;
+        case CMD_UNIFORM_1F:
+            glUniform1f(args[0], WordFloat(args[1]));
+            break;
+        case CMD_UNIFORM_3F:
+            glUniform3f(args[0], WordFloat(args[1]), WordFloat(args[2]), WordFloat(args[3]));
+            break;
+        case CMD_UNIFORM_4F:
+            glUniform4f(args[0], WordFloat(args[1]), WordFloat(args[2]), WordFloat(args[3]), WordFloat(args[4]));
+            break;
+        case CMD_DRAW_ARRAYS:
+            glDrawArrays(args[0], args[1], args[2]);
+            break;
+        }
+        word = args + length;
+    }
+}
+
+CommandRecorder::CommandRecorder(int workers):generation(0), pending(0), quit(false), count(0), record(NULL) {
+    if (workers <= 0) workers = max(1u, thread::hardware_concurrency());
+    buffers.resize(workers);
+    for (int i = 1; i < workers; i++)
+        threads.push_back(thread(&CommandRecorder::Work, this, i));
+}
+
+CommandRecorder::~CommandRecorder() {
+    {
+        lock_guard<mutex> lock(m);
+        quit = true;
+    }
+    started.notify_all();
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+}
+
+void CommandRecorder::RecordRange(int worker) {
+    size_t workers = buffers.size();
+    buffers[worker].Clear();
+    record(buffers[worker], count * worker / workers, count * (worker + 1) / workers);
+}
+
+// Workers sleep between frames and wake once per Record call.
+void CommandRecorder::Work(int worker) {
+    unsigned seen = 0;
+    for (;;) {
+        {
+            unique_lock<mutex> lock(m);
+            started.wait(lock, [&] { return quit || generation != seen; });
+            if (quit) return;
+            seen = generation;
+        }
+        RecordRange(worker);
+        lock_guard<mutex> lock(m);
+        if (--pending == 0) finished.notify_one();
+    }
+}
+
+void CommandRecorder::Record(size_t count, RecordFunc record) {
+    {
+        lock_guard<mutex> lock(m);
+        this->count = count;
+        this->record = record;
+        pending = threads.size();
+        generation++;
+    }
+    started.notify_all();
+    RecordRange(0);
+    unique_lock<mutex> lock(m);
+    finished.wait(lock, [&] { return pending == 0; });
+}
+
+void CommandRecorder::Execute() const {
+    for (size_t i = 0; i < buffers.size(); i++)
+        buffers[i].Execute();
+}
+
+size_t CommandRecorder::Bytes() const {
+    size_t bytes = 0;
+    for (size_t i = 0; i < buffers.size(); i++)
+        bytes += buffers[i].Bytes();
+    return bytes;
+}
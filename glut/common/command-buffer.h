@@ -0,0 +1,65 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#include <GL/glew.h>
+
+// Draw and state packets recorded without a GL context and replayed later on
+// the thread that owns one. Packets are a header word (type, length) followed
+// by their arguments, all packed into 32-bit words.
+class CommandBuffer {
+public:
+    void Clear() { words.clear(); }
+    size_t Bytes() const { return words.size() * sizeof(uint32_t); }
+    void UseProgram(GLuint program);
+    void BindBuffer(GLenum target, GLuint buffer);
+    // Enables the attribute too; the pointer is an offset into the bound buffer.
+    void VertexAttribPointer(GLuint index, GLint size, GLenum type, GLsizei stride, GLuint offset);
+    void Uniform1f(GLint location, GLfloat v);
+    void Uniform3fv(GLint location, const GLfloat *v);
+    void Uniform4fv(GLint location, const GLfloat *v);
+    void DrawArrays(GLenum mode, GLint first, GLsizei count);
+    // Issues the packets in order, state through glState.
+    void Execute() const;
+private:
+    uint32_t *Packet(int type, int length);
+    vector<uint32_t> words;
+};
+
+// Splits [0, count) into one contiguous range per worker, records each range
+// into that worker's buffer in parallel and replays the buffers in range
+// order, so the GL sees the same sequence a single thread would record. The
+// calling thread records the first range itself.
+class CommandRecorder {
+public:
+    typedef void (*RecordFunc)(CommandBuffer &commands, size_t begin, size_t end);
+    // workers 0 uses every core.
+    explicit CommandRecorder(int workers = 0);
+    ~CommandRecorder();
+    // Blocks until every range is recorded.
+    void Record(size_t count, RecordFunc record);
+    void Execute() const;
+    size_t Bytes() const;
+    int getWorkers() const { return buffers.size(); }
+private:
+    void RecordRange(int worker);
+    void Work(int worker);
+
+    vector<CommandBuffer> buffers;
+    vector<thread> threads;
+    mutex m;
+    condition_variable started, finished;
+    unsigned generation;
+    int pending;
+    bool quit;
+    size_t count;
+    RecordFunc record;
+};
+
+#endif // COMMAND_BUFFER_H
@@ -0,0 +1,156 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+using namespace std;
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include "bench-metric.h"
+#include "frame-timeline.h"
+#include "shader-reloader.h"
+
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+FrameTimeline frameTimeline;
+
+static void WriteAtExit() {
+    frameTimeline.Write();
+}
+
+FrameTimeline::FrameTimeline():active(false), swapMarked(false), gpuOffset(0), frames(0), collected(0), dropped(0) {
+}
+
+// GL_TIMESTAMP readings are in GPU time; one synchronous reading next to a
+// CPU reading gives the offset used to put both on one axis.
+bool FrameTimeline::Start(const string &traceFile) {
+    if (!(GLEW_VERSION_3_3 || GLEW_ARB_timer_query)) {
+        cerr << "timer queries [ UNSUPPORTED ], no trace" << endl;
+        return false;
+    }
+    this->traceFile = traceFile;
+    glGenQueries(2 * (LATENCY + 1), &queries[0][0]);
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    gpuOffset = MetricClockMs() - gpuNow / 1000000.0;
+    if (GLEW_EXT_disjoint_timer_query) {
+        GLint disjoint;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);     // clears the flag
+    }
+    active = true;
+    atexit(WriteAtExit);
+    cerr << "frame timeline [ OK ] " << traceFile << endl;
+    return true;
+}
+
+void FrameTimeline::BeginFrame() {
+    if (!active) return;
+    int slot = frames % (LATENCY + 1);
+    pending[slot].cpuBegin = MetricClockMs();
+    glQueryCounter(queries[slot][0], GL_TIMESTAMP);
+    swapMarked = false;
+}
+
+// The second query lands after every command of the frame, so the GPU
+// interval covers its execution but not presentation.
+void FrameTimeline::BeginSwap() {
+    if (!active) return;
+    int slot = frames % (LATENCY + 1);
+    glQueryCounter(queries[slot][1], GL_TIMESTAMP);
+    pending[slot].cpuSwap = MetricClockMs();
+    swapMarked = true;
+}
+
+// A display callback that swaps with plain glutSwapBuffers gets a swap of
+// zero length at its end.
+void FrameTimeline::EndFrame() {
+    if (!active) return;
+    if (!swapMarked) BeginSwap();
+    pending[frames % (LATENCY + 1)].cpuEnd = MetricClockMs();
+    frames++;
+    Collect();
+}
+
+// Reads back every frame at least LATENCY frames old without blocking.
+void FrameTimeline::Collect() {
+    bool disjoint = false;
+    if (GLEW_EXT_disjoint_timer_query) {
+        GLint value = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &value);
+        disjoint = value != 0;
+    }
+    while (frames - collected > LATENCY) {
+        int slot = collected % (LATENCY + 1);
+        Frame &frame = pending[slot];
+        GLint available = 0;
+        glGetQueryObjectiv(queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        frame.gpuValid = available && !disjoint;
+        if (frame.gpuValid) {
+            GLuint64 begin, end;
+            glGetQueryObjectui64v(queries[slot][0], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(queries[slot][1], GL_QUERY_RESULT, &end);
+            frame.gpuBegin = begin / 1000000.0 + gpuOffset;
+            frame.gpuEnd = end / 1000000.0 + gpuOffset;
+        } else {
+            dropped++;
+        }
+        done.push_back(frame);
+        collected++;
+    }
+}
+
+static void TraceEvent(ostream &out, bool &first, const char *name, int tid, double begin, double end) {
+    out << (first ? "" : ",\n") << "{\"name\": \"" << name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tid
+        << ", \"ts\": " << begin * 1000.0 << ", \"dur\": " << (end - begin) * 1000.0 << "}";
+    first = false;
+}
+
+// Chrome trace format: complete ("X") events in microseconds, CPU on thread
+// 1 and GPU on thread 2, named through metadata events.
+bool FrameTimeline::Write() const {
+    if (!active) return false;
+    ofstream out(traceFile.c_str());
+    if (!out) {
+        cerr << traceFile << " write [ ERROR ]" << endl;
+        return false;
+    }
+    out << fixed;
+    out.precision(3);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"CPU\"}},\n";
+    out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 2, \"args\": {\"name\": \"GPU\"}}";
+    bool first = false;
+    double origin = done.empty() ? 0 : done[0].cpuBegin;
+    for (size_t i = 0; i < done.size(); i++) {
+        const Frame &frame = done[i];
+        TraceEvent(out, first, "submit", 1, frame.cpuBegin - origin, frame.cpuSwap - origin);
+        TraceEvent(out, first, "swap", 1, frame.cpuSwap - origin, frame.cpuEnd - origin);
+        if (frame.gpuValid)
+            TraceEvent(out, first, "gpu", 2, frame.gpuBegin - origin, frame.gpuEnd - origin);
+    }
+    out << "\n]}\n";
+    cerr << "frame timeline: " << done.size() << " frames, " << dropped << " without gpu times [ "
+         << (out ? "OK" : "ERROR") << " ]" << endl;
+    return bool(out);
+}
+
+static void (*timedDisplay)() = NULL;
+
+static void TimedDisplay() {
+    frameTimeline.BeginFrame();
+    timedDisplay();
+    frameTimeline.EndFrame();
+}
+
+void TimelineDisplayFunc(void (*display)()) {
+    timedDisplay = display;
+    glutDisplayFunc(TimedDisplay);
+}
+
+void TimelineSwapBuffers() {
+    frameTimeline.BeginSwap();
+    shaderReloader.EndFrame();
+    glutSwapBuffers();
+}
@@ -0,0 +1,55 @@
+#ifndef FRAME_TIMELINE_H
+#define FRAME_TIMELINE_H
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <GL/glew.h>
+
+// Per-frame CPU and GPU timestamps, written out as a Chrome trace
+// (chrome://tracing, Perfetto) when the program exits. A frame is split into
+// CPU submit (display callback up to the swap), swap and GPU execution.
+// GPU timestamps come from timer queries that are read back LATENCY frames
+// later; a frame whose queries are still not ready then is dropped rather
+// than waited for.
+class FrameTimeline {
+public:
+    enum { LATENCY = 3 };
+    FrameTimeline();
+    // Starts recording if timer queries are available; needs a context.
+    bool Start(const string &traceFile);
+    bool IsActive() const { return active; }
+    void BeginFrame();
+    void BeginSwap();
+    void EndFrame();
+    bool Write() const;
+private:
+    struct Frame {
+        double cpuBegin, cpuSwap, cpuEnd;
+        double gpuBegin, gpuEnd;
+        bool gpuValid;
+    };
+    void Collect();
+
+    bool active;
+    bool swapMarked;
+    string traceFile;
+    double gpuOffset;           // CPU ms minus GPU ms, sampled at Start
+    GLuint queries[LATENCY + 1][2];
+    Frame pending[LATENCY + 1];
+    unsigned long frames;       // frames begun
+    unsigned long collected;    // frames moved to done
+    unsigned long dropped;
+    vector<Frame> done;
+};
+
+extern FrameTimeline frameTimeline;
+
+// Drop-in replacements for glutDisplayFunc and glutSwapBuffers that feed
+// frameTimeline while it is active. The swap is also the frame boundary
+// where shaderReloader publishes rebuilt programs.
+void TimelineDisplayFunc(void (*display)());
+void TimelineSwapBuffers();
+
+#endif // FRAME_TIMELINE_H
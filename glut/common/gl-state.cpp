@@ -0,0 +1,214 @@
+#include <cstring>
+
+#include "gl-state.h"
+
+GlState glState;
+
+GlState::GlState() {
+    memset(&frame, 0, sizeof(frame));
+    lastFrame = total = frame;
+    frames = 0;
+    Invalidate();
+}
+
+void GlState::Invalidate() {
+    programKnown = false;
+    vaoKnown = false;
+    framebufferKnown = false;
+    for (int i = 0; i < BUFFER_SLOTS; i++) bufferKnown[i] = false;
+    for (int i = 0; i < CAP_SLOTS; i++) capKnown[i] = false;
+    blendKnown = false;
+    clearKnown = false;
+    InvalidateVertexArray();
+}
+
+// Attribute arrays and the element buffer belong to the bound VAO.
+void GlState::InvalidateVertexArray() {
+    memset(attribs, 0, sizeof(attribs));
+    bufferKnown[BufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = false;
+}
+
+bool GlState::Keep(bool same) {
+    if (same) frame.eliminated++;
+    else frame.issued++;
+    return !same;
+}
+
+int GlState::BufferSlot(GLenum target) {
+    switch (target) {
+    case GL_ARRAY_BUFFER: return 0;
+    case GL_ELEMENT_ARRAY_BUFFER: return 1;
+    case GL_DRAW_INDIRECT_BUFFER: return 2;
+    case GL_PIXEL_PACK_BUFFER: return 3;
+    case GL_PIXEL_UNPACK_BUFFER: return 4;
+    default: return -1;
+    }
+}
+
+int GlState::CapSlot(GLenum cap) {
+    switch (cap) {
+    case GL_BLEND: return 0;
+    case GL_DEPTH_TEST: return 1;
+    case GL_CULL_FACE: return 2;
+    case GL_SCISSOR_TEST: return 3;
+    default: return -1;
+    }
+}
+
+void GlState::UseProgram(GLuint program) {
+    if (!Keep(programKnown && this->program == program)) return;
+    glUseProgram(program);
+    programKnown = true;
+    this->program = program;
+}
+
+void GlState::BindBuffer(GLenum target, GLuint buffer) {
+    int slot = BufferSlot(target);
+    if (slot < 0) {
+        Keep(false);
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (!Keep(bufferKnown[slot] && this->buffer[slot] == buffer)) return;
+    glBindBuffer(target, buffer);
+    bufferKnown[slot] = true;
+    this->buffer[slot] = buffer;
+}
+
+void GlState::BindVertexArray(GLuint vao) {
+    if (!Keep(vaoKnown && this->vao == vao)) return;
+    glBindVertexArray(vao);
+    vaoKnown = true;
+    this->vao = vao;
+    InvalidateVertexArray();
+}
+
+void GlState::BindFramebuffer(GLuint framebuffer) {
+    if (!Keep(framebufferKnown && this->framebuffer == framebuffer)) return;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    framebufferKnown = true;
+    this->framebuffer = framebuffer;
+}
+
+void GlState::EnableVertexAttribArray(GLuint index) {
+    if (index < MAX_ATTRIBS) {
+        Attrib &a = attribs[index];
+        if (!Keep(a.enabledKnown && a.enabled)) return;
+        a.enabledKnown = a.enabled = true;
+    } else {
+        Keep(false);
+    }
+    glEnableVertexAttribArray(index);
+}
+
+void GlState::DisableVertexAttribArray(GLuint index) {
+    if (index < MAX_ATTRIBS) {
+        Attrib &a = attribs[index];
+        if (!Keep(a.enabledKnown && !a.enabled)) return;
+        a.enabledKnown = true;
+        a.enabled = false;
+    } else {
+        Keep(false);
+    }
+    glDisableVertexAttribArray(index);
+}
+
+// The source buffer is part of the pointer state, so the comparison needs to
+// know what is bound to GL_ARRAY_BUFFER.
+void GlState::VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                                  GLsizei stride, const GLvoid *pointer) {
+    int slot = BufferSlot(GL_ARRAY_BUFFER);
+    if (index >= MAX_ATTRIBS || !bufferKnown[slot]) {
+        Keep(false);
+        glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+        if (index < MAX_ATTRIBS) attribs[index].pointerKnown = false;
+        return;
+    }
+    Attrib &a = attribs[index];
+    bool same = a.pointerKnown && a.buffer == buffer[slot] && a.size == size && a.type == type &&
+                a.normalized == normalized && a.stride == stride && a.pointer == pointer;
+    if (!Keep(same)) return;
+    glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+    a.pointerKnown = true;
+    a.buffer = buffer[slot];
+    a.size = size;
+    a.type = type;
+    a.normalized = normalized;
+    a.stride = stride;
+    a.pointer = pointer;
+}
+
+void GlState::VertexAttribDivisor(GLuint index, GLuint divisor) {
+    if (index < MAX_ATTRIBS) {
+        Attrib &a = attribs[index];
+        if (!Keep(a.divisorKnown && a.divisor == divisor)) return;
+        a.divisorKnown = true;
+        a.divisor = divisor;
+    } else {
+        Keep(false);
+    }
+    glVertexAttribDivisor(index, divisor);
+}
+
+void GlState::SetCap(GLenum cap, bool enable) {
+    int slot = CapSlot(cap);
+    if (slot >= 0) {
+        if (!Keep(capKnown[slot] && this->cap[slot] == enable)) return;
+        capKnown[slot] = true;
+        this->cap[slot] = enable;
+    } else {
+        Keep(false);
+    }
+    if (enable) glEnable(cap);
+    else glDisable(cap);
+}
+
+void GlState::Enable(GLenum cap) {
+    SetCap(cap, true);
+}
+
+void GlState::Disable(GLenum cap) {
+    SetCap(cap, false);
+}
+
+void GlState::BlendFunc(GLenum sfactor, GLenum dfactor) {
+    if (!Keep(blendKnown && blendSrc == sfactor && blendDst == dfactor)) return;
+    glBlendFunc(sfactor, dfactor);
+    blendKnown = true;
+    blendSrc = sfactor;
+    blendDst = dfactor;
+}
+
+// Per-buffer functions are not shadowed; they also overwrite what BlendFunc
+// set for that buffer, so the next BlendFunc always goes through.
+void GlState::BlendFunci(GLuint buf, GLenum sfactor, GLenum dfactor) {
+    Keep(false);
+    glBlendFunci(buf, sfactor, dfactor);
+    blendKnown = false;
+}
+
+void GlState::ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+    bool same = clearKnown && clearColor[0] == red && clearColor[1] == green &&
+                clearColor[2] == blue && clearColor[3] == alpha;
+    if (!Keep(same)) return;
+    glClearColor(red, green, blue, alpha);
+    clearKnown = true;
+    clearColor[0] = red;
+    clearColor[1] = green;
+    clearColor[2] = blue;
+    clearColor[3] = alpha;
+}
+
+void GlState::EndFrame() {
+    lastFrame = frame;
+    total.issued += frame.issued;
+    total.eliminated += frame.eliminated;
+    frames++;
+    memset(&frame, 0, sizeof(frame));
+}
+
+void GlState::Report(ostream &out) const {
+    if (frames == 0) return;
+    out << "state calls per frame: issued " << (double) total.issued / frames
+        << ", eliminated " << (double) total.eliminated / frames << endl;
+}
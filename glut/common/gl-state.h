@@ -0,0 +1,79 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <iostream>
+using namespace std;
+
+#include <GL/glew.h>
+
+// Shadow copy of the GL state the demos touch every frame. A call that would
+// set a value already in place is dropped before it reaches the driver.
+// Anything changed behind its back must be followed by Invalidate().
+class GlState {
+public:
+    struct Counters {
+        unsigned long issued;
+        unsigned long eliminated;
+    };
+    GlState();
+    void Invalidate();
+    void UseProgram(GLuint program);
+    void BindBuffer(GLenum target, GLuint buffer);
+    void BindVertexArray(GLuint vao);
+    void BindFramebuffer(GLuint framebuffer);
+    void EnableVertexAttribArray(GLuint index);
+    void DisableVertexAttribArray(GLuint index);
+    void VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                             GLsizei stride, const GLvoid *pointer);
+    void VertexAttribDivisor(GLuint index, GLuint divisor);
+    void Enable(GLenum cap);
+    void Disable(GLenum cap);
+    void BlendFunc(GLenum sfactor, GLenum dfactor);
+    void BlendFunci(GLuint buf, GLenum sfactor, GLenum dfactor);
+    void ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+    void EndFrame();
+    const Counters &LastFrame() const { return lastFrame; }
+    void Report(ostream &out) const;
+private:
+    enum { MAX_ATTRIBS = 16, BUFFER_SLOTS = 5, CAP_SLOTS = 4 };
+    struct Attrib {
+        bool enabledKnown;
+        bool enabled;
+        bool pointerKnown;
+        GLuint buffer;
+        GLint size;
+        GLenum type;
+        GLboolean normalized;
+        GLsizei stride;
+        const GLvoid *pointer;
+        bool divisorKnown;
+        GLuint divisor;
+    };
+    bool Keep(bool same);
+    void InvalidateVertexArray();
+    static int BufferSlot(GLenum target);
+    static int CapSlot(GLenum cap);
+    void SetCap(GLenum cap, bool enable);
+
+    bool programKnown;
+    GLuint program;
+    bool vaoKnown;
+    GLuint vao;
+    bool framebufferKnown;
+    GLuint framebuffer;
+    bool bufferKnown[BUFFER_SLOTS];
+    GLuint buffer[BUFFER_SLOTS];
+    Attrib attribs[MAX_ATTRIBS];
+    bool capKnown[CAP_SLOTS];
+    bool cap[CAP_SLOTS];
+    bool blendKnown;
+    GLenum blendSrc, blendDst;
+    bool clearKnown;
+    GLfloat clearColor[4];
+    Counters frame, lastFrame, total;
+    unsigned long frames;
+};
+
+extern GlState glState;
+
+#endif // GL_STATE_H
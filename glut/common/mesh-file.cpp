@@ -0,0 +1,245 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+using namespace std;
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mesh-file.h"
+
+static uint32_t TypeSize(uint32_t type) {
+    switch (type) {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE: return 1;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT: return 2;
+    case GL_DOUBLE: return 8;
+    default: return 4;
+    }
+}
+
+// count elements of elementSize bytes each fit in size bytes, without
+// overflowing on a hostile count.
+static bool Fits(uint64_t count, uint64_t elementSize, uint64_t size) {
+    return elementSize == 0 ? true : count <= size / elementSize;
+}
+
+MeshFile::MeshFile():base(NULL), size(0), header(NULL), attributes(NULL), streams(NULL) {
+}
+
+MeshFile::~MeshFile() {
+    Close();
+}
+
+void MeshFile::Close() {
+    if (base) munmap(base, size);
+    base = NULL;
+    size = 0;
+    header = NULL;
+    attributes = NULL;
+    streams = NULL;
+}
+
+// Checks everything later accessors rely on, so a truncated or foreign file
+// fails here rather than faulting in the middle of an upload.
+bool MeshFile::Open(const string &fileName) {
+    Close();
+    int fd = open(fileName.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(MeshHeader)) {
+        cerr << fileName << " open [ ERROR ]" << endl;
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    size = st.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        cerr << fileName << " mmap [ ERROR ]" << endl;
+        size = 0;
+        return false;
+    }
+    base = (char *) mapping;
+    header = (const MeshHeader *) base;
+    attributes = (const MeshAttribute *) (header + 1);
+    streams = (const MeshStream *) (attributes + header->attributeCount);
+    bool ok = !memcmp(header->magic, "MESH", 4) && header->version == MESH_VERSION
+            && header->attributeCount < 256 && header->streamCount < 256
+            && (const char *) (streams + header->streamCount) <= base + size;
+    for (uint32_t i = 0; ok && i < header->streamCount; i++)
+        ok = streams[i].offset % MESH_ALIGNMENT == 0 && streams[i].offset <= size
+                && streams[i].size <= size - streams[i].offset;
+    for (uint32_t i = 0; ok && i < header->attributeCount; i++) {
+        const MeshAttribute &a = attributes[i];
+        ok = a.stream < header->streamCount && a.name[MESH_NAME_SIZE - 1] == '\0'
+                && streams[a.stream].kind == MESH_STREAM_VERTEX && a.components >= 1 && a.components <= 4
+                && (uint64_t) a.offset + a.components * TypeSize(a.type) <= streams[a.stream].stride;
+    }
+    // The draw calls take the counts as they are, so every stream has to
+    // hold them.
+    uint32_t indexSize = 0;
+    if (ok && header->indexCount > 0) {
+        indexSize = header->indexType == GL_UNSIGNED_SHORT ? 2 : header->indexType == GL_UNSIGNED_INT ? 4 : 0;
+        ok = indexSize != 0 && IndexStream() >= 0;
+    }
+    for (uint32_t i = 0; ok && i < header->streamCount; i++) {
+        if (streams[i].kind == MESH_STREAM_VERTEX)
+            ok = Fits(header->vertexCount, streams[i].stride, streams[i].size);
+        else if (streams[i].kind == MESH_STREAM_INDEX)
+            ok = Fits(header->indexCount, indexSize, streams[i].size);
+        else
+            ok = false;
+    }
+    if (!ok) {
+        cerr << fileName << " mesh [ CORRUPT ]" << endl;
+        Close();
+    }
+    return ok;
+}
+
+const MeshAttribute *MeshFile::FindAttribute(const char *name) const {
+    if (!header) return NULL;
+    for (uint32_t i = 0; i < header->attributeCount; i++)
+        if (!strncmp(attributes[i].name, name, MESH_NAME_SIZE)) return &attributes[i];
+    return NULL;
+}
+
+int MeshFile::IndexStream() const {
+    if (!header) return -1;
+    for (uint32_t i = 0; i < header->streamCount; i++)
+        if (streams[i].kind == MESH_STREAM_INDEX) return i;
+    return -1;
+}
+
+void MeshFile::Prefetch(int stream, uint64_t offset, uint64_t size) const {
+    uint64_t begin = streams[stream].offset + offset;
+    uint64_t aligned = begin / MESH_ALIGNMENT * MESH_ALIGNMENT;
+    madvise(base + aligned, size + (begin - aligned), MADV_WILLNEED);
+}
+
+MeshData::MeshData():vertexCount(0), primitive(GL_TRIANGLES) {
+    for (int i = 0; i < 3; i++) {
+        boundsMin[i] = 0.0f;
+        boundsMax[i] = 0.0f;
+    }
+}
+
+void MeshData::AddAttribute(const char *name, uint32_t stream, uint32_t components, uint32_t type, bool normalized) {
+    if (streams.size() <= stream) streams.resize(stream + 1, VertexStream{ 0, vector<char>() });
+    MeshAttribute attribute;
+    memset(&attribute, 0, sizeof(attribute));
+    strncpy(attribute.name, name, MESH_NAME_SIZE - 1);
+    attribute.stream = stream;
+    attribute.components = components;
+    attribute.type = type;
+    attribute.normalized = normalized;
+    attribute.offset = streams[stream].stride;
+    streams[stream].stride += components * TypeSize(type);
+    attributes.push_back(attribute);
+}
+
+static bool Write(FILE *file, const void *data, size_t size, uint64_t &offset, bool align = false) {
+    static const char zeros[MESH_ALIGNMENT] = {};
+    size_t pad = align ? (MESH_ALIGNMENT - offset % MESH_ALIGNMENT) % MESH_ALIGNMENT : 0;
+    bool ok = fwrite(zeros, 1, pad, file) == pad && fwrite(data, 1, size, file) == size;
+    offset += pad + size;
+    return ok;
+}
+
+bool WriteMeshFile(const string &fileName, const MeshData &mesh) {
+    bool shortIndices = mesh.vertexCount <= 65536;
+    vector<uint16_t> indices16;
+    if (shortIndices) indices16.assign(mesh.indices.begin(), mesh.indices.end());
+
+    MeshHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "MESH", 4);
+    header.version = MESH_VERSION;
+    header.attributeCount = mesh.attributes.size();
+    header.streamCount = mesh.streams.size() + (mesh.indices.empty() ? 0 : 1);
+    header.vertexCount = mesh.vertexCount;
+    header.indexCount = mesh.indices.size();
+    header.indexType = mesh.indices.empty() ? 0 : shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    header.primitive = mesh.primitive;
+    memcpy(header.boundsMin, mesh.boundsMin, sizeof(header.boundsMin));
+    memcpy(header.boundsMax, mesh.boundsMax, sizeof(header.boundsMax));
+
+    vector<MeshStream> streams(header.streamCount);
+    vector<const void *> data(header.streamCount);
+    uint64_t offset = sizeof(header) + mesh.attributes.size() * sizeof(MeshAttribute) + streams.size() * sizeof(MeshStream);
+    for (size_t i = 0; i < streams.size(); i++) {
+        bool index = i == mesh.streams.size();
+        streams[i].kind = index ? MESH_STREAM_INDEX : MESH_STREAM_VERTEX;
+        streams[i].stride = index ? (shortIndices ? 2 : 4) : mesh.streams[i].stride;
+        streams[i].size = index ? header.indexCount * streams[i].stride : mesh.streams[i].data.size();
+        streams[i].offset = (offset + MESH_ALIGNMENT - 1) / MESH_ALIGNMENT * MESH_ALIGNMENT;
+        offset = streams[i].offset + streams[i].size;
+        data[i] = index ? (shortIndices ? (const void *) indices16.data() : (const void *) mesh.indices.data())
+                        : (const void *) mesh.streams[i].data.data();
+    }
+
+    FILE *file = fopen(fileName.c_str(), "wb");
+    bool ok = file != NULL;
+    offset = 0;
+    ok = ok && Write(file, &header, sizeof(header), offset);
+    ok = ok && Write(file, mesh.attributes.data(), mesh.attributes.size() * sizeof(MeshAttribute), offset);
+    ok = ok && Write(file, streams.data(), streams.size() * sizeof(MeshStream), offset);
+    for (size_t i = 0; ok && i < streams.size(); i++)
+        ok = Write(file, data[i], streams[i].size, offset, true);
+    if (file && fclose(file) != 0) ok = false;
+    cerr << fileName << " write [ " << (ok ? "OK" : "ERROR") << " ]" << endl;
+    return ok;
+}
+
+bool ReadMeshFile(const string &fileName, MeshData &mesh) {
+    MeshFile file;
+    if (!file.Open(fileName)) return false;
+    const MeshHeader &header = file.Header();
+    mesh = MeshData();
+    mesh.vertexCount = header.vertexCount;
+    mesh.primitive = header.primitive;
+    memcpy(mesh.boundsMin, header.boundsMin, sizeof(mesh.boundsMin));
+    memcpy(mesh.boundsMax, header.boundsMax, sizeof(mesh.boundsMax));
+
+    // MeshData keeps vertex streams only, so renumber around the index stream.
+    vector<uint32_t> vertexStream(header.streamCount, 0);
+    for (uint32_t i = 0; i < header.streamCount; i++) {
+        const MeshStream &stream = file.Stream(i);
+        if (stream.kind != MESH_STREAM_VERTEX) continue;
+        vertexStream[i] = mesh.streams.size();
+        const char *data = file.StreamData(i);
+        mesh.streams.push_back(MeshData::VertexStream{ stream.stride, vector<char>(data, data + header.vertexCount * stream.stride) });
+    }
+    for (uint32_t i = 0; i < header.attributeCount; i++) {
+        MeshAttribute attribute = file.Attribute(i);
+        attribute.stream = vertexStream[attribute.stream];
+        mesh.attributes.push_back(attribute);
+    }
+
+    int index = file.IndexStream();
+    if (index >= 0) {
+        uint32_t size = header.indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+        mesh.indices.resize(header.indexCount);
+        const char *data = file.StreamData(index);
+        for (uint64_t i = 0; i < header.indexCount; i++) {
+            if (size == 2) {
+                uint16_t value;
+                memcpy(&value, data + i * 2, 2);
+                mesh.indices[i] = value;
+            } else {
+                memcpy(&mesh.indices[i], data + i * 4, 4);
+            }
+        }
+        for (uint64_t i = 0; i < header.indexCount; i++) {
+            if (mesh.indices[i] >= header.vertexCount) {
+                cerr << fileName << " mesh [ CORRUPT ]" << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
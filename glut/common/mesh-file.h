@@ -0,0 +1,111 @@
+#ifndef MESH_FILE_H
+#define MESH_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <GL/glew.h>
+
+// Binary mesh container, laid out so that a mapped file can be handed to GL
+// without parsing or copying:
+//   MeshHeader
+//   MeshAttribute[attributeCount]
+//   MeshStream[streamCount]
+//   stream data, each stream starting on a MESH_ALIGNMENT boundary
+// Little endian. Types, index types and the primitive are GL enums.
+enum {
+    MESH_VERSION = 1,
+    MESH_ALIGNMENT = 4096,      // page aligned, so streams can be madvise'd
+    MESH_NAME_SIZE = 16
+};
+
+enum MeshStreamKind {
+    MESH_STREAM_VERTEX = 0,
+    MESH_STREAM_INDEX = 1
+};
+
+struct MeshHeader {
+    char magic[4];              // "MESH"
+    uint32_t version;
+    uint32_t attributeCount;
+    uint32_t streamCount;
+    uint64_t vertexCount;
+    uint64_t indexCount;        // 0 when drawn with glDrawArrays
+    uint32_t indexType;         // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    uint32_t primitive;
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
+struct MeshAttribute {
+    char name[MESH_NAME_SIZE];  // vertex shader attribute, NUL padded
+    uint32_t stream;
+    uint32_t components;
+    uint32_t type;
+    uint32_t normalized;
+    uint32_t offset;            // within a vertex of the stream
+    uint32_t reserved;          // keeps the stream table 8 byte aligned
+};
+
+struct MeshStream {
+    uint32_t kind;
+    uint32_t stride;
+    uint64_t offset;            // from the start of the file
+    uint64_t size;
+};
+
+// Read-only view of a mesh file through a private mapping. Nothing is read
+// until a stream is touched; Prefetch asks the kernel to start early.
+class MeshFile {
+public:
+    MeshFile();
+    ~MeshFile();
+    bool Open(const string &fileName);
+    void Close();
+    // Header, Attribute, Stream and StreamData need an open file.
+    bool IsOpen() const { return header != NULL; }
+    const MeshHeader &Header() const { return *header; }
+    const MeshAttribute &Attribute(int i) const { return attributes[i]; }
+    const MeshAttribute *FindAttribute(const char *name) const;
+    const MeshStream &Stream(int i) const { return streams[i]; }
+    // -1 when there is none.
+    int IndexStream() const;
+    const char *StreamData(int i) const { return base + streams[i].offset; }
+    void Prefetch(int stream, uint64_t offset, uint64_t size) const;
+    size_t FileSize() const { return size; }
+private:
+    MeshFile(const MeshFile &);
+    MeshFile &operator=(const MeshFile &);
+    char *base;
+    size_t size;
+    const MeshHeader *header;
+    const MeshAttribute *attributes;
+    const MeshStream *streams;
+};
+
+// A mesh being built in memory, for the converters.
+struct MeshData {
+    struct VertexStream {
+        uint32_t stride;
+        vector<char> data;
+    };
+    vector<MeshAttribute> attributes;
+    vector<VertexStream> streams;
+    vector<uint32_t> indices;   // written as GL_UNSIGNED_SHORT when they fit
+    uint64_t vertexCount;
+    uint32_t primitive;
+    float boundsMin[3];
+    float boundsMax[3];
+    MeshData();
+    // Adds an attribute at the end of a vertex of stream, growing its stride.
+    void AddAttribute(const char *name, uint32_t stream, uint32_t components, uint32_t type, bool normalized = false);
+};
+
+bool WriteMeshFile(const string &fileName, const MeshData &mesh);
+// Loads a mesh file back for further processing; indices become 32 bit.
+bool ReadMeshFile(const string &fileName, MeshData &mesh);
+
+#endif // MESH_FILE_H
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+using namespace std;
+
+#include "gl-state.h"
+#include "render-queue.h"
+
+// Below this a single thread sorts faster than several can be woken.
+static const size_t PARALLEL_SORT_MIN = 16384;
+static const int RADIX_BITS = 8;
+static const int RADIX_SIZE = 1 << RADIX_BITS;
+static const int RADIX_PASSES = 64 / RADIX_BITS;
+
+class Barrier {
+public:
+    explicit Barrier(int count):count(count), waiting(0), generation(0) {}
+    void Wait() {
+        unique_lock<mutex> lock(m);
+        int current = generation;
+        if (++waiting == count) {
+            waiting = 0;
+            generation++;
+            cv.notify_all();
+        } else {
+            cv.wait(lock, [&] { return generation != current; });
+        }
+    }
+private:
+    mutex m;
+    condition_variable cv;
+    int count, waiting, generation;
+};
+
+// Shared by the threads for one Sort call. Every thread owns a slice of the
+// input, counts the digits in it, and after the offsets are known scatters
+// the slice into the other buffer, which keeps each pass stable.
+struct RadixSort {
+    size_t n;
+    int threads;
+    uint64_t *keys[2];
+    uint32_t *values[2];
+    vector<size_t> counts;      // [thread][digit]
+    bool skip;
+    int result;                 // which buffer holds the sorted data
+    Barrier barrier;
+    RadixSort(size_t n, int threads):n(n), threads(threads), counts(threads * RADIX_SIZE), barrier(threads) {}
+};
+
+static void RadixWorker(RadixSort *sort, int thread) {
+    size_t begin = sort->n * thread / sort->threads;
+    size_t end = sort->n * (thread + 1) / sort->threads;
+    size_t *counts = &sort->counts[thread * RADIX_SIZE];
+    int from = 0;
+    for (int pass = 0; pass < RADIX_PASSES; pass++) {
+        int shift = pass * RADIX_BITS;
+        const uint64_t *keys = sort->keys[from];
+        fill(counts, counts + RADIX_SIZE, 0);
+        for (size_t i = begin; i < end; i++)
+            counts[(keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+        sort->barrier.Wait();
+        // Turn the counts into scatter offsets: digit major, thread minor. A
+        // pass where every key has the same digit would only copy.
+        if (thread == 0) {
+            size_t offset = 0;
+            sort->skip = false;
+            for (int digit = 0; digit < RADIX_SIZE; digit++) {
+                size_t total = 0;
+                for (int t = 0; t < sort->threads; t++) {
+                    size_t &count = sort->counts[t * RADIX_SIZE + digit];
+                    total += count;
+                    size_t next = offset + count;
+                    count = offset;
+                    offset = next;
+                }
+                if (total == sort->n) sort->skip = true;
+            }
+        }
+        sort->barrier.Wait();
+        if (sort->skip) continue;
+        const uint32_t *values = sort->values[from];
+        uint64_t *keysOut = sort->keys[1 - from];
+        uint32_t *valuesOut = sort->values[1 - from];
+        for (size_t i = begin; i < end; i++) {
+            size_t &offset = counts[(keys[i] >> shift) & (RADIX_SIZE - 1)];
+            keysOut[offset] = keys[i];
+            valuesOut[offset] = values[i];
+            offset++;
+        }
+        from = 1 - from;
+        // Nobody may count the next pass before every slice is scattered.
+        sort->barrier.Wait();
+    }
+    // Every thread skipped the same passes, so they agree on where it ended.
+    if (thread == 0) sort->result = from;
+}
+
+RenderQueue::RenderQueue(int threads):generation(0), pending(0), quit(false), sort(NULL) {
+    if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+    this->threads = threads;
+}
+
+RenderQueue::~RenderQueue() {
+    {
+        lock_guard<mutex> lock(m);
+        quit = true;
+    }
+    started.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+}
+
+// Workers sleep between frames and wake once per parallel Sort call.
+void RenderQueue::Work(int worker) {
+    unsigned seen = 0;
+    for (;;) {
+        {
+            unique_lock<mutex> lock(m);
+            started.wait(lock, [&] { return quit || generation != seen; });
+            if (quit) return;
+            seen = generation;
+        }
+        RadixWorker(sort, worker);
+        lock_guard<mutex> lock(m);
+        if (--pending == 0) finished.notify_one();
+    }
+}
+
+uint64_t RenderQueue::MakeKey(GLuint program, GLuint material, GLuint buffer, GLfloat depth) {
+    uint64_t z = (uint64_t) (min(max(depth, 0.0f), 1.0f) * 0xFFFFFF);
+    return (uint64_t) (program & 0xFF) << 56 |
+           (uint64_t) (material & 0xFFFF) << 40 |
+           (uint64_t) (buffer & 0xFFF) << 28 |
+           z << 4;
+}
+
+// LSD radix sort of the keys, carrying the item indices along.
+void RenderQueue::Sort() {
+    size_t n = items.size();
+    keys.resize(n);
+    keyScratch.resize(n);
+    order.resize(n);
+    orderScratch.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = items[i].key;
+        order[i] = i;
+    }
+    if (n < 2) return;
+    bool parallel = threads > 1 && n >= PARALLEL_SORT_MIN;
+    RadixSort current(n, parallel ? threads : 1);
+    current.keys[0] = &keys[0];
+    current.keys[1] = &keyScratch[0];
+    current.values[0] = &order[0];
+    current.values[1] = &orderScratch[0];
+    if (parallel) {
+        for (int t = workers.size() + 1; t < threads; t++)
+            workers.push_back(thread(&RenderQueue::Work, this, t));
+        {
+            lock_guard<mutex> lock(m);
+            sort = &current;
+            pending = workers.size();
+            generation++;
+        }
+        started.notify_all();
+    }
+    RadixWorker(&current, 0);
+    if (parallel) {
+        unique_lock<mutex> lock(m);
+        finished.wait(lock, [&] { return pending == 0; });
+        sort = NULL;
+    }
+    if (current.result == 1) {
+        keys.swap(keyScratch);
+        order.swap(orderScratch);
+    }
+}
+
+unsigned RenderQueue::Changed(const RenderItem *last, const RenderItem &item) {
+    if (!last) return CHANGE_PROGRAM | CHANGE_MATERIAL | CHANGE_BUFFER;
+    return (item.program != last->program ? CHANGE_PROGRAM : 0) |
+           (item.material != last->material ? CHANGE_MATERIAL : 0) |
+           (item.buffer != last->buffer ? CHANGE_BUFFER : 0);
+}
+
+RenderQueue::Changes RenderQueue::CountChanges() const {
+    Changes changes = { 0, 0, 0 };
+    const RenderItem *last = NULL;
+    for (size_t i = 0; i < items.size(); i++) {
+        const RenderItem &item = Item(i);
+        unsigned changed = Changed(last, item);
+        if (changed & CHANGE_PROGRAM) changes.programs++;
+        if (changed & CHANGE_MATERIAL) changes.materials++;
+        if (changed & CHANGE_BUFFER) changes.buffers++;
+        last = &item;
+    }
+    return changes;
+}
+
+void RenderQueue::Submit(DrawFunc draw) const {
+    const RenderItem *last = NULL;
+    for (size_t i = 0; i < items.size(); i++) {
+        const RenderItem &item = Item(i);
+        unsigned changes = Changed(last, item);
+        if (changes & CHANGE_PROGRAM) glState.UseProgram(item.program);
+        if (changes & CHANGE_BUFFER) glState.BindBuffer(GL_ARRAY_BUFFER, item.buffer);
+        draw(item, changes);
+        last = &item;
+    }
+}
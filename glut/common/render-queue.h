@@ -0,0 +1,85 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#include <GL/glew.h>
+
+// One draw as recorded by the scene. program and buffer are GL names, bound
+// by the queue; material and object mean nothing to the queue and are handed
+// back to the draw callback.
+struct RenderItem {
+    uint64_t key;
+    GLuint program;
+    GLuint material;
+    GLuint buffer;
+    GLfloat depth;
+    GLuint object;
+};
+
+struct RadixSort;
+
+// Draws are collected for a frame, ordered by a 64-bit key so that draws
+// sharing a program, then a material, then a vertex buffer end up next to
+// each other, and submitted in that order.
+class RenderQueue {
+public:
+    enum Change {
+        CHANGE_PROGRAM = 1,
+        CHANGE_MATERIAL = 2,
+        CHANGE_BUFFER = 4
+    };
+    struct Changes {
+        unsigned long programs;
+        unsigned long materials;
+        unsigned long buffers;
+        unsigned long Total() const { return programs + materials + buffers; }
+    };
+    // Called once per item with the Change bits that differ from the item
+    // before it; program and array buffer are already bound.
+    typedef void (*DrawFunc)(const RenderItem &item, unsigned changes);
+
+    // threads 0 uses every core. The sort threads are started by the first
+    // Sort large enough to use them and sleep between frames.
+    explicit RenderQueue(int threads = 0);
+    ~RenderQueue();
+    // Bits 63-56 program, 55-40 material, 39-28 buffer, 27-4 depth in [0, 1]
+    // front to back; fields wider than that are truncated.
+    static uint64_t MakeKey(GLuint program, GLuint material, GLuint buffer, GLfloat depth);
+    void Clear() { items.clear(); order.clear(); }
+    void Push(const RenderItem &item) { items.push_back(item); }
+    size_t Size() const { return items.size(); }
+    void Sort();
+    // Items in submission order.
+    const RenderItem &Item(size_t i) const { return items[order.empty() ? i : order[i]]; }
+    // Change bits between two consecutive items, all of them when last is NULL.
+    static unsigned Changed(const RenderItem *last, const RenderItem &item);
+    Changes CountChanges() const;
+    void Submit(DrawFunc draw) const;
+    int getThreads() const { return threads; }
+private:
+    void Work(int worker);
+
+    int threads;
+    vector<RenderItem> items;
+    // Item indices in submission order, empty until sorted.
+    vector<uint32_t> order;
+    // Sort buffers, kept between frames.
+    vector<uint64_t> keys, keyScratch;
+    vector<uint32_t> orderScratch;
+    // Sort threads 1 to threads - 1; the calling thread is thread 0.
+    vector<thread> workers;
+    mutex m;
+    condition_variable started, finished;
+    unsigned generation;
+    int pending;
+    bool quit;
+    RadixSort *sort;
+};
+
+#endif // RENDER_QUEUE_H
@@ -0,0 +1,403 @@
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+using namespace std;
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <GL/glew.h>
+#include <GL/glx.h>
+#include <EGL/egl.h>
+
+#include "gl-state.h"
+#include "shader-reloader.h"
+
+// The demos link libEGL only when built headless; everywhere else these stay
+// unresolved and the GLX path is taken.
+#pragma weak eglGetCurrentContext
+#pragma weak eglGetCurrentDisplay
+#pragma weak eglQueryContext
+#pragma weak eglChooseConfig
+#pragma weak eglCreateContext
+#pragma weak eglCreatePbufferSurface
+#pragma weak eglMakeCurrent
+#pragma weak eglBindAPI
+#pragma weak eglReleaseThread
+#pragma weak eglDestroyContext
+#pragma weak eglDestroySurface
+
+ShaderReloader shaderReloader;
+
+struct ShaderReloader::Context {
+    bool egl;
+    EGLDisplay eglDisplay;
+    EGLContext eglContext;
+    EGLSurface eglSurface;
+    Display *glxDisplay;
+    GLXContext glxContext;
+    GLXPbuffer glxPbuffer;
+};
+
+// Editors save with several writes or a rename; wait this long for the rest.
+static const int SETTLE_MS = 50;
+
+ShaderReloader::ShaderReloader():active(false), inotifyFd(-1), context(NULL) {
+    wakeFd[0] = wakeFd[1] = -1;
+}
+
+ShaderReloader::~ShaderReloader() {
+    assert(!active && "ShaderReloader::Stop not called");
+}
+
+void ShaderReloader::Stop() {
+    if (!active) return;
+    while (write(wakeFd[1], "q", 1) != 1 && errno == EINTR) {
+    }
+    worker.join();
+    active = false;
+    close(inotifyFd);
+    close(wakeFd[0]);
+    close(wakeFd[1]);
+    inotifyFd = wakeFd[0] = wakeFd[1] = -1;
+    for (size_t i = 0; i < watched.size(); i++) {
+        Watched *w = watched[i];
+        if (w->built) {
+            glDeleteProgram(w->built);
+            glDeleteSync(w->fence);
+        }
+        if (w->published) glDeleteProgram(w->published);
+        delete w;
+    }
+    watched.clear();
+    directories.clear();
+    FreeContext();
+}
+
+bool ShaderReloader::CreateContext() {
+    context = new Context();
+    if (glXGetCurrentContext()) {
+        Display *dpy = glXGetCurrentDisplay();
+        const int attribs[] = { GLX_DRAWABLE_TYPE, GLX_PBUFFER_BIT, GLX_RENDER_TYPE, GLX_RGBA_BIT, None };
+        int count = 0;
+        GLXFBConfig *configs = glXChooseFBConfig(dpy, DefaultScreen(dpy), attribs, &count);
+        if (!configs || count < 1) {
+            FreeContext();
+            return false;
+        }
+        const int pbufferAttribs[] = { GLX_PBUFFER_WIDTH, 1, GLX_PBUFFER_HEIGHT, 1, None };
+        context->glxDisplay = dpy;
+        context->glxPbuffer = glXCreatePbuffer(dpy, configs[0], pbufferAttribs);
+        context->glxContext = glXCreateNewContext(dpy, configs[0], GLX_RGBA_TYPE, glXGetCurrentContext(), True);
+        XFree(configs);
+        if (context->glxPbuffer && context->glxContext) return true;
+        FreeContext();
+        return false;
+    }
+    if (!eglGetCurrentContext || eglGetCurrentContext() == EGL_NO_CONTEXT) {
+        FreeContext();
+        return false;
+    }
+    context->egl = true;
+    context->eglDisplay = eglGetCurrentDisplay();
+    EGLint configId = 0, count = 0;
+    eglQueryContext(context->eglDisplay, eglGetCurrentContext(), EGL_CONFIG_ID, &configId);
+    const EGLint attribs[] = { EGL_CONFIG_ID, configId, EGL_NONE };
+    EGLConfig config;
+    if (!eglChooseConfig(context->eglDisplay, attribs, &config, 1, &count) || count < 1) {
+        FreeContext();
+        return false;
+    }
+    const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    context->eglSurface = eglCreatePbufferSurface(context->eglDisplay, config, pbufferAttribs);
+    context->eglContext = eglCreateContext(context->eglDisplay, config, eglGetCurrentContext(), NULL);
+    if (context->eglSurface != EGL_NO_SURFACE && context->eglContext != EGL_NO_CONTEXT) return true;
+    FreeContext();
+    return false;
+}
+
+// Undoes CreateContext, when the reloader cannot start or once it has
+// stopped; the worker no longer has the context current.
+void ShaderReloader::FreeContext() {
+    if (!context->egl) {
+        if (context->glxContext) glXDestroyContext(context->glxDisplay, context->glxContext);
+        if (context->glxPbuffer) glXDestroyPbuffer(context->glxDisplay, context->glxPbuffer);
+    } else {
+        if (context->eglContext != EGL_NO_CONTEXT) eglDestroyContext(context->eglDisplay, context->eglContext);
+        if (context->eglSurface != EGL_NO_SURFACE) eglDestroySurface(context->eglDisplay, context->eglSurface);
+    }
+    delete context;
+    context = NULL;
+}
+
+// Worker thread.
+bool ShaderReloader::MakeContextCurrent() {
+    if (!context->egl)
+        return glXMakeContextCurrent(context->glxDisplay, context->glxPbuffer, context->glxPbuffer, context->glxContext);
+    eglBindAPI(EGL_OPENGL_API);
+    return eglMakeCurrent(context->eglDisplay, context->eglSurface, context->eglSurface, context->eglContext);
+}
+
+void ShaderReloader::DestroyContext() {
+    if (!context->egl) {
+        glXMakeContextCurrent(context->glxDisplay, None, None, NULL);
+    } else {
+        eglMakeCurrent(context->eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglReleaseThread();
+    }
+}
+
+bool ShaderReloader::Start() {
+    if (active) return true;
+    if (!CreateContext()) {
+        cerr << "shader reload context [ ERROR ]" << endl;
+        return false;
+    }
+    inotifyFd = inotify_init1(IN_CLOEXEC);
+    if (inotifyFd < 0 || pipe(wakeFd) != 0) {
+        cerr << "shader reload inotify [ ERROR ]" << endl;
+        if (inotifyFd >= 0) close(inotifyFd);
+        inotifyFd = -1;
+        FreeContext();
+        return false;
+    }
+    active = true;
+    worker = thread(&ShaderReloader::Run, this);
+    cerr << "shader reload [ OK ]" << endl;
+    return true;
+}
+
+// Directories are watched rather than files, so files replaced by a rename
+// keep being noticed.
+int ShaderReloader::Watch(const vector<GLenum> &types, const vector<string> &fileNames) {
+    if (!active) return 0;
+    Watched *w = new Watched();
+    w->types = types;
+    w->fileNames = fileNames;
+    lock_guard<mutex> lock(m);
+    for (size_t i = 0; i < fileNames.size(); i++) {
+        size_t slash = fileNames[i].rfind('/');
+        string path = slash == string::npos ? "." : fileNames[i].substr(0, slash);
+        bool known = false;
+        for (size_t d = 0; d < directories.size(); d++)
+            known = known || directories[d].path == path;
+        if (known) continue;
+        Directory directory = { inotify_add_watch(inotifyFd, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO), path };
+        if (directory.wd < 0) cerr << path << " watch [ ERROR ]" << endl;
+        else directories.push_back(directory);
+    }
+    watched.push_back(w);
+    return watched.size();
+}
+
+void ShaderReloader::Run() {
+    if (!MakeContextCurrent()) {
+        cerr << "shader reload make current [ ERROR ]" << endl;
+        return;
+    }
+    vector<char> buffer(4096);
+    pollfd fds[2] = { { inotifyFd, POLLIN, 0 }, { wakeFd[0], POLLIN, 0 } };
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) continue;
+        if (fds[1].revents) break;
+        // Collect the burst, then rebuild each affected program once.
+        do {
+            ssize_t size = read(inotifyFd, &buffer[0], buffer.size());
+            lock_guard<mutex> lock(m);
+            for (ssize_t at = 0; at < size;) {
+                const inotify_event *event = (const inotify_event *) &buffer[at];
+                at += sizeof(inotify_event) + event->len;
+                if (!event->len) continue;
+                string path;
+                for (size_t d = 0; d < directories.size(); d++)
+                    if (directories[d].wd == event->wd) path = directories[d].path;
+                string fileName = path == "." ? event->name : path + "/" + event->name;
+                for (size_t i = 0; i < watched.size(); i++)
+                    for (size_t f = 0; f < watched[i]->fileNames.size(); f++)
+                        if (watched[i]->fileNames[f] == fileName) watched[i]->dirty = true;
+            }
+        } while (poll(fds, 1, SETTLE_MS) > 0);
+        vector<Watched *> dirty;
+        {
+            lock_guard<mutex> lock(m);
+            for (size_t i = 0; i < watched.size(); i++)
+                if (watched[i]->dirty) dirty.push_back(watched[i]);
+        }
+        for (size_t i = 0; i < dirty.size(); i++) {
+            dirty[i]->dirty = false;
+            Rebuild(*dirty[i]);
+        }
+    }
+    DestroyContext();
+}
+
+static bool CheckBuild(GLuint object, bool isProgram, const string &what) {
+    GLint status = GL_FALSE, length = 0;
+    if (isProgram) glGetProgramiv(object, GL_LINK_STATUS, &status);
+    else glGetShaderiv(object, GL_COMPILE_STATUS, &status);
+    if (status == GL_TRUE) return true;
+    if (isProgram) glGetProgramiv(object, GL_INFO_LOG_LENGTH, &length);
+    else glGetShaderiv(object, GL_INFO_LOG_LENGTH, &length);
+    vector<char> log(length + 1);
+    if (isProgram) glGetProgramInfoLog(object, log.size(), NULL, &log[0]);
+    else glGetShaderInfoLog(object, log.size(), NULL, &log[0]);
+    cerr << what << " reload [ ERROR ]" << endl << &log[0] << endl;
+    return false;
+}
+
+// Worker thread. The fence makes sure the render context only sees a
+// program once the worker's commands have completed.
+void ShaderReloader::Rebuild(Watched &w) {
+    GLuint program = glCreateProgram();
+    vector<GLuint> shaders;
+    bool ok = true;
+    for (size_t i = 0; i < w.fileNames.size() && ok; i++) {
+        ifstream file(w.fileNames[i].c_str());
+        stringstream source;
+        source << file.rdbuf();
+        string text = source.str();
+        const char *src = text.c_str();
+        GLuint shader = glCreateShader(w.types[i]);
+        glShaderSource(shader, 1, &src, NULL);
+        glCompileShader(shader);
+        glAttachShader(program, shader);
+        shaders.push_back(shader);
+        ok = file && CheckBuild(shader, false, w.fileNames[i]);
+    }
+    if (ok) {
+        glLinkProgram(program);
+        ok = CheckBuild(program, true, "program");
+    }
+    for (size_t i = 0; i < shaders.size(); i++)
+        glDeleteShader(shaders[i]);
+    if (!ok) {
+        glDeleteProgram(program);
+        return;
+    }
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+    lock_guard<mutex> lock(m);
+    if (w.built) {
+        glDeleteProgram(w.built);
+        glDeleteSync(w.fence);
+    }
+    w.built = program;
+    w.fence = fence;
+    cerr << "program reload [ OK ]" << endl;
+}
+
+// Never blocks: a program whose fence has not signalled waits for the next
+// frame.
+void ShaderReloader::EndFrame() {
+    if (!active) return;
+    lock_guard<mutex> lock(m);
+    for (size_t i = 0; i < watched.size(); i++) {
+        Watched &w = *watched[i];
+        if (!w.built) continue;
+        GLenum status = glClientWaitSync(w.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) continue;
+        glDeleteSync(w.fence);
+        if (w.published) glDeleteProgram(w.published);
+        w.published = w.built;
+        w.built = 0;
+    }
+}
+
+GLuint ShaderReloader::Take(int handle) {
+    if (!active || handle <= 0) return 0;
+    GLuint program = watched[handle - 1]->published;
+    watched[handle - 1]->published = 0;
+    return program;
+}
+
+// Only the first element of arrays is carried over, and only for the float,
+// int, bool, unsigned and sampler types.
+void ShaderReloader::CopyUniforms(GLuint from, GLuint to) {
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(to, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(to, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    vector<char> name(maxLength + 1);
+    glState.UseProgram(to);
+    for (GLint i = 0; i < count; i++) {
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(to, i, name.size(), NULL, &size, &type, &name[0]);
+        GLint fromLocation = glGetUniformLocation(from, &name[0]);
+        GLint toLocation = glGetUniformLocation(to, &name[0]);
+        if (fromLocation < 0 || toLocation < 0) continue;
+        GLfloat f[16];
+        GLint n[4];
+        GLuint u[4];
+        switch (type) {
+        case GL_FLOAT: glGetUniformfv(from, fromLocation, f); glUniform1fv(toLocation, 1, f); break;
+        case GL_FLOAT_VEC2: glGetUniformfv(from, fromLocation, f); glUniform2fv(toLocation, 1, f); break;
+        case GL_FLOAT_VEC3: glGetUniformfv(from, fromLocation, f); glUniform3fv(toLocation, 1, f); break;
+        case GL_FLOAT_VEC4: glGetUniformfv(from, fromLocation, f); glUniform4fv(toLocation, 1, f); break;
+        case GL_FLOAT_MAT2: glGetUniformfv(from, fromLocation, f); glUniformMatrix2fv(toLocation, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT3: glGetUniformfv(from, fromLocation, f); glUniformMatrix3fv(toLocation, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT4: glGetUniformfv(from, fromLocation, f); glUniformMatrix4fv(toLocation, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT2x3: glGetUniformfv(from, fromLocation, f); glUniformMatrix2x3fv(toLocation, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT2x4: glGetUniformfv(from, fromLocation, f); glUniformMatrix2x4fv(toLocation, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT3x2: glGetUniformfv(from, fromLocation, f); glUniformMatrix3x2fv(toLocation, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT3x4: glGetUniformfv(from, fromLocation, f); glUniformMatrix3x4fv(toLocation, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT4x2: glGetUniformfv(from, fromLocation, f); glUniformMatrix4x2fv(toLocation, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT4x3: glGetUniformfv(from, fromLocation, f); glUniformMatrix4x3fv(toLocation, 1, GL_FALSE, f); break;
+        // bools are set through the int entry points
+        case GL_INT:
+        case GL_BOOL: glGetUniformiv(from, fromLocation, n); glUniform1iv(toLocation, 1, n); break;
+        case GL_INT_VEC2:
+        case GL_BOOL_VEC2: glGetUniformiv(from, fromLocation, n); glUniform2iv(toLocation, 1, n); break;
+        case GL_INT_VEC3:
+        case GL_BOOL_VEC3: glGetUniformiv(from, fromLocation, n); glUniform3iv(toLocation, 1, n); break;
+        case GL_INT_VEC4:
+        case GL_BOOL_VEC4: glGetUniformiv(from, fromLocation, n); glUniform4iv(toLocation, 1, n); break;
+        case GL_UNSIGNED_INT: glGetUniformuiv(from, fromLocation, u); glUniform1uiv(toLocation, 1, u); break;
+        case GL_UNSIGNED_INT_VEC2: glGetUniformuiv(from, fromLocation, u); glUniform2uiv(toLocation, 1, u); break;
+        case GL_UNSIGNED_INT_VEC3: glGetUniformuiv(from, fromLocation, u); glUniform3uiv(toLocation, 1, u); break;
+        case GL_UNSIGNED_INT_VEC4: glGetUniformuiv(from, fromLocation, u); glUniform4uiv(toLocation, 1, u); break;
+        // samplers hold the texture unit
+        case GL_SAMPLER_1D:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_1D_SHADOW:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_1D_ARRAY:
+        case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_2D_ARRAY_SHADOW:
+        case GL_SAMPLER_CUBE_SHADOW:
+        case GL_SAMPLER_2D_RECT:
+        case GL_SAMPLER_2D_RECT_SHADOW:
+        case GL_SAMPLER_BUFFER:
+        case GL_SAMPLER_2D_MULTISAMPLE:
+        case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+        case GL_INT_SAMPLER_1D:
+        case GL_INT_SAMPLER_2D:
+        case GL_INT_SAMPLER_3D:
+        case GL_INT_SAMPLER_CUBE:
+        case GL_INT_SAMPLER_1D_ARRAY:
+        case GL_INT_SAMPLER_2D_ARRAY:
+        case GL_INT_SAMPLER_2D_RECT:
+        case GL_INT_SAMPLER_BUFFER:
+        case GL_UNSIGNED_INT_SAMPLER_1D:
+        case GL_UNSIGNED_INT_SAMPLER_2D:
+        case GL_UNSIGNED_INT_SAMPLER_3D:
+        case GL_UNSIGNED_INT_SAMPLER_CUBE:
+        case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+        case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+            glGetUniformiv(from, fromLocation, n);
+            glUniform1iv(toLocation, 1, n);
+            break;
+        default:
+            // doubles, images and the like keep the rebuilt program's defaults
+            cerr << &name[0] << " reload [ NOT COPIED ]" << endl;
+            break;
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef SHADER_RELOADER_H
+#define SHADER_RELOADER_H
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#include <GL/glew.h>
+
+// Rebuilds programs when their shader files change. A background thread
+// waits on inotify, reads the changed sources and compiles and links them on
+// its own context, shared with the render context; a program that links is
+// fenced and handed over at the next frame boundary (EndFrame), where the
+// render thread can pick it up with Take. Until then, and for good if the
+// new sources do not build, the old program keeps being used.
+//
+// Under GLX the worker shares the render thread's X display, which needs a
+// thread safe Xlib: libX11 1.8 or later, or XInitThreads before glutInit.
+//
+// Stop must run while that display and the render context are still alive:
+// freeglut closes the display before it calls exit, so the demos stop the
+// reloader from glutCloseFunc as well as after glutMainLoop returns.
+class ShaderReloader {
+public:
+    ShaderReloader();
+    ~ShaderReloader();
+    // Needs the render context current; false when no shared context or
+    // inotify is available, and Watch then does nothing.
+    bool Start();
+    // Render thread, with the render context current. Joins the worker and
+    // destroys its context; anything not yet taken is dropped.
+    void Stop();
+    bool IsActive() const { return active; }
+    // Returns a handle for Take, 0 when not active.
+    int Watch(const vector<GLenum> &types, const vector<string> &fileNames);
+    // Render thread, once per frame after the last draw.
+    void EndFrame();
+    // The rebuilt program for handle published by the last EndFrame, or 0.
+    // The caller owns it from then on.
+    GLuint Take(int handle);
+    // Carries uniform values over to a rebuilt program; leaves to bound.
+    static void CopyUniforms(GLuint from, GLuint to);
+private:
+    struct Watched {
+        vector<GLenum> types;
+        vector<string> fileNames;
+        bool dirty;             // worker only
+        GLuint built;           // linked by the worker, guarded by m
+        GLsync fence;
+        GLuint published;       // render thread only
+    };
+    struct Directory {
+        int wd;
+        string path;
+    };
+    void Run();
+    void Rebuild(Watched &watched);
+    bool CreateContext();
+    bool MakeContextCurrent();
+    void DestroyContext();
+    void FreeContext();
+
+    bool active;
+    int inotifyFd;
+    int wakeFd[2];
+    thread worker;
+    mutex m;
+    vector<Watched *> watched;
+    vector<Directory> directories;
+    struct Context;
+    Context *context;
+};
+
+extern ShaderReloader shaderReloader;
+
+#endif // SHADER_RELOADER_H
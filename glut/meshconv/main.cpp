@@ -0,0 +1,423 @@
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bench-metric.h"
+#include "mesh-file.h"
+#include "optimize.h"
+
+// Builds mesh files (mesh-file.h) for the demos:
+//   meshconv input.obj output.mesh
+//       positions go to stream 0, normals and texture coordinates, when the
+//       OBJ has them, interleaved to stream 1; faces are triangulated as fans
+//       and identical v/vt/vn corners share one vertex
+//   meshconv --grid TRIANGLES output.mesh|output.obj
+//       a rippled grid of at least TRIANGLES triangles, for load tests
+//   meshconv --bench [--cold] file.mesh [file.obj]
+//       load time of the mapped mesh against read() into memory and against
+//       parsing the OBJ; --cold drops the files from the page cache first
+//   meshconv --optimize [--cache N] [--threshold T] input.obj|input.mesh output.mesh
+//       indexes the vertices and reorders triangles and vertices for the
+//       post-transform cache (optimize.h), reporting the simulated ACMR and
+//       ATVR of an N entry FIFO (16 by default) after each step
+
+struct Corner {
+    int v, t, n;
+    bool operator==(const Corner &o) const { return v == o.v && t == o.t && n == o.n; }
+};
+
+struct CornerHash {
+    size_t operator()(const Corner &c) const {
+        return ((size_t) c.v * 0x9e3779b1u) ^ ((size_t) c.t * 0x85ebca6bu) ^ ((size_t) c.n * 0xc2b2ae35u);
+    }
+};
+
+class ObjReader {
+public:
+    bool Load(const string &fileName, MeshData &mesh);
+private:
+    void Face(const char *p, const char *end);
+    const char *ParseCorner(const char *p, const char *end, Corner &corner) const;
+    uint32_t Vertex(const Corner &corner);
+    void Forget(size_t first);
+    vector<float> positions, normals, texcoords;
+    vector<Corner> corners;     // in vertex order
+    vector<int> plain;          // position index -> vertex, for v-only corners
+    unordered_map<Corner, uint32_t, CornerHash> shared;
+    vector<uint32_t> indices;
+    vector<uint32_t> face;
+};
+
+static int ResolveIndex(long index, size_t count) {
+    return index < 0 ? (int) (count + index) : (int) index - 1;
+}
+
+// strtol and strtof stop only at a character that cannot continue the
+// number, which may lie past the end of the mapping when the file does not
+// end in a newline; numbers are copied out first so they never look beyond
+// end.
+static const int NUMBER_SIZE = 64;
+
+static const char *CopyNumber(const char *p, const char *end, char (&number)[NUMBER_SIZE]) {
+    size_t length = min((size_t) (end - p), (size_t) NUMBER_SIZE - 1);
+    memcpy(number, p, length);
+    number[length] = '\0';
+    return number;
+}
+
+static const char *ParseLong(const char *p, const char *end, long &value) {
+    char number[NUMBER_SIZE], *next;
+    value = strtol(CopyNumber(p, end, number), &next, 10);
+    return p + (next - number);
+}
+
+static const char *ParseFloat(const char *p, const char *end, float &value) {
+    char number[NUMBER_SIZE], *next;
+    value = strtof(CopyNumber(p, end, number), &next);
+    return p + (next - number);
+}
+
+const char *ObjReader::ParseCorner(const char *p, const char *end, Corner &corner) const {
+    long index;
+    p = ParseLong(p, end, index);
+    corner.v = ResolveIndex(index, positions.size() / 3);
+    corner.t = corner.n = -1;
+    if (p < end && *p == '/') {
+        p++;
+        if (p < end && *p != '/') {
+            p = ParseLong(p, end, index);
+            corner.t = ResolveIndex(index, texcoords.size() / 2);
+        }
+        if (p < end && *p == '/') {
+            p = ParseLong(p + 1, end, index);
+            corner.n = ResolveIndex(index, normals.size() / 3);
+        }
+    }
+    return p;
+}
+
+uint32_t ObjReader::Vertex(const Corner &corner) {
+    if (corner.t < 0 && corner.n < 0) {
+        if (plain.size() <= (size_t) corner.v) plain.resize(corner.v + 1, -1);
+        if (plain[corner.v] < 0) {
+            plain[corner.v] = corners.size();
+            corners.push_back(corner);
+        }
+        return plain[corner.v];
+    }
+    auto found = shared.insert(make_pair(corner, (uint32_t) corners.size()));
+    if (found.second) corners.push_back(corner);
+    return found.first->second;
+}
+
+// Drops the vertices made since corners had first entries, so a face that
+// turns out to be invalid leaves nothing behind.
+void ObjReader::Forget(size_t first) {
+    for (size_t i = first; i < corners.size(); i++) {
+        if (corners[i].t < 0 && corners[i].n < 0) plain[corners[i].v] = -1;
+        else shared.erase(corners[i]);
+    }
+    corners.resize(first);
+}
+
+void ObjReader::Face(const char *p, const char *end) {
+    face.clear();
+    size_t first = corners.size();
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        if (p == end || *p == '\n' || *p == '\r' || *p == '#') break;
+        Corner corner;
+        p = ParseCorner(p, end, corner);
+        if (corner.v < 0 || (size_t) corner.v >= positions.size() / 3) {
+            Forget(first);
+            return;
+        }
+        face.push_back(Vertex(corner));
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\n') p++;
+    }
+    for (size_t i = 2; i < face.size(); i++) {
+        indices.push_back(face[0]);
+        indices.push_back(face[i - 1]);
+        indices.push_back(face[i]);
+    }
+}
+
+static void ParseFloats(const char *p, const char *end, int count, vector<float> &out) {
+    for (int i = 0; i < count; i++) {
+        float value;
+        p = ParseFloat(p, end, value);
+        out.push_back(value);
+    }
+}
+
+bool ObjReader::Load(const string &fileName, MeshData &mesh) {
+    int fd = open(fileName.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        cerr << fileName << " open [ ERROR ]" << endl;
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    void *mapping = st.st_size ? mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        cerr << fileName << " mmap [ ERROR ]" << endl;
+        return false;
+    }
+    madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+    const char *p = (const char *) mapping;
+    const char *end = p + st.st_size;
+    while (p < end) {
+        const char *eol = (const char *) memchr(p, '\n', end - p);
+        if (!eol) eol = end;
+        if (p[0] == 'v' && p + 1 < eol && p[1] == ' ') ParseFloats(p + 2, eol, 3, positions);
+        else if (p[0] == 'v' && p + 2 < eol && p[1] == 'n' && p[2] == ' ') ParseFloats(p + 3, eol, 3, normals);
+        else if (p[0] == 'v' && p + 2 < eol && p[1] == 't' && p[2] == ' ') ParseFloats(p + 3, eol, 2, texcoords);
+        else if (p[0] == 'f' && p + 1 < eol && p[1] == ' ') Face(p + 2, eol);
+        p = eol + 1;
+    }
+    munmap(mapping, st.st_size);
+
+    bool hasNormals = false, hasTexcoords = false;
+    for (size_t i = 0; i < corners.size(); i++) {
+        hasNormals = hasNormals || corners[i].n >= 0;
+        hasTexcoords = hasTexcoords || corners[i].t >= 0;
+    }
+    mesh.AddAttribute("position", 0, 3, GL_FLOAT);
+    if (hasNormals) mesh.AddAttribute("normal", 1, 3, GL_FLOAT);
+    if (hasTexcoords) mesh.AddAttribute("texcoord", 1, 2, GL_FLOAT);
+    mesh.vertexCount = corners.size();
+    for (size_t s = 0; s < mesh.streams.size(); s++) mesh.streams[s].data.resize(corners.size() * mesh.streams[s].stride);
+
+    float *position = (float *) mesh.streams[0].data.data();
+    float *attributes = hasNormals || hasTexcoords ? (float *) mesh.streams[1].data.data() : NULL;
+    for (int i = 0; i < 3; i++) {
+        mesh.boundsMin[i] = corners.empty() ? 0.0f : HUGE_VALF;
+        mesh.boundsMax[i] = corners.empty() ? 0.0f : -HUGE_VALF;
+    }
+    for (size_t c = 0; c < corners.size(); c++) {
+        const Corner &corner = corners[c];
+        for (int i = 0; i < 3; i++) {
+            float x = positions[corner.v * 3 + i];
+            *position++ = x;
+            mesh.boundsMin[i] = min(mesh.boundsMin[i], x);
+            mesh.boundsMax[i] = max(mesh.boundsMax[i], x);
+        }
+        if (hasNormals)
+            for (int i = 0; i < 3; i++)
+                *attributes++ = corner.n >= 0 && (size_t) corner.n < normals.size() / 3 ? normals[corner.n * 3 + i] : 0.0f;
+        if (hasTexcoords)
+            for (int i = 0; i < 2; i++)
+                *attributes++ = corner.t >= 0 && (size_t) corner.t < texcoords.size() / 2 ? texcoords[corner.t * 2 + i] : 0.0f;
+    }
+    mesh.indices.swap(indices);
+    return true;
+}
+
+// side x side quads, two triangles each, in row order.
+static void BuildGrid(uint64_t triangles, MeshData &mesh) {
+    uint32_t side = (uint32_t) ceil(sqrt(triangles / 2.0));
+    uint32_t row = side + 1;
+    mesh.AddAttribute("position", 0, 3, GL_FLOAT);
+    mesh.vertexCount = (uint64_t) row * row;
+    mesh.streams[0].data.resize(mesh.vertexCount * mesh.streams[0].stride);
+    float *position = (float *) mesh.streams[0].data.data();
+    for (uint32_t y = 0; y < row; y++) {
+        for (uint32_t x = 0; x < row; x++) {
+            float fx = -1.0f + 2.0f * x / side;
+            float fy = -1.0f + 2.0f * y / side;
+            *position++ = fx;
+            *position++ = fy;
+            *position++ = 0.05f * sinf(fx * 20.0f) * cosf(fy * 20.0f);
+        }
+    }
+    mesh.indices.resize((uint64_t) side * side * 6);
+    uint32_t *index = mesh.indices.data();
+    for (uint32_t y = 0; y < side; y++) {
+        for (uint32_t x = 0; x < side; x++) {
+            uint32_t v = y * row + x;
+            uint32_t quad[] = { v, v + 1, v + row, v + row, v + 1, v + row + 1 };
+            index = copy(quad, quad + 6, index);
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        mesh.boundsMin[i] = -1.0f;
+        mesh.boundsMax[i] = 1.0f;
+    }
+    mesh.boundsMin[2] = -0.05f;
+    mesh.boundsMax[2] = 0.05f;
+}
+
+static bool WriteObj(const string &fileName, const MeshData &mesh) {
+    FILE *file = fopen(fileName.c_str(), "w");
+    if (!file) {
+        cerr << fileName << " write [ ERROR ]" << endl;
+        return false;
+    }
+    const float *position = (const float *) mesh.streams[0].data.data();
+    for (uint64_t i = 0; i < mesh.vertexCount; i++, position += 3)
+        fprintf(file, "v %.6f %.6f %.6f\n", position[0], position[1], position[2]);
+    for (size_t i = 0; i < mesh.indices.size(); i += 3)
+        fprintf(file, "f %u %u %u\n", mesh.indices[i] + 1, mesh.indices[i + 1] + 1, mesh.indices[i + 2] + 1);
+    bool ok = fclose(file) == 0;
+    cerr << fileName << " write [ " << (ok ? "OK" : "ERROR") << " ]" << endl;
+    return ok;
+}
+
+static void Evict(const string &fileName) {
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+// Reads every byte, the way the driver's copy into the buffer object would.
+static uint64_t Checksum(const char *data, uint64_t size) {
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        sum += word;
+    }
+    return sum;
+}
+
+static int Bench(const string &meshName, const string &objName, bool cold) {
+    uint64_t sum = 0;
+    if (cold) Evict(meshName);
+    double start = MetricClockMs();
+    MeshFile mesh;
+    if (!mesh.Open(meshName)) return EXIT_FAILURE;
+    for (uint32_t i = 0; i < mesh.Header().streamCount; i++) {
+        mesh.Prefetch(i, 0, mesh.Stream(i).size);
+        sum += Checksum(mesh.StreamData(i), mesh.Stream(i).size);
+    }
+    double mappedMs = MetricClockMs() - start;
+    double megabytes = mesh.FileSize() / 1048576.0;
+    uint64_t triangles = (mesh.Header().indexCount ? mesh.Header().indexCount : mesh.Header().vertexCount) / 3;
+    mesh.Close();
+
+    if (cold) Evict(meshName);
+    start = MetricClockMs();
+    FILE *file = fopen(meshName.c_str(), "rb");
+    vector<char> buffer;
+    if (file) {
+        fseek(file, 0, SEEK_END);
+        buffer.resize(ftell(file));
+        fseek(file, 0, SEEK_SET);
+        if (fread(buffer.data(), 1, buffer.size(), file) != buffer.size()) buffer.clear();
+        fclose(file);
+    }
+    sum += Checksum(buffer.data(), buffer.size());
+    double readMs = MetricClockMs() - start;
+
+    cout << meshName << ": " << triangles << " triangles, " << megabytes << " MB" << (cold ? ", cold cache" : "") << endl;
+    cout << "  mmap          " << mappedMs << " ms (" << megabytes / (mappedMs / 1000.0) << " MB/s)" << endl;
+    cout << "  read + copy   " << readMs << " ms (" << megabytes / (readMs / 1000.0) << " MB/s)" << endl;
+    if (!objName.empty()) {
+        if (cold) Evict(objName);
+        start = MetricClockMs();
+        MeshData parsed;
+        ObjReader reader;
+        if (!reader.Load(objName, parsed)) return EXIT_FAILURE;
+        double parseMs = MetricClockMs() - start;
+        cout << "  obj parse     " << parseMs << " ms (" << parseMs / mappedMs << "x mmap)" << endl;
+    }
+    return sum == 1 ? EXIT_FAILURE : EXIT_SUCCESS;     // keeps the sums alive
+}
+
+static bool EndsWith(const string &s, const char *suffix) {
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+static void ReportCache(const char *step, const MeshData &mesh, int cacheSize) {
+    CacheStats stats = SimulateCache(mesh.indices, mesh.vertexCount, cacheSize);
+    cerr << "  " << step << ": " << mesh.vertexCount << " vertices, ACMR " << stats.acmr << ", ATVR " << stats.atvr << endl;
+}
+
+static int Optimize(int argc, char **argv) {
+    int cacheSize = 16;
+    float threshold = 1.05f;
+    int arg = 2;
+    for (; arg + 1 < argc && !strncmp(argv[arg], "--", 2); arg += 2) {
+        if (!strcmp(argv[arg], "--cache")) cacheSize = max(3, atoi(argv[arg + 1]));
+        else if (!strcmp(argv[arg], "--threshold")) threshold = strtof(argv[arg + 1], NULL);
+        else break;
+    }
+    if (argc != arg + 2) return EXIT_FAILURE;
+    string in = argv[arg];
+    MeshData mesh;
+    ObjReader reader;
+    if (!(EndsWith(in, ".mesh") ? ReadMeshFile(in, mesh) : reader.Load(in, mesh))) return EXIT_FAILURE;
+    if (mesh.primitive != GL_TRIANGLES) {
+        cerr << in << " optimize [ UNSUPPORTED ] primitive is not GL_TRIANGLES" << endl;
+        return EXIT_FAILURE;
+    }
+
+    cerr << in << ": " << (mesh.indices.empty() ? mesh.vertexCount : mesh.indices.size()) / 3 << " triangles, "
+         << cacheSize << " entry cache" << endl;
+    double start = MetricClockMs();
+    if (mesh.indices.empty()) {
+        // As drawn with glDrawArrays: every corner is its own vertex.
+        CacheStats stats = { 3.0, mesh.vertexCount ? 1.0 : 0.0 };
+        cerr << "  unindexed: " << mesh.vertexCount << " vertices, ACMR " << stats.acmr << ", ATVR " << stats.atvr << endl;
+    } else {
+        ReportCache("input", mesh, cacheSize);
+    }
+    IndexVertices(mesh);
+    ReportCache("indexed", mesh, cacheSize);
+    vector<uint32_t> boundaries;
+    OptimizeVertexCache(mesh.indices, mesh.vertexCount, cacheSize, &boundaries);
+    ReportCache("vertex cache", mesh, cacheSize);
+    size_t clusters = OptimizeOverdraw(mesh, boundaries, cacheSize, threshold);
+    cerr << "  overdraw: " << clusters << " clusters" << endl;
+    ReportCache("overdraw", mesh, cacheSize);
+    OptimizeVertexFetch(mesh);
+    ReportCache("vertex fetch", mesh, cacheSize);
+    cerr << "  " << MetricClockMs() - start << " ms" << endl;
+    return WriteMeshFile(argv[arg + 1], mesh) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 3 && !strcmp(argv[1], "--bench")) {
+        bool cold = !strcmp(argv[2], "--cold");
+        int first = cold ? 3 : 2;
+        if (argc <= first) return EXIT_FAILURE;
+        return Bench(argv[first], argc > first + 1 ? argv[first + 1] : "", cold);
+    }
+    if (argc >= 4 && !strcmp(argv[1], "--optimize")) return Optimize(argc, argv);
+    if (argc == 4 && !strcmp(argv[1], "--grid")) {
+        MeshData mesh;
+        BuildGrid(strtoull(argv[2], NULL, 10), mesh);
+        string out = argv[3];
+        bool ok = EndsWith(out, ".obj") ? WriteObj(out, mesh) : WriteMeshFile(out, mesh);
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (argc == 3) {
+        MeshData mesh;
+        ObjReader reader;
+        double start = MetricClockMs();
+        if (!reader.Load(argv[1], mesh)) return EXIT_FAILURE;
+        cerr << argv[1] << ": " << mesh.vertexCount << " vertices, " << mesh.indices.size() / 3 << " triangles in "
+             << MetricClockMs() - start << " ms" << endl;
+        return WriteMeshFile(argv[2], mesh) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    cerr << "usage: meshconv input.obj output.mesh" << endl
+         << "       meshconv --grid TRIANGLES output.mesh|output.obj" << endl
+         << "       meshconv --bench [--cold] file.mesh [file.obj]" << endl
+         << "       meshconv --optimize [--cache N] [--threshold T] input.obj|input.mesh output.mesh" << endl;
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+using namespace std;
+
+#include "optimize.h"
+
+CacheStats SimulateCache(const vector<uint32_t> &indices, uint64_t vertexCount, int cacheSize) {
+    // A vertex is still cached while fewer than cacheSize misses followed it.
+    vector<uint64_t> inserted(vertexCount, 0);
+    vector<bool> used(vertexCount, false);
+    uint64_t time = cacheSize + 1;
+    uint64_t misses = 0, referenced = 0;
+    for (size_t i = 0; i < indices.size(); i++) {
+        uint32_t v = indices[i];
+        if (time - inserted[v] > (uint64_t) cacheSize) {
+            inserted[v] = time++;
+            misses++;
+        }
+        if (!used[v]) {
+            used[v] = true;
+            referenced++;
+        }
+    }
+    CacheStats stats;
+    stats.acmr = indices.empty() ? 0.0 : (double) misses / (indices.size() / 3);
+    stats.atvr = referenced ? (double) misses / referenced : 0.0;
+    return stats;
+}
+
+static uint64_t HashVertex(const MeshData &mesh, uint32_t v) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t s = 0; s < mesh.streams.size(); s++) {
+        const unsigned char *p = (const unsigned char *) mesh.streams[s].data.data() + (size_t) v * mesh.streams[s].stride;
+        for (uint32_t i = 0; i < mesh.streams[s].stride; i++) hash = (hash ^ p[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static bool SameVertex(const MeshData &mesh, uint32_t a, uint32_t b) {
+    for (size_t s = 0; s < mesh.streams.size(); s++) {
+        uint32_t stride = mesh.streams[s].stride;
+        const char *data = mesh.streams[s].data.data();
+        if (memcmp(data + (size_t) a * stride, data + (size_t) b * stride, stride)) return false;
+    }
+    return true;
+}
+
+// Keeps the vertices listed in order, in that order, across all streams.
+static void KeepVertices(MeshData &mesh, const vector<uint32_t> &order) {
+    for (size_t s = 0; s < mesh.streams.size(); s++) {
+        uint32_t stride = mesh.streams[s].stride;
+        vector<char> data(order.size() * stride);
+        for (size_t i = 0; i < order.size(); i++)
+            memcpy(&data[i * stride], &mesh.streams[s].data[(size_t) order[i] * stride], stride);
+        mesh.streams[s].data.swap(data);
+    }
+    mesh.vertexCount = order.size();
+}
+
+void IndexVertices(MeshData &mesh) {
+    uint64_t n = mesh.vertexCount;
+    size_t tableSize = 1;
+    while (tableSize < n * 2) tableSize *= 2;
+    vector<uint32_t> table(tableSize, UINT32_MAX);
+    vector<uint32_t> remap(n);
+    vector<uint32_t> unique;
+    for (uint32_t v = 0; v < n; v++) {
+        size_t slot = HashVertex(mesh, v) & (tableSize - 1);
+        while (table[slot] != UINT32_MAX && !SameVertex(mesh, table[slot], v)) slot = (slot + 1) & (tableSize - 1);
+        if (table[slot] == UINT32_MAX) {
+            table[slot] = v;
+            remap[v] = unique.size();
+            unique.push_back(v);
+        } else {
+            remap[v] = remap[table[slot]];
+        }
+    }
+    if (mesh.indices.empty()) {
+        mesh.indices = remap;
+    } else {
+        for (size_t i = 0; i < mesh.indices.size(); i++) mesh.indices[i] = remap[mesh.indices[i]];
+    }
+    KeepVertices(mesh, unique);
+}
+
+// Tipsify. Emits all remaining triangles around a fanning vertex, then moves
+// to the candidate that will still be in the cache after its own remaining
+// triangles are emitted, preferring the one that entered it first; with no
+// such candidate it backtracks through recently used vertices (the dead-end
+// stack) and finally scans for any vertex with triangles left.
+void OptimizeVertexCache(vector<uint32_t> &indices, uint64_t vertexCount, int cacheSize,
+                         vector<uint32_t> *hardBoundaries) {
+    size_t triangles = indices.size() / 3;
+    vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < indices.size(); i++) offsets[indices[i] + 1]++;
+    for (uint64_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+    vector<uint32_t> adjacency(indices.size());
+    vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++) adjacency[fill[indices[i]]++] = i / 3;
+
+    vector<uint32_t> live(vertexCount);
+    for (uint64_t v = 0; v < vertexCount; v++) live[v] = offsets[v + 1] - offsets[v];
+    vector<uint64_t> cacheTime(vertexCount, 0);
+    vector<bool> emitted(triangles, false);
+    vector<uint32_t> deadEnd;
+    vector<uint32_t> candidates;
+    vector<uint32_t> result;
+    result.reserve(indices.size());
+    uint64_t time = cacheSize + 1;
+    uint64_t cursor = 0;
+
+    if (hardBoundaries) hardBoundaries->clear();
+    int64_t fan = vertexCount ? 0 : -1;
+    while (fan >= 0) {
+        candidates.clear();
+        for (uint32_t a = offsets[fan]; a < offsets[fan + 1]; a++) {
+            uint32_t t = adjacency[a];
+            if (emitted[t]) continue;
+            for (int c = 0; c < 3; c++) {
+                uint32_t v = indices[t * 3 + c];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - cacheTime[v] > (uint64_t) cacheSize) cacheTime[v] = time++;
+            }
+            emitted[t] = true;
+        }
+
+        int64_t best = -1;
+        int64_t bestPriority = -1;
+        for (size_t i = 0; i < candidates.size(); i++) {
+            uint32_t v = candidates[i];
+            if (!live[v]) continue;
+            int64_t priority = 0;
+            if (time - cacheTime[v] + 2 * live[v] <= (uint64_t) cacheSize) priority = time - cacheTime[v];
+            if (priority > bestPriority) {
+                best = v;
+                bestPriority = priority;
+            }
+        }
+        if (best < 0) {
+            while (!deadEnd.empty() && best < 0) {
+                uint32_t v = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[v]) best = v;
+            }
+            while (best < 0 && cursor < vertexCount) {
+                if (live[cursor]) best = cursor;
+                cursor++;
+            }
+            if (best >= 0 && hardBoundaries) hardBoundaries->push_back(result.size() / 3);
+        }
+        fan = best;
+    }
+    if (hardBoundaries && (hardBoundaries->empty() || hardBoundaries->front() != 0))
+        hardBoundaries->insert(hardBoundaries->begin(), 0);
+    indices.swap(result);
+}
+
+struct Cluster {
+    uint32_t begin, end;    // triangles
+    float sortKey;
+};
+
+static void Position(const MeshData &mesh, const MeshAttribute &position, uint32_t v, float out[3]) {
+    const MeshData::VertexStream &stream = mesh.streams[position.stream];
+    memcpy(out, &stream.data[(size_t) v * stream.stride + position.offset], 3 * sizeof(float));
+}
+
+// Misses of triangles [begin, end) with a cache that starts out empty.
+static uint64_t ClusterMisses(const vector<uint32_t> &indices, uint32_t begin, uint32_t end, int cacheSize,
+                              vector<uint64_t> &inserted, uint64_t &time) {
+    uint64_t misses = 0;
+    time += cacheSize + 1;
+    for (size_t i = begin * 3; i < end * 3; i++) {
+        uint32_t v = indices[i];
+        if (time - inserted[v] > (uint64_t) cacheSize) {
+            inserted[v] = time++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+size_t OptimizeOverdraw(MeshData &mesh, const vector<uint32_t> &hardBoundaries, int cacheSize, float threshold) {
+    const MeshAttribute *position = NULL;
+    for (size_t i = 0; i < mesh.attributes.size(); i++)
+        if (!strcmp(mesh.attributes[i].name, "position")) position = &mesh.attributes[i];
+    uint32_t triangles = mesh.indices.size() / 3;
+    if (!position || position->type != GL_FLOAT || position->components < 3 || !triangles) return 1;
+
+    // Soft boundaries: a hard cluster is cut wherever the part since the last
+    // cut, on a cold cache, is within threshold of the whole cluster's ACMR.
+    vector<Cluster> clusters;
+    vector<uint64_t> inserted(mesh.vertexCount, 0);
+    uint64_t time = 0;
+    for (size_t h = 0; h < hardBoundaries.size(); h++) {
+        uint32_t begin = hardBoundaries[h];
+        uint32_t end = h + 1 < hardBoundaries.size() ? hardBoundaries[h + 1] : triangles;
+        double limit = threshold * ClusterMisses(mesh.indices, begin, end, cacheSize, inserted, time) / (end - begin);
+        uint32_t start = begin;
+        uint64_t misses = 0;
+        time += cacheSize + 1;
+        for (uint32_t t = begin; t < end; t++) {
+            for (int c = 0; c < 3; c++) {
+                uint32_t v = mesh.indices[t * 3 + c];
+                if (time - inserted[v] > (uint64_t) cacheSize) {
+                    inserted[v] = time++;
+                    misses++;
+                }
+            }
+            if (t + 1 < end && (double) misses / (t + 1 - start) <= limit) {
+                clusters.push_back(Cluster{ start, t + 1, 0.0f });
+                start = t + 1;
+                misses = 0;
+                time += cacheSize + 1;
+            }
+        }
+        clusters.push_back(Cluster{ start, end, 0.0f });
+    }
+
+    // Area weighted centroids and normals; clusters whose normal points away
+    // from the mesh centroid are more likely to occlude the rest.
+    vector<float> centroids(clusters.size() * 3, 0.0f), normals(clusters.size() * 3, 0.0f);
+    double meshCentroid[3] = { 0.0, 0.0, 0.0 };
+    double meshArea = 0.0;
+    for (size_t c = 0; c < clusters.size(); c++) {
+        double area = 0.0;
+        for (uint32_t t = clusters[c].begin; t < clusters[c].end; t++) {
+            float p[3][3];
+            for (int k = 0; k < 3; k++) Position(mesh, *position, mesh.indices[t * 3 + k], p[k]);
+            float e1[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+            float e2[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+            float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            float a = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int k = 0; k < 3; k++) {
+                centroids[c * 3 + k] += a * (p[0][k] + p[1][k] + p[2][k]) / 3.0f;
+                normals[c * 3 + k] += n[k];
+            }
+            area += a;
+        }
+        for (int k = 0; k < 3; k++) {
+            meshCentroid[k] += centroids[c * 3 + k];
+            if (area > 0.0) centroids[c * 3 + k] /= area;
+        }
+        meshArea += area;
+    }
+    for (int k = 0; k < 3; k++) if (meshArea > 0.0) meshCentroid[k] /= meshArea;
+    for (size_t c = 0; c < clusters.size(); c++) {
+        const float *n = &normals[c * 3];
+        float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        float key = 0.0f;
+        for (int k = 0; k < 3; k++) key += (centroids[c * 3 + k] - (float) meshCentroid[k]) * n[k];
+        clusters[c].sortKey = length > 0.0f ? key / length : 0.0f;
+    }
+    stable_sort(clusters.begin(), clusters.end(), [](const Cluster &a, const Cluster &b) { return a.sortKey > b.sortKey; });
+
+    vector<uint32_t> sorted;
+    sorted.reserve(mesh.indices.size());
+    for (size_t c = 0; c < clusters.size(); c++)
+        sorted.insert(sorted.end(), mesh.indices.begin() + clusters[c].begin * 3, mesh.indices.begin() + clusters[c].end * 3);
+    mesh.indices.swap(sorted);
+    return clusters.size();
+}
+
+void OptimizeVertexFetch(MeshData &mesh) {
+    vector<uint32_t> remap(mesh.vertexCount, UINT32_MAX);
+    vector<uint32_t> order;
+    for (size_t i = 0; i < mesh.indices.size(); i++) {
+        uint32_t &v = mesh.indices[i];
+        if (remap[v] == UINT32_MAX) {
+            remap[v] = order.size();
+            order.push_back(v);
+        }
+        v = remap[v];
+    }
+    KeepVertices(mesh, order);
+}
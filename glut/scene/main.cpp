@@ -0,0 +1,302 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include "bench-metric.h"
+#include "command-buffer.h"
+#include "frame-timeline.h"
+#include "gl-state.h"
+#include "render-queue.h"
+
+// Many small shapes, each drawn with one of a few programs, one of many
+// materials (a color uniform) and one of a few vertex buffers, recorded in
+// scene order. With --order sorted the render queue groups them by state
+// before submission. With --record N the draws are recorded by N threads
+// into command buffers and replayed on the display thread.
+enum { PROGRAMS = 3, MATERIALS = 64, SHAPES = 4 };
+
+const char *vsSrc =
+        "#version 120\n"
+        "attribute vec2 coord2d;"
+        "uniform vec3 placement;"
+        "uniform float depth;"
+        "void main(void) {"
+        "   gl_Position = vec4(coord2d * placement.z + placement.xy, depth * 2.0 - 1.0, 1.0);"
+        "}";
+
+const char *fsSrc[PROGRAMS] = {
+        "#version 120\n"
+        "uniform vec4 color;"
+        "void main(void) {"
+        "   gl_FragColor = color;"
+        "}",
+        "#version 120\n"
+        "uniform vec4 color;"
+        "void main(void) {"
+        "   gl_FragColor = color * (0.75 + 0.25 * sin(gl_FragCoord.x * 0.5));"
+        "}",
+        "#version 120\n"
+        "uniform vec4 color;"
+        "void main(void) {"
+        "   gl_FragColor = color * (0.75 + 0.25 * sin(length(gl_FragCoord.xy) * 0.25));"
+        "}",
+};
+
+struct SceneProgram {
+    GLuint id;
+    GLint coord2d;
+    GLint placement;
+    GLint depth;
+    GLint color;
+};
+
+struct SceneObject {
+    int program;
+    GLuint material;
+    int shape;
+    GLfloat placement[3];
+    GLfloat depth;
+};
+
+SceneProgram programs[PROGRAMS];
+GLuint shapeBuffers[SHAPES];
+GLsizei shapeVertices[SHAPES];
+GLfloat materials[MATERIALS][4];
+vector<SceneObject> objects;
+RenderQueue *queue;
+bool sorted = true;
+CommandRecorder *recorder = NULL;
+int frame = 0;
+
+GLuint CreateShader(const GLenum type, const char *src) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &src, NULL);
+    glCompileShader(shader);
+    GLint compileOk = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compileOk);
+    if (compileOk == GL_FALSE) {
+        return 0;
+    }
+    return shader;
+}
+
+GLuint CreateProgram(const char *fs) {
+    GLuint prog = glCreateProgram();
+    glAttachShader(prog, CreateShader(GL_VERTEX_SHADER, vsSrc));
+    glAttachShader(prog, CreateShader(GL_FRAGMENT_SHADER, fs));
+    glLinkProgram(prog);
+    GLint linkOk;
+    glGetProgramiv(prog, GL_LINK_STATUS, &linkOk);
+    if (!linkOk) {
+        return 0;
+    }
+    return prog;
+}
+
+GLfloat Random(GLfloat low, GLfloat high) {
+    return low + (high - low) * (rand() / (GLfloat) RAND_MAX);
+}
+
+// Objects are listed in creation order, the way a scene graph would walk
+// them, so consecutive objects rarely share any state.
+void BuildScene(int count) {
+    srand(1);
+    objects.resize(count);
+    for (int i = 0; i < count; i++) {
+        SceneObject &object = objects[i];
+        object.program = rand() % PROGRAMS;
+        object.material = rand() % MATERIALS;
+        object.shape = rand() % SHAPES;
+        object.placement[0] = Random(-0.95f, 0.95f);
+        object.placement[1] = Random(-0.95f, 0.95f);
+        object.placement[2] = Random(0.01f, 0.05f);
+        object.depth = Random(0.0f, 1.0f);
+    }
+}
+
+// The per-object work of a frame: every object wobbles around its place.
+void PlaceObject(const SceneObject &object, size_t index, GLfloat placement[3]) {
+    GLfloat phase = frame * 0.05f + index * 0.618f;
+    placement[0] = object.placement[0] + 0.01f * sin(phase);
+    placement[1] = object.placement[1] + 0.01f * cos(phase);
+    placement[2] = object.placement[2] * (1.0f + 0.1f * sin(phase * 0.5f));
+}
+
+void DrawObject(const RenderItem &item, unsigned changes) {
+    const SceneObject &object = objects[item.object];
+    const SceneProgram &program = programs[object.program];
+    if (changes & (RenderQueue::CHANGE_PROGRAM | RenderQueue::CHANGE_MATERIAL))
+        glUniform4fv(program.color, 1, materials[item.material]);
+    if (changes & (RenderQueue::CHANGE_PROGRAM | RenderQueue::CHANGE_BUFFER)) {
+        glState.EnableVertexAttribArray(program.coord2d);
+        glState.VertexAttribPointer(program.coord2d, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    }
+    GLfloat placement[3];
+    PlaceObject(object, item.object, placement);
+    glUniform3fv(program.placement, 1, placement);
+    glUniform1f(program.depth, object.depth);
+    glDrawArrays(GL_TRIANGLES, 0, shapeVertices[object.shape]);
+}
+
+// Same packets as Submit and DrawObject issue directly. Each range starts
+// with no state assumed, since another thread recorded what precedes it.
+void RecordObjects(CommandBuffer &commands, size_t begin, size_t end) {
+    const RenderItem *last = NULL;
+    for (size_t i = begin; i < end; i++) {
+        const RenderItem &item = queue->Item(i);
+        const SceneObject &object = objects[item.object];
+        const SceneProgram &program = programs[object.program];
+        unsigned changes = RenderQueue::Changed(last, item);
+        if (changes & RenderQueue::CHANGE_PROGRAM)
+            commands.UseProgram(item.program);
+        if (changes & RenderQueue::CHANGE_BUFFER)
+            commands.BindBuffer(GL_ARRAY_BUFFER, item.buffer);
+        if (changes & (RenderQueue::CHANGE_PROGRAM | RenderQueue::CHANGE_MATERIAL))
+            commands.Uniform4fv(program.color, materials[item.material]);
+        if (changes & (RenderQueue::CHANGE_PROGRAM | RenderQueue::CHANGE_BUFFER))
+            commands.VertexAttribPointer(program.coord2d, 2, GL_FLOAT, 0, 0);
+        GLfloat placement[3];
+        PlaceObject(object, item.object, placement);
+        commands.Uniform3fv(program.placement, placement);
+        commands.Uniform1f(program.depth, object.depth);
+        commands.DrawArrays(GL_TRIANGLES, 0, shapeVertices[object.shape]);
+        last = &item;
+    }
+}
+
+RenderQueue::Changes unsortedChanges, sortedChanges;
+
+void display() {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    queue->Clear();
+    for (size_t i = 0; i < objects.size(); i++) {
+        const SceneObject &object = objects[i];
+        RenderItem item;
+        item.program = programs[object.program].id;
+        item.material = object.material;
+        item.buffer = shapeBuffers[object.shape];
+        item.depth = object.depth;
+        item.object = i;
+        item.key = RenderQueue::MakeKey(item.program, item.material, item.buffer, item.depth);
+        queue->Push(item);
+    }
+    unsortedChanges = queue->CountChanges();
+    if (sorted) {
+        double start = MetricClockMs();
+        queue->Sort();
+        ReportMetric("sort_ms", MetricClockMs() - start);
+    }
+    sortedChanges = queue->CountChanges();
+    ReportMetric("state_changes_unsorted", unsortedChanges.Total());
+    ReportMetric("state_changes_submitted", sortedChanges.Total());
+    if (recorder) {
+        double start = MetricClockMs();
+        recorder->Record(queue->Size(), RecordObjects);
+        double recorded = MetricClockMs();
+        recorder->Execute();
+        ReportMetric("record_ms", recorded - start);
+        ReportMetric("replay_ms", MetricClockMs() - recorded);
+        ReportMetric("command_bytes", recorder->Bytes());
+    } else {
+        queue->Submit(DrawObject);
+    }
+    frame++;
+    glState.EndFrame();
+    TimelineSwapBuffers();
+}
+
+// Triangle lists around the origin with unit radius.
+void InitShapes() {
+    const GLfloat triangle[] = { 0, 1, -0.87f, -0.5f, 0.87f, -0.5f };
+    const GLfloat square[] = { -0.7f, -0.7f, 0.7f, -0.7f, -0.7f, 0.7f, -0.7f, 0.7f, 0.7f, -0.7f, 0.7f, 0.7f };
+    const GLfloat diamond[] = { 0, -1, 0.6f, 0, 0, 1, 0, 1, -0.6f, 0, 0, -1 };
+    const GLfloat arrow[] = { 0, 1, -0.8f, 0, 0.8f, 0, -0.3f, 0, 0.3f, 0, -0.3f, -1, -0.3f, -1, 0.3f, 0, 0.3f, -1 };
+    const GLfloat *data[SHAPES] = { triangle, square, diamond, arrow };
+    const GLsizeiptr sizes[SHAPES] = { sizeof(triangle), sizeof(square), sizeof(diamond), sizeof(arrow) };
+    glGenBuffers(SHAPES, shapeBuffers);
+    for (int i = 0; i < SHAPES; i++) {
+        shapeVertices[i] = sizes[i] / (2 * sizeof(GLfloat));
+        glState.BindBuffer(GL_ARRAY_BUFFER, shapeBuffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, sizes[i], data[i], GL_STATIC_DRAW);
+    }
+}
+
+void init() {
+    for (int i = 0; i < PROGRAMS; i++) {
+        SceneProgram &program = programs[i];
+        program.id = CreateProgram(fsSrc[i]);
+        program.coord2d = glGetAttribLocation(program.id, "coord2d");
+        program.placement = glGetUniformLocation(program.id, "placement");
+        program.depth = glGetUniformLocation(program.id, "depth");
+        program.color = glGetUniformLocation(program.id, "color");
+    }
+    for (int i = 0; i < MATERIALS; i++) {
+        materials[i][0] = (i & 3) / 3.0f;
+        materials[i][1] = ((i >> 2) & 3) / 3.0f;
+        materials[i][2] = ((i >> 4) & 3) / 3.0f;
+        materials[i][3] = 1.0f;
+    }
+    InitShapes();
+    glState.ClearColor(0.0, 0.0, 0.0, 1.0);
+    glState.Enable(GL_DEPTH_TEST);
+}
+
+int main(int argc, char** argv) {
+    glutInit(&argc, argv);
+    const char *traceFile = NULL;
+    int count = 10000;
+    int threads = 0;
+    int workers = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--objects") && i + 1 < argc) {
+            count = max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--order") && i + 1 < argc) {
+            sorted = strcmp(argv[++i], "submit") != 0;
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--record") && i + 1 < argc) {
+            workers = max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            traceFile = argv[++i];
+        }
+    }
+    glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH);
+    glutInitWindowPosition(100, 200);
+    glutInitWindowSize(640, 480);
+    glutCreateWindow("scene");
+    // Headless there is no X display for a GLX-built GLEW, which reports so
+    // only after it has loaded the GL entry points.
+    GLenum glewStat = glewInit();
+    if (glewStat != GLEW_OK && glewStat != GLEW_ERROR_NO_GLX_DISPLAY) {
+        cerr << glewGetErrorString(glewStat) << endl;
+        return EXIT_FAILURE;
+    }
+    init();
+    if (traceFile) frameTimeline.Start(traceFile);
+    BuildScene(count);
+    queue = new RenderQueue(threads);
+    string title = string("scene ") + (sorted ? "sorted " : "submit ") + to_string(count);
+    if (workers > 0) {
+        recorder = new CommandRecorder(workers);
+        title += " record " + to_string(workers);
+    }
+    glutSetWindowTitle(title.c_str());
+    TimelineDisplayFunc(display);
+    glutIdleFunc(glutPostRedisplay);
+    glutMainLoop();
+    cerr << "state changes per frame: submission order " << unsortedChanges.Total()
+         << ", sorted " << sortedChanges.Total()
+         << " (programs " << sortedChanges.programs << ", materials " << sortedChanges.materials
+         << ", buffers " << sortedChanges.buffers << ")" << endl;
+    glState.Report(cerr);
+    delete recorder;
+    delete queue;
+    return EXIT_SUCCESS;
+}
@@ -1,49 +1,86 @@
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
 using namespace std;
 
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "frame-timeline.h"
+#include "gl-state.h"
 #include "program.h"
+#include "shader-reloader.h"
 
+const NameId coord2dId = NameHash("coord2d");
 GLint attribute_coord2d;
+unsigned progGeneration;
 Program prog;
 
+// Locations are queried again when a hot reload has swapped the program.
+void useProg() {
+    prog.Use();
+    if (progGeneration == prog.Generation()) return;
+    attribute_coord2d = prog.Attrib(coord2dId);
+    progGeneration = prog.Generation();
+}
+
 void display() {
-    glClearColor(0.0, 0.0, 0.0, 1.0);
+    glState.ClearColor(0.0, 0.0, 0.0, 1.0);
     glClear(GL_COLOR_BUFFER_BIT);
-    glEnableVertexAttribArray(attribute_coord2d);
-    GLfloat triangle_vertices[] = {
+    useProg();
+    glState.EnableVertexAttribArray(attribute_coord2d);
+    static const GLfloat triangle_vertices[] = {
          0.0,  0.8,
         -0.8, -0.8,
          0.8, -0.8,
     };
-    glVertexAttribPointer(attribute_coord2d, 2, GL_FLOAT, GL_FALSE, 0, triangle_vertices);
+    glState.BindBuffer(GL_ARRAY_BUFFER, 0);
+    glState.VertexAttribPointer(attribute_coord2d, 2, GL_FLOAT, GL_FALSE, 0, triangle_vertices);
     glDrawArrays(GL_TRIANGLES, 0, 3);
-    glDisableVertexAttribArray(attribute_coord2d);
-    glutSwapBuffers();
+    glState.EndFrame();
+    TimelineSwapBuffers();
 }
 
 void init() {
     prog.CreateProgram({ { GL_VERTEX_SHADER, "shaders/vert" }, { GL_FRAGMENT_SHADER, "shaders/frag" } });
-    attribute_coord2d = glGetAttribLocation(prog.getProgramId(), "coord2d");
+    attribute_coord2d = prog.Attrib(coord2dId);
+}
+
+// freeglut closes the X display before exit, so the reloader stops here.
+void stopReload() {
+    shaderReloader.Stop();
 }
 
 int main(int argc, char** argv) {
     glutInit(&argc, argv);
+    const char *traceFile = NULL;
+    bool reload = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (!strcmp(argv[i], "--reload")) {
+            reload = true;
+        }
+    }
     glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH);
     glutInitWindowPosition(100, 200);
     glutInitWindowSize(640, 480);
     glutCreateWindow("shaders");
     glutInitContextVersion(2, 1);
     glutInitContextProfile(GLUT_CORE_PROFILE);
+    // Headless there is no X display for a GLX-built GLEW, which reports so
+    // only after it has loaded the GL entry points.
     GLenum glewStat = glewInit();
-    if (glewStat != GLEW_OK) {
+    if (glewStat != GLEW_OK && glewStat != GLEW_ERROR_NO_GLX_DISPLAY) {
         cerr << glewGetErrorString(glewStat) << endl;
         return EXIT_FAILURE;
     }
+    if (reload && shaderReloader.Start()) glutCloseFunc(stopReload);
     init();
-    glutDisplayFunc(display);
+    if (traceFile) frameTimeline.Start(traceFile);
+    TimelineDisplayFunc(display);
     glutMainLoop();
+    shaderReloader.Stop();
+    glState.Report(cerr);
     return EXIT_SUCCESS;
 }
@@ -1,4 +1,99 @@
 #include "program.h"
+#include "gl-state.h"
+#include "shader-reloader.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+
+// Linked programs are kept in PROGRAM_CACHE_DIR (".program-cache" by default)
+// as glGetProgramBinary blobs, keyed by the shader sources and the driver.
+static const char cacheMagic[4] = { 'P', 'R', 'G', 'B' };
+
+static string CacheDir()
+{
+    const char *dir = getenv("PROGRAM_CACHE_DIR");
+    return dir ? dir : ".program-cache";
+}
+
+static uint64_t Fnv1a(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = (const unsigned char *) data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static uint64_t Fnv1a(uint64_t hash, const char *str)
+{
+    return str ? Fnv1a(hash, str, strlen(str) + 1) : hash;
+}
+
+// Reflection tables are open-addressed with linear probing, sized to a power
+// of two at least four times the number of active variables (arrays take two
+// entries, and a free slot must always remain); type 0 marks a free
+// slot since no GL type enum is zero.
+static void InsertVar(vector<ProgramVar> &table, const ProgramVar &var)
+{
+    size_t mask = table.size() - 1;
+    for (size_t i = var.id & mask; ; i = (i + 1) & mask)
+    {
+        if (table[i].type == 0)
+        {
+            table[i] = var;
+            return;
+        }
+        if (table[i].id == var.id)
+        {
+            cerr << "program reflection [ HASH CLASH ]" << endl;
+            return;
+        }
+    }
+}
+
+static GLint FindVar(const vector<ProgramVar> &table, NameId id)
+{
+    if (table.empty()) return -1;
+    size_t mask = table.size() - 1;
+    for (size_t i = id & mask; table[i].type != 0; i = (i + 1) & mask)
+        if (table[i].id == id) return table[i].location;
+    return -1;
+}
+
+static void ReflectVars(GLuint program, bool attribs, vector<ProgramVar> &table)
+{
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(program, attribs ? GL_ACTIVE_ATTRIBUTES : GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, attribs ? GL_ACTIVE_ATTRIBUTE_MAX_LENGTH : GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    size_t capacity = 1;
+    while (capacity < 4 * (size_t) count) capacity <<= 1;
+    table.assign(count > 0 ? capacity : 0, ProgramVar());
+    vector<char> name(maxLength + 1);
+    for (GLint i = 0; i < count; i++)
+    {
+        ProgramVar var;
+        GLsizei length = 0;
+        if (attribs)
+            glGetActiveAttrib(program, i, name.size(), &length, &var.size, &var.type, &name[0]);
+        else
+            glGetActiveUniform(program, i, name.size(), &length, &var.size, &var.type, &name[0]);
+        var.location = attribs ? glGetAttribLocation(program, &name[0]) : glGetUniformLocation(program, &name[0]);
+        if (var.location < 0) continue;
+        var.id = NameHash(&name[0]);
+        InsertVar(table, var);
+        // arrays are reported as "name[0]"; make plain "name" find them too
+        if (length > 3 && strcmp(&name[length - 3], "[0]") == 0)
+        {
+            name[length - 3] = '\0';
+            var.id = NameHash(&name[0]);
+            InsertVar(table, var);
+        }
+    }
+}
 
 Program::~Program()
 {
@@ -7,40 +102,161 @@ Program::~Program()
 }
 
 void Program::CreateProgram(vector<Shader> shaders)
+{
+    Submit(shaders);
+    Use();
+}
+
+// Submits every compile and link up front so a driver with
+// GL_KHR_parallel_shader_compile can build them on its own threads; nothing
+// waits on the compiler until each program is first used.
+void Program::CreatePrograms(vector<Program *> programs, vector<vector<Shader> > shaders)
+{
+    if (GLEW_KHR_parallel_shader_compile)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    for (int i = 0; i < programs.size(); i++)
+        programs[i]->Submit(shaders[i]);
+}
+
+void Program::Submit(vector<Shader> shaders)
 {
     _priv->programId = glCreateProgram();
     cerr << "program create [ " << ((_priv->programId == 0) ? "ERROR" : "OK") << " ]" << endl;
+    _priv->shaders = shaders;
+    _priv->sources.resize(shaders.size());
     for (int i = 0; i < shaders.size(); i++)
+        ReadShader(shaders[i].fileName, _priv->sources[i]);
+
+    _priv->cacheFile = CacheFileName(shaders, _priv->sources);
+    _priv->pending = true;
+    _priv->fromBinary = LoadBinary(_priv->cacheFile);
+    if (!_priv->fromBinary)
+        CompileAndLink();
+    if (shaderReloader.IsActive() && !_priv->reload)
+    {
+        vector<GLenum> types;
+        vector<string> fileNames;
+        for (int i = 0; i < shaders.size(); i++)
+        {
+            types.push_back(shaders[i].type);
+            fileNames.push_back(shaders[i].fileName);
+        }
+        _priv->reload = shaderReloader.Watch(types, fileNames);
+    }
+}
+
+// Never blocks: without parallel compile support there is nothing to poll,
+// and the program is reported ready.
+bool Program::IsReady() const
+{
+    if (!_priv->pending || !GLEW_KHR_parallel_shader_compile)
+        return true;
+    GLint done = GL_TRUE;
+    glGetProgramiv(_priv->programId, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
+}
+
+void Program::Use()
+{
+    if (_priv->pending)
+        Finish();
+    if (_priv->reload)
+        SwapReloaded();
+    glState.UseProgram(_priv->programId);
+}
+
+// A rebuilt program replaces the current one between frames, keeping the
+// uniform values set on the old one but not necessarily their locations.
+void Program::SwapReloaded()
+{
+    GLuint program = shaderReloader.Take(_priv->reload);
+    if (!program)
+        return;
+    ShaderReloader::CopyUniforms(_priv->programId, program);
+    glDeleteProgram(_priv->programId);
+    _priv->programId = program;
+    Reflect();
+    _priv->generation++;
+}
+
+void Program::CompileAndLink()
+{
+    for (int i = 0; i < _priv->shaders.size(); i++)
     {
-        CreateShader(shaders[i].type, shaders[i].fileName);
-        glAttachShader(_priv->programId, _priv->shaderId[shaders[i].type]);
+        CreateShader(_priv->shaders[i].type, _priv->sources[i]);
+        glAttachShader(_priv->programId, _priv->shaderId[_priv->shaders[i].type]);
     }
+    if (!_priv->cacheFile.empty())
+        glProgramParameteri(_priv->programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(_priv->programId);
+}
 
+void Program::Finish()
+{
+    _priv->pending = false;
     GLint status;
     glGetProgramiv(_priv->programId, GL_LINK_STATUS, &status);
+    if (_priv->fromBinary)
+    {
+        cerr << "program cache [ " << ((status != GL_TRUE) ? "REJECTED" : "OK") << " ]" << endl;
+        if (status == GL_TRUE)
+        {
+            Reflect();
+            return;
+        }
+        remove(_priv->cacheFile.c_str());
+        _priv->fromBinary = false;
+        CompileAndLink();
+        glGetProgramiv(_priv->programId, GL_LINK_STATUS, &status);
+    }
+
+    for (int i = 0; i < _priv->shaders.size(); i++)
+        CheckShader(_priv->shaders[i].type, _priv->shaders[i].fileName);
     cerr << "program link [ " << ((status != GL_TRUE) ? "ERROR" : "OK") << " ]" << endl;
-    glUseProgram(_priv->programId);
+    if (status == GL_TRUE)
+    {
+        Reflect();
+        SaveBinary(_priv->cacheFile);
+    }
 }
 
-void Program::CreateShader(GLuint type, const string fileName)
+void Program::Reflect()
+{
+    ReflectVars(_priv->programId, true, _priv->attribs);
+    ReflectVars(_priv->programId, false, _priv->uniforms);
+}
+
+GLint Program::Attrib(NameId id) const
+{
+    return FindVar(_priv->attribs, id);
+}
+
+GLint Program::Uniform(NameId id) const
+{
+    return FindVar(_priv->uniforms, id);
+}
+
+void Program::CreateShader(GLuint type, const string &src)
 {
     _priv->shaderId[type] = glCreateShader(type);
 
-    string src;
-    ReadShader(fileName, src);
     const char *c_src = src.c_str();
 
     glShaderSource(_priv->shaderId[type], 1, &c_src, NULL);
     glCompileShader(_priv->shaderId[type]);
+}
+
+void Program::CheckShader(GLuint type, const string fileName) const
+{
+    ShdrId shader = _priv->shaderId[type];
 
     GLint status;
-    glGetShaderiv(_priv->shaderId[type], GL_COMPILE_STATUS, &status);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
     cerr << fileName << " compile [ " << ((status != GL_TRUE) ? "ERROR" : "OK") << " ]" << endl;
 
     GLsizei bufSize = 100;
     char *infoLog = new char[bufSize];
-    glGetShaderInfoLog(_priv->shaderId[type], bufSize, NULL, infoLog);
+    glGetShaderInfoLog(shader, bufSize, NULL, infoLog);
     cerr << infoLog;
     delete[] infoLog;
 }
@@ -56,3 +272,91 @@ void Program::ReadShader(const string fileName, string &src) const {
     }
     file.close();
 }
+
+// Empty when the driver cannot hand out program binaries.
+string Program::CacheFileName(const vector<Shader> &shaders, const vector<string> &sources) const
+{
+    GLint formats = 0;
+    if (GLEW_ARB_get_program_binary)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats == 0)
+        return "";
+
+    uint64_t key = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < shaders.size(); i++)
+    {
+        key = Fnv1a(key, &shaders[i].type, sizeof(shaders[i].type));
+        key = Fnv1a(key, sources[i].c_str());
+    }
+    key = Fnv1a(key, (const char *) glGetString(GL_VENDOR));
+    key = Fnv1a(key, (const char *) glGetString(GL_RENDERER));
+    key = Fnv1a(key, (const char *) glGetString(GL_VERSION));
+
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long) key);
+    return CacheDir() + "/" + name;
+}
+
+// Whether the driver accepts the binary is only known in Finish().
+bool Program::LoadBinary(const string &cacheFile)
+{
+    if (cacheFile.empty())
+        return false;
+    fstream file(cacheFile, ios::in | ios::binary);
+    if (!file.is_open())
+        return false;
+
+    // The binary takes the rest of the file; a length that disagrees with
+    // the file size is never trusted, the entry is dropped instead.
+    file.seekg(0, ios::end);
+    streamoff size = file.tellg();
+    file.seekg(0, ios::beg);
+    char magic[4];
+    GLenum format;
+    GLint length = 0;
+    file.read(magic, sizeof(magic));
+    file.read((char *) &format, sizeof(format));
+    file.read((char *) &length, sizeof(length));
+    streamoff header = sizeof(magic) + sizeof(format) + sizeof(length);
+    vector<char> binary;
+    if (file && length > 0 && length == size - header)
+    {
+        binary.resize(length);
+        file.read(&binary[0], length);
+    }
+    if (!file || memcmp(magic, cacheMagic, sizeof(magic)) != 0 || binary.empty())
+    {
+        cerr << "program cache [ CORRUPT ]" << endl;
+        file.close();
+        remove(cacheFile.c_str());
+        return false;
+    }
+
+    glProgramBinary(_priv->programId, format, &binary[0], length);
+    return true;
+}
+
+void Program::SaveBinary(const string &cacheFile) const
+{
+    if (cacheFile.empty())
+        return;
+    GLint length = 0;
+    glGetProgramiv(_priv->programId, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    vector<char> binary(length);
+    GLenum format;
+    glGetProgramBinary(_priv->programId, length, &length, &format, &binary[0]);
+
+    mkdir(CacheDir().c_str(), 0755);
+    string tmpFile = cacheFile + ".tmp";
+    fstream file(tmpFile, ios::out | ios::binary | ios::trunc);
+    file.write(cacheMagic, sizeof(cacheMagic));
+    file.write((const char *) &format, sizeof(format));
+    file.write((const char *) &length, sizeof(length));
+    file.write(&binary[0], length);
+    file.close();
+    bool ok = !file.fail() && rename(tmpFile.c_str(), cacheFile.c_str()) == 0;
+    cerr << "program cache store [ " << (ok ? "OK" : "ERROR") << " ]" << endl;
+}
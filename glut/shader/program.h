@@ -7,6 +7,7 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <cstdint>
 using namespace std;
 
 #include <GL/glew.h>
@@ -14,6 +15,22 @@ using namespace std;
 
 typedef GLuint ShdrId;
 typedef GLuint ShdrType;
+typedef uint32_t NameId;
+
+// FNV-1a of an attribute or uniform name. Usable in constant expressions, so
+// ids for names known at compile time cost nothing at run time.
+constexpr NameId NameHash(const char *name, NameId hash = 0x811c9dc5u)
+{
+    return *name ? NameHash(name + 1, (hash ^ (unsigned char) *name) * 0x01000193u) : hash;
+}
+
+struct ProgramVar
+{
+    NameId id;
+    GLint location;
+    GLenum type;
+    GLint size;
+};
 
 struct Shader
 {
@@ -27,6 +44,15 @@ class Program
     {
         map<ShdrType, ShdrId> shaderId;
         GLuint programId;
+        vector<Shader> shaders;
+        vector<string> sources;
+        string cacheFile;
+        bool pending;
+        bool fromBinary;
+        int reload;             // shaderReloader handle, 0 when not watched
+        unsigned generation;    // bumped whenever a reload replaces the program
+        vector<ProgramVar> attribs;
+        vector<ProgramVar> uniforms;
     } *_priv;
 
 public:
@@ -34,11 +60,33 @@ public:
     Program(vector<Shader> shaders):Program() { CreateProgram(shaders); }
     ~Program();
     void CreateProgram(vector<Shader> shaders);
+    static void CreatePrograms(vector<Program *> programs, vector<vector<Shader> > shaders);
+    void Submit(vector<Shader> shaders);
+    bool IsReady() const;
+    void Use();
     GLuint getProgramId() const { return _priv->programId; }
+    // Changes when a hot reload swaps in a rebuilt program, whose attribute
+    // and uniform locations may differ; cached locations must be queried
+    // again after Use() once it does.
+    unsigned Generation() const { return _priv->generation; }
+    // Served from the table built at link time, -1 when inactive or before
+    // the program has been used.
+    GLint Attrib(NameId id) const;
+    GLint Attrib(const char *name) const { return Attrib(NameHash(name)); }
+    GLint Uniform(NameId id) const;
+    GLint Uniform(const char *name) const { return Uniform(NameHash(name)); }
 
 private:
-    void CreateShader(GLuint type, const string fileName);
+    void CompileAndLink();
+    void Finish();
+    void SwapReloaded();
+    void Reflect();
+    void CreateShader(GLuint type, const string &src);
+    void CheckShader(GLuint type, const string fileName) const;
     void ReadShader(const string fileName, string &src) const;
+    string CacheFileName(const vector<Shader> &shaders, const vector<string> &sources) const;
+    bool LoadBinary(const string &cacheFile);
+    void SaveBinary(const string &cacheFile) const;
 };
 
 #endif // PROGRAM_H
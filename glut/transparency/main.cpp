@@ -1,28 +1,46 @@
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 using namespace std;
 
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "frame-timeline.h"
+#include "gl-state.h"
 #include "program.h"
+#include "shader-reloader.h"
+#include "quads.h"
 
 Program prog;
+const NameId coord2dId = NameHash("coord2d");
 GLint attributeCoord2d;
+unsigned progGeneration;
 GLuint vboTriangle;
 
+// Locations are queried again when a hot reload has swapped the program.
+void useProg() {
+    prog.Use();
+    if (progGeneration == prog.Generation()) return;
+    attributeCoord2d = prog.Attrib(coord2dId);
+    progGeneration = prog.Generation();
+}
+
 void display() {
     glClear(GL_COLOR_BUFFER_BIT);
-    glEnableVertexAttribArray(attributeCoord2d);
-    glVertexAttribPointer(attributeCoord2d, 2, GL_FLOAT, GL_FALSE, 0, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, vboTriangle);
+    useProg();
+    glState.EnableVertexAttribArray(attributeCoord2d);
+    glState.BindBuffer(GL_ARRAY_BUFFER, vboTriangle);
+    glState.VertexAttribPointer(attributeCoord2d, 2, GL_FLOAT, GL_FALSE, 0, 0);
     glDrawArrays(GL_TRIANGLES, 0, 3);
-    glDisableVertexAttribArray(attributeCoord2d);
-    glutSwapBuffers();
+    glState.EndFrame();
+    TimelineSwapBuffers();
 }
 
 void init() {
     prog.CreateProgram({ { GL_VERTEX_SHADER, "shaders/vert" }, { GL_FRAGMENT_SHADER, "shaders/frag" } });
-    attributeCoord2d = glGetAttribLocation(prog.getProgramId(), "coord2d");
+    attributeCoord2d = prog.Attrib(coord2dId);
     glClearColor(0.0, 0.0, 0.0, 1.0);
     GLfloat triangleVertices[] = {
          0.0,  0.8,
@@ -30,27 +48,74 @@ void init() {
          0.8, -0.8,
     };
     glGenBuffers(1, &vboTriangle);
-    glBindBuffer(GL_ARRAY_BUFFER, vboTriangle);
+    glState.BindBuffer(GL_ARRAY_BUFFER, vboTriangle);
     glBufferData(GL_ARRAY_BUFFER, sizeof(triangleVertices), triangleVertices, GL_STATIC_DRAW);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glState.Enable(GL_BLEND);
+    glState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+// freeglut closes the X display before exit, so the reloader stops here.
+void stopReload() {
+    shaderReloader.Stop();
 }
 
 int main(int argc, char** argv) {
     glutInit(&argc, argv);
+    const char *traceFile = NULL;
+    bool reload = false;
+    int quads = 0;
+    bool sweep = false;
+    QuadMode quadMode = QUADS_SORTED;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quads") && i + 1 < argc) {
+            quads = max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--mode") && i + 1 < argc) {
+            i++;
+            if (!strcmp(argv[i], "oit")) quadMode = QUADS_OIT;
+        } else if (!strcmp(argv[i], "--sweep")) {
+            sweep = true;
+        } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (!strcmp(argv[i], "--reload")) {
+            reload = true;
+        }
+    }
     glutInitDisplayMode(GLUT_RGBA | GLUT_ALPHA | GLUT_DOUBLE | GLUT_DEPTH);
     glutInitWindowPosition(100, 200);
     glutInitWindowSize(640, 480);
     glutCreateWindow("transparency");
     glutInitContextVersion(2, 1);
     glutInitContextProfile(GLUT_CORE_PROFILE);
+    // Headless there is no X display for a GLX-built GLEW, which reports so
+    // only after it has loaded the GL entry points.
     GLenum glewStat = glewInit();
-    if (glewStat != GLEW_OK) {
+    if (glewStat != GLEW_OK && glewStat != GLEW_ERROR_NO_GLX_DISPLAY) {
         cerr << glewGetErrorString(glewStat) << endl;
         return EXIT_FAILURE;
     }
+    if (reload && shaderReloader.Start()) glutCloseFunc(stopReload);
     init();
-    glutDisplayFunc(display);
+    if (traceFile) frameTimeline.Start(traceFile);
+    if (quads > 0 || sweep) {
+        quadMode = InitQuads(quadMode);
+        TimelineDisplayFunc(DisplayQuads);
+        glutIdleFunc(glutPostRedisplay);
+        // Sweeping relies on glutMainLoop returning, as it does headless.
+        const int counts[] = { 10000, 20000, 50000, 100000 };
+        for (int n : counts) {
+            if (!sweep) n = quads;
+            SetQuadCount(n);
+            glutSetWindowTitle((string("transparency ") + QuadModeName(quadMode) + " " + to_string(n)).c_str());
+            glutMainLoop();
+            if (!sweep) break;
+        }
+        shaderReloader.Stop();
+        glState.Report(cerr);
+        return EXIT_SUCCESS;
+    }
+    TimelineDisplayFunc(display);
     glutMainLoop();
+    shaderReloader.Stop();
+    glState.Report(cerr);
     return EXIT_SUCCESS;
 }
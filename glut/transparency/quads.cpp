@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+using namespace std;
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include "bench-metric.h"
+#include "frame-timeline.h"
+#include "gl-state.h"
+#include "program.h"
+#include "quads.h"
+
+// Interleaved per vertex: coord2d, depth (start, speed), color.
+struct QuadVertex {
+    GLfloat x, y;
+    GLfloat z0, speed;
+    GLfloat r, g, b, a;
+};
+
+static Program quadsProg;
+static Program oitProg;
+static Program compositeProg;
+static GLint attributeCoord2d[2];
+static GLint attributeDepth[2];
+static GLint attributeColor[2];
+static GLint uniformTime[2];
+static unsigned quadsGeneration[2];
+static GLint compositeCoord2d;
+static unsigned compositeGeneration;
+static GLuint vboQuads;
+static GLuint iboQuads;
+static GLuint vboScreen;
+static GLuint oitFramebuffer;
+static GLuint oitTextures[2];
+static bool perBufferBlend;
+static QuadMode quadMode;
+static int quadCount;
+static int frame;
+static vector<GLfloat> starts;
+static vector<GLfloat> speeds;
+static vector<GLfloat> depths;
+static vector<GLuint> order;
+static vector<GLuint> indices;
+
+const char *QuadModeName(QuadMode mode) {
+    return mode == QUADS_OIT ? "oit" : "sorted";
+}
+
+static GLfloat Random(GLfloat low, GLfloat high) {
+    return low + (high - low) * (rand() / (GLfloat) RAND_MAX);
+}
+
+// Queried again whenever a hot reload has swapped the program.
+static void QueryLocations(int p) {
+    Program *prog = p ? &oitProg : &quadsProg;
+    attributeCoord2d[p] = prog->Attrib("coord2d");
+    attributeDepth[p] = prog->Attrib("depth");
+    attributeColor[p] = prog->Attrib("color");
+    uniformTime[p] = prog->Uniform("time");
+    quadsGeneration[p] = prog->Generation();
+}
+
+static void QueryCompositeLocations() {
+    compositeCoord2d = compositeProg.Attrib("coord2d");
+    compositeGeneration = compositeProg.Generation();
+}
+
+static void InitTargets() {
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGenTextures(2, oitTextures);
+    const GLenum formats[] = { GL_RGBA16F, GL_R16F };
+    const GLenum layouts[] = { GL_RGBA, GL_RED };
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, oitTextures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, formats[i], viewport[2], viewport[3], 0, layouts[i], GL_FLOAT, NULL);
+    }
+    glGenFramebuffers(1, &oitFramebuffer);
+    glState.BindFramebuffer(oitFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, oitTextures[0], 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, oitTextures[1], 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    cerr << "oit framebuffer [ " << (status == GL_FRAMEBUFFER_COMPLETE ? "OK" : "ERROR") << " ]" << endl;
+    glState.BindFramebuffer(0);
+    compositeProg.Use();
+    glUniform1i(compositeProg.Uniform("accumTexture"), 0);
+    glUniform1i(compositeProg.Uniform("revealageTexture"), 1);
+    glUniform2f(compositeProg.Uniform("viewportSize"), viewport[2], viewport[3]);
+    QueryCompositeLocations();
+    const GLfloat screen[] = { -1, -1, 1, -1, -1, 1, 1, 1 };
+    glGenBuffers(1, &vboScreen);
+    glState.BindBuffer(GL_ARRAY_BUFFER, vboScreen);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(screen), screen, GL_STATIC_DRAW);
+}
+
+// The composite pass needs GL 3.0 for float render targets, glClearBuffer and
+// multiple draw buffers; per-buffer blend functions (GL 4.0) save a pass.
+QuadMode InitQuads(QuadMode mode) {
+    if (mode == QUADS_OIT && !GLEW_VERSION_3_0) {
+        cerr << "oit needs GL 3.0, using sorted quads" << endl;
+        mode = QUADS_SORTED;
+    }
+    quadMode = mode;
+    perBufferBlend = GLEW_VERSION_4_0;
+    Program::CreatePrograms({ &quadsProg, &oitProg, &compositeProg }, {
+        { { GL_VERTEX_SHADER, "shaders/vert-quads" }, { GL_FRAGMENT_SHADER, "shaders/frag-quads" } },
+        { { GL_VERTEX_SHADER, "shaders/vert-quads" }, { GL_FRAGMENT_SHADER, "shaders/frag-oit" } },
+        { { GL_VERTEX_SHADER, "shaders/vert" }, { GL_FRAGMENT_SHADER, "shaders/frag-composite" } },
+    });
+    quadsProg.Use();
+    QueryLocations(0);
+    oitProg.Use();
+    QueryLocations(1);
+    glGenBuffers(1, &vboQuads);
+    glGenBuffers(1, &iboQuads);
+    if (quadMode == QUADS_OIT) InitTargets();
+    return quadMode;
+}
+
+// Same seed every time, so sorted and OIT runs draw the same scene.
+void SetQuadCount(int count) {
+    quadCount = count;
+    frame = 0;
+    srand(1);
+    vector<QuadVertex> vertices(count * 4);
+    starts.resize(count);
+    speeds.resize(count);
+    depths.resize(count);
+    order.resize(count);
+    indices.resize(count * 6);
+    for (int i = 0; i < count; i++) {
+        GLfloat size = Random(0.05f, 0.25f);
+        GLfloat x = Random(-1.0f, 1.0f - size);
+        GLfloat y = Random(-1.0f, 1.0f - size);
+        starts[i] = Random(0.0f, 1.0f);
+        speeds[i] = Random(-0.2f, 0.2f);
+        GLfloat r = Random(0.0f, 1.0f), g = Random(0.0f, 1.0f), b = Random(0.0f, 1.0f);
+        GLfloat a = Random(0.2f, 0.8f);
+        for (int v = 0; v < 4; v++) {
+            QuadVertex vertex = { x + size * (v & 1), y + size * (v >> 1), starts[i], speeds[i], r, g, b, a };
+            vertices[i * 4 + v] = vertex;
+        }
+        order[i] = i;
+    }
+    glState.BindBuffer(GL_ARRAY_BUFFER, vboQuads);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(QuadVertex), &vertices[0], GL_STATIC_DRAW);
+    // Without a CPU sort the index buffer never changes.
+    if (quadMode == QUADS_OIT) {
+        for (int i = 0; i < count; i++) {
+            GLuint quad[] = { i * 4u, i * 4u + 1, i * 4u + 2, i * 4u + 2, i * 4u + 1, i * 4u + 3 };
+            copy(quad, quad + 6, indices.begin() + i * 6);
+        }
+        glState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboQuads);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
+    }
+}
+
+// Mirrors vert-quads, then rewrites the index buffer farthest quad first.
+static void SortQuads(GLfloat time) {
+    double start = MetricClockMs();
+    for (int i = 0; i < quadCount; i++) {
+        GLfloat z = starts[i] + time * speeds[i];
+        depths[i] = z - floor(z);
+    }
+    sort(order.begin(), order.end(), [](GLuint a, GLuint b) { return depths[a] > depths[b]; });
+    for (int i = 0; i < quadCount; i++) {
+        GLuint q = order[i] * 4;
+        GLuint quad[] = { q, q + 1, q + 2, q + 2, q + 1, q + 3 };
+        copy(quad, quad + 6, indices.begin() + i * 6);
+    }
+    glState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboQuads);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(GLuint), &indices[0]);
+    ReportMetric("sort_ms", MetricClockMs() - start);
+}
+
+static void DrawQuads(int p, GLfloat time) {
+    Program *prog = p ? &oitProg : &quadsProg;
+    if (quadsGeneration[p] != prog->Generation()) QueryLocations(p);
+    glUniform1f(uniformTime[p], time);
+    glState.BindBuffer(GL_ARRAY_BUFFER, vboQuads);
+    glState.EnableVertexAttribArray(attributeCoord2d[p]);
+    glState.EnableVertexAttribArray(attributeDepth[p]);
+    glState.EnableVertexAttribArray(attributeColor[p]);
+    glState.VertexAttribPointer(attributeCoord2d[p], 2, GL_FLOAT, GL_FALSE, sizeof(QuadVertex), (const GLvoid *) offsetof(QuadVertex, x));
+    glState.VertexAttribPointer(attributeDepth[p], 2, GL_FLOAT, GL_FALSE, sizeof(QuadVertex), (const GLvoid *) offsetof(QuadVertex, z0));
+    glState.VertexAttribPointer(attributeColor[p], 4, GL_FLOAT, GL_FALSE, sizeof(QuadVertex), (const GLvoid *) offsetof(QuadVertex, r));
+    glState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboQuads);
+    glDrawElements(GL_TRIANGLES, quadCount * 6, GL_UNSIGNED_INT, 0);
+}
+
+static void DisplaySorted(GLfloat time) {
+    SortQuads(time);
+    quadsProg.Use();
+    glState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    DrawQuads(0, time);
+}
+
+// Accumulation sums premultiplied color times weight, revealage multiplies
+// (1 - alpha). Without per-buffer blending each target gets its own pass.
+static void DisplayOit(GLfloat time) {
+    static const GLenum both[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    static const GLenum accumOnly[] = { GL_COLOR_ATTACHMENT0, GL_NONE };
+    static const GLenum revealageOnly[] = { GL_NONE, GL_COLOR_ATTACHMENT1 };
+    static const GLfloat zero[] = { 0, 0, 0, 0 };
+    static const GLfloat one[] = { 1, 1, 1, 1 };
+    glState.BindFramebuffer(oitFramebuffer);
+    glDrawBuffers(2, both);
+    glClearBufferfv(GL_COLOR, 0, zero);
+    glClearBufferfv(GL_COLOR, 1, one);
+    oitProg.Use();
+    if (perBufferBlend) {
+        glState.BlendFunci(0, GL_ONE, GL_ONE);
+        glState.BlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+        DrawQuads(1, time);
+    } else {
+        glDrawBuffers(2, accumOnly);
+        glState.BlendFunc(GL_ONE, GL_ONE);
+        DrawQuads(1, time);
+        glDrawBuffers(2, revealageOnly);
+        glState.BlendFunc(GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+        DrawQuads(1, time);
+    }
+
+    glState.BindFramebuffer(0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, oitTextures[0]);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, oitTextures[1]);
+    compositeProg.Use();
+    if (compositeGeneration != compositeProg.Generation()) QueryCompositeLocations();
+    glState.BlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+    glState.BindBuffer(GL_ARRAY_BUFFER, vboScreen);
+    glState.EnableVertexAttribArray(compositeCoord2d);
+    glState.VertexAttribPointer(compositeCoord2d, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+void DisplayQuads() {
+    glClear(GL_COLOR_BUFFER_BIT);
+    GLfloat time = frame++ / 60.0f;
+    if (quadMode == QUADS_OIT) DisplayOit(time);
+    else DisplaySorted(time);
+    glState.EndFrame();
+    TimelineSwapBuffers();
+}
@@ -0,0 +1,20 @@
+#ifndef QUADS_H
+#define QUADS_H
+
+#include <GL/glew.h>
+
+// Overlapping translucent quads drifting through depth, composited either
+// back to front after sorting on the CPU every frame, or order independently
+// with weighted blended OIT into floating point targets.
+enum QuadMode {
+    QUADS_SORTED,
+    QUADS_OIT
+};
+
+const char *QuadModeName(QuadMode mode);
+// Returns the mode actually used, falling back when OIT is unsupported.
+QuadMode InitQuads(QuadMode mode);
+void SetQuadCount(int count);
+void DisplayQuads();
+
+#endif // QUADS_H
@@ -4,6 +4,8 @@ using namespace std;
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "gl-state.h"
+
 const char *vsSrc =
         "#version 120\n"
         "attribute vec2 coord2d;"
@@ -46,28 +48,30 @@ GLuint CreateProgram() {
 }
 
 void display() {
-    glClearColor(0.0, 0.0, 0.0, 1.0);
+    glState.ClearColor(0.0, 0.0, 0.0, 1.0);
     glClear(GL_COLOR_BUFFER_BIT);
-    glEnableVertexAttribArray(attribute_coord2d);
-    GLfloat triangle_vertices[] = {
+    glState.EnableVertexAttribArray(attribute_coord2d);
+    static const GLfloat triangle_vertices[] = {
          0.0,  0.8,
         -0.8, -0.8,
          0.8, -0.8,
     };
-    glVertexAttribPointer(attribute_coord2d, 2, GL_FLOAT, GL_FALSE, 0, triangle_vertices);
+    glState.BindBuffer(GL_ARRAY_BUFFER, 0);
+    glState.VertexAttribPointer(attribute_coord2d, 2, GL_FLOAT, GL_FALSE, 0, triangle_vertices);
     glDrawArrays(GL_TRIANGLES, 0, 3);
-    glDisableVertexAttribArray(attribute_coord2d);
+    glState.EndFrame();
     glutSwapBuffers();
 }
 
 void init() {
     program = CreateProgram();
-    glUseProgram(program);
+    glState.UseProgram(program);
     attribute_coord2d = glGetAttribLocation(program, "coord2d");
 }
 
 void free() {
     cout << "free res" << endl;
+    glState.Report(cerr);
     glDeleteProgram(program);
 }
 
@@ -79,8 +83,10 @@ int main(int argc, char** argv) {
     glutCreateWindow("triangle");
     glutInitContextVersion(2, 1);
     glutInitContextProfile(GLUT_CORE_PROFILE);
+    // Headless there is no X display for a GLX-built GLEW, which reports so
+    // only after it has loaded the GL entry points.
     GLenum glewStat = glewInit();
-    if (glewStat != GLEW_OK) {
+    if (glewStat != GLEW_OK && glewStat != GLEW_ERROR_NO_GLX_DISPLAY) {
         cerr << glewGetErrorString(glewStat) << endl;
         return EXIT_FAILURE;
     }
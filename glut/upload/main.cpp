@@ -0,0 +1,207 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include "bench-metric.h"
+
+// The same mesh submitted through each of the vertex upload styles found in
+// the other samples:
+//   client - client-side array re-specified every frame (glut/triangle)
+//   stream - VBO refilled with glBufferData every frame
+//   vbo    - static VBO, attribute pointer set up every frame (glut/vbo)
+//   vao    - static VBO captured in a VAO (redbook/firstprog/triangles)
+enum UploadPath { PATH_CLIENT, PATH_STREAM, PATH_VBO, PATH_VAO, PATH_COUNT };
+const char *pathNames[PATH_COUNT] = { "client", "stream", "vbo", "vao" };
+
+const char *vsSrc =
+        "#version 120\n"
+        "attribute vec2 coord2d;"
+        "void main(void) {"
+        "   gl_Position = vec4(coord2d, 0.0, 1.0);"
+        "}";
+
+const char *fsSrc =
+        "#version 120\n"
+        "void main(void) {"
+        "   gl_FragColor = vec4(gl_FragCoord.x / 640.0, gl_FragCoord.y / 480.0, 0.5, 1.0);"
+        "}";
+
+GLuint program;
+GLint attribute_coord2d;
+UploadPath path = PATH_VBO;
+vector<GLfloat> vertices;
+GLuint vbo;
+GLuint vao;
+
+GLuint CreateShader(const GLenum type, const char *src) {
+    GLuint shader = glCreateShader(type);
+    if (!shader) return 0;
+    glShaderSource(shader, 1, &src, NULL);
+    glCompileShader(shader);
+    GLint compileOk = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compileOk);
+    if (compileOk == GL_FALSE) {
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// 0 when any step fails, so that no path is timed with a broken program.
+GLuint CreateProgram() {
+    GLuint vs = CreateShader(GL_VERTEX_SHADER, vsSrc);
+    GLuint fs = CreateShader(GL_FRAGMENT_SHADER, fsSrc);
+    GLuint prog = vs && fs ? glCreateProgram() : 0;
+    if (prog) {
+        glAttachShader(prog, vs);
+        glAttachShader(prog, fs);
+        glLinkProgram(prog);
+    }
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    if (!prog) return 0;
+    GLint linkOk = GL_FALSE;
+    glGetProgramiv(prog, GL_LINK_STATUS, &linkOk);
+    if (!linkOk) {
+        glDeleteProgram(prog);
+        return 0;
+    }
+    return prog;
+}
+
+// Small triangles on a square grid covering the viewport.
+void BuildMesh(int triangles) {
+    int side = (int) ceil(sqrt((double) triangles));
+    GLfloat cell = 1.8f / side;
+    vertices.resize(triangles * 6);
+    for (int i = 0; i < triangles; i++) {
+        GLfloat x = -0.9f + (i % side) * cell;
+        GLfloat y = -0.9f + (i / side) * cell;
+        GLfloat tri[] = { x, y, x + cell, y, x, y + cell };
+        copy(tri, tri + 6, vertices.begin() + i * 6);
+    }
+}
+
+// Static paths get their data up front; that cost is not part of a frame.
+void SetupPath() {
+    GLsizeiptr size = vertices.size() * sizeof(GLfloat);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, size, path == PATH_STREAM ? NULL : &vertices[0],
+                 path == PATH_STREAM ? GL_STREAM_DRAW : GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (path == PATH_VAO) {
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glVertexAttribPointer(attribute_coord2d, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(attribute_coord2d);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+void display() {
+    glClear(GL_COLOR_BUFFER_BIT);
+    GLsizei count = vertices.size() / 2;
+    double start = MetricClockMs();
+    switch (path) {
+    case PATH_CLIENT:
+        glEnableVertexAttribArray(attribute_coord2d);
+        glVertexAttribPointer(attribute_coord2d, 2, GL_FLOAT, GL_FALSE, 0, &vertices[0]);
+        glDrawArrays(GL_TRIANGLES, 0, count);
+        glDisableVertexAttribArray(attribute_coord2d);
+        break;
+    case PATH_STREAM:
+    case PATH_VBO:
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        if (path == PATH_STREAM) {
+            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), NULL, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(GLfloat), &vertices[0]);
+        }
+        glEnableVertexAttribArray(attribute_coord2d);
+        glVertexAttribPointer(attribute_coord2d, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        glDrawArrays(GL_TRIANGLES, 0, count);
+        glDisableVertexAttribArray(attribute_coord2d);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        break;
+    default:
+        glBindVertexArray(vao);
+        glDrawArrays(GL_TRIANGLES, 0, count);
+        glBindVertexArray(0);
+        break;
+    }
+    ReportMetric("submit_ms", MetricClockMs() - start);
+    ReportMetric("vertices", count);
+    glutSwapBuffers();
+}
+
+bool init() {
+    program = CreateProgram();
+    if (!program) {
+        cerr << "upload program [ ERROR ]" << endl;
+        return false;
+    }
+    glUseProgram(program);
+    attribute_coord2d = glGetAttribLocation(program, "coord2d");
+    if (attribute_coord2d < 0) {
+        cerr << "upload attribute coord2d [ ERROR ]" << endl;
+        return false;
+    }
+    glClearColor(0.0, 0.0, 0.0, 1.0);
+    glGenBuffers(1, &vbo);
+    if (path == PATH_VAO && !(GLEW_VERSION_3_0 || GLEW_ARB_vertex_array_object)) {
+        cerr << "vertex array objects [ UNSUPPORTED ], using vbo" << endl;
+        path = PATH_VBO;
+    }
+    if (path == PATH_VAO) glGenVertexArrays(1, &vao);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    glutInit(&argc, argv);
+    int triangles = 100000;
+    bool sweep = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--path") && i + 1 < argc) {
+            i++;
+            for (int p = 0; p < PATH_COUNT; p++)
+                if (!strcmp(argv[i], pathNames[p])) path = (UploadPath) p;
+        } else if (!strcmp(argv[i], "--triangles") && i + 1 < argc) {
+            triangles = max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--sweep")) {
+            sweep = true;
+        }
+    }
+    glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE);
+    glutInitWindowPosition(100, 200);
+    glutInitWindowSize(640, 480);
+    glutCreateWindow("upload");
+    // Headless there is no X display for a GLX-built GLEW, which reports so
+    // only after it has loaded the GL entry points.
+    GLenum glewStat = glewInit();
+    if (glewStat != GLEW_OK && glewStat != GLEW_ERROR_NO_GLX_DISPLAY) {
+        cerr << glewGetErrorString(glewStat) << endl;
+        return EXIT_FAILURE;
+    }
+    if (!init()) return EXIT_FAILURE;
+    glutDisplayFunc(display);
+    glutIdleFunc(glutPostRedisplay);
+    // Sweeping relies on glutMainLoop returning, as it does headless; the
+    // last step is clamped so the maximum is always measured.
+    for (int n = sweep ? 1 : triangles; ; n = n < triangles / 10 ? n * 10 : triangles) {
+        BuildMesh(n);
+        SetupPath();
+        glutSetWindowTitle((string("upload ") + pathNames[path] + " " + to_string(n * 3)).c_str());
+        glutMainLoop();
+        if (n == triangles) break;
+    }
+    glDeleteProgram(program);
+    return EXIT_SUCCESS;
+}
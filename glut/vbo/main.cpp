@@ -1,28 +1,90 @@
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
 using namespace std;
 
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "frame-timeline.h"
+#include "gl-state.h"
 #include "program.h"
+#include "shader-reloader.h"
+#include "mesh.h"
+#include "objects.h"
+#include "stream-buffer.h"
 
 Program prog;
+const NameId coord2dId = NameHash("coord2d");
 GLint attributeCoord2d;
+unsigned progGeneration;
 GLuint vboTriangle;
 
+// Locations are queried again when a hot reload has swapped the program.
+void useProg() {
+    prog.Use();
+    if (progGeneration == prog.Generation()) return;
+    attributeCoord2d = prog.Attrib(coord2dId);
+    progGeneration = prog.Generation();
+}
+
+// --stream: rewrite streamTriangles small triangles every frame
+StreamBuffer *stream = NULL;
+StreamBuffer::Strategy streamStrategy = StreamBuffer::PERSISTENT;
+int streamTriangles = 1000000;
+vector<GLfloat> streamBase;
+vector<GLfloat> streamScratch;
+int streamFrame = 0;
+
 void display() {
     glClear(GL_COLOR_BUFFER_BIT);
-    glEnableVertexAttribArray(attributeCoord2d);
-    glVertexAttribPointer(attributeCoord2d, 2, GL_FLOAT, GL_FALSE, 0, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, vboTriangle);
+    useProg();
+    glState.EnableVertexAttribArray(attributeCoord2d);
+    glState.BindBuffer(GL_ARRAY_BUFFER, vboTriangle);
+    glState.VertexAttribPointer(attributeCoord2d, 2, GL_FLOAT, GL_FALSE, 0, 0);
     glDrawArrays(GL_TRIANGLES, 0, 3);
-    glDisableVertexAttribArray(attributeCoord2d);
-    glutSwapBuffers();
+    glState.EndFrame();
+    TimelineSwapBuffers();
+}
+
+void displayStream() {
+    glClear(GL_COLOR_BUFFER_BIT);
+    useProg();
+    GLsizeiptr size = streamBase.size() * sizeof(GLfloat);
+    GLfloat *vertices = (GLfloat *) stream->Map(size);
+    // A frame the driver would not map goes up with glBufferSubData instead.
+    bool mapped = vertices != NULL;
+    if (!mapped) {
+        streamScratch.resize(streamBase.size());
+        vertices = &streamScratch[0];
+    }
+    GLfloat dx = 0.05f * sin(streamFrame * 0.1f);
+    GLfloat dy = 0.05f * cos(streamFrame * 0.1f);
+    for (size_t i = 0; i < streamBase.size(); i += 2) {
+        vertices[i] = streamBase[i] + dx;
+        vertices[i + 1] = streamBase[i + 1] + dy;
+    }
+    if (mapped) {
+        stream->Unmap();
+    } else {
+        glState.BindBuffer(GL_ARRAY_BUFFER, stream->getBufferId());
+        glBufferSubData(GL_ARRAY_BUFFER, stream->Offset(), size, vertices);
+    }
+    glState.EnableVertexAttribArray(attributeCoord2d);
+    glState.BindBuffer(GL_ARRAY_BUFFER, stream->getBufferId());
+    glState.VertexAttribPointer(attributeCoord2d, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid *) stream->Offset());
+    glDrawArrays(GL_TRIANGLES, 0, streamTriangles * 3);
+    stream->EndFrame();
+    glState.EndFrame();
+    streamFrame++;
+    TimelineSwapBuffers();
 }
 
 void init() {
     prog.CreateProgram({ { GL_VERTEX_SHADER, "shaders/vert" }, { GL_FRAGMENT_SHADER, "shaders/frag" } });
-    attributeCoord2d = glGetAttribLocation(prog.getProgramId(), "coord2d");
+    attributeCoord2d = prog.Attrib(coord2dId);
     glClearColor(0.0, 0.0, 0.0, 1.0);
     GLfloat triangleVertices[] = {
          0.0,  0.8,
@@ -30,25 +92,116 @@ void init() {
          0.8, -0.8,
     };
     glGenBuffers(1, &vboTriangle);
-    glBindBuffer(GL_ARRAY_BUFFER, vboTriangle);
+    glState.BindBuffer(GL_ARRAY_BUFFER, vboTriangle);
     glBufferData(GL_ARRAY_BUFFER, sizeof(triangleVertices), triangleVertices, GL_STATIC_DRAW);
 }
 
+// Tiny triangles on a square grid covering the viewport.
+void initStream() {
+    int side = (int) ceil(sqrt((double) streamTriangles));
+    GLfloat cell = 1.8f / side;
+    streamBase.resize(streamTriangles * 6);
+    for (int i = 0; i < streamTriangles; i++) {
+        GLfloat x = -0.9f + (i % side) * cell;
+        GLfloat y = -0.9f + (i / side) * cell;
+        GLfloat tri[] = { x, y, x + cell, y, x, y + cell };
+        copy(tri, tri + 6, streamBase.begin() + i * 6);
+    }
+    stream = new StreamBuffer(GL_ARRAY_BUFFER, streamBase.size() * sizeof(GLfloat), 3, streamStrategy);
+}
+
+// freeglut closes the X display before exit, so the reloader stops here.
+void stopReload() {
+    shaderReloader.Stop();
+}
+
 int main(int argc, char** argv) {
     glutInit(&argc, argv);
+    const char *traceFile = NULL;
+    const char *meshFile = NULL;
+    bool reload = false;
+    bool streaming = false;
+    int objects = 0;
+    bool sweep = false;
+    DrawPath drawPath = DRAW_INSTANCED;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--stream") && i + 1 < argc) {
+            streaming = true;
+            i++;
+            if (!strcmp(argv[i], "map")) streamStrategy = StreamBuffer::MAP_RANGE;
+            else if (!strcmp(argv[i], "orphan")) streamStrategy = StreamBuffer::ORPHAN;
+        } else if (!strcmp(argv[i], "--triangles") && i + 1 < argc) {
+            streamTriangles = max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--objects") && i + 1 < argc) {
+            objects = max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--draw") && i + 1 < argc) {
+            i++;
+            if (!strcmp(argv[i], "single")) drawPath = DRAW_SINGLE;
+            else if (!strcmp(argv[i], "multidraw")) drawPath = DRAW_MULTIDRAW;
+        } else if (!strcmp(argv[i], "--sweep")) {
+            sweep = true;
+        } else if (!strcmp(argv[i], "--mesh") && i + 1 < argc) {
+            meshFile = argv[++i];
+        } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (!strcmp(argv[i], "--reload")) {
+            reload = true;
+        }
+    }
     glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH);
     glutInitWindowPosition(100, 200);
     glutInitWindowSize(640, 480);
     glutCreateWindow("vbo");
     glutInitContextVersion(2, 1);
     glutInitContextProfile(GLUT_CORE_PROFILE);
+    // Headless there is no X display for a GLX-built GLEW, which reports so
+    // only after it has loaded the GL entry points.
     GLenum glewStat = glewInit();
-    if (glewStat != GLEW_OK) {
+    if (glewStat != GLEW_OK && glewStat != GLEW_ERROR_NO_GLX_DISPLAY) {
         cerr << glewGetErrorString(glewStat) << endl;
         return EXIT_FAILURE;
     }
+    if (reload && shaderReloader.Start()) glutCloseFunc(stopReload);
     init();
-    glutDisplayFunc(display);
+    if (traceFile) frameTimeline.Start(traceFile);
+    if (meshFile) {
+        if (!InitMesh(meshFile)) {
+            shaderReloader.Stop();
+            return EXIT_FAILURE;
+        }
+        glutSetWindowTitle((string("vbo mesh ") + meshFile).c_str());
+        TimelineDisplayFunc(DisplayMesh);
+        glutIdleFunc(glutPostRedisplay);
+    } else if (streaming) {
+        initStream();
+        glutSetWindowTitle((string("vbo stream ") + StreamBuffer::StrategyName(stream->getStrategy())).c_str());
+        TimelineDisplayFunc(displayStream);
+        glutIdleFunc(glutPostRedisplay);
+    } else if (objects > 0 || sweep) {
+        drawPath = InitObjects(vboTriangle, drawPath);
+        TimelineDisplayFunc(DisplayObjects);
+        glutIdleFunc(glutPostRedisplay);
+        // Sweeping relies on glutMainLoop returning, as it does headless; the
+        // last step is clamped so the maximum is always measured.
+        int last = objects > 0 ? objects : 1000000;
+        for (int n = sweep ? 1 : last; ; n = n < last / 10 ? n * 10 : last) {
+            SetObjectCount(n);
+            glutSetWindowTitle((string("vbo ") + DrawPathName(drawPath) + " " + to_string(n)).c_str());
+            glutMainLoop();
+            if (n == last) break;
+        }
+        shaderReloader.Stop();
+        glState.Report(cerr);
+        return EXIT_SUCCESS;
+    } else {
+        TimelineDisplayFunc(display);
+    }
     glutMainLoop();
+    shaderReloader.Stop();
+    glState.Report(cerr);
+    if (stream) {
+        cerr << "stream stalls " << stream->stalls << ", orphans " << stream->orphans << endl;
+        delete stream;
+    }
     return EXIT_SUCCESS;
 }
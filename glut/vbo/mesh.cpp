@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include "bench-metric.h"
+#include "frame-timeline.h"
+#include "gl-state.h"
+#include "mesh.h"
+#include "mesh-file.h"
+#include "program.h"
+
+static const uint64_t UPLOAD_SLICE = 16 << 20;
+
+static Program meshProg;
+static MeshFile meshFile;
+static vector<GLuint> meshBuffers;
+static int indexStream;
+static GLint uniformCenter, uniformScale;
+static unsigned meshGeneration;
+static GLfloat center[3], scale[3];
+static double uploadMs;
+static bool uploadReported;
+
+// Shader invocations per frame, from GL_ARB_pipeline_statistics_query, read
+// back one frame late so the queries never stall the pipeline.
+static const int STAT_VERTEX = 0, STAT_FRAGMENT = 1, STAT_COUNT = 2;
+static GLuint statQueries[2][STAT_COUNT];
+static bool statsEnabled;
+static int statFrame;
+
+static void UploadStream(int stream, GLenum target) {
+    const MeshStream &s = meshFile.Stream(stream);
+    const char *data = meshFile.StreamData(stream);
+    glState.BindBuffer(target, meshBuffers[stream]);
+    glBufferData(target, s.size, NULL, GL_STATIC_DRAW);
+    meshFile.Prefetch(stream, 0, min(UPLOAD_SLICE, s.size));
+    for (uint64_t offset = 0; offset < s.size; offset += UPLOAD_SLICE) {
+        uint64_t size = min(UPLOAD_SLICE, s.size - offset);
+        if (offset + size < s.size) meshFile.Prefetch(stream, offset + size, min(UPLOAD_SLICE, s.size - offset - size));
+        glBufferSubData(target, offset, size, data + offset);
+    }
+}
+
+static void QueryLocations() {
+    uniformCenter = meshProg.Uniform("center");
+    uniformScale = meshProg.Uniform("scale");
+    meshGeneration = meshProg.Generation();
+}
+
+bool InitMesh(const char *fileName) {
+    double start = MetricClockMs();
+    if (!meshFile.Open(fileName)) return false;
+    double opened = MetricClockMs();
+    const MeshHeader &header = meshFile.Header();
+    meshBuffers.resize(header.streamCount);
+    glGenBuffers(header.streamCount, &meshBuffers[0]);
+    indexStream = meshFile.IndexStream();
+    for (uint32_t i = 0; i < header.streamCount; i++)
+        UploadStream(i, (int) i == indexStream ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER);
+    glFinish();
+    uploadMs = MetricClockMs() - opened;
+
+    meshProg.CreateProgram({ { GL_VERTEX_SHADER, "shaders/vert-mesh" }, { GL_FRAGMENT_SHADER, "shaders/frag" } });
+    QueryLocations();
+    // Fit the x/y extent of the bounds to the viewport and z to the depth range.
+    GLfloat extent = max(header.boundsMax[0] - header.boundsMin[0], header.boundsMax[1] - header.boundsMin[1]);
+    GLfloat depth = header.boundsMax[2] - header.boundsMin[2];
+    for (int i = 0; i < 3; i++) center[i] = 0.5f * (header.boundsMin[i] + header.boundsMax[i]);
+    scale[0] = scale[1] = extent > 0.0f ? 1.8f / extent : 1.0f;
+    scale[2] = depth > 0.0f ? 1.8f / depth : 1.0f;
+    glState.Enable(GL_DEPTH_TEST);
+
+    statsEnabled = GLEW_ARB_pipeline_statistics_query;
+    if (statsEnabled) glGenQueries(2 * STAT_COUNT, &statQueries[0][0]);
+    else cerr << "pipeline statistics [ UNSUPPORTED ], no shader invocation counts" << endl;
+
+    uint64_t triangles = (header.indexCount ? header.indexCount : header.vertexCount) / 3;
+    cerr << "mesh " << fileName << ": " << header.vertexCount << " vertices, " << triangles << " triangles, "
+         << meshFile.FileSize() / 1048576.0 << " MB, open " << opened - start << " ms, upload " << uploadMs << " ms ("
+         << meshFile.FileSize() / 1048576.0 / (uploadMs / 1000.0) << " MB/s) [ OK ]" << endl;
+    return true;
+}
+
+// Reports the previous frame's counts if they have arrived, else skips them.
+static void CollectStats(uint64_t triangles) {
+    GLuint *queries = statQueries[(statFrame - 1) & 1];
+    GLint available = 0;
+    glGetQueryObjectiv(queries[STAT_FRAGMENT], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return;
+    GLuint64 vertex, fragment;
+    glGetQueryObjectui64v(queries[STAT_VERTEX], GL_QUERY_RESULT, &vertex);
+    glGetQueryObjectui64v(queries[STAT_FRAGMENT], GL_QUERY_RESULT, &fragment);
+    ReportMetric("vs invocations", vertex);
+    ReportMetric("vs invocations per triangle", triangles ? (double) vertex / triangles : 0.0);
+    ReportMetric("fs invocations", fragment);
+}
+
+void DisplayMesh() {
+    const MeshHeader &header = meshFile.Header();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    meshProg.Use();
+    if (meshGeneration != meshProg.Generation()) QueryLocations();
+    glUniform3fv(uniformCenter, 1, center);
+    glUniform3fv(uniformScale, 1, scale);
+    for (uint32_t i = 0; i < header.attributeCount; i++) {
+        const MeshAttribute &attribute = meshFile.Attribute(i);
+        GLint location = meshProg.Attrib(attribute.name);
+        if (location < 0) continue;
+        glState.BindBuffer(GL_ARRAY_BUFFER, meshBuffers[attribute.stream]);
+        glState.EnableVertexAttribArray(location);
+        glState.VertexAttribPointer(location, attribute.components, attribute.type, attribute.normalized,
+                                    meshFile.Stream(attribute.stream).stride, (const GLvoid *) (uintptr_t) attribute.offset);
+    }
+    GLuint *queries = statQueries[statFrame & 1];
+    if (statsEnabled) {
+        glBeginQuery(GL_VERTEX_SHADER_INVOCATIONS_ARB, queries[STAT_VERTEX]);
+        glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, queries[STAT_FRAGMENT]);
+    }
+    if (indexStream >= 0) {
+        glState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshBuffers[indexStream]);
+        glDrawElements(header.primitive, header.indexCount, header.indexType, 0);
+    } else {
+        glDrawArrays(header.primitive, 0, header.vertexCount);
+    }
+    if (statsEnabled) {
+        glEndQuery(GL_VERTEX_SHADER_INVOCATIONS_ARB);
+        glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB);
+        if (statFrame > 0) CollectStats((header.indexCount ? header.indexCount : header.vertexCount) / 3);
+        statFrame++;
+    }
+    if (!uploadReported) {
+        ReportMetric("mesh upload ms", uploadMs);
+        uploadReported = true;
+    }
+    glState.EndFrame();
+    TimelineSwapBuffers();
+}
@@ -0,0 +1,12 @@
+#ifndef MESH_H
+#define MESH_H
+
+// A mesh file (see mesh-file.h) drawn in place of the triangle. Its streams
+// are uploaded straight from the file mapping in slices, so the driver never
+// stages the whole mesh at once and the kernel reads the next slice ahead
+// while the current one is copied. Every attribute in the file that the
+// program uses is bound.
+bool InitMesh(const char *fileName);
+void DisplayMesh();
+
+#endif // MESH_H
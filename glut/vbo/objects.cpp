@@ -0,0 +1,113 @@
+#include <cmath>
+#include <vector>
+using namespace std;
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include "frame-timeline.h"
+#include "gl-state.h"
+#include "objects.h"
+#include "program.h"
+
+struct DrawArraysIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint first;
+    GLuint baseInstance;
+};
+
+static Program objectsProg;
+static GLint attributeCoord2d;
+static GLint attributeInstance;
+static unsigned objectsGeneration;
+static GLuint vboTriangle;
+static GLuint vboInstances;
+static GLuint indirectBuffer;
+static DrawPath drawPath;
+static int objectCount;
+static vector<GLfloat> instances;
+
+static void QueryLocations() {
+    attributeCoord2d = objectsProg.Attrib("coord2d");
+    attributeInstance = objectsProg.Attrib("instance");
+    objectsGeneration = objectsProg.Generation();
+}
+
+const char *DrawPathName(DrawPath path) {
+    switch (path) {
+    case DRAW_INSTANCED: return "instanced";
+    case DRAW_MULTIDRAW: return "multidraw";
+    default: return "single";
+    }
+}
+
+DrawPath InitObjects(GLuint vertexBuffer, DrawPath path) {
+    objectsProg.CreateProgram({ { GL_VERTEX_SHADER, "shaders/vert-instanced" }, { GL_FRAGMENT_SHADER, "shaders/frag" } });
+    QueryLocations();
+    vboTriangle = vertexBuffer;
+    bool instancing = GLEW_ARB_instanced_arrays && GLEW_ARB_draw_instanced;
+    // Each indirect command selects its object through baseInstance, which
+    // is ignored without ARB_base_instance: every object would be drawn as
+    // object 0.
+    bool baseInstance = GLEW_VERSION_4_2 || GLEW_ARB_base_instance;
+    if (path == DRAW_MULTIDRAW && !(instancing && baseInstance && GLEW_ARB_multi_draw_indirect)) path = DRAW_INSTANCED;
+    if (path == DRAW_INSTANCED && !instancing) path = DRAW_SINGLE;
+    drawPath = path;
+    glGenBuffers(1, &vboInstances);
+    glGenBuffers(1, &indirectBuffer);
+    return drawPath;
+}
+
+// Objects sit on a square grid covering the viewport, scaled to their cell.
+void SetObjectCount(int count) {
+    objectCount = count;
+    int side = (int) ceil(sqrt((double) count));
+    GLfloat cell = 2.0f / side;
+    instances.resize(count * 3);
+    for (int i = 0; i < count; i++) {
+        instances[i * 3] = -1.0f + cell * (i % side + 0.5f);
+        instances[i * 3 + 1] = -1.0f + cell * (i / side + 0.5f);
+        instances[i * 3 + 2] = cell * 0.5f;
+    }
+    if (drawPath == DRAW_SINGLE) return;
+    glState.BindBuffer(GL_ARRAY_BUFFER, vboInstances);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(GLfloat), &instances[0], GL_STATIC_DRAW);
+    if (drawPath != DRAW_MULTIDRAW) return;
+    vector<DrawArraysIndirectCommand> commands(count);
+    for (int i = 0; i < count; i++) {
+        DrawArraysIndirectCommand command = { 3, 1, 0, (GLuint) i };
+        commands[i] = command;
+    }
+    glState.BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(commands[0]), &commands[0], GL_STATIC_DRAW);
+}
+
+void DisplayObjects() {
+    glClear(GL_COLOR_BUFFER_BIT);
+    objectsProg.Use();
+    if (objectsGeneration != objectsProg.Generation()) QueryLocations();
+    glState.BindBuffer(GL_ARRAY_BUFFER, vboTriangle);
+    glState.EnableVertexAttribArray(attributeCoord2d);
+    glState.VertexAttribPointer(attributeCoord2d, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    if (drawPath == DRAW_SINGLE) {
+        glState.DisableVertexAttribArray(attributeInstance);
+        for (int i = 0; i < objectCount; i++) {
+            glVertexAttrib3fv(attributeInstance, &instances[i * 3]);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+    } else {
+        glState.BindBuffer(GL_ARRAY_BUFFER, vboInstances);
+        glState.EnableVertexAttribArray(attributeInstance);
+        glState.VertexAttribPointer(attributeInstance, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        glState.VertexAttribDivisor(attributeInstance, 1);
+        if (drawPath == DRAW_INSTANCED) {
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 3, objectCount);
+        } else {
+            glState.BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+            glMultiDrawArraysIndirect(GL_TRIANGLES, 0, objectCount, 0);
+        }
+    }
+    glState.EndFrame();
+    TimelineSwapBuffers();
+}
@@ -0,0 +1,21 @@
+#ifndef OBJECTS_H
+#define OBJECTS_H
+
+#include <GL/glew.h>
+
+// Many copies of the vbo triangle, each with its own offset and scale, drawn
+// either one call per object, with one instanced call, or with one
+// glMultiDrawArraysIndirect call.
+enum DrawPath {
+    DRAW_SINGLE,
+    DRAW_INSTANCED,
+    DRAW_MULTIDRAW
+};
+
+const char *DrawPathName(DrawPath path);
+// Returns the path actually used, falling back when the extensions are missing.
+DrawPath InitObjects(GLuint vertexBuffer, DrawPath path);
+void SetObjectCount(int count);
+void DisplayObjects();
+
+#endif // OBJECTS_H
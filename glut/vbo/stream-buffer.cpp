@@ -0,0 +1,95 @@
+#include "gl-state.h"
+#include "stream-buffer.h"
+
+StreamBuffer::StreamBuffer(GLenum target, GLsizeiptr regionSize, int regions, Strategy preferred)
+    : stalls(0), orphans(0), target(target), bufferId(0), strategy(preferred),
+      regionSize(regionSize), regions(regions), region(0), offset(0), persistent(NULL) {
+    fences = new GLsync[regions]();
+    if (strategy == PERSISTENT && !(GLEW_ARB_buffer_storage && GLEW_ARB_sync)) strategy = MAP_RANGE;
+    if (strategy == MAP_RANGE && !(GLEW_ARB_map_buffer_range && GLEW_ARB_sync)) strategy = ORPHAN;
+    glGenBuffers(1, &bufferId);
+    glState.BindBuffer(target, bufferId);
+    if (strategy == PERSISTENT) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(target, regionSize * regions, NULL, flags);
+        persistent = (char *) glMapBufferRange(target, 0, regionSize * regions, flags);
+        if (!persistent) {
+            // Immutable storage cannot be respecified, so the fallback needs
+            // a buffer of its own.
+            cerr << "stream buffer persistent map [ ERROR ]" << endl;
+            glState.BindBuffer(target, 0);
+            glDeleteBuffers(1, &bufferId);
+            glGenBuffers(1, &bufferId);
+            glState.BindBuffer(target, bufferId);
+            strategy = GLEW_ARB_map_buffer_range ? MAP_RANGE : ORPHAN;
+        }
+    }
+    if (strategy == MAP_RANGE)
+        glBufferData(target, regionSize * regions, NULL, GL_STREAM_DRAW);
+    else if (strategy == ORPHAN)
+        glBufferData(target, regionSize, NULL, GL_STREAM_DRAW);
+    cerr << "stream buffer " << StrategyName(strategy) << " [ OK ]" << endl;
+}
+
+StreamBuffer::~StreamBuffer() {
+    for (int i = 0; i < regions; i++)
+        if (fences[i]) glDeleteSync(fences[i]);
+    delete[] fences;
+    if (persistent) {
+        glState.BindBuffer(target, bufferId);
+        glUnmapBuffer(target);
+    }
+    glDeleteBuffers(1, &bufferId);
+}
+
+const char *StreamBuffer::StrategyName(Strategy strategy) {
+    switch (strategy) {
+    case PERSISTENT: return "persistent";
+    case MAP_RANGE: return "map";
+    default: return "orphan";
+    }
+}
+
+void StreamBuffer::WaitRegion(int region) {
+    if (!fences[region]) return;
+    GLenum result = glClientWaitSync(fences[region], 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        stalls++;
+        do {
+            result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fences[region]);
+    fences[region] = 0;
+}
+
+void *StreamBuffer::Map(GLsizeiptr size) {
+    if (size > regionSize) return NULL;
+    glState.BindBuffer(target, bufferId);
+    if (strategy == ORPHAN) {
+        // Last resort: hand the old storage to the driver and get fresh memory.
+        orphans++;
+        offset = 0;
+        glBufferData(target, regionSize, NULL, GL_STREAM_DRAW);
+        if (GLEW_ARB_map_buffer_range)
+            return glMapBufferRange(target, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        return glMapBuffer(target, GL_WRITE_ONLY);
+    }
+    WaitRegion(region);
+    offset = region * regionSize;
+    if (strategy == PERSISTENT) return persistent + offset;
+    return glMapBufferRange(target, offset, size,
+                            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+}
+
+void StreamBuffer::Unmap() {
+    if (strategy == PERSISTENT) return;
+    glState.BindBuffer(target, bufferId);
+    glUnmapBuffer(target);
+}
+
+void StreamBuffer::EndFrame() {
+    if (strategy == ORPHAN) return;
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region = (region + 1) % regions;
+}
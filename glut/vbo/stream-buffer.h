@@ -0,0 +1,46 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <iostream>
+using namespace std;
+
+#include <GL/glew.h>
+
+// Ring of per-frame regions for geometry rewritten every frame. The buffer
+// is split into `regions` equal parts; a frame writes into one part, fences
+// it in EndFrame() and only reuses it once the GPU has passed that fence.
+class StreamBuffer {
+public:
+    enum Strategy {
+        PERSISTENT,     // ARB_buffer_storage, mapped once for the lifetime;
+                        // MAP_RANGE (or ORPHAN) when that mapping fails
+        MAP_RANGE,      // unsynchronized glMapBufferRange per frame
+        ORPHAN          // glBufferData(NULL) + map, no fences needed
+    };
+    StreamBuffer(GLenum target, GLsizeiptr regionSize, int regions = 3, Strategy preferred = PERSISTENT);
+    ~StreamBuffer();
+    // Up to regionSize bytes per frame; Offset() is where they land. NULL
+    // when the driver fails to map, and then there is nothing to Unmap.
+    void *Map(GLsizeiptr size);
+    void Unmap();
+    void EndFrame();
+    GLintptr Offset() const { return offset; }
+    GLuint getBufferId() const { return bufferId; }
+    Strategy getStrategy() const { return strategy; }
+    static const char *StrategyName(Strategy strategy);
+    unsigned long stalls;
+    unsigned long orphans;
+private:
+    void WaitRegion(int region);
+    GLenum target;
+    GLuint bufferId;
+    Strategy strategy;
+    GLsizeiptr regionSize;
+    int regions;
+    int region;
+    GLintptr offset;
+    char *persistent;
+    GLsync *fences;
+};
+
+#endif // STREAM_BUFFER_H
@@ -0,0 +1,157 @@
+/*
+ * Every call the API trace records, as X-macros. Includers define:
+ *
+ * API_TRACE_GL(name, params, args, sig, replay, shadow)
+ *   A void GL ES 2 function whose arguments are all scalars. sig has one
+ *   character per argument: 'i' for integers, 'f' for floats. replay is the
+ *   argument list the replayer passes, built from I(n)/F(n) for argument n
+ *   as recorded and BUF/TEX/FBO/RBO/PRG/SHD(n) for object names, LOC(n) for
+ *   uniform locations and USE(n) for the program of glUseProgram. shadow is
+ *   evaluated by the capture library after the call to track state it needs
+ *   for client arrays, 0 when there is none.
+ *
+ * API_TRACE_UNIFORM(name, type, components)
+ *   glUniform{1234}{if}v: location, count, count * components values.
+ *
+ * API_TRACE_MATRIX(name, components)
+ *   glUniformMatrix{234}fv: location, count, transpose, the values.
+ *
+ * API_TRACE_ATTRIB(name, components)
+ *   glVertexAttrib{1234}fv: index, the values.
+ *
+ * API_TRACE_CUSTOM(name)
+ *   Encoded by hand on both sides.
+ *
+ * New calls go at the end, see api_trace_format.h.
+ */
+
+API_TRACE_GL(glActiveTexture, (GLenum texture), (texture), "i", (I(0)), 0)
+API_TRACE_GL(glAttachShader, (GLuint program, GLuint shader), (program, shader), "ii", (PRG(0), SHD(1)), 0)
+API_TRACE_GL(glBindBuffer, (GLenum target, GLuint buffer), (target, buffer), "ii", (I(0), BUF(1)), trace_bind_buffer(target, buffer))
+API_TRACE_GL(glBindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer), "ii", (I(0), FBO(1)), 0)
+API_TRACE_GL(glBindRenderbuffer, (GLenum target, GLuint renderbuffer), (target, renderbuffer), "ii", (I(0), RBO(1)), 0)
+API_TRACE_GL(glBindTexture, (GLenum target, GLuint texture), (target, texture), "ii", (I(0), TEX(1)), 0)
+API_TRACE_GL(glBlendColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha), "ffff", (F(0), F(1), F(2), F(3)), 0)
+API_TRACE_GL(glBlendEquation, (GLenum mode), (mode), "i", (I(0)), 0)
+API_TRACE_GL(glBlendEquationSeparate, (GLenum modeRGB, GLenum modeAlpha), (modeRGB, modeAlpha), "ii", (I(0), I(1)), 0)
+API_TRACE_GL(glBlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor), "ii", (I(0), I(1)), 0)
+API_TRACE_GL(glBlendFuncSeparate, (GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha), (srcRGB, dstRGB, srcAlpha, dstAlpha), "iiii", (I(0), I(1), I(2), I(3)), 0)
+API_TRACE_GL(glClear, (GLbitfield mask), (mask), "i", (I(0)), 0)
+API_TRACE_GL(glClearColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha), "ffff", (F(0), F(1), F(2), F(3)), 0)
+API_TRACE_GL(glClearDepthf, (GLfloat depth), (depth), "f", (F(0)), 0)
+API_TRACE_GL(glClearStencil, (GLint s), (s), "i", (I(0)), 0)
+API_TRACE_GL(glColorMask, (GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha), (red, green, blue, alpha), "iiii", (I(0), I(1), I(2), I(3)), 0)
+API_TRACE_GL(glCompileShader, (GLuint shader), (shader), "i", (SHD(0)), 0)
+API_TRACE_GL(glCopyTexImage2D, (GLenum target, GLint level, GLenum internalformat, GLint x, GLint y, GLsizei width, GLsizei height, GLint border), (target, level, internalformat, x, y, width, height, border), "iiiiiiii", (I(0), I(1), I(2), I(3), I(4), I(5), I(6), I(7)), 0)
+API_TRACE_GL(glCopyTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height), (target, level, xoffset, yoffset, x, y, width, height), "iiiiiiii", (I(0), I(1), I(2), I(3), I(4), I(5), I(6), I(7)), 0)
+API_TRACE_GL(glCullFace, (GLenum mode), (mode), "i", (I(0)), 0)
+API_TRACE_GL(glDeleteProgram, (GLuint program), (program), "i", (PRG(0)), 0)
+API_TRACE_GL(glDeleteShader, (GLuint shader), (shader), "i", (SHD(0)), 0)
+API_TRACE_GL(glDepthFunc, (GLenum func), (func), "i", (I(0)), 0)
+API_TRACE_GL(glDepthMask, (GLboolean flag), (flag), "i", (I(0)), 0)
+API_TRACE_GL(glDepthRangef, (GLfloat n, GLfloat f), (n, f), "ff", (F(0), F(1)), 0)
+API_TRACE_GL(glDetachShader, (GLuint program, GLuint shader), (program, shader), "ii", (PRG(0), SHD(1)), 0)
+API_TRACE_GL(glDisable, (GLenum cap), (cap), "i", (I(0)), 0)
+API_TRACE_GL(glDisableVertexAttribArray, (GLuint index), (index), "i", (I(0)), trace_enable_attrib(index, 0))
+API_TRACE_GL(glEnable, (GLenum cap), (cap), "i", (I(0)), 0)
+API_TRACE_GL(glEnableVertexAttribArray, (GLuint index), (index), "i", (I(0)), trace_enable_attrib(index, 1))
+API_TRACE_GL(glFinish, (void), (), "", (), 0)
+API_TRACE_GL(glFlush, (void), (), "", (), 0)
+API_TRACE_GL(glFramebufferRenderbuffer, (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer), (target, attachment, renderbuffertarget, renderbuffer), "iiii", (I(0), I(1), I(2), RBO(3)), 0)
+API_TRACE_GL(glFramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level), (target, attachment, textarget, texture, level), "iiiii", (I(0), I(1), I(2), TEX(3), I(4)), 0)
+API_TRACE_GL(glFrontFace, (GLenum mode), (mode), "i", (I(0)), 0)
+API_TRACE_GL(glGenerateMipmap, (GLenum target), (target), "i", (I(0)), 0)
+API_TRACE_GL(glHint, (GLenum target, GLenum mode), (target, mode), "ii", (I(0), I(1)), 0)
+API_TRACE_GL(glLineWidth, (GLfloat width), (width), "f", (F(0)), 0)
+API_TRACE_GL(glLinkProgram, (GLuint program), (program), "i", (PRG(0)), 0)
+API_TRACE_GL(glPixelStorei, (GLenum pname, GLint param), (pname, param), "ii", (I(0), I(1)), trace_pixel_store(pname, param))
+API_TRACE_GL(glPolygonOffset, (GLfloat factor, GLfloat units), (factor, units), "ff", (F(0), F(1)), 0)
+API_TRACE_GL(glReleaseShaderCompiler, (void), (), "", (), 0)
+API_TRACE_GL(glRenderbufferStorage, (GLenum target, GLenum internalformat, GLsizei width, GLsizei height), (target, internalformat, width, height), "iiii", (I(0), I(1), I(2), I(3)), 0)
+API_TRACE_GL(glSampleCoverage, (GLfloat value, GLboolean invert), (value, invert), "fi", (F(0), I(1)), 0)
+API_TRACE_GL(glScissor, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height), "iiii", (I(0), I(1), I(2), I(3)), 0)
+API_TRACE_GL(glStencilFunc, (GLenum func, GLint ref, GLuint mask), (func, ref, mask), "iii", (I(0), I(1), I(2)), 0)
+API_TRACE_GL(glStencilFuncSeparate, (GLenum face, GLenum func, GLint ref, GLuint mask), (face, func, ref, mask), "iiii", (I(0), I(1), I(2), I(3)), 0)
+API_TRACE_GL(glStencilMask, (GLuint mask), (mask), "i", (I(0)), 0)
+API_TRACE_GL(glStencilMaskSeparate, (GLenum face, GLuint mask), (face, mask), "ii", (I(0), I(1)), 0)
+API_TRACE_GL(glStencilOp, (GLenum fail, GLenum zfail, GLenum zpass), (fail, zfail, zpass), "iii", (I(0), I(1), I(2)), 0)
+API_TRACE_GL(glStencilOpSeparate, (GLenum face, GLenum sfail, GLenum dpfail, GLenum dppass), (face, sfail, dpfail, dppass), "iiii", (I(0), I(1), I(2), I(3)), 0)
+API_TRACE_GL(glTexParameterf, (GLenum target, GLenum pname, GLfloat param), (target, pname, param), "iif", (I(0), I(1), F(2)), 0)
+API_TRACE_GL(glTexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param), "iii", (I(0), I(1), I(2)), 0)
+API_TRACE_GL(glUniform1f, (GLint location, GLfloat v0), (location, v0), "if", (LOC(0), F(1)), 0)
+API_TRACE_GL(glUniform2f, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1), "iff", (LOC(0), F(1), F(2)), 0)
+API_TRACE_GL(glUniform3f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2), (location, v0, v1, v2), "ifff", (LOC(0), F(1), F(2), F(3)), 0)
+API_TRACE_GL(glUniform4f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (location, v0, v1, v2, v3), "iffff", (LOC(0), F(1), F(2), F(3), F(4)), 0)
+API_TRACE_GL(glUniform1i, (GLint location, GLint v0), (location, v0), "ii", (LOC(0), I(1)), 0)
+API_TRACE_GL(glUniform2i, (GLint location, GLint v0, GLint v1), (location, v0, v1), "iii", (LOC(0), I(1), I(2)), 0)
+API_TRACE_GL(glUniform3i, (GLint location, GLint v0, GLint v1, GLint v2), (location, v0, v1, v2), "iiii", (LOC(0), I(1), I(2), I(3)), 0)
+API_TRACE_GL(glUniform4i, (GLint location, GLint v0, GLint v1, GLint v2, GLint v3), (location, v0, v1, v2, v3), "iiiii", (LOC(0), I(1), I(2), I(3), I(4)), 0)
+API_TRACE_GL(glUseProgram, (GLuint program), (program), "i", (USE(0)), 0)
+API_TRACE_GL(glValidateProgram, (GLuint program), (program), "i", (PRG(0)), 0)
+API_TRACE_GL(glVertexAttrib1f, (GLuint index, GLfloat x), (index, x), "if", (I(0), F(1)), 0)
+API_TRACE_GL(glVertexAttrib2f, (GLuint index, GLfloat x, GLfloat y), (index, x, y), "iff", (I(0), F(1), F(2)), 0)
+API_TRACE_GL(glVertexAttrib3f, (GLuint index, GLfloat x, GLfloat y, GLfloat z), (index, x, y, z), "ifff", (I(0), F(1), F(2), F(3)), 0)
+API_TRACE_GL(glVertexAttrib4f, (GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w), (index, x, y, z, w), "iffff", (I(0), F(1), F(2), F(3), F(4)), 0)
+API_TRACE_GL(glViewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height), "iiii", (I(0), I(1), I(2), I(3)), 0)
+
+API_TRACE_UNIFORM(glUniform1fv, GLfloat, 1)
+API_TRACE_UNIFORM(glUniform2fv, GLfloat, 2)
+API_TRACE_UNIFORM(glUniform3fv, GLfloat, 3)
+API_TRACE_UNIFORM(glUniform4fv, GLfloat, 4)
+API_TRACE_UNIFORM(glUniform1iv, GLint, 1)
+API_TRACE_UNIFORM(glUniform2iv, GLint, 2)
+API_TRACE_UNIFORM(glUniform3iv, GLint, 3)
+API_TRACE_UNIFORM(glUniform4iv, GLint, 4)
+API_TRACE_MATRIX(glUniformMatrix2fv, 4)
+API_TRACE_MATRIX(glUniformMatrix3fv, 9)
+API_TRACE_MATRIX(glUniformMatrix4fv, 16)
+API_TRACE_ATTRIB(glVertexAttrib1fv, 1)
+API_TRACE_ATTRIB(glVertexAttrib2fv, 2)
+API_TRACE_ATTRIB(glVertexAttrib3fv, 3)
+API_TRACE_ATTRIB(glVertexAttrib4fv, 4)
+
+API_TRACE_CUSTOM(glBindAttribLocation)
+API_TRACE_CUSTOM(glBufferData)
+API_TRACE_CUSTOM(glBufferSubData)
+API_TRACE_CUSTOM(glCompressedTexImage2D)
+API_TRACE_CUSTOM(glCompressedTexSubImage2D)
+API_TRACE_CUSTOM(glCreateProgram)
+API_TRACE_CUSTOM(glCreateShader)
+API_TRACE_CUSTOM(glDeleteBuffers)
+API_TRACE_CUSTOM(glDeleteFramebuffers)
+API_TRACE_CUSTOM(glDeleteRenderbuffers)
+API_TRACE_CUSTOM(glDeleteTextures)
+API_TRACE_CUSTOM(glDrawArrays)
+API_TRACE_CUSTOM(glDrawElements)
+API_TRACE_CUSTOM(glGenBuffers)
+API_TRACE_CUSTOM(glGenFramebuffers)
+API_TRACE_CUSTOM(glGenRenderbuffers)
+API_TRACE_CUSTOM(glGenTextures)
+API_TRACE_CUSTOM(glGetAttribLocation)
+API_TRACE_CUSTOM(glGetUniformLocation)
+API_TRACE_CUSTOM(glReadPixels)
+API_TRACE_CUSTOM(glShaderSource)
+API_TRACE_CUSTOM(glTexImage2D)
+API_TRACE_CUSTOM(glTexParameterfv)
+API_TRACE_CUSTOM(glTexParameteriv)
+API_TRACE_CUSTOM(glTexSubImage2D)
+API_TRACE_CUSTOM(glVertexAttribPointer)
+
+/* Client side vertex data for the next draw: index, size, type, normalized,
+ * stride, first vertex, the bytes from the first to the last vertex used. */
+API_TRACE_CUSTOM(ClientArray)
+
+API_TRACE_CUSTOM(eglGetDisplay)
+API_TRACE_CUSTOM(eglInitialize)
+API_TRACE_CUSTOM(eglTerminate)
+API_TRACE_CUSTOM(eglBindAPI)
+API_TRACE_CUSTOM(eglChooseConfig)
+API_TRACE_CUSTOM(eglCreateWindowSurface)
+API_TRACE_CUSTOM(eglCreatePixmapSurface)
+API_TRACE_CUSTOM(eglCreatePbufferSurface)
+API_TRACE_CUSTOM(eglDestroySurface)
+API_TRACE_CUSTOM(eglCreateContext)
+API_TRACE_CUSTOM(eglDestroyContext)
+API_TRACE_CUSTOM(eglMakeCurrent)
+API_TRACE_CUSTOM(eglSwapBuffers)
+API_TRACE_CUSTOM(eglSwapInterval)
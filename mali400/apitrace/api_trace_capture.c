@@ -0,0 +1,1405 @@
+/*
+ * API trace capture library.
+ *
+ * Preload it into a GL ES 2 / EGL application to record every call that
+ * affects rendering into a binary trace (see api_trace_format.h):
+ *
+ *   API_TRACE_FILE=app.trace LD_PRELOAD=./libapitrace.so ./app
+ *
+ * Queries (glGet*, glIs*, glCheckFramebufferStatus, glGetError, ...) go
+ * straight to the driver without being recorded; the replayer does not need
+ * them. Client side vertex arrays are captured at draw time for the range of
+ * vertices the draw reads. The client array shadow is process wide, so
+ * applications drawing from client arrays in several contexts at once are
+ * not supported.
+ */
+
+#define _GNU_SOURCE
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+#ifdef API_TRACE_FBDEV
+#include <EGL/fbdev_window.h>
+#endif
+
+#include "api_trace_format.h"
+
+#define TRACE_EXPORT __attribute__((visibility("default")))
+
+#define TRACE_MAX_ATTRIBS 16
+#define TRACE_MAX_SHADOW_BUFFER 65536
+
+struct trace_attrib
+{
+	GLboolean enabled;
+	GLint size;
+	GLenum type;
+	GLboolean normalized;
+	GLsizei stride;
+	const void* pointer;
+	GLuint buffer;
+};
+
+struct trace_shadow_buffer
+{
+	unsigned char* data;
+	GLsizeiptr size;
+};
+
+static FILE* trace_file;
+static pthread_mutex_t trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static __thread int trace_nested;
+static uint64_t trace_last_us;
+
+static struct trace_attrib trace_attribs[TRACE_MAX_ATTRIBS];
+static GLuint trace_array_buffer;
+static GLuint trace_element_buffer;
+static GLint trace_unpack_alignment = 4;
+static struct trace_shadow_buffer trace_element_shadow[TRACE_MAX_SHADOW_BUFFER];
+
+/* ------------------------------------------------------------------------ */
+/* writing */
+
+static void
+put_uvarint(uint64_t v)
+{
+	while (v >= 0x80)
+	{
+		putc_unlocked((int)(v & 0x7f) | 0x80, trace_file);
+		v >>= 7;
+	}
+	putc_unlocked((int)v, trace_file);
+}
+
+static void
+put_int(int64_t v)
+{
+	put_uvarint(((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+static void
+put_float(float f)
+{
+	uint32_t bits;
+	int i;
+
+	memcpy(&bits, &f, sizeof(bits));
+	for (i = 0; i < 4; i++)
+	{
+		putc_unlocked((int)(bits >> (i * 8)) & 0xff, trace_file);
+	}
+}
+
+static void
+put_handle(const void* handle)
+{
+	put_uvarint((uintptr_t)handle);
+}
+
+static void
+put_blob(const void* data, size_t size)
+{
+	if (data == NULL)
+	{
+		put_uvarint(0);
+		return;
+	}
+	put_uvarint((uint64_t)size + 1);
+	fwrite_unlocked(data, 1, size, trace_file);
+}
+
+static void
+put_string(const char* s)
+{
+	put_blob(s, s != NULL ? strlen(s) : 0);
+}
+
+static uint64_t
+trace_now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void
+put_call(enum api_trace_call call)
+{
+	uint64_t now = trace_now_us();
+
+	put_uvarint(call);
+	put_uvarint(now - trace_last_us);
+	trace_last_us = now;
+}
+
+static void
+put_scalars(const char* sig, ...)
+{
+	va_list ap;
+
+	va_start(ap, sig);
+	for (; *sig != '\0'; sig++)
+	{
+		if (*sig == 'f')
+		{
+			put_float((float)va_arg(ap, double));
+		}
+		else
+		{
+			put_int(va_arg(ap, int));
+		}
+	}
+	va_end(ap);
+}
+
+/* EGL attribute lists: number of pairs, -1 for NULL, then the pairs. */
+static void
+put_attrib_list(const EGLint* list)
+{
+	int n = 0;
+	int i;
+
+	if (list == NULL)
+	{
+		put_int(-1);
+		return;
+	}
+	while (list[n * 2] != EGL_NONE)
+	{
+		n++;
+	}
+	put_int(n);
+	for (i = 0; i < n * 2; i++)
+	{
+		put_int(list[i]);
+	}
+}
+
+/* ------------------------------------------------------------------------ */
+/* locking and setup */
+
+/* Returns nonzero when the call should be recorded. Calls the driver makes
+ * into its own exported entry points are not. */
+static int
+trace_lock(void)
+{
+	if (trace_nested++ != 0 || trace_file == NULL)
+	{
+		return 0;
+	}
+	pthread_mutex_lock(&trace_mutex);
+	return 1;
+}
+
+static void
+trace_unlock(int recording)
+{
+	if (recording)
+	{
+		pthread_mutex_unlock(&trace_mutex);
+	}
+	trace_nested--;
+}
+
+static void*
+trace_resolve(const char* name)
+{
+	static __eglMustCastToProperFunctionPointerType (*real_get_proc)(const char*);
+	void* proc = dlsym(RTLD_NEXT, name);
+
+	if (proc == NULL)
+	{
+		if (real_get_proc == NULL)
+		{
+			real_get_proc = dlsym(RTLD_NEXT, "eglGetProcAddress");
+		}
+		if (real_get_proc != NULL)
+		{
+			proc = (void*)real_get_proc(name);
+		}
+	}
+	if (proc == NULL)
+	{
+		fprintf(stderr, "apitrace: %s not found\n", name);
+		abort();
+	}
+	return proc;
+}
+
+#define TRACE_REAL(name) \
+	static __typeof__(name)* real_##name; \
+	if (real_##name == NULL) \
+	{ \
+		real_##name = (__typeof__(name)*)trace_resolve(#name); \
+	}
+
+__attribute__((constructor)) static void
+trace_open(void)
+{
+	const char* path = getenv("API_TRACE_FILE");
+	uint32_t header[2] = { API_TRACE_VERSION, sizeof(void*) };
+	unsigned char bytes[8];
+	int i;
+
+	if (path == NULL)
+	{
+		path = "api.trace";
+	}
+	trace_file = fopen(path, "wb");
+	if (trace_file == NULL)
+	{
+		perror(path);
+		return;
+	}
+	for (i = 0; i < 8; i++)
+	{
+		bytes[i] = (unsigned char)(header[i / 4] >> ((i % 4) * 8));
+	}
+	fwrite(API_TRACE_MAGIC, 1, API_TRACE_MAGIC_SIZE, trace_file);
+	fwrite(bytes, 1, sizeof(bytes), trace_file);
+	trace_last_us = trace_now_us();
+}
+
+__attribute__((destructor)) static void
+trace_close(void)
+{
+	pthread_mutex_lock(&trace_mutex);
+	if (trace_file != NULL)
+	{
+		fclose(trace_file);
+		trace_file = NULL;
+	}
+	pthread_mutex_unlock(&trace_mutex);
+}
+
+/* ------------------------------------------------------------------------ */
+/* shadowed state */
+
+static int
+trace_bind_buffer(GLenum target, GLuint buffer)
+{
+	if (target == GL_ARRAY_BUFFER)
+	{
+		trace_array_buffer = buffer;
+	}
+	else if (target == GL_ELEMENT_ARRAY_BUFFER)
+	{
+		trace_element_buffer = buffer;
+	}
+	return 0;
+}
+
+static int
+trace_enable_attrib(GLuint index, GLboolean enabled)
+{
+	if (index < TRACE_MAX_ATTRIBS)
+	{
+		trace_attribs[index].enabled = enabled;
+	}
+	return 0;
+}
+
+static int
+trace_pixel_store(GLenum pname, GLint param)
+{
+	if (pname == GL_UNPACK_ALIGNMENT)
+	{
+		trace_unpack_alignment = param;
+	}
+	return 0;
+}
+
+static size_t
+trace_type_size(GLenum type)
+{
+	switch (type)
+	{
+	case GL_BYTE:
+	case GL_UNSIGNED_BYTE:
+		return 1;
+	case GL_SHORT:
+	case GL_UNSIGNED_SHORT:
+	case GL_HALF_FLOAT_OES:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+/* Bytes glTexImage2D/glTexSubImage2D read for the current unpack alignment. */
+static size_t
+trace_image_size(GLsizei width, GLsizei height, GLenum format, GLenum type)
+{
+	size_t components;
+	size_t pixel;
+	size_t row;
+
+	if (width <= 0 || height <= 0)
+	{
+		return 0;
+	}
+	switch (format)
+	{
+	case GL_ALPHA:
+	case GL_LUMINANCE:
+	case GL_DEPTH_COMPONENT:
+		components = 1;
+		break;
+	case GL_LUMINANCE_ALPHA:
+		components = 2;
+		break;
+	case GL_RGB:
+		components = 3;
+		break;
+	default:
+		components = 4;
+		break;
+	}
+	switch (type)
+	{
+	case GL_UNSIGNED_SHORT_5_6_5:
+	case GL_UNSIGNED_SHORT_4_4_4_4:
+	case GL_UNSIGNED_SHORT_5_5_5_1:
+		pixel = 2;
+		break;
+	case GL_UNSIGNED_INT_24_8_OES:
+		pixel = 4;
+		break;
+	default:
+		pixel = components * trace_type_size(type);
+		break;
+	}
+	row = (width * pixel + trace_unpack_alignment - 1) / trace_unpack_alignment * trace_unpack_alignment;
+	return row * (height - 1) + width * pixel;
+}
+
+static void
+trace_shadow_element_data(GLintptr offset, GLsizeiptr size, const void* data, int reallocate)
+{
+	struct trace_shadow_buffer* shadow;
+
+	if (trace_element_buffer >= TRACE_MAX_SHADOW_BUFFER)
+	{
+		return;
+	}
+	shadow = &trace_element_shadow[trace_element_buffer];
+	if (reallocate)
+	{
+		free(shadow->data);
+		shadow->data = calloc(1, size > 0 ? size : 1);
+		shadow->size = shadow->data != NULL ? size : 0;
+	}
+	if (data != NULL && offset >= 0 && offset + size <= shadow->size)
+	{
+		memcpy(shadow->data + offset, data, size);
+	}
+}
+
+/* Records the vertices [first, first + count) of every enabled client array
+ * ahead of a draw. */
+static void
+trace_client_arrays(GLint first, GLsizei count)
+{
+	int i;
+
+	for (i = 0; i < TRACE_MAX_ATTRIBS; i++)
+	{
+		const struct trace_attrib* a = &trace_attribs[i];
+		size_t element;
+		size_t stride;
+
+		if (!a->enabled || a->buffer != 0 || a->pointer == NULL || count <= 0)
+		{
+			continue;
+		}
+		element = a->size * trace_type_size(a->type);
+		stride = a->stride != 0 ? (size_t)a->stride : element;
+
+		put_call(API_TRACE_CALL_ClientArray);
+		put_scalars("iiiiii", i, a->size, a->type, a->normalized, a->stride, first);
+		put_blob((const unsigned char*)a->pointer + first * stride, (count - 1) * stride + element);
+	}
+}
+
+static int
+trace_has_client_arrays(void)
+{
+	int i;
+
+	for (i = 0; i < TRACE_MAX_ATTRIBS; i++)
+	{
+		if (trace_attribs[i].enabled && trace_attribs[i].buffer == 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* ------------------------------------------------------------------------ */
+/* GL ES 2 */
+
+#define TRACE_ARGS(...) , ##__VA_ARGS__
+
+#define API_TRACE_GL(name, params, args, sig, replay, shadow) \
+	TRACE_EXPORT void GL_APIENTRY name params \
+	{ \
+		int recording; \
+		TRACE_REAL(name) \
+		recording = trace_lock(); \
+		if (recording) \
+		{ \
+			put_call(API_TRACE_CALL_##name); \
+			put_scalars(sig TRACE_ARGS args); \
+		} \
+		real_##name args; \
+		(void)(shadow); \
+		trace_unlock(recording); \
+	}
+#define API_TRACE_UNIFORM(name, type, components) \
+	TRACE_EXPORT void GL_APIENTRY name(GLint location, GLsizei count, const type* value) \
+	{ \
+		int recording; \
+		TRACE_REAL(name) \
+		recording = trace_lock(); \
+		if (recording) \
+		{ \
+			put_call(API_TRACE_CALL_##name); \
+			put_scalars("ii", location, count); \
+			put_blob(value, count * components * sizeof(type)); \
+		} \
+		real_##name(location, count, value); \
+		trace_unlock(recording); \
+	}
+#define API_TRACE_MATRIX(name, components) \
+	TRACE_EXPORT void GL_APIENTRY name(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) \
+	{ \
+		int recording; \
+		TRACE_REAL(name) \
+		recording = trace_lock(); \
+		if (recording) \
+		{ \
+			put_call(API_TRACE_CALL_##name); \
+			put_scalars("iii", location, count, transpose); \
+			put_blob(value, count * components * sizeof(GLfloat)); \
+		} \
+		real_##name(location, count, transpose, value); \
+		trace_unlock(recording); \
+	}
+#define API_TRACE_ATTRIB(name, components) \
+	TRACE_EXPORT void GL_APIENTRY name(GLuint index, const GLfloat* v) \
+	{ \
+		int recording; \
+		TRACE_REAL(name) \
+		recording = trace_lock(); \
+		if (recording) \
+		{ \
+			put_call(API_TRACE_CALL_##name); \
+			put_scalars("i", index); \
+			put_blob(v, components * sizeof(GLfloat)); \
+		} \
+		real_##name(index, v); \
+		trace_unlock(recording); \
+	}
+#define API_TRACE_CUSTOM(name)
+#include "api_trace_calls.h"
+#undef API_TRACE_GL
+#undef API_TRACE_UNIFORM
+#undef API_TRACE_MATRIX
+#undef API_TRACE_ATTRIB
+#undef API_TRACE_CUSTOM
+
+#define TRACE_GEN(name) \
+	TRACE_EXPORT void GL_APIENTRY name(GLsizei n, GLuint* names) \
+	{ \
+		int recording; \
+		GLsizei i; \
+		TRACE_REAL(name) \
+		recording = trace_lock(); \
+		real_##name(n, names); \
+		if (recording) \
+		{ \
+			put_call(API_TRACE_CALL_##name); \
+			put_int(n); \
+			for (i = 0; i < n; i++) \
+			{ \
+				put_int(names[i]); \
+			} \
+		} \
+		trace_unlock(recording); \
+	}
+
+#define TRACE_DELETE(name) \
+	TRACE_EXPORT void GL_APIENTRY name(GLsizei n, const GLuint* names) \
+	{ \
+		int recording; \
+		GLsizei i; \
+		TRACE_REAL(name) \
+		recording = trace_lock(); \
+		if (recording) \
+		{ \
+			put_call(API_TRACE_CALL_##name); \
+			put_int(n); \
+			for (i = 0; i < n; i++) \
+			{ \
+				put_int(names[i]); \
+			} \
+		} \
+		real_##name(n, names); \
+		trace_unlock(recording); \
+	}
+
+TRACE_GEN(glGenBuffers)
+TRACE_GEN(glGenFramebuffers)
+TRACE_GEN(glGenRenderbuffers)
+TRACE_GEN(glGenTextures)
+TRACE_DELETE(glDeleteFramebuffers)
+TRACE_DELETE(glDeleteRenderbuffers)
+TRACE_DELETE(glDeleteTextures)
+
+TRACE_EXPORT void GL_APIENTRY
+glDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+	int recording;
+	GLsizei i;
+	TRACE_REAL(glDeleteBuffers)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glDeleteBuffers);
+		put_int(n);
+		for (i = 0; i < n; i++)
+		{
+			put_int(buffers[i]);
+		}
+	}
+	for (i = 0; i < n; i++)
+	{
+		if (buffers[i] < TRACE_MAX_SHADOW_BUFFER)
+		{
+			free(trace_element_shadow[buffers[i]].data);
+			trace_element_shadow[buffers[i]].data = NULL;
+			trace_element_shadow[buffers[i]].size = 0;
+		}
+		if (buffers[i] == trace_array_buffer)
+		{
+			trace_array_buffer = 0;
+		}
+		if (buffers[i] == trace_element_buffer)
+		{
+			trace_element_buffer = 0;
+		}
+	}
+	real_glDeleteBuffers(n, buffers);
+	trace_unlock(recording);
+}
+
+TRACE_EXPORT GLuint GL_APIENTRY
+glCreateProgram(void)
+{
+	int recording;
+	GLuint result;
+	TRACE_REAL(glCreateProgram)
+
+	recording = trace_lock();
+	result = real_glCreateProgram();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glCreateProgram);
+		put_int(result);
+	}
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT GLuint GL_APIENTRY
+glCreateShader(GLenum type)
+{
+	int recording;
+	GLuint result;
+	TRACE_REAL(glCreateShader)
+
+	recording = trace_lock();
+	result = real_glCreateShader(type);
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glCreateShader);
+		put_scalars("ii", type, result);
+	}
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT void GL_APIENTRY
+glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)
+{
+	int recording;
+	GLsizei i;
+	TRACE_REAL(glShaderSource)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glShaderSource);
+		put_scalars("ii", shader, count);
+		for (i = 0; i < count; i++)
+		{
+			if (length != NULL && length[i] >= 0)
+			{
+				put_blob(string[i], length[i]);
+			}
+			else
+			{
+				put_string(string[i]);
+			}
+		}
+	}
+	real_glShaderSource(shader, count, string, length);
+	trace_unlock(recording);
+}
+
+TRACE_EXPORT void GL_APIENTRY
+glBindAttribLocation(GLuint program, GLuint index, const GLchar* name)
+{
+	int recording;
+	TRACE_REAL(glBindAttribLocation)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glBindAttribLocation);
+		put_scalars("ii", program, index);
+		put_string(name);
+	}
+	real_glBindAttribLocation(program, index, name);
+	trace_unlock(recording);
+}
+
+TRACE_EXPORT GLint GL_APIENTRY
+glGetAttribLocation(GLuint program, const GLchar* name)
+{
+	int recording;
+	GLint result;
+	TRACE_REAL(glGetAttribLocation)
+
+	recording = trace_lock();
+	result = real_glGetAttribLocation(program, name);
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glGetAttribLocation);
+		put_int(program);
+		put_string(name);
+		put_int(result);
+	}
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT GLint GL_APIENTRY
+glGetUniformLocation(GLuint program, const GLchar* name)
+{
+	int recording;
+	GLint result;
+	TRACE_REAL(glGetUniformLocation)
+
+	recording = trace_lock();
+	result = real_glGetUniformLocation(program, name);
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glGetUniformLocation);
+		put_int(program);
+		put_string(name);
+		put_int(result);
+	}
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT void GL_APIENTRY
+glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+	int recording;
+	TRACE_REAL(glBufferData)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glBufferData);
+		put_int(target);
+		put_int(size);
+		put_int(usage);
+		put_blob(data, size);
+	}
+	if (target == GL_ELEMENT_ARRAY_BUFFER)
+	{
+		trace_shadow_element_data(0, size, data, 1);
+	}
+	real_glBufferData(target, size, data, usage);
+	trace_unlock(recording);
+}
+
+TRACE_EXPORT void GL_APIENTRY
+glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+	int recording;
+	TRACE_REAL(glBufferSubData)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glBufferSubData);
+		put_int(target);
+		put_int(offset);
+		put_blob(data, size);
+	}
+	if (target == GL_ELEMENT_ARRAY_BUFFER)
+	{
+		trace_shadow_element_data(offset, size, data, 0);
+	}
+	real_glBufferSubData(target, offset, size, data);
+	trace_unlock(recording);
+}
+
+TRACE_EXPORT void GL_APIENTRY
+glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels)
+{
+	int recording;
+	TRACE_REAL(glTexImage2D)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glTexImage2D);
+		put_scalars("iiiiiiii", target, level, internalformat, width, height, border, format, type);
+		put_blob(pixels, trace_image_size(width, height, format, type));
+	}
+	real_glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+	trace_unlock(recording);
+}
+
+TRACE_EXPORT void GL_APIENTRY
+glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+	int recording;
+	TRACE_REAL(glTexSubImage2D)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glTexSubImage2D);
+		put_scalars("iiiiiiii", target, level, xoffset, yoffset, width, height, format, type);
+		put_blob(pixels, trace_image_size(width, height, format, type));
+	}
+	real_glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+	trace_unlock(recording);
+}
+
+TRACE_EXPORT void GL_APIENTRY
+glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void* data)
+{
+	int recording;
+	TRACE_REAL(glCompressedTexImage2D)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glCompressedTexImage2D);
+		put_scalars("iiiiiii", target, level, internalformat, width, height, border, imageSize);
+		put_blob(data, imageSize);
+	}
+	real_glCompressedTexImage2D(target, level, internalformat, width, height, border, imageSize, data);
+	trace_unlock(recording);
+}
+
+TRACE_EXPORT void GL_APIENTRY
+glCompressedTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void* data)
+{
+	int recording;
+	TRACE_REAL(glCompressedTexSubImage2D)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glCompressedTexSubImage2D);
+		put_scalars("iiiiiiii", target, level, xoffset, yoffset, width, height, format, imageSize);
+		put_blob(data, imageSize);
+	}
+	real_glCompressedTexSubImage2D(target, level, xoffset, yoffset, width, height, format, imageSize, data);
+	trace_unlock(recording);
+}
+
+TRACE_EXPORT void GL_APIENTRY
+glTexParameterfv(GLenum target, GLenum pname, const GLfloat* params)
+{
+	int recording;
+	TRACE_REAL(glTexParameterfv)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glTexParameterfv);
+		put_scalars("iif", target, pname, params[0]);
+	}
+	real_glTexParameterfv(target, pname, params);
+	trace_unlock(recording);
+}
+
+TRACE_EXPORT void GL_APIENTRY
+glTexParameteriv(GLenum target, GLenum pname, const GLint* params)
+{
+	int recording;
+	TRACE_REAL(glTexParameteriv)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glTexParameteriv);
+		put_scalars("iii", target, pname, params[0]);
+	}
+	real_glTexParameteriv(target, pname, params);
+	trace_unlock(recording);
+}
+
+TRACE_EXPORT void GL_APIENTRY
+glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels)
+{
+	int recording;
+	TRACE_REAL(glReadPixels)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_glReadPixels);
+		put_scalars("iiiiii", x, y, width, height, format, type);
+	}
+	real_glReadPixels(x, y, width, height, format, type, pixels);
+	trace_unlock(recording);
+}
+
+TRACE_EXPORT void GL_APIENTRY
+glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer)
+{
+	int recording;
+	TRACE_REAL(glVertexAttribPointer)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		/* client arrays are recorded at draw time, only offsets here */
+		put_call(API_TRACE_CALL_glVertexAttribPointer);
+		put_scalars("iiiiii", index, size, type, normalized, stride, trace_array_buffer != 0);
+		put_int(trace_array_buffer != 0 ? (intptr_t)pointer : 0);
+	}
+	if (index < TRACE_MAX_ATTRIBS)
+	{
+		struct trace_attrib* a = &trace_attribs[index];
+
+		a->size = size;
+		a->type = type;
+		a->normalized = normalized;
+		a->stride = stride;
+		a->pointer = pointer;
+		a->buffer = trace_array_buffer;
+	}
+	real_glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+	trace_unlock(recording);
+}
+
+TRACE_EXPORT void GL_APIENTRY
+glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+	int recording;
+	TRACE_REAL(glDrawArrays)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		trace_client_arrays(first, count);
+		put_call(API_TRACE_CALL_glDrawArrays);
+		put_scalars("iii", mode, first, count);
+	}
+	real_glDrawArrays(mode, first, count);
+	trace_unlock(recording);
+}
+
+TRACE_EXPORT void GL_APIENTRY
+glDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+	int recording;
+	TRACE_REAL(glDrawElements)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		size_t index_size = trace_type_size(type);
+		const unsigned char* data = indices;
+
+		if (trace_element_buffer != 0)
+		{
+			data = NULL;
+			if (trace_element_buffer < TRACE_MAX_SHADOW_BUFFER)
+			{
+				const struct trace_shadow_buffer* shadow = &trace_element_shadow[trace_element_buffer];
+
+				if ((uintptr_t)indices + count * index_size <= (size_t)shadow->size)
+				{
+					data = shadow->data + (uintptr_t)indices;
+				}
+			}
+		}
+		if (data != NULL && count > 0 && trace_has_client_arrays())
+		{
+			GLuint lo = ~0u;
+			GLuint hi = 0;
+			GLsizei i;
+
+			for (i = 0; i < count; i++)
+			{
+				GLuint index = index_size == 1 ? data[i]
+				             : index_size == 2 ? ((const GLushort*)data)[i]
+				             : ((const GLuint*)data)[i];
+
+				lo = index < lo ? index : lo;
+				hi = index > hi ? index : hi;
+			}
+			trace_client_arrays(lo, hi - lo + 1);
+		}
+
+		put_call(API_TRACE_CALL_glDrawElements);
+		put_scalars("iiii", mode, count, type, trace_element_buffer != 0);
+		if (trace_element_buffer != 0)
+		{
+			put_int((intptr_t)indices);
+		}
+		else
+		{
+			put_blob(indices, count * index_size);
+		}
+	}
+	real_glDrawElements(mode, count, type, indices);
+	trace_unlock(recording);
+}
+
+/* ------------------------------------------------------------------------ */
+/* EGL */
+
+TRACE_EXPORT EGLDisplay EGLAPIENTRY
+eglGetDisplay(EGLNativeDisplayType display_id)
+{
+	int recording;
+	EGLDisplay result;
+	TRACE_REAL(eglGetDisplay)
+
+	recording = trace_lock();
+	result = real_eglGetDisplay(display_id);
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_eglGetDisplay);
+		put_handle((const void*)(uintptr_t)display_id);
+		put_handle(result);
+	}
+	trace_unlock(recording);
+	return result;
+}
+
+/* Platform displays are recorded as eglGetDisplay, the replayer picks the
+ * display of its own platform either way. */
+static EGLDisplay
+trace_platform_display(EGLDisplay result, void* native_display)
+{
+	int recording = trace_lock();
+
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_eglGetDisplay);
+		put_handle(native_display);
+		put_handle(result);
+	}
+	trace_unlock(recording);
+	return result;
+}
+
+#ifdef EGL_VERSION_1_5
+TRACE_EXPORT EGLDisplay EGLAPIENTRY
+eglGetPlatformDisplay(EGLenum platform, void* native_display, const EGLAttrib* attrib_list)
+{
+	TRACE_REAL(eglGetPlatformDisplay)
+
+	return trace_platform_display(real_eglGetPlatformDisplay(platform, native_display, attrib_list), native_display);
+}
+#endif
+
+#ifdef EGL_EXT_platform_base
+TRACE_EXPORT EGLDisplay EGLAPIENTRY
+eglGetPlatformDisplayEXT(EGLenum platform, void* native_display, const EGLint* attrib_list)
+{
+	static PFNEGLGETPLATFORMDISPLAYEXTPROC real_eglGetPlatformDisplayEXT;
+
+	if (real_eglGetPlatformDisplayEXT == NULL)
+	{
+		real_eglGetPlatformDisplayEXT = (PFNEGLGETPLATFORMDISPLAYEXTPROC)trace_resolve("eglGetPlatformDisplayEXT");
+	}
+	return trace_platform_display(real_eglGetPlatformDisplayEXT(platform, native_display, attrib_list), native_display);
+}
+#endif
+
+TRACE_EXPORT EGLBoolean EGLAPIENTRY
+eglInitialize(EGLDisplay dpy, EGLint* major, EGLint* minor)
+{
+	int recording;
+	EGLBoolean result;
+	TRACE_REAL(eglInitialize)
+
+	recording = trace_lock();
+	result = real_eglInitialize(dpy, major, minor);
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_eglInitialize);
+		put_handle(dpy);
+	}
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT EGLBoolean EGLAPIENTRY
+eglTerminate(EGLDisplay dpy)
+{
+	int recording;
+	EGLBoolean result;
+	TRACE_REAL(eglTerminate)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_eglTerminate);
+		put_handle(dpy);
+	}
+	result = real_eglTerminate(dpy);
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT EGLBoolean EGLAPIENTRY
+eglBindAPI(EGLenum api)
+{
+	int recording;
+	EGLBoolean result;
+	TRACE_REAL(eglBindAPI)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_eglBindAPI);
+		put_int(api);
+	}
+	result = real_eglBindAPI(api);
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT EGLBoolean EGLAPIENTRY
+eglChooseConfig(EGLDisplay dpy, const EGLint* attrib_list, EGLConfig* configs, EGLint config_size, EGLint* num_config)
+{
+	int recording;
+	EGLBoolean result;
+	EGLint i;
+	TRACE_REAL(eglChooseConfig)
+
+	recording = trace_lock();
+	result = real_eglChooseConfig(dpy, attrib_list, configs, config_size, num_config);
+	if (recording)
+	{
+		EGLint n = result && configs != NULL && num_config != NULL ? *num_config : 0;
+
+		put_call(API_TRACE_CALL_eglChooseConfig);
+		put_handle(dpy);
+		put_attrib_list(attrib_list);
+		put_int(n);
+		for (i = 0; i < n; i++)
+		{
+			put_handle(configs[i]);
+		}
+	}
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT EGLSurface EGLAPIENTRY
+eglCreateWindowSurface(EGLDisplay dpy, EGLConfig config, EGLNativeWindowType win, const EGLint* attrib_list)
+{
+	int recording;
+	EGLSurface result;
+	TRACE_REAL(eglCreateWindowSurface)
+
+	recording = trace_lock();
+	result = real_eglCreateWindowSurface(dpy, config, win, attrib_list);
+	if (recording)
+	{
+		EGLint attribs[EGL_WINDOW_ATTRIB_LAST];
+		int i;
+
+		memset(attribs, 0, sizeof(attribs));
+		attribs[EGL_WINDOW_ATTRIB_HANDLE] = (EGLint)(uintptr_t)win;
+#ifdef API_TRACE_FBDEV
+		if (win != NULL)
+		{
+			attribs[EGL_WINDOW_ATTRIB_WIDTH] = win->width;
+			attribs[EGL_WINDOW_ATTRIB_HEIGHT] = win->height;
+		}
+#else
+		if (result != EGL_NO_SURFACE)
+		{
+			eglQuerySurface(dpy, result, EGL_WIDTH, &attribs[EGL_WINDOW_ATTRIB_WIDTH]);
+			eglQuerySurface(dpy, result, EGL_HEIGHT, &attribs[EGL_WINDOW_ATTRIB_HEIGHT]);
+		}
+#endif
+
+		put_call(API_TRACE_CALL_eglCreateWindowSurface);
+		put_handle(dpy);
+		put_handle(config);
+		for (i = 0; i < EGL_WINDOW_ATTRIB_LAST; i++)
+		{
+			put_int(attribs[i]);
+		}
+		put_attrib_list(attrib_list);
+		put_handle(result);
+	}
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT EGLSurface EGLAPIENTRY
+eglCreatePixmapSurface(EGLDisplay dpy, EGLConfig config, EGLNativePixmapType pixmap, const EGLint* attrib_list)
+{
+	int recording;
+	EGLSurface result;
+	TRACE_REAL(eglCreatePixmapSurface)
+
+	recording = trace_lock();
+	result = real_eglCreatePixmapSurface(dpy, config, pixmap, attrib_list);
+	if (recording)
+	{
+		EGLint attribs[EGL_PIXMAP_ATTRIB_LAST];
+		int i;
+
+		memset(attribs, 0, sizeof(attribs));
+		attribs[EGL_PIXMAP_ATTRIB_HANDLE] = (EGLint)(uintptr_t)pixmap;
+#ifdef API_TRACE_FBDEV
+		if (pixmap != NULL)
+		{
+			const fbdev_pixmap* p = (const fbdev_pixmap*)pixmap;
+
+			/* fbdev pixmaps are linear; PIXEL_FORMAT packs the red, green,
+			 * blue, alpha and luminance sizes in 6 bits each */
+			attribs[EGL_PIXMAP_ATTRIB_UMP] = (p->flags & FBDEV_PIXMAP_SUPPORTS_UMP) != 0;
+			attribs[EGL_PIXMAP_ATTRIB_WIDTH] = p->width;
+			attribs[EGL_PIXMAP_ATTRIB_HEIGHT] = p->height;
+			attribs[EGL_PIXMAP_ATTRIB_PITCH] = p->width * p->bytes_per_pixel;
+			attribs[EGL_PIXMAP_ATTRIB_PIXEL_FORMAT] = p->red_size | p->green_size << 6 | p->blue_size << 12 | p->alpha_size << 18 | p->luminance_size << 24;
+			attribs[EGL_PIXMAP_ATTRIB_TEXEL_FORMAT] = p->format;
+		}
+#else
+		if (result != EGL_NO_SURFACE)
+		{
+			eglQuerySurface(dpy, result, EGL_WIDTH, &attribs[EGL_PIXMAP_ATTRIB_WIDTH]);
+			eglQuerySurface(dpy, result, EGL_HEIGHT, &attribs[EGL_PIXMAP_ATTRIB_HEIGHT]);
+		}
+#endif
+
+		put_call(API_TRACE_CALL_eglCreatePixmapSurface);
+		put_handle(dpy);
+		put_handle(config);
+		for (i = 0; i < EGL_PIXMAP_ATTRIB_LAST; i++)
+		{
+			put_int(attribs[i]);
+		}
+		put_attrib_list(attrib_list);
+		put_handle(result);
+	}
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT EGLSurface EGLAPIENTRY
+eglCreatePbufferSurface(EGLDisplay dpy, EGLConfig config, const EGLint* attrib_list)
+{
+	int recording;
+	EGLSurface result;
+	TRACE_REAL(eglCreatePbufferSurface)
+
+	recording = trace_lock();
+	result = real_eglCreatePbufferSurface(dpy, config, attrib_list);
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_eglCreatePbufferSurface);
+		put_handle(dpy);
+		put_handle(config);
+		put_attrib_list(attrib_list);
+		put_handle(result);
+	}
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT EGLBoolean EGLAPIENTRY
+eglDestroySurface(EGLDisplay dpy, EGLSurface surface)
+{
+	int recording;
+	EGLBoolean result;
+	TRACE_REAL(eglDestroySurface)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_eglDestroySurface);
+		put_handle(dpy);
+		put_handle(surface);
+	}
+	result = real_eglDestroySurface(dpy, surface);
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT EGLContext EGLAPIENTRY
+eglCreateContext(EGLDisplay dpy, EGLConfig config, EGLContext share_context, const EGLint* attrib_list)
+{
+	int recording;
+	EGLContext result;
+	TRACE_REAL(eglCreateContext)
+
+	recording = trace_lock();
+	result = real_eglCreateContext(dpy, config, share_context, attrib_list);
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_eglCreateContext);
+		put_handle(dpy);
+		put_handle(config);
+		put_handle(share_context);
+		put_attrib_list(attrib_list);
+		put_handle(result);
+	}
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT EGLBoolean EGLAPIENTRY
+eglDestroyContext(EGLDisplay dpy, EGLContext ctx)
+{
+	int recording;
+	EGLBoolean result;
+	TRACE_REAL(eglDestroyContext)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_eglDestroyContext);
+		put_handle(dpy);
+		put_handle(ctx);
+	}
+	result = real_eglDestroyContext(dpy, ctx);
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT EGLBoolean EGLAPIENTRY
+eglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx)
+{
+	int recording;
+	EGLBoolean result;
+	TRACE_REAL(eglMakeCurrent)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_eglMakeCurrent);
+		put_handle(dpy);
+		put_handle(draw);
+		put_handle(read);
+		put_handle(ctx);
+	}
+	result = real_eglMakeCurrent(dpy, draw, read, ctx);
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT EGLBoolean EGLAPIENTRY
+eglSwapBuffers(EGLDisplay dpy, EGLSurface surface)
+{
+	int recording;
+	EGLBoolean result;
+	TRACE_REAL(eglSwapBuffers)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_eglSwapBuffers);
+		put_handle(dpy);
+		put_handle(surface);
+		/* a crash mid-frame still leaves every completed frame on disk */
+		fflush(trace_file);
+	}
+	result = real_eglSwapBuffers(dpy, surface);
+	trace_unlock(recording);
+	return result;
+}
+
+TRACE_EXPORT EGLBoolean EGLAPIENTRY
+eglSwapInterval(EGLDisplay dpy, EGLint interval)
+{
+	int recording;
+	EGLBoolean result;
+	TRACE_REAL(eglSwapInterval)
+
+	recording = trace_lock();
+	if (recording)
+	{
+		put_call(API_TRACE_CALL_eglSwapInterval);
+		put_handle(dpy);
+		put_int(interval);
+	}
+	result = real_eglSwapInterval(dpy, interval);
+	trace_unlock(recording);
+	return result;
+}
+
+/* Applications loading GL entry points through EGL get the traced ones. */
+TRACE_EXPORT __eglMustCastToProperFunctionPointerType EGLAPIENTRY
+eglGetProcAddress(const char* procname)
+{
+	static void* self;
+	void* proc = NULL;
+	TRACE_REAL(eglGetProcAddress)
+
+	if (self == NULL)
+	{
+		Dl_info info;
+
+		if (dladdr((void*)trace_open, &info) != 0)
+		{
+			self = dlopen(info.dli_fname, RTLD_LAZY | RTLD_NOLOAD);
+		}
+	}
+	if (self != NULL && procname != NULL)
+	{
+		proc = dlsym(self, procname);
+	}
+	if (proc != NULL)
+	{
+		return (__eglMustCastToProperFunctionPointerType)proc;
+	}
+	return real_eglGetProcAddress(procname);
+}
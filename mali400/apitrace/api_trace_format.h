@@ -0,0 +1,61 @@
+/*
+ * Binary API trace format shared by the capture library (api_trace_capture.c)
+ * and the replayer (api_trace_replay.c).
+ */
+
+#ifndef _API_TRACE_FORMAT_H_
+#define _API_TRACE_FORMAT_H_
+
+#include <EGL/egl_api_trace_format.h>
+
+/**
+ * A trace starts with a fixed 16 byte header:
+ *   8 bytes  API_TRACE_MAGIC
+ *   4 bytes  API_TRACE_VERSION, little endian
+ *   4 bytes  size of a pointer in the traced process, little endian
+ *
+ * followed by one record per call:
+ *   varint   call id, an enum api_trace_call value
+ *   varint   microseconds since the previous record
+ *   ...      the arguments, in call order
+ *
+ * Argument encodings:
+ *   int      zigzag varint (GLint, GLenum, GLsizei, GLintptr, EGLint, ...)
+ *   float    4 bytes IEEE 754, little endian
+ *   handle   varint of the value seen by the application (EGLDisplay,
+ *            EGLConfig, EGLSurface, EGLContext, GL object names); the
+ *            replayer maps them to its own objects
+ *   blob     varint of length + 1, then length bytes; 0 stands for NULL
+ *   string   blob without the terminating NUL
+ *
+ * Native windows and pixmaps are not stored as handles but as arrays of
+ * EGL_WINDOW_ATTRIB_LAST / EGL_PIXMAP_ATTRIB_LAST ints laid out as in
+ * egl_api_trace_format.h, so the replayer can create an equivalent surface
+ * on another system.
+ */
+#define API_TRACE_MAGIC         "MALITRC\0"
+#define API_TRACE_MAGIC_SIZE    8
+#define API_TRACE_VERSION       1
+#define API_TRACE_HEADER_SIZE   16
+
+/**
+ * Call ids, in the order of api_trace_calls.h. Adding calls anywhere but the
+ * end of that table breaks old traces and needs an API_TRACE_VERSION bump.
+ */
+enum api_trace_call
+{
+#define API_TRACE_GL(name, params, args, sig, replay, shadow) API_TRACE_CALL_##name,
+#define API_TRACE_UNIFORM(name, type, components) API_TRACE_CALL_##name,
+#define API_TRACE_MATRIX(name, components) API_TRACE_CALL_##name,
+#define API_TRACE_ATTRIB(name, components) API_TRACE_CALL_##name,
+#define API_TRACE_CUSTOM(name) API_TRACE_CALL_##name,
+#include "api_trace_calls.h"
+#undef API_TRACE_GL
+#undef API_TRACE_UNIFORM
+#undef API_TRACE_MATRIX
+#undef API_TRACE_ATTRIB
+#undef API_TRACE_CUSTOM
+	API_TRACE_CALL_COUNT
+};
+
+#endif /* _API_TRACE_FORMAT_H_ */
@@ -0,0 +1,1188 @@
+/*
+ * API trace replayer.
+ *
+ *   api_trace_replay [-t] [-f] [-c] [-v] trace
+ *
+ * Re-executes a trace written by libapitrace as fast as possible, or with
+ * -t at the pace it was captured, and reports how long every frame took.
+ * Object names, EGL handles and uniform locations are mapped to the ones the
+ * replaying driver hands out. Window and pixmap surfaces are recreated from
+ * their recorded attributes: as fbdev windows and pixmaps when built with
+ * API_TRACE_FBDEV, as pbuffers of the same size otherwise. Calls are issued
+ * from a single thread in the order they were recorded.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+#ifdef API_TRACE_FBDEV
+#include <EGL/fbdev_window.h>
+#endif
+
+#include "api_trace_format.h"
+
+#define REPLAY_MAX_ARGS 16
+#define REPLAY_MAX_CONFIGS 64
+#define REPLAY_MAX_SOURCES 64
+
+typedef union
+{
+	int64_t i;
+	float f;
+} replay_arg;
+
+struct reader
+{
+	const unsigned char* p;
+	const unsigned char* end;
+	int eof;
+};
+
+struct map
+{
+	uint64_t* keys;
+	uint64_t* values;
+	size_t capacity;
+	size_t count;
+};
+
+static struct map buffers;
+static struct map textures;
+static struct map framebuffers;
+static struct map renderbuffers;
+static struct map programs;
+static struct map locations;
+static struct map handles;
+
+static GLuint current_program;
+static int option_timing;
+static int option_finish;
+static int option_checksum;
+static int option_verbose;
+
+/* ------------------------------------------------------------------------ */
+/* maps from recorded to replayed names; key 0 always maps to 0 */
+
+static uint64_t*
+map_find(const struct map* m, uint64_t key)
+{
+	size_t i;
+
+	if (m->capacity == 0)
+	{
+		return NULL;
+	}
+	for (i = (key * 0x9e3779b97f4a7c15ull) >> 32 & (m->capacity - 1); m->keys[i] != 0; i = (i + 1) & (m->capacity - 1))
+	{
+		if (m->keys[i] == key)
+		{
+			return &m->values[i];
+		}
+	}
+	return NULL;
+}
+
+static void
+map_put(struct map* m, uint64_t key, uint64_t value)
+{
+	uint64_t* slot;
+	size_t i;
+
+	if (key == 0)
+	{
+		return;
+	}
+	slot = map_find(m, key);
+	if (slot != NULL)
+	{
+		*slot = value;
+		return;
+	}
+	if ((m->count + 1) * 2 > m->capacity)
+	{
+		struct map grown;
+
+		grown.capacity = m->capacity != 0 ? m->capacity * 2 : 256;
+		grown.count = 0;
+		grown.keys = calloc(grown.capacity, sizeof(uint64_t));
+		grown.values = calloc(grown.capacity, sizeof(uint64_t));
+		if (grown.keys == NULL || grown.values == NULL)
+		{
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+		for (i = 0; i < m->capacity; i++)
+		{
+			if (m->keys[i] != 0)
+			{
+				map_put(&grown, m->keys[i], m->values[i]);
+			}
+		}
+		free(m->keys);
+		free(m->values);
+		*m = grown;
+	}
+	for (i = (key * 0x9e3779b97f4a7c15ull) >> 32 & (m->capacity - 1); m->keys[i] != 0; i = (i + 1) & (m->capacity - 1))
+	{
+	}
+	m->keys[i] = key;
+	m->values[i] = value;
+	m->count++;
+}
+
+static uint64_t
+map_get(const struct map* m, uint64_t key)
+{
+	const uint64_t* slot = map_find(m, key);
+
+	return slot != NULL ? *slot : key;
+}
+
+/* ------------------------------------------------------------------------ */
+/* reading */
+
+static uint64_t
+get_uvarint(struct reader* r)
+{
+	uint64_t v = 0;
+	int shift = 0;
+
+	while (r->p < r->end)
+	{
+		unsigned char c = *r->p++;
+
+		v |= (uint64_t)(c & 0x7f) << shift;
+		if ((c & 0x80) == 0)
+		{
+			return v;
+		}
+		shift += 7;
+	}
+	r->eof = 1;
+	return 0;
+}
+
+static int64_t
+get_int(struct reader* r)
+{
+	uint64_t v = get_uvarint(r);
+
+	return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static float
+get_float(struct reader* r)
+{
+	uint32_t bits = 0;
+	float f;
+	int i;
+
+	if (r->end - r->p < 4)
+	{
+		r->eof = 1;
+		return 0.0f;
+	}
+	for (i = 0; i < 4; i++)
+	{
+		bits |= (uint32_t)*r->p++ << (i * 8);
+	}
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+static const void*
+get_blob(struct reader* r, size_t* size)
+{
+	uint64_t n = get_uvarint(r);
+	const void* data;
+
+	*size = 0;
+	if (n == 0)
+	{
+		return NULL;
+	}
+	if (n - 1 > (uint64_t)(r->end - r->p))
+	{
+		r->eof = 1;
+		return NULL;
+	}
+	data = r->p;
+	*size = n - 1;
+	r->p += n - 1;
+	return data;
+}
+
+/* Blobs handed to GL as typed arrays, copied so they are aligned. */
+static const void*
+get_aligned_blob(struct reader* r)
+{
+	static void* scratch;
+	static size_t scratch_size;
+	size_t size;
+	const void* data = get_blob(r, &size);
+
+	if (data == NULL)
+	{
+		return NULL;
+	}
+	if (size > scratch_size)
+	{
+		free(scratch);
+		scratch_size = size * 2;
+		scratch = malloc(scratch_size);
+	}
+	memcpy(scratch, data, size);
+	return scratch;
+}
+
+static const char*
+get_string(struct reader* r)
+{
+	static char* scratch;
+	static size_t scratch_size;
+	size_t size;
+	const void* data = get_blob(r, &size);
+
+	if (data == NULL)
+	{
+		return NULL;
+	}
+	if (size + 1 > scratch_size)
+	{
+		free(scratch);
+		scratch_size = size * 2 + 1;
+		scratch = malloc(scratch_size);
+	}
+	memcpy(scratch, data, size);
+	scratch[size] = '\0';
+	return scratch;
+}
+
+static void
+get_scalars(struct reader* r, const char* sig, replay_arg* arg)
+{
+	for (; *sig != '\0'; sig++, arg++)
+	{
+		if (*sig == 'f')
+		{
+			arg->f = get_float(r);
+		}
+		else
+		{
+			arg->i = get_int(r);
+		}
+	}
+}
+
+/* NULL for a NULL list, otherwise a static copy terminated by EGL_NONE with
+ * room for one more pair. */
+static EGLint*
+get_attrib_list(struct reader* r)
+{
+	static EGLint list[REPLAY_MAX_ARGS * 2 + 3];
+	int64_t n = get_int(r);
+	int64_t i;
+	int kept = 0;
+
+	if (n < 0)
+	{
+		return NULL;
+	}
+	for (i = 0; i < n * 2; i++)
+	{
+		EGLint v = (EGLint)get_int(r);
+
+		if (kept < REPLAY_MAX_ARGS * 2)
+		{
+			list[kept++] = v;
+		}
+	}
+	list[kept] = EGL_NONE;
+	return list;
+}
+
+static void*
+get_handle(struct reader* r)
+{
+	return (void*)(uintptr_t)map_get(&handles, get_uvarint(r));
+}
+
+/* ------------------------------------------------------------------------ */
+/* time */
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void
+sleep_until_ns(uint64_t deadline)
+{
+	struct timespec ts;
+
+	ts.tv_sec = deadline / 1000000000;
+	ts.tv_nsec = deadline % 1000000000;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+	{
+	}
+}
+
+/* ------------------------------------------------------------------------ */
+/* GL helpers */
+
+#define I(n) ((GLint)arg[n].i)
+#define F(n) (arg[n].f)
+#define BUF(n) ((GLuint)map_get(&buffers, (GLuint)arg[n].i))
+#define TEX(n) ((GLuint)map_get(&textures, (GLuint)arg[n].i))
+#define FBO(n) ((GLuint)map_get(&framebuffers, (GLuint)arg[n].i))
+#define RBO(n) ((GLuint)map_get(&renderbuffers, (GLuint)arg[n].i))
+#define PRG(n) ((GLuint)map_get(&programs, (GLuint)arg[n].i))
+#define SHD(n) PRG(n)
+#define LOC(n) replay_location((GLint)arg[n].i)
+#define USE(n) replay_use_program((GLuint)arg[n].i)
+
+static uint64_t
+location_key(GLuint program, GLint location)
+{
+	return (uint64_t)program << 32 | (uint32_t)location;
+}
+
+static GLint
+replay_location(GLint location)
+{
+	const uint64_t* slot;
+
+	if (location < 0)
+	{
+		return location;
+	}
+	/* locations the application derived itself (array elements) pass
+	 * through unchanged */
+	slot = map_find(&locations, location_key(current_program, location));
+	return slot != NULL ? (GLint)*slot : location;
+}
+
+static GLuint
+replay_use_program(GLuint program)
+{
+	current_program = program;
+	return (GLuint)map_get(&programs, program);
+}
+
+static void
+replay_gen(struct reader* r, struct map* m, void (GL_APIENTRY *gen)(GLsizei, GLuint*))
+{
+	GLsizei n = (GLsizei)get_int(r);
+	GLsizei i;
+
+	for (i = 0; i < n && !r->eof; i++)
+	{
+		GLuint name;
+
+		gen(1, &name);
+		map_put(m, (GLuint)get_int(r), name);
+	}
+}
+
+static void
+replay_delete(struct reader* r, struct map* m, void (GL_APIENTRY *del)(GLsizei, const GLuint*))
+{
+	GLsizei n = (GLsizei)get_int(r);
+	GLsizei i;
+
+	for (i = 0; i < n && !r->eof; i++)
+	{
+		GLuint name = (GLuint)map_get(m, (GLuint)get_int(r));
+
+		del(1, &name);
+	}
+}
+
+static void
+replay_shader_source(struct reader* r)
+{
+	const GLchar* strings[REPLAY_MAX_SOURCES];
+	GLint lengths[REPLAY_MAX_SOURCES];
+	GLuint shader = (GLuint)map_get(&programs, (GLuint)get_int(r));
+	GLsizei count = (GLsizei)get_int(r);
+	GLsizei i;
+
+	for (i = 0; i < count && !r->eof; i++)
+	{
+		size_t size;
+		const void* data = get_blob(r, &size);
+
+		if (i < REPLAY_MAX_SOURCES)
+		{
+			strings[i] = data != NULL ? data : "";
+			lengths[i] = (GLint)size;
+		}
+	}
+	glShaderSource(shader, count < REPLAY_MAX_SOURCES ? count : REPLAY_MAX_SOURCES, strings, lengths);
+}
+
+static void
+replay_get_attrib_location(struct reader* r)
+{
+	GLuint program = (GLuint)map_get(&programs, (GLuint)get_int(r));
+	const char* name = get_string(r);
+	GLint recorded = (GLint)get_int(r);
+	GLint location;
+
+	if (name == NULL)
+	{
+		return;
+	}
+	location = glGetAttribLocation(program, name);
+	if (recorded >= 0 && location != recorded)
+	{
+		/* pin the attribute where the trace expects it */
+		glBindAttribLocation(program, recorded, name);
+		glLinkProgram(program);
+	}
+}
+
+static void
+replay_get_uniform_location(struct reader* r)
+{
+	GLuint recorded_program = (GLuint)get_int(r);
+	const char* name = get_string(r);
+	GLint recorded = (GLint)get_int(r);
+
+	if (name != NULL && recorded >= 0)
+	{
+		GLint location = glGetUniformLocation((GLuint)map_get(&programs, recorded_program), name);
+
+		map_put(&locations, location_key(recorded_program, recorded), (uint32_t)location);
+	}
+}
+
+static void
+replay_draw_elements(struct reader* r)
+{
+	replay_arg arg[4];
+	const void* indices;
+
+	get_scalars(r, "iiii", arg);
+	if (I(3))
+	{
+		indices = (const void*)(intptr_t)get_int(r);
+	}
+	else
+	{
+		size_t size;
+
+		indices = get_blob(r, &size);
+	}
+	glDrawElements(I(0), I(1), I(2), indices);
+}
+
+/* Points attribute index at recorded client data; the trace stays in memory
+ * so the data outlives the draw that follows. */
+static void
+replay_client_array(struct reader* r)
+{
+	replay_arg arg[6];
+	const unsigned char* data;
+	size_t size;
+	size_t stride;
+	GLint bound;
+
+	get_scalars(r, "iiiiii", arg);
+	data = get_blob(r, &size);
+	if (data == NULL)
+	{
+		return;
+	}
+	stride = I(4) != 0 ? (size_t)I(4) : (size_t)I(1) * (I(2) == GL_BYTE || I(2) == GL_UNSIGNED_BYTE ? 1 : I(2) == GL_SHORT || I(2) == GL_UNSIGNED_SHORT || I(2) == GL_HALF_FLOAT_OES ? 2 : 4);
+
+	glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &bound);
+	if (bound != 0)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	glVertexAttribPointer(I(0), I(1), I(2), I(3), I(4), data - (size_t)I(5) * stride);
+	if (bound != 0)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, bound);
+	}
+}
+
+static void
+replay_read_pixels(struct reader* r)
+{
+	static void* scratch;
+	static size_t scratch_size;
+	replay_arg arg[6];
+	size_t size;
+
+	get_scalars(r, "iiiiii", arg);
+	if (I(2) <= 0 || I(3) <= 0)
+	{
+		return;
+	}
+	size = ((size_t)I(2) * 16 + 8) * I(3);
+	if (size > scratch_size)
+	{
+		free(scratch);
+		scratch_size = size;
+		scratch = malloc(scratch_size);
+	}
+	glReadPixels(I(0), I(1), I(2), I(3), I(4), I(5), scratch);
+}
+
+/* ------------------------------------------------------------------------ */
+/* EGL */
+
+static EGLDisplay
+replay_display(void)
+{
+#ifndef API_TRACE_FBDEV
+	const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+	if (extensions != NULL && strstr(extensions, "EGL_MESA_platform_surfaceless") != NULL)
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+		if (get_platform_display != NULL)
+		{
+			return get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		}
+	}
+#endif
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static void
+replay_choose_config(struct reader* r)
+{
+	EGLConfig configs[REPLAY_MAX_CONFIGS];
+	EGLDisplay dpy = get_handle(r);
+	EGLint* list = get_attrib_list(r);
+	int64_t n = get_int(r);
+	EGLint found = 0;
+	int64_t i;
+
+#ifndef API_TRACE_FBDEV
+	{
+		/* window and pixmap surfaces become pbuffers */
+		static EGLint pbuffer[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_NONE };
+		int k;
+
+		if (list == NULL)
+		{
+			list = pbuffer;
+		}
+		for (k = 0; list[k] != EGL_NONE && list[k] != EGL_SURFACE_TYPE; k += 2)
+		{
+		}
+		if (list[k] == EGL_NONE)
+		{
+			list[k + 2] = EGL_NONE;
+		}
+		list[k] = EGL_SURFACE_TYPE;
+		list[k + 1] = EGL_PBUFFER_BIT;
+	}
+#endif
+	eglChooseConfig(dpy, list, configs, REPLAY_MAX_CONFIGS, &found);
+	for (i = 0; i < n && !r->eof; i++)
+	{
+		uint64_t recorded = get_uvarint(r);
+
+		if (found > 0)
+		{
+			map_put(&handles, recorded, (uintptr_t)configs[i < found ? i : found - 1]);
+		}
+	}
+}
+
+#ifndef API_TRACE_FBDEV
+static EGLSurface
+replay_native_surface(EGLDisplay dpy, EGLConfig config, EGLint width, EGLint height)
+{
+	EGLint pbuffer[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+
+	return eglCreatePbufferSurface(dpy, config, pbuffer);
+}
+#endif
+
+static void
+replay_window_surface(struct reader* r)
+{
+	EGLint attribs[EGL_WINDOW_ATTRIB_LAST];
+	EGLDisplay dpy = get_handle(r);
+	EGLConfig config = get_handle(r);
+	EGLSurface surface;
+	int i;
+
+	for (i = 0; i < EGL_WINDOW_ATTRIB_LAST; i++)
+	{
+		attribs[i] = (EGLint)get_int(r);
+	}
+#ifdef API_TRACE_FBDEV
+	{
+		EGLint* list = get_attrib_list(r);
+		fbdev_window* window = calloc(1, sizeof(*window));
+
+		window->width = attribs[EGL_WINDOW_ATTRIB_WIDTH];
+		window->height = attribs[EGL_WINDOW_ATTRIB_HEIGHT];
+		surface = eglCreateWindowSurface(dpy, config, window, list);
+	}
+#else
+	get_attrib_list(r);
+	surface = replay_native_surface(dpy, config, attribs[EGL_WINDOW_ATTRIB_WIDTH], attribs[EGL_WINDOW_ATTRIB_HEIGHT]);
+#endif
+	map_put(&handles, get_uvarint(r), (uintptr_t)surface);
+}
+
+static void
+replay_pixmap_surface(struct reader* r)
+{
+	EGLint attribs[EGL_PIXMAP_ATTRIB_LAST];
+	EGLDisplay dpy = get_handle(r);
+	EGLConfig config = get_handle(r);
+	EGLSurface surface;
+	int i;
+
+	for (i = 0; i < EGL_PIXMAP_ATTRIB_LAST; i++)
+	{
+		attribs[i] = (EGLint)get_int(r);
+	}
+#ifdef API_TRACE_FBDEV
+	{
+		/* UMP backed pixmaps are replayed from plain memory */
+		EGLint* list = get_attrib_list(r);
+		fbdev_pixmap* pixmap = calloc(1, sizeof(*pixmap));
+		EGLint format = attribs[EGL_PIXMAP_ATTRIB_PIXEL_FORMAT];
+
+		pixmap->width = attribs[EGL_PIXMAP_ATTRIB_WIDTH];
+		pixmap->height = attribs[EGL_PIXMAP_ATTRIB_HEIGHT];
+		pixmap->bytes_per_pixel = pixmap->width != 0 ? attribs[EGL_PIXMAP_ATTRIB_PITCH] / pixmap->width : 0;
+		pixmap->red_size = format & 0x3f;
+		pixmap->green_size = format >> 6 & 0x3f;
+		pixmap->blue_size = format >> 12 & 0x3f;
+		pixmap->alpha_size = format >> 18 & 0x3f;
+		pixmap->luminance_size = format >> 24 & 0x3f;
+		pixmap->buffer_size = pixmap->bytes_per_pixel * 8;
+		pixmap->format = attribs[EGL_PIXMAP_ATTRIB_TEXEL_FORMAT];
+		pixmap->data = calloc(pixmap->height, attribs[EGL_PIXMAP_ATTRIB_PITCH]);
+		surface = eglCreatePixmapSurface(dpy, config, pixmap, list);
+	}
+#else
+	get_attrib_list(r);
+	surface = replay_native_surface(dpy, config, attribs[EGL_PIXMAP_ATTRIB_WIDTH], attribs[EGL_PIXMAP_ATTRIB_HEIGHT]);
+#endif
+	map_put(&handles, get_uvarint(r), (uintptr_t)surface);
+}
+
+/* ------------------------------------------------------------------------ */
+/* frames */
+
+struct frames
+{
+	double* ms;
+	double* captured_ms;
+	size_t count;
+	size_t capacity;
+	uint32_t checksum;
+};
+
+static uint32_t
+frame_checksum(void)
+{
+	static unsigned char* pixels;
+	static size_t pixels_size;
+	EGLint width = 0;
+	EGLint height = 0;
+	uint32_t hash = 2166136261u;
+	size_t size;
+	size_t i;
+
+	eglQuerySurface(eglGetCurrentDisplay(), eglGetCurrentSurface(EGL_DRAW), EGL_WIDTH, &width);
+	eglQuerySurface(eglGetCurrentDisplay(), eglGetCurrentSurface(EGL_DRAW), EGL_HEIGHT, &height);
+	size = (size_t)width * height * 4;
+	if (size > pixels_size)
+	{
+		free(pixels);
+		pixels_size = size;
+		pixels = malloc(pixels_size);
+	}
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	for (i = 0; i < size; i++)
+	{
+		hash = (hash ^ pixels[i]) * 16777619u;
+	}
+	return hash;
+}
+
+static void
+frame_add(struct frames* f, double ms, double captured_ms)
+{
+	if (f->count == f->capacity)
+	{
+		f->capacity = f->capacity != 0 ? f->capacity * 2 : 1024;
+		f->ms = realloc(f->ms, f->capacity * sizeof(double));
+		f->captured_ms = realloc(f->captured_ms, f->capacity * sizeof(double));
+		if (f->ms == NULL || f->captured_ms == NULL)
+		{
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+	}
+	f->ms[f->count] = ms;
+	f->captured_ms[f->count] = captured_ms;
+	f->count++;
+	if (option_verbose)
+	{
+		if (option_checksum)
+		{
+			printf("frame %zu: %.3f ms (captured %.3f ms) checksum %08x\n", f->count, ms, captured_ms, f->checksum);
+		}
+		else
+		{
+			printf("frame %zu: %.3f ms (captured %.3f ms)\n", f->count, ms, captured_ms);
+		}
+	}
+}
+
+static int
+compare_double(const void* a, const void* b)
+{
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static double
+percentile(const double* sorted, size_t count, double p)
+{
+	return sorted[(size_t)(p * (count - 1) + 0.5)];
+}
+
+static void
+frames_report(struct frames* f, double seconds)
+{
+	double captured = 0.0;
+	size_t i;
+
+	if (f->count == 0)
+	{
+		printf("no frames in %.3f s\n", seconds);
+		return;
+	}
+	for (i = 0; i < f->count; i++)
+	{
+		captured += f->captured_ms[i];
+	}
+	qsort(f->ms, f->count, sizeof(double), compare_double);
+	printf("%zu frames in %.3f s, %.2f fps (captured %.2f fps)\n", f->count, seconds, f->count / seconds, captured > 0.0 ? f->count * 1000.0 / captured : 0.0);
+	printf("frame ms: min %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f\n", f->ms[0], percentile(f->ms, f->count, 0.5), percentile(f->ms, f->count, 0.9), percentile(f->ms, f->count, 0.99), f->ms[f->count - 1]);
+	if (option_checksum)
+	{
+		printf("last frame checksum %08x\n", f->checksum);
+	}
+}
+
+/* ------------------------------------------------------------------------ */
+/* replay */
+
+static void
+replay(struct reader* r, struct frames* frames)
+{
+	replay_arg arg[REPLAY_MAX_ARGS];
+	uint64_t start = now_ns();
+	uint64_t frame_start = start;
+	uint64_t recorded_us = 0;
+	uint64_t frame_recorded_us = 0;
+
+	while (r->p < r->end && !r->eof)
+	{
+		uint64_t call = get_uvarint(r);
+
+		recorded_us += get_uvarint(r);
+		if (option_timing)
+		{
+			uint64_t deadline = start + recorded_us * 1000;
+
+			if (deadline > now_ns())
+			{
+				sleep_until_ns(deadline);
+			}
+		}
+
+		switch (call)
+		{
+#define API_TRACE_GL(name, params, args, sig, replay, shadow) \
+		case API_TRACE_CALL_##name: \
+			get_scalars(r, sig, arg); \
+			name replay; \
+			break;
+#define API_TRACE_UNIFORM(name, type, components) \
+		case API_TRACE_CALL_##name: \
+			get_scalars(r, "ii", arg); \
+			name(LOC(0), I(1), (const type*)get_aligned_blob(r)); \
+			break;
+#define API_TRACE_MATRIX(name, components) \
+		case API_TRACE_CALL_##name: \
+			get_scalars(r, "iii", arg); \
+			name(LOC(0), I(1), I(2), (const GLfloat*)get_aligned_blob(r)); \
+			break;
+#define API_TRACE_ATTRIB(name, components) \
+		case API_TRACE_CALL_##name: \
+			get_scalars(r, "i", arg); \
+			name(I(0), (const GLfloat*)get_aligned_blob(r)); \
+			break;
+#define API_TRACE_CUSTOM(name)
+#include "api_trace_calls.h"
+#undef API_TRACE_GL
+#undef API_TRACE_UNIFORM
+#undef API_TRACE_MATRIX
+#undef API_TRACE_ATTRIB
+#undef API_TRACE_CUSTOM
+
+		case API_TRACE_CALL_glBindAttribLocation:
+		{
+			GLuint program = (GLuint)map_get(&programs, (GLuint)get_int(r));
+			GLuint index = (GLuint)get_int(r);
+			const char* name = get_string(r);
+
+			if (name != NULL)
+			{
+				glBindAttribLocation(program, index, name);
+			}
+			break;
+		}
+		case API_TRACE_CALL_glBufferData:
+		{
+			size_t size;
+
+			get_scalars(r, "iii", arg);
+			glBufferData(I(0), (GLsizeiptr)arg[1].i, get_blob(r, &size), I(2));
+			break;
+		}
+		case API_TRACE_CALL_glBufferSubData:
+		{
+			const void* data;
+			size_t size;
+
+			get_scalars(r, "ii", arg);
+			data = get_blob(r, &size);
+			glBufferSubData(I(0), (GLintptr)arg[1].i, size, data);
+			break;
+		}
+		case API_TRACE_CALL_glCompressedTexImage2D:
+		{
+			size_t size;
+
+			get_scalars(r, "iiiiiii", arg);
+			glCompressedTexImage2D(I(0), I(1), I(2), I(3), I(4), I(5), I(6), get_blob(r, &size));
+			break;
+		}
+		case API_TRACE_CALL_glCompressedTexSubImage2D:
+		{
+			size_t size;
+
+			get_scalars(r, "iiiiiiii", arg);
+			glCompressedTexSubImage2D(I(0), I(1), I(2), I(3), I(4), I(5), I(6), I(7), get_blob(r, &size));
+			break;
+		}
+		case API_TRACE_CALL_glCreateProgram:
+			map_put(&programs, (GLuint)get_int(r), glCreateProgram());
+			break;
+		case API_TRACE_CALL_glCreateShader:
+			get_scalars(r, "ii", arg);
+			map_put(&programs, (GLuint)I(1), glCreateShader(I(0)));
+			break;
+		case API_TRACE_CALL_glDeleteBuffers:
+			replay_delete(r, &buffers, glDeleteBuffers);
+			break;
+		case API_TRACE_CALL_glDeleteFramebuffers:
+			replay_delete(r, &framebuffers, glDeleteFramebuffers);
+			break;
+		case API_TRACE_CALL_glDeleteRenderbuffers:
+			replay_delete(r, &renderbuffers, glDeleteRenderbuffers);
+			break;
+		case API_TRACE_CALL_glDeleteTextures:
+			replay_delete(r, &textures, glDeleteTextures);
+			break;
+		case API_TRACE_CALL_glDrawArrays:
+			get_scalars(r, "iii", arg);
+			glDrawArrays(I(0), I(1), I(2));
+			break;
+		case API_TRACE_CALL_glDrawElements:
+			replay_draw_elements(r);
+			break;
+		case API_TRACE_CALL_glGenBuffers:
+			replay_gen(r, &buffers, glGenBuffers);
+			break;
+		case API_TRACE_CALL_glGenFramebuffers:
+			replay_gen(r, &framebuffers, glGenFramebuffers);
+			break;
+		case API_TRACE_CALL_glGenRenderbuffers:
+			replay_gen(r, &renderbuffers, glGenRenderbuffers);
+			break;
+		case API_TRACE_CALL_glGenTextures:
+			replay_gen(r, &textures, glGenTextures);
+			break;
+		case API_TRACE_CALL_glGetAttribLocation:
+			replay_get_attrib_location(r);
+			break;
+		case API_TRACE_CALL_glGetUniformLocation:
+			replay_get_uniform_location(r);
+			break;
+		case API_TRACE_CALL_glReadPixels:
+			replay_read_pixels(r);
+			break;
+		case API_TRACE_CALL_glShaderSource:
+			replay_shader_source(r);
+			break;
+		case API_TRACE_CALL_glTexImage2D:
+		{
+			size_t size;
+
+			get_scalars(r, "iiiiiiii", arg);
+			glTexImage2D(I(0), I(1), I(2), I(3), I(4), I(5), I(6), I(7), get_blob(r, &size));
+			break;
+		}
+		case API_TRACE_CALL_glTexParameterfv:
+			get_scalars(r, "iif", arg);
+			glTexParameterfv(I(0), I(1), &arg[2].f);
+			break;
+		case API_TRACE_CALL_glTexParameteriv:
+		{
+			GLint param;
+
+			get_scalars(r, "iii", arg);
+			param = I(2);
+			glTexParameteriv(I(0), I(1), &param);
+			break;
+		}
+		case API_TRACE_CALL_glTexSubImage2D:
+		{
+			size_t size;
+
+			get_scalars(r, "iiiiiiii", arg);
+			glTexSubImage2D(I(0), I(1), I(2), I(3), I(4), I(5), I(6), I(7), get_blob(r, &size));
+			break;
+		}
+		case API_TRACE_CALL_glVertexAttribPointer:
+			get_scalars(r, "iiiiiii", arg);
+			if (I(5))
+			{
+				glVertexAttribPointer(I(0), I(1), I(2), I(3), I(4), (const void*)(intptr_t)arg[6].i);
+			}
+			break;
+		case API_TRACE_CALL_ClientArray:
+			replay_client_array(r);
+			break;
+
+		case API_TRACE_CALL_eglGetDisplay:
+			get_uvarint(r);
+			map_put(&handles, get_uvarint(r), (uintptr_t)replay_display());
+			break;
+		case API_TRACE_CALL_eglInitialize:
+			eglInitialize(get_handle(r), NULL, NULL);
+			break;
+		case API_TRACE_CALL_eglTerminate:
+			eglTerminate(get_handle(r));
+			break;
+		case API_TRACE_CALL_eglBindAPI:
+			eglBindAPI((EGLenum)get_int(r));
+			break;
+		case API_TRACE_CALL_eglChooseConfig:
+			replay_choose_config(r);
+			break;
+		case API_TRACE_CALL_eglCreateWindowSurface:
+			replay_window_surface(r);
+			break;
+		case API_TRACE_CALL_eglCreatePixmapSurface:
+			replay_pixmap_surface(r);
+			break;
+		case API_TRACE_CALL_eglCreatePbufferSurface:
+		{
+			EGLDisplay dpy = get_handle(r);
+			EGLConfig config = get_handle(r);
+			EGLint* list = get_attrib_list(r);
+
+			map_put(&handles, get_uvarint(r), (uintptr_t)eglCreatePbufferSurface(dpy, config, list));
+			break;
+		}
+		case API_TRACE_CALL_eglDestroySurface:
+		{
+			EGLDisplay dpy = get_handle(r);
+
+			eglDestroySurface(dpy, get_handle(r));
+			break;
+		}
+		case API_TRACE_CALL_eglCreateContext:
+		{
+			EGLDisplay dpy = get_handle(r);
+			EGLConfig config = get_handle(r);
+			EGLContext share = get_handle(r);
+			EGLint* list = get_attrib_list(r);
+
+			map_put(&handles, get_uvarint(r), (uintptr_t)eglCreateContext(dpy, config, share, list));
+			break;
+		}
+		case API_TRACE_CALL_eglDestroyContext:
+		{
+			EGLDisplay dpy = get_handle(r);
+
+			eglDestroyContext(dpy, get_handle(r));
+			break;
+		}
+		case API_TRACE_CALL_eglMakeCurrent:
+		{
+			EGLDisplay dpy = get_handle(r);
+			EGLSurface draw = get_handle(r);
+			EGLSurface read = get_handle(r);
+
+			eglMakeCurrent(dpy, draw, read, get_handle(r));
+			break;
+		}
+		case API_TRACE_CALL_eglSwapBuffers:
+		{
+			EGLDisplay dpy = get_handle(r);
+			EGLSurface surface = get_handle(r);
+			uint64_t end;
+
+			if (option_checksum)
+			{
+				frames->checksum = frame_checksum();
+			}
+			if (option_finish)
+			{
+				glFinish();
+			}
+			eglSwapBuffers(dpy, surface);
+			end = now_ns();
+			frame_add(frames, (end - frame_start) / 1e6, (recorded_us - frame_recorded_us) / 1e3);
+			frame_start = end;
+			frame_recorded_us = recorded_us;
+			break;
+		}
+		case API_TRACE_CALL_eglSwapInterval:
+		{
+			EGLDisplay dpy = get_handle(r);
+			EGLint interval = (EGLint)get_int(r);
+
+			eglSwapInterval(dpy, option_timing ? interval : 0);
+			break;
+		}
+
+		default:
+			fprintf(stderr, "unknown call %llu, trace corrupt\n", (unsigned long long)call);
+			return;
+		}
+	}
+}
+
+static void
+usage(const char* argv0)
+{
+	fprintf(stderr, "usage: %s [-t] [-f] [-c] [-v] trace\n", argv0);
+	fprintf(stderr, "  -t  replay at the captured pace instead of as fast as possible\n");
+	fprintf(stderr, "  -f  glFinish before every swap, so frame times include the GPU\n");
+	fprintf(stderr, "  -c  checksum the frame before every swap\n");
+	fprintf(stderr, "  -v  print every frame\n");
+}
+
+int
+main(int argc, char** argv)
+{
+	struct reader r;
+	struct frames frames;
+	unsigned char* data;
+	long size;
+	uint32_t version;
+	uint64_t start;
+	FILE* f;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "tfcv")) != -1)
+	{
+		switch (opt)
+		{
+		case 't':
+			option_timing = 1;
+			break;
+		case 'f':
+			option_finish = 1;
+			break;
+		case 'c':
+			option_checksum = 1;
+			break;
+		case 'v':
+			option_verbose = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (optind != argc - 1)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	f = fopen(argv[optind], "rb");
+	if (f == NULL)
+	{
+		perror(argv[optind]);
+		return 1;
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	data = malloc(size > 0 ? size : 1);
+	if (data == NULL || fread(data, 1, size, f) != (size_t)size)
+	{
+		fprintf(stderr, "%s: read failed\n", argv[optind]);
+		return 1;
+	}
+	fclose(f);
+
+	if (size < API_TRACE_HEADER_SIZE || memcmp(data, API_TRACE_MAGIC, API_TRACE_MAGIC_SIZE) != 0)
+	{
+		fprintf(stderr, "%s: not an API trace\n", argv[optind]);
+		return 1;
+	}
+	version = data[8] | data[9] << 8 | data[10] << 16 | (uint32_t)data[11] << 24;
+	if (version != API_TRACE_VERSION)
+	{
+		fprintf(stderr, "%s: trace version %u, expected %u\n", argv[optind], version, API_TRACE_VERSION);
+		return 1;
+	}
+
+	r.p = data + API_TRACE_HEADER_SIZE;
+	r.end = data + size;
+	r.eof = 0;
+	memset(&frames, 0, sizeof(frames));
+
+	start = now_ns();
+	replay(&r, &frames);
+	if (r.eof)
+	{
+		fprintf(stderr, "trace truncated, replayed up to the last complete call\n");
+	}
+	frames_report(&frames, (now_ns() - start) / 1e9);
+	return 0;
+}
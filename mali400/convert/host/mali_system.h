@@ -0,0 +1,24 @@
+/*
+ * Host stand-in for the DDK's mali_system.h.
+ *
+ * The shipped include/mali_system.h pulls in runtime, architecture and
+ * hardware configuration headers that are not part of this tree. The
+ * conversion code only needs the basic types and macros, so this header
+ * provides them and is put ahead of the DDK include directory; everything
+ * else comes from the real headers.
+ */
+
+#ifndef _MALI_SYSTEM_H_
+#define _MALI_SYSTEM_H_
+
+#include <assert.h>
+#include <stddef.h>
+
+#include <mali_config.h>
+#include <base/mali_types.h>
+#include <base/mali_macros.h>
+
+#define MALI_DEBUG_ASSERT( expr, X ) assert( expr )
+#define MALI_DEBUG_ASSERT_POINTER( pointer ) assert( (pointer) != NULL )
+
+#endif /* _MALI_SYSTEM_H_ */
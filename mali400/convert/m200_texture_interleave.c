@@ -0,0 +1,571 @@
+/*
+ * Host implementations of _m200_texture_interleave_16x16_blocked,
+ * _m200_texture_interleave_2d and _m200_texture_swizzle from
+ * shared/m200_texture.h.
+ *
+ * mali_convert_block_interleave_lut stores every 2x2 quad of a 16x16 block
+ * as four consecutive texels: top left, top right, bottom right, bottom
+ * left. Taking two source rows at a time, a quad is the top pair followed
+ * by the swapped bottom pair, which is a swap and an interleave in vector
+ * registers; the quads then go to the offsets the table gives for their
+ * top left texel. Blocks on the right and bottom edges are done texel by
+ * texel, and source rows of the next block are prefetched.
+ *
+ * The 2D interleaved layout is the same Z order over the whole texture
+ * rather than within 16x16 blocks, so it is written a quad at a time too.
+ * _m200_texture_swizzle dispatches between linear and 16x16 blocked
+ * layouts; going from blocked back to linear also takes whole blocks.
+ */
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#include <shared/mali_convert.h>
+#include <shared/m200_texture.h>
+
+#if defined(__GNUC__)
+#define M200_PREFETCH( address ) __builtin_prefetch( address )
+#else
+#define M200_PREFETCH( address )
+#endif
+
+#define M200_CACHE_LINE 64
+
+/* Bytes per texel, 0 for formats with texels smaller than a byte or compressed. */
+MALI_STATIC_INLINE int _m200_texture_texel_size( m200_texel_format format )
+{
+	switch ( format )
+	{
+		case M200_TEXEL_FORMAT_AL_44:
+		case M200_TEXEL_FORMAT_L_8:
+		case M200_TEXEL_FORMAT_A_8:
+		case M200_TEXEL_FORMAT_I_8:
+		case M200_TEXEL_FORMAT_RGB_332:
+		case M200_TEXEL_FORMAT_ARGB_2222:
+		case M200_TEXEL_FORMAT_PAL_8:
+			return 1;
+		case M200_TEXEL_FORMAT_RGB_565:
+		case M200_TEXEL_FORMAT_ARGB_1555:
+		case M200_TEXEL_FORMAT_ARGB_4444:
+		case M200_TEXEL_FORMAT_AL_88:
+		case M200_TEXEL_FORMAT_L_16:
+		case M200_TEXEL_FORMAT_A_16:
+		case M200_TEXEL_FORMAT_I_16:
+		case M200_TEXEL_FORMAT_L_FP16:
+		case M200_TEXEL_FORMAT_A_FP16:
+		case M200_TEXEL_FORMAT_I_FP16:
+			return 2;
+		case M200_TEXEL_FORMAT_RGB_888:
+			return 3;
+		case M200_TEXEL_FORMAT_ARGB_8888:
+		case M200_TEXEL_FORMAT_xRGB_8888:
+		case M200_TEXEL_FORMAT_ARGB_2_10_10_10:
+		case M200_TEXEL_FORMAT_RGB_11_11_10:
+		case M200_TEXEL_FORMAT_RGB_10_12_10:
+		case M200_TEXEL_FORMAT_AL_16_16:
+		case M200_TEXEL_FORMAT_AL_FP16:
+		case M200_TEXEL_FORMAT_DEPTH_STENCIL_24_8:
+		case M200_TEXEL_FORMAT_VERBATIM_COPY32:
+			return 4;
+		case M200_TEXEL_FORMAT_RGB_16_16_16:
+		case M200_TEXEL_FORMAT_RGB_FP16:
+			return 6;
+		case M200_TEXEL_FORMAT_ARGB_16_16_16_16:
+		case M200_TEXEL_FORMAT_ARGB_FP16:
+		case M200_TEXEL_FORMAT_CONVOLUTION_TEXTURE_64:
+			return 8;
+		default:
+			return 0;
+	}
+}
+
+/* Bits per texel, including the formats _m200_texture_texel_size leaves out. */
+MALI_STATIC_INLINE int _m200_texture_texel_bits( m200_texel_format format )
+{
+	switch ( format )
+	{
+		case M200_TEXEL_FORMAT_L_1:
+		case M200_TEXEL_FORMAT_A_1:
+		case M200_TEXEL_FORMAT_I_1:
+			return 1;
+		case M200_TEXEL_FORMAT_AL_11:
+			return 2;
+		case M200_TEXEL_FORMAT_L_4:
+		case M200_TEXEL_FORMAT_A_4:
+		case M200_TEXEL_FORMAT_I_4:
+		case M200_TEXEL_FORMAT_ARGB_1111:
+		case M200_TEXEL_FORMAT_PAL_4:
+		case M200_TEXEL_FORMAT_ETC:
+			return 4;
+		default:
+			return 8 * _m200_texture_texel_size( format );
+	}
+}
+
+/* Part of a block inside the image, texel by texel. */
+static void _m200_texture_interleave_partial_block( u8 *dest, const u8 *src, int src_pitch, int size,
+                                                    s32 block_width, s32 block_height )
+{
+	s32 x, y;
+	for ( y = 0; y < block_height; y++ )
+	{
+		for ( x = 0; x < block_width; x++ )
+		{
+			memcpy( dest + MALI_CONVERT_BLOCK_OFFSET( x, y ) * size, src + y * src_pitch + x * size, size );
+		}
+	}
+}
+
+/* A full block, a quad of four texels at a time. */
+static void _m200_texture_interleave_block_quads( u8 *dest, const u8 *src, int src_pitch, int size )
+{
+	int j, k;
+	for ( j = 0; j < 8; j++ )
+	{
+		const u8 *top = src + 2 * j * src_pitch;
+		const u8 *bottom = top + src_pitch;
+		const u8 *offsets = &mali_convert_block_interleave_lut[j * 32];
+		for ( k = 0; k < 8; k++ )
+		{
+			u8 *quad = dest + offsets[2 * k] * size;
+			memcpy( quad, top + 2 * k * size, 2 * size );
+			memcpy( quad + 2 * size, bottom + ( 2 * k + 1 ) * size, size );
+			memcpy( quad + 3 * size, bottom + 2 * k * size, size );
+		}
+	}
+}
+
+/* The reverse of _m200_texture_interleave_partial_block. */
+static void _m200_texture_deinterleave_partial_block( u8 *dest, const u8 *src, int dst_pitch, int size,
+                                                      s32 block_width, s32 block_height )
+{
+	s32 x, y;
+	for ( y = 0; y < block_height; y++ )
+	{
+		for ( x = 0; x < block_width; x++ )
+		{
+			memcpy( dest + y * dst_pitch + x * size, src + MALI_CONVERT_BLOCK_OFFSET( x, y ) * size, size );
+		}
+	}
+}
+
+/*
+ * The reverse of _m200_texture_interleave_block_quads. Forced inline so
+ * that the callers' constant sizes turn the copies into plain moves.
+ */
+MALI_STATIC_FORCE_INLINE void _m200_texture_deinterleave_block_quads( u8 *dest, const u8 *src, int dst_pitch, int size )
+{
+	int j, k;
+	for ( j = 0; j < 8; j++ )
+	{
+		u8 *top = dest + 2 * j * dst_pitch;
+		u8 *bottom = top + dst_pitch;
+		const u8 *offsets = &mali_convert_block_interleave_lut[j * 32];
+		for ( k = 0; k < 8; k++ )
+		{
+			const u8 *quad = src + offsets[2 * k] * size;
+			memcpy( top + 2 * k * size, quad, 2 * size );
+			memcpy( bottom + ( 2 * k + 1 ) * size, quad + 2 * size, size );
+			memcpy( bottom + 2 * k * size, quad + 3 * size, size );
+		}
+	}
+}
+
+static void _m200_texture_deinterleave_block( u8 *dest, const u8 *src, int dst_pitch, int size )
+{
+	switch ( size )
+	{
+		case 1: _m200_texture_deinterleave_block_quads( dest, src, dst_pitch, 1 ); break;
+		case 2: _m200_texture_deinterleave_block_quads( dest, src, dst_pitch, 2 ); break;
+		case 4: _m200_texture_deinterleave_block_quads( dest, src, dst_pitch, 4 ); break;
+		case 8: _m200_texture_deinterleave_block_quads( dest, src, dst_pitch, 8 ); break;
+		default: _m200_texture_deinterleave_block_quads( dest, src, dst_pitch, size ); break;
+	}
+}
+
+#if defined(__SSE2__)
+
+static void _m200_texture_interleave_block_8( u8 *dest, const u8 *src, int src_pitch )
+{
+	int j, k;
+	for ( j = 0; j < 8; j++ )
+	{
+		const u8 *offsets = &mali_convert_block_interleave_lut[j * 32];
+		__m128i top = _mm_loadu_si128( (const __m128i *)( src + 2 * j * src_pitch ) );
+		__m128i bottom = _mm_loadu_si128( (const __m128i *)( src + ( 2 * j + 1 ) * src_pitch ) );
+		__m128i quads[2];
+
+		bottom = _mm_or_si128( _mm_slli_epi16( bottom, 8 ), _mm_srli_epi16( bottom, 8 ) );
+		quads[0] = _mm_unpacklo_epi16( top, bottom );
+		quads[1] = _mm_unpackhi_epi16( top, bottom );
+		for ( k = 0; k < 8; k++ )
+		{
+			u32 quad = (u32)_mm_cvtsi128_si32( quads[k >> 2] );
+			memcpy( dest + offsets[2 * k], &quad, 4 );
+			quads[k >> 2] = _mm_srli_si128( quads[k >> 2], 4 );
+		}
+	}
+}
+
+static void _m200_texture_interleave_block_16( u8 *dest, const u8 *src, int src_pitch )
+{
+	int j, m;
+	for ( j = 0; j < 8; j++ )
+	{
+		const u8 *offsets = &mali_convert_block_interleave_lut[j * 32];
+		for ( m = 0; m < 2; m++ )
+		{
+			__m128i top = _mm_loadu_si128( (const __m128i *)( src + 2 * j * src_pitch + m * 16 ) );
+			__m128i bottom = _mm_loadu_si128( (const __m128i *)( src + ( 2 * j + 1 ) * src_pitch + m * 16 ) );
+			__m128i lo, hi;
+
+			bottom = _mm_shufflehi_epi16( _mm_shufflelo_epi16( bottom, 0xB1 ), 0xB1 );
+			lo = _mm_unpacklo_epi32( top, bottom );
+			hi = _mm_unpackhi_epi32( top, bottom );
+			_mm_storel_epi64( (__m128i *)( dest + offsets[8 * m + 0] * 2 ), lo );
+			_mm_storel_epi64( (__m128i *)( dest + offsets[8 * m + 2] * 2 ), _mm_srli_si128( lo, 8 ) );
+			_mm_storel_epi64( (__m128i *)( dest + offsets[8 * m + 4] * 2 ), hi );
+			_mm_storel_epi64( (__m128i *)( dest + offsets[8 * m + 6] * 2 ), _mm_srli_si128( hi, 8 ) );
+		}
+	}
+}
+
+static void _m200_texture_interleave_block_32( u8 *dest, const u8 *src, int src_pitch )
+{
+	int j, m;
+	for ( j = 0; j < 8; j++ )
+	{
+		const u8 *offsets = &mali_convert_block_interleave_lut[j * 32];
+		for ( m = 0; m < 4; m++ )
+		{
+			__m128i top = _mm_loadu_si128( (const __m128i *)( src + 2 * j * src_pitch + m * 16 ) );
+			__m128i bottom = _mm_loadu_si128( (const __m128i *)( src + ( 2 * j + 1 ) * src_pitch + m * 16 ) );
+
+			bottom = _mm_shuffle_epi32( bottom, 0xB1 );
+			_mm_storeu_si128( (__m128i *)( dest + offsets[4 * m + 0] * 4 ), _mm_unpacklo_epi64( top, bottom ) );
+			_mm_storeu_si128( (__m128i *)( dest + offsets[4 * m + 2] * 4 ), _mm_unpackhi_epi64( top, bottom ) );
+		}
+	}
+}
+
+static void _m200_texture_interleave_block_64( u8 *dest, const u8 *src, int src_pitch )
+{
+	int j, k;
+	for ( j = 0; j < 8; j++ )
+	{
+		const u8 *offsets = &mali_convert_block_interleave_lut[j * 32];
+		for ( k = 0; k < 8; k++ )
+		{
+			__m128i top = _mm_loadu_si128( (const __m128i *)( src + 2 * j * src_pitch + k * 16 ) );
+			__m128i bottom = _mm_loadu_si128( (const __m128i *)( src + ( 2 * j + 1 ) * src_pitch + k * 16 ) );
+			u8 *quad = dest + offsets[2 * k] * 8;
+
+			_mm_storeu_si128( (__m128i *)quad, top );
+			_mm_storeu_si128( (__m128i *)( quad + 16 ), _mm_shuffle_epi32( bottom, 0x4E ) );
+		}
+	}
+}
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+static void _m200_texture_interleave_block_8( u8 *dest, const u8 *src, int src_pitch )
+{
+	int j;
+	for ( j = 0; j < 8; j++ )
+	{
+		const u8 *offsets = &mali_convert_block_interleave_lut[j * 32];
+		uint8x16_t top = vld1q_u8( src + 2 * j * src_pitch );
+		uint8x16_t bottom = vrev16q_u8( vld1q_u8( src + ( 2 * j + 1 ) * src_pitch ) );
+		uint16x8x2_t quads = vzipq_u16( vreinterpretq_u16_u8( top ), vreinterpretq_u16_u8( bottom ) );
+		uint32x4_t lo = vreinterpretq_u32_u16( quads.val[0] );
+		uint32x4_t hi = vreinterpretq_u32_u16( quads.val[1] );
+
+		vst1q_lane_u32( (u32 *)( dest + offsets[0] ), lo, 0 );
+		vst1q_lane_u32( (u32 *)( dest + offsets[2] ), lo, 1 );
+		vst1q_lane_u32( (u32 *)( dest + offsets[4] ), lo, 2 );
+		vst1q_lane_u32( (u32 *)( dest + offsets[6] ), lo, 3 );
+		vst1q_lane_u32( (u32 *)( dest + offsets[8] ), hi, 0 );
+		vst1q_lane_u32( (u32 *)( dest + offsets[10] ), hi, 1 );
+		vst1q_lane_u32( (u32 *)( dest + offsets[12] ), hi, 2 );
+		vst1q_lane_u32( (u32 *)( dest + offsets[14] ), hi, 3 );
+	}
+}
+
+static void _m200_texture_interleave_block_16( u8 *dest, const u8 *src, int src_pitch )
+{
+	int j, m;
+	for ( j = 0; j < 8; j++ )
+	{
+		const u8 *offsets = &mali_convert_block_interleave_lut[j * 32];
+		for ( m = 0; m < 2; m++ )
+		{
+			uint16x8_t top = vld1q_u16( (const u16 *)( src + 2 * j * src_pitch + m * 16 ) );
+			uint16x8_t bottom = vrev32q_u16( vld1q_u16( (const u16 *)( src + ( 2 * j + 1 ) * src_pitch + m * 16 ) ) );
+			uint32x4x2_t quads = vzipq_u32( vreinterpretq_u32_u16( top ), vreinterpretq_u32_u16( bottom ) );
+
+			vst1_u32( (u32 *)( dest + offsets[8 * m + 0] * 2 ), vget_low_u32( quads.val[0] ) );
+			vst1_u32( (u32 *)( dest + offsets[8 * m + 2] * 2 ), vget_high_u32( quads.val[0] ) );
+			vst1_u32( (u32 *)( dest + offsets[8 * m + 4] * 2 ), vget_low_u32( quads.val[1] ) );
+			vst1_u32( (u32 *)( dest + offsets[8 * m + 6] * 2 ), vget_high_u32( quads.val[1] ) );
+		}
+	}
+}
+
+static void _m200_texture_interleave_block_32( u8 *dest, const u8 *src, int src_pitch )
+{
+	int j, m;
+	for ( j = 0; j < 8; j++ )
+	{
+		const u8 *offsets = &mali_convert_block_interleave_lut[j * 32];
+		for ( m = 0; m < 4; m++ )
+		{
+			uint32x4_t top = vld1q_u32( (const u32 *)( src + 2 * j * src_pitch + m * 16 ) );
+			uint32x4_t bottom = vrev64q_u32( vld1q_u32( (const u32 *)( src + ( 2 * j + 1 ) * src_pitch + m * 16 ) ) );
+
+			vst1q_u32( (u32 *)( dest + offsets[4 * m + 0] * 4 ), vcombine_u32( vget_low_u32( top ), vget_low_u32( bottom ) ) );
+			vst1q_u32( (u32 *)( dest + offsets[4 * m + 2] * 4 ), vcombine_u32( vget_high_u32( top ), vget_high_u32( bottom ) ) );
+		}
+	}
+}
+
+static void _m200_texture_interleave_block_64( u8 *dest, const u8 *src, int src_pitch )
+{
+	int j, k;
+	for ( j = 0; j < 8; j++ )
+	{
+		const u8 *offsets = &mali_convert_block_interleave_lut[j * 32];
+		for ( k = 0; k < 8; k++ )
+		{
+			uint8x16_t top = vld1q_u8( src + 2 * j * src_pitch + k * 16 );
+			uint8x16_t bottom = vld1q_u8( src + ( 2 * j + 1 ) * src_pitch + k * 16 );
+			u8 *quad = dest + offsets[2 * k] * 8;
+
+			vst1q_u8( quad, top );
+			vst1q_u8( quad + 16, vextq_u8( bottom, bottom, 8 ) );
+		}
+	}
+}
+
+#else
+
+static void _m200_texture_interleave_block_8( u8 *dest, const u8 *src, int src_pitch )
+{
+	_m200_texture_interleave_block_quads( dest, src, src_pitch, 1 );
+}
+
+static void _m200_texture_interleave_block_16( u8 *dest, const u8 *src, int src_pitch )
+{
+	_m200_texture_interleave_block_quads( dest, src, src_pitch, 2 );
+}
+
+static void _m200_texture_interleave_block_32( u8 *dest, const u8 *src, int src_pitch )
+{
+	_m200_texture_interleave_block_quads( dest, src, src_pitch, 4 );
+}
+
+static void _m200_texture_interleave_block_64( u8 *dest, const u8 *src, int src_pitch )
+{
+	_m200_texture_interleave_block_quads( dest, src, src_pitch, 8 );
+}
+
+#endif
+
+void _m200_texture_interleave_16x16_blocked( void *dest, const void *src, s32 width, s32 height,
+                                             int src_pitch, m200_texel_format texel_format )
+{
+	int size = _m200_texture_texel_size( texel_format );
+	s32 blocks_per_row = ( width + 15 ) / 16;
+	s32 bx, by;
+	int row;
+
+	MALI_DEBUG_ASSERT_POINTER( dest );
+	MALI_DEBUG_ASSERT_POINTER( src );
+	MALI_DEBUG_ASSERT( 0 != size, ("unsupported texel format %d", texel_format) );
+	if ( 0 == size ) return;
+
+	for ( by = 0; by * 16 < height; by++ )
+	{
+		const u8 *src_rows = (const u8 *)src + by * 16 * src_pitch;
+		s32 block_height = height - by * 16 < 16 ? height - by * 16 : 16;
+
+		for ( bx = 0; bx < blocks_per_row; bx++ )
+		{
+			const u8 *block_src = src_rows + bx * 16 * size;
+			u8 *block_dest = (u8 *)dest + ( by * blocks_per_row + bx ) * 16 * 16 * size;
+			s32 block_width = width - bx * 16 < 16 ? width - bx * 16 : 16;
+
+			/* every cache line of the next block's rows; 16 texels of 8 bytes span at least two */
+			if ( bx + 1 < blocks_per_row )
+			{
+				for ( row = 0; row < block_height; row++ )
+				{
+					const u8 *next = block_src + row * src_pitch + 16 * size;
+					int line = -(int)( (uintptr_t)next & ( M200_CACHE_LINE - 1 ) );
+					for ( ; line < 16 * size; line += M200_CACHE_LINE ) M200_PREFETCH( next + line );
+				}
+			}
+
+			if ( 16 != block_width || 16 != block_height )
+			{
+				_m200_texture_interleave_partial_block( block_dest, block_src, src_pitch, size, block_width, block_height );
+				continue;
+			}
+			switch ( size )
+			{
+				case 1: _m200_texture_interleave_block_8( block_dest, block_src, src_pitch ); break;
+				case 2: _m200_texture_interleave_block_16( block_dest, block_src, src_pitch ); break;
+				case 4: _m200_texture_interleave_block_32( block_dest, block_src, src_pitch ); break;
+				case 8: _m200_texture_interleave_block_64( block_dest, block_src, src_pitch ); break;
+				default: _m200_texture_interleave_block_quads( block_dest, block_src, src_pitch, size ); break;
+			}
+		}
+	}
+}
+
+/* The reverse of _m200_texture_interleave_16x16_blocked, block by block. */
+static void _m200_texture_deinterleave_16x16_blocked( void *dest, const void *src, s32 width, s32 height,
+                                                      int dst_pitch, int size )
+{
+	s32 blocks_per_row = ( width + 15 ) / 16;
+	s32 bx, by;
+
+	for ( by = 0; by * 16 < height; by++ )
+	{
+		u8 *dest_rows = (u8 *)dest + by * 16 * dst_pitch;
+		s32 block_height = height - by * 16 < 16 ? height - by * 16 : 16;
+
+		for ( bx = 0; bx < blocks_per_row; bx++ )
+		{
+			const u8 *block_src = (const u8 *)src + ( by * blocks_per_row + bx ) * 16 * 16 * size;
+			u8 *block_dest = dest_rows + bx * 16 * size;
+			s32 block_width = width - bx * 16 < 16 ? width - bx * 16 : 16;
+
+			if ( 16 != block_width || 16 != block_height )
+			{
+				_m200_texture_deinterleave_partial_block( block_dest, block_src, dst_pitch, size, block_width, block_height );
+			}
+			else
+			{
+				_m200_texture_deinterleave_block( block_dest, block_src, dst_pitch, size );
+			}
+		}
+	}
+}
+
+/*
+ * The next even coordinate in spread form, from that of an even one: the
+ * odd bits are set so the carry runs straight through them.
+ */
+MALI_STATIC_FORCE_INLINE u32 _m200_texture_spread_next_pair( u32 spread )
+{
+	return ( ( spread | 0xAAAAAAAAu ) + 4 ) & 0x55555555u;
+}
+
+/*
+ * Elements of size bytes in Z order over the whole texture: the even bits
+ * of an element's index are x ^ y and the odd bits y, each coordinate
+ * spread to the even bits, so a quad's top left element starts four
+ * consecutive ones in the same order as in a 16x16 block.
+ */
+MALI_STATIC_FORCE_INLINE void _m200_texture_interleave_2d_quads( u8 *dest, const u8 *src, s32 width, s32 height,
+                                                                 int src_pitch, int size )
+{
+	u32 x_spread, y_spread = 0;
+	s32 x, y;
+
+	for ( y = 0; y < height; y += 2, y_spread = _m200_texture_spread_next_pair( y_spread ) )
+	{
+		const u8 *top = src + y * src_pitch;
+		const u8 *bottom = top + src_pitch;
+		mali_bool full_height = y + 1 < height;
+
+		for ( x = 0, x_spread = 0; x < width; x += 2, x_spread = _m200_texture_spread_next_pair( x_spread ) )
+		{
+			u8 *quad = dest + ( ( x_spread ^ y_spread ) + ( y_spread << 1 ) ) * size;
+
+			if ( x + 1 < width && full_height )
+			{
+				memcpy( quad, top + x * size, 2 * size );
+				memcpy( quad + 2 * size, bottom + ( x + 1 ) * size, size );
+				memcpy( quad + 3 * size, bottom + x * size, size );
+				continue;
+			}
+			memcpy( quad, top + x * size, size );
+			if ( x + 1 < width ) memcpy( quad + size, top + ( x + 1 ) * size, size );
+			if ( full_height ) memcpy( quad + 3 * size, bottom + x * size, size );
+		}
+	}
+}
+
+void _m200_texture_interleave_2d( void *dest, const void *src, s32 width, s32 height,
+                                  int src_pitch, m200_texel_format texel_format, s32 texels_per_block )
+{
+	int size = ( texels_per_block * _m200_texture_texel_bits( texel_format ) + 7 ) / 8;
+
+	MALI_DEBUG_ASSERT_POINTER( dest );
+	MALI_DEBUG_ASSERT_POINTER( src );
+	MALI_DEBUG_ASSERT( 0 != size, ("unsupported texel format %d", texel_format) );
+
+	switch ( size )
+	{
+		case 0: break;
+		case 1: _m200_texture_interleave_2d_quads( dest, src, width, height, src_pitch, 1 ); break;
+		case 2: _m200_texture_interleave_2d_quads( dest, src, width, height, src_pitch, 2 ); break;
+		case 4: _m200_texture_interleave_2d_quads( dest, src, width, height, src_pitch, 4 ); break;
+		case 8: _m200_texture_interleave_2d_quads( dest, src, width, height, src_pitch, 8 ); break;
+		default: _m200_texture_interleave_2d_quads( dest, src, width, height, src_pitch, size ); break;
+	}
+}
+
+/*
+ * Linear and 16x16 blocked layouts only. Texels have to be whole bytes
+ * except for a linear to linear copy; ETC goes through
+ * _m200_texture_interleave_16x16_blocked_etc, which the host build lacks.
+ */
+mali_err_code _m200_texture_swizzle( void *dest, m200_texture_addressing_mode dest_mode,
+                                     const void *src, m200_texture_addressing_mode src_mode,
+                                     s32 width, s32 height, m200_texel_format format,
+                                     int dst_pitch, int src_pitch )
+{
+	int size = _m200_texture_texel_size( format );
+	s32 y;
+
+	MALI_DEBUG_ASSERT_POINTER( dest );
+	MALI_DEBUG_ASSERT_POINTER( src );
+
+	if ( M200_TEXTURE_ADDRESSING_MODE_LINEAR == dest_mode && M200_TEXTURE_ADDRESSING_MODE_LINEAR == src_mode )
+	{
+		int row_bytes = ( width * _m200_texture_texel_bits( format ) + 7 ) / 8;
+		if ( 0 == row_bytes && 0 < width ) return MALI_ERR_FUNCTION_FAILED;
+		for ( y = 0; y < height; y++ )
+		{
+			memcpy( (u8 *)dest + y * dst_pitch, (const u8 *)src + y * src_pitch, row_bytes );
+		}
+		return MALI_ERR_NO_ERROR;
+	}
+
+	if ( 0 == size ) return MALI_ERR_FUNCTION_FAILED;
+
+	if ( M200_TEXTURE_ADDRESSING_MODE_16X16_BLOCKED == dest_mode && M200_TEXTURE_ADDRESSING_MODE_LINEAR == src_mode )
+	{
+		_m200_texture_interleave_16x16_blocked( dest, src, width, height, src_pitch, format );
+		return MALI_ERR_NO_ERROR;
+	}
+	if ( M200_TEXTURE_ADDRESSING_MODE_LINEAR == dest_mode && M200_TEXTURE_ADDRESSING_MODE_16X16_BLOCKED == src_mode )
+	{
+		_m200_texture_deinterleave_16x16_blocked( dest, src, width, height, dst_pitch, size );
+		return MALI_ERR_NO_ERROR;
+	}
+	if ( M200_TEXTURE_ADDRESSING_MODE_16X16_BLOCKED == dest_mode && M200_TEXTURE_ADDRESSING_MODE_16X16_BLOCKED == src_mode )
+	{
+		memcpy( dest, src, (size_t)MALI_ALIGN( width, 16 ) * MALI_ALIGN( height, 16 ) * size );
+		return MALI_ERR_NO_ERROR;
+	}
+	return MALI_ERR_FUNCTION_FAILED;
+}
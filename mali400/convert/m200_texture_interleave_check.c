@@ -0,0 +1,215 @@
+/*
+ * Checks _m200_texture_interleave_16x16_blocked against per texel
+ * MALI_CONVERT_BLOCKED_ADDRESS placement and measures both; also checks
+ * _m200_texture_interleave_2d against per texel Z order placement and that
+ * _m200_texture_swizzle takes blocked textures back to linear.
+ *
+ *   m200_texture_interleave_check      compare them for each texel size on
+ *                                      aligned and unaligned image sizes
+ *   m200_texture_interleave_check -b   also time a 4096x4096 interleave
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <shared/mali_convert.h>
+#include <shared/m200_texture.h>
+
+#define BENCH_SIZE 4096
+#define BENCH_RUNS 5
+
+typedef struct
+{
+	const char *name;
+	m200_texel_format format;
+	int size;
+} check_format;
+
+static const check_format check_formats[] =
+{
+	{ "L_8", M200_TEXEL_FORMAT_L_8, 1 },
+	{ "RGB_565", M200_TEXEL_FORMAT_RGB_565, 2 },
+	{ "RGB_888", M200_TEXEL_FORMAT_RGB_888, 3 },
+	{ "ARGB_8888", M200_TEXEL_FORMAT_ARGB_8888, 4 },
+	{ "RGB_16_16_16", M200_TEXEL_FORMAT_RGB_16_16_16, 6 },
+	{ "ARGB_16_16_16_16", M200_TEXEL_FORMAT_ARGB_16_16_16_16, 8 }
+};
+
+static const s32 check_sizes[][2] =
+{
+	{ 1, 1 }, { 16, 16 }, { 17, 3 }, { 33, 47 }, { 64, 64 }, { 100, 37 }, { 255, 257 }
+};
+
+static unsigned int check_seed = 12345;
+
+static u8 check_random_byte( void )
+{
+	check_seed = check_seed * 1103515245u + 12345u;
+	return (u8)( check_seed >> 16 );
+}
+
+static double check_clock_ms( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void check_naive( u8 *dest, const u8 *src, s32 width, s32 height, int src_pitch, int size )
+{
+	s32 x, y;
+	for ( y = 0; y < height; y++ )
+	{
+		for ( x = 0; x < width; x++ )
+		{
+			memcpy( dest + MALI_CONVERT_BLOCKED_ADDRESS( x, y, MALI_ALIGN( width, 16 ) ) * size, src + y * src_pitch + x * size, size );
+		}
+	}
+}
+
+/* Even bits of the index are x ^ y, odd bits y. */
+static u32 check_index_2d( s32 x, s32 y )
+{
+	u32 index = 0;
+	int bit;
+	for ( bit = 0; bit < 16; bit++ )
+	{
+		index |= ( ( ( x ^ y ) >> bit ) & 1u ) << ( 2 * bit );
+		index |= ( ( y >> bit ) & 1u ) << ( 2 * bit + 1 );
+	}
+	return index;
+}
+
+static void check_naive_2d( u8 *dest, const u8 *src, s32 width, s32 height, int src_pitch, int size )
+{
+	s32 x, y;
+	for ( y = 0; y < height; y++ )
+	{
+		for ( x = 0; x < width; x++ )
+		{
+			memcpy( dest + check_index_2d( x, y ) * size, src + y * src_pitch + x * size, size );
+		}
+	}
+}
+
+static mali_bool check_same( const char *what, s32 width, s32 height, const u8 *expected, const u8 *actual, size_t bytes )
+{
+	size_t i;
+	if ( 0 == memcmp( expected, actual, bytes ) ) return MALI_TRUE;
+	for ( i = 0; expected[i] == actual[i]; i++ );
+	printf( "  %s %dx%d: byte %d is 0x%02X, expected 0x%02X\n", what, (int)width, (int)height, (int)i, actual[i], expected[i] );
+	return MALI_FALSE;
+}
+
+/* Best of BENCH_RUNS, in GB/s of texel data. */
+static double check_bench( mali_bool naive, u8 *dest, const u8 *src, const check_format *format )
+{
+	double bytes = (double)BENCH_SIZE * BENCH_SIZE * format->size;
+	double best = 0.0;
+	int run;
+
+	for ( run = 0; run < BENCH_RUNS; run++ )
+	{
+		double start = check_clock_ms(), ms;
+		if ( naive ) check_naive( dest, src, BENCH_SIZE, BENCH_SIZE, BENCH_SIZE * format->size, format->size );
+		else _m200_texture_interleave_16x16_blocked( dest, src, BENCH_SIZE, BENCH_SIZE, BENCH_SIZE * format->size, format->format );
+		ms = check_clock_ms() - start;
+		if ( 0 == run || bytes / ( ms * 1e6 ) > best ) best = bytes / ( ms * 1e6 );
+	}
+	return best;
+}
+
+int main( int argc, char **argv )
+{
+	mali_bool bench = argc > 1 && 0 == strcmp( argv[1], "-b" );
+	int failures = 0;
+	int f, s;
+
+	for ( f = 0; f < (int)( sizeof( check_formats ) / sizeof( check_formats[0] ) ); f++ )
+	{
+		const check_format *format = &check_formats[f];
+		mali_bool ok = MALI_TRUE;
+
+		for ( s = 0; s < (int)( sizeof( check_sizes ) / sizeof( check_sizes[0] ) ) && ok; s++ )
+		{
+			s32 width = check_sizes[s][0], height = check_sizes[s][1];
+			/* padded pitches, so that rows past the width are never read or written */
+			int src_pitch = width * format->size + 5;
+			int dst_pitch = width * format->size + 3;
+			size_t src_bytes = (size_t)src_pitch * height;
+			size_t dest_bytes = (size_t)MALI_ALIGN( width, 16 ) * MALI_ALIGN( height, 16 ) * format->size;
+			size_t linear_bytes = (size_t)dst_pitch * height;
+			/* the 2D layout covers the enclosing power of two square */
+			s32 side = 1;
+			size_t dest_2d_bytes, bytes;
+			u8 *src, *blocked, *expected, *actual;
+			s32 y;
+			size_t i;
+
+			while ( side < width || side < height ) side *= 2;
+			dest_2d_bytes = (size_t)side * side * format->size;
+			bytes = dest_bytes > dest_2d_bytes ? dest_bytes : dest_2d_bytes;
+			bytes = bytes > linear_bytes ? bytes : linear_bytes;
+			src = malloc( src_bytes );
+			blocked = malloc( dest_bytes );
+			expected = malloc( bytes );
+			actual = malloc( bytes );
+
+			for ( i = 0; i < src_bytes; i++ ) src[i] = check_random_byte();
+			memset( expected, 0xA5, dest_bytes );
+			memset( blocked, 0xA5, dest_bytes );
+			check_naive( expected, src, width, height, src_pitch, format->size );
+			_m200_texture_interleave_16x16_blocked( blocked, src, width, height, src_pitch, format->format );
+			ok = check_same( "blocked", width, height, expected, blocked, dest_bytes );
+
+			memset( expected, 0xA5, linear_bytes );
+			memset( actual, 0xA5, linear_bytes );
+			for ( y = 0; y < height; y++ ) memcpy( expected + y * dst_pitch, src + y * src_pitch, width * format->size );
+			if ( MALI_ERR_NO_ERROR != _m200_texture_swizzle( actual, M200_TEXTURE_ADDRESSING_MODE_LINEAR, blocked,
+			                                                 M200_TEXTURE_ADDRESSING_MODE_16X16_BLOCKED, width, height,
+			                                                 format->format, dst_pitch, 0 ) )
+			{
+				printf( "  swizzle %dx%d: failed\n", (int)width, (int)height );
+				ok = MALI_FALSE;
+			}
+			ok = check_same( "blocked to linear", width, height, expected, actual, linear_bytes ) && ok;
+
+			memset( expected, 0xA5, dest_2d_bytes );
+			memset( actual, 0xA5, dest_2d_bytes );
+			check_naive_2d( expected, src, width, height, src_pitch, format->size );
+			_m200_texture_interleave_2d( actual, src, width, height, src_pitch, format->format, 1 );
+			ok = check_same( "2d", width, height, expected, actual, dest_2d_bytes ) && ok;
+
+			free( src );
+			free( blocked );
+			free( expected );
+			free( actual );
+		}
+		printf( "%s: %s\n", format->name, ok ? "exact" : "MISMATCH" );
+		if ( !ok ) failures++;
+	}
+
+	if ( bench )
+	{
+		u8 *src = malloc( (size_t)BENCH_SIZE * BENCH_SIZE * 8 );
+		u8 *dest = malloc( (size_t)BENCH_SIZE * BENCH_SIZE * 8 );
+		memset( src, 0x5A, (size_t)BENCH_SIZE * BENCH_SIZE * 8 );
+		memset( dest, 0, (size_t)BENCH_SIZE * BENCH_SIZE * 8 );
+
+		printf( "\n%-18s %8s %8s   (GB/s, %dx%d)\n", "format", "naive", "blocks", BENCH_SIZE, BENCH_SIZE );
+		for ( f = 0; f < (int)( sizeof( check_formats ) / sizeof( check_formats[0] ) ); f++ )
+		{
+			printf( "%-18s %8.2f %8.2f\n", check_formats[f].name,
+			        check_bench( MALI_TRUE, dest, src, &check_formats[f] ), check_bench( MALI_FALSE, dest, src, &check_formats[f] ) );
+		}
+		free( src );
+		free( dest );
+	}
+
+	printf( "%s\n", failures ? "FAILED" : "interleave matches per texel addressing" );
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,338 @@
+/*
+ * AVX2 kernels for the RGBA8888 conversions. Byte formats are moved with
+ * in-lane byte shuffles; the packed formats use the SSE2 arithmetic on
+ * twice the pixels. Built with -mavx2 and only called after
+ * _mali_convert_avx2_supported().
+ */
+
+#include <string.h>
+#include <immintrin.h>
+
+#include "mali_convert_simd.h"
+
+#define LOAD128( p ) _mm_loadu_si128( (const __m128i *)(p) )
+#define LOAD( p ) _mm256_loadu_si256( (const __m256i *)(p) )
+#define STORE( p, v ) _mm256_storeu_si256( (__m256i *)(p), (v) )
+
+#define Z (char)0x80    /* shuffle index that produces a zero byte */
+
+static mali_bool _mali_convert_avx2_supported( void )
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports( "avx2" ) ? MALI_TRUE : MALI_FALSE;
+}
+
+/** Same 16 byte shuffle in both lanes. */
+MALI_STATIC_FORCE_INLINE __m256i _mali_convert_avx2_mask( const char mask[16] )
+{
+	return _mm256_broadcastsi128_si256( LOAD128( mask ) );
+}
+
+/** 16 bit lanes of (r | g << 8) and (b | a << 8) to 16 pixels of RGBA8888. */
+MALI_STATIC_FORCE_INLINE void _mali_convert_avx2_store_rgba( u8 *dst, __m256i rg, __m256i ba )
+{
+	__m256i lo = _mm256_unpacklo_epi16( rg, ba );
+	__m256i hi = _mm256_unpackhi_epi16( rg, ba );
+	STORE( dst, _mm256_permute2x128_si256( lo, hi, 0x20 ) );
+	STORE( dst + 32, _mm256_permute2x128_si256( lo, hi, 0x31 ) );
+}
+
+/** Packs 32 bit lanes holding 16 bit values, keeping pixel order. */
+MALI_STATIC_FORCE_INLINE __m256i _mali_convert_avx2_pack32( __m256i lo, __m256i hi )
+{
+	lo = _mm256_srai_epi32( _mm256_slli_epi32( lo, 16 ), 16 );
+	hi = _mm256_srai_epi32( _mm256_slli_epi32( hi, 16 ), 16 );
+	return _mm256_permute4x64_epi64( _mm256_packs_epi32( lo, hi ), 0xD8 );
+}
+
+static int _mali_convert_avx2_from_8bit( u8 *dst, const u8 *src, int count, enum mali_convert_pixel_format format )
+{
+	static const char l8[2][16] =
+	{
+		{ 0, 0, 0, Z, 1, 1, 1, Z, 2, 2, 2, Z, 3, 3, 3, Z },
+		{ 4, 4, 4, Z, 5, 5, 5, Z, 6, 6, 6, Z, 7, 7, 7, Z }
+	};
+	static const char a8[2][16] =
+	{
+		{ Z, Z, Z, 0, Z, Z, Z, 1, Z, Z, Z, 2, Z, Z, Z, 3 },
+		{ Z, Z, Z, 4, Z, Z, Z, 5, Z, Z, Z, 6, Z, Z, Z, 7 }
+	};
+	static const char la8[16] = { 0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7 };
+	static const char rgb8[16] = { 0, 1, 2, Z, 3, 4, 5, Z, 6, 7, 8, Z, 9, 10, 11, Z };
+	const __m256i alpha = _mm256_set1_epi32( (int)0xFF000000 );
+	int i = 0;
+
+	switch ( format )
+	{
+		case MALI_CONVERT_PIXEL_FORMAT_R8G8B8A8:
+			memcpy( dst, src, (size_t)count * 4 );
+			return count;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L8:
+		case MALI_CONVERT_PIXEL_FORMAT_A8:
+		{
+			/* Each output takes 8 source bytes, broadcast to both lanes; the
+			 * low lane expands the first 4, the high lane the last 4. */
+			mali_bool lum = MALI_CONVERT_PIXEL_FORMAT_L8 == format;
+			__m256i mask = _mm256_set_m128i( LOAD128( lum ? l8[1] : a8[1] ), LOAD128( lum ? l8[0] : a8[0] ) );
+			__m256i set = lum ? alpha : _mm256_setzero_si256();
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				__m128i v = LOAD128( src + i );
+				__m256i first = _mm256_broadcastsi128_si256( v );
+				__m256i second = _mm256_broadcastsi128_si256( _mm_srli_si128( v, 8 ) );
+				STORE( dst + i * 4, _mm256_or_si256( _mm256_shuffle_epi8( first, mask ), set ) );
+				STORE( dst + i * 4 + 32, _mm256_or_si256( _mm256_shuffle_epi8( second, mask ), set ) );
+			}
+			return i;
+		}
+
+		case MALI_CONVERT_PIXEL_FORMAT_L8A8:
+		{
+			__m256i mask = _mali_convert_avx2_mask( la8 );
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				__m128i v0 = LOAD128( src + i * 2 ), v1 = LOAD128( src + i * 2 + 16 );
+				/* Lanes of 4 pixels: bytes 0-7 and 8-15 of each load. */
+				STORE( dst + i * 4, _mm256_shuffle_epi8( _mm256_set_m128i( _mm_srli_si128( v0, 8 ), v0 ), mask ) );
+				STORE( dst + i * 4 + 32, _mm256_shuffle_epi8( _mm256_set_m128i( _mm_srli_si128( v1, 8 ), v1 ), mask ) );
+			}
+			return i;
+		}
+
+		case MALI_CONVERT_PIXEL_FORMAT_R8G8B8:
+		{
+			__m256i mask = _mali_convert_avx2_mask( rgb8 );
+			/* 16 byte loads of 12 byte groups read 4 bytes ahead, so stop while
+			 * the last load still ends inside the source. */
+			for ( ; i + 8 + 2 <= count; i += 8 )
+			{
+				__m256i v = _mm256_set_m128i( LOAD128( src + i * 3 + 12 ), LOAD128( src + i * 3 ) );
+				STORE( dst + i * 4, _mm256_or_si256( _mm256_shuffle_epi8( v, mask ), alpha ) );
+			}
+			return i;
+		}
+
+		default:
+			return 0;
+	}
+}
+
+static int _mali_convert_avx2_from_16bit( u8 *dst, const u16 *src, int count, enum mali_convert_pixel_format format )
+{
+	const __m256i mask4 = _mm256_set1_epi16( 0x0F ), mask5 = _mm256_set1_epi16( 0x1F ), mask6 = _mm256_set1_epi16( 0x3F );
+	const __m256i alpha = _mm256_set1_epi16( (short)0xFF00 );
+	int i = 0;
+
+	switch ( format )
+	{
+		case MALI_CONVERT_PIXEL_FORMAT_R5G6B5:
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				__m256i t = LOAD( src + i );
+				__m256i r = _mm256_srli_epi16( t, 11 );
+				__m256i g = _mm256_and_si256( _mm256_srli_epi16( t, 5 ), mask6 );
+				__m256i b = _mm256_and_si256( t, mask5 );
+				r = _mm256_or_si256( _mm256_slli_epi16( r, 3 ), _mm256_srli_epi16( r, 2 ) );
+				g = _mm256_or_si256( _mm256_slli_epi16( g, 2 ), _mm256_srli_epi16( g, 4 ) );
+				b = _mm256_or_si256( _mm256_slli_epi16( b, 3 ), _mm256_srli_epi16( b, 2 ) );
+				_mali_convert_avx2_store_rgba( dst + i * 4, _mm256_or_si256( r, _mm256_slli_epi16( g, 8 ) ), _mm256_or_si256( b, alpha ) );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_R4G4B4A4:
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				__m256i t = LOAD( src + i );
+				__m256i r = _mm256_srli_epi16( t, 12 );
+				__m256i g = _mm256_and_si256( _mm256_srli_epi16( t, 8 ), mask4 );
+				__m256i b = _mm256_and_si256( _mm256_srli_epi16( t, 4 ), mask4 );
+				__m256i a = _mm256_and_si256( t, mask4 );
+				__m256i rg = _mm256_or_si256( r, _mm256_slli_epi16( g, 8 ) );
+				__m256i ba = _mm256_or_si256( b, _mm256_slli_epi16( a, 8 ) );
+				_mali_convert_avx2_store_rgba( dst + i * 4, _mm256_or_si256( rg, _mm256_slli_epi16( rg, 4 ) ), _mm256_or_si256( ba, _mm256_slli_epi16( ba, 4 ) ) );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_R5G5B5A1:
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				__m256i t = LOAD( src + i );
+				__m256i r = _mm256_srli_epi16( t, 11 );
+				__m256i g = _mm256_and_si256( _mm256_srli_epi16( t, 6 ), mask5 );
+				__m256i b = _mm256_and_si256( _mm256_srli_epi16( t, 1 ), mask5 );
+				__m256i a = _mm256_and_si256( _mm256_srai_epi16( _mm256_slli_epi16( t, 15 ), 15 ), alpha );
+				r = _mm256_or_si256( _mm256_slli_epi16( r, 3 ), _mm256_srli_epi16( r, 2 ) );
+				g = _mm256_or_si256( _mm256_slli_epi16( g, 3 ), _mm256_srli_epi16( g, 2 ) );
+				b = _mm256_or_si256( _mm256_slli_epi16( b, 3 ), _mm256_srli_epi16( b, 2 ) );
+				_mali_convert_avx2_store_rgba( dst + i * 4, _mm256_or_si256( r, _mm256_slli_epi16( g, 8 ) ), _mm256_or_si256( b, a ) );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L16A16:
+		{
+			static const char la16[16] = { 1, 1, 1, 3, 5, 5, 5, 7, 9, 9, 9, 11, 13, 13, 13, 15 };
+			__m256i mask = _mali_convert_avx2_mask( la16 );
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				STORE( dst + i * 4, _mm256_shuffle_epi8( LOAD( src + i * 2 ), mask ) );
+			}
+			return i;
+		}
+
+		case MALI_CONVERT_PIXEL_FORMAT_R16G16B16A16:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				__m256i lo = _mm256_srli_epi16( LOAD( src + i * 4 ), 8 );
+				__m256i hi = _mm256_srli_epi16( LOAD( src + i * 4 + 16 ), 8 );
+				STORE( dst + i * 4, _mm256_permute4x64_epi64( _mm256_packus_epi16( lo, hi ), 0xD8 ) );
+			}
+			return i;
+
+		default:
+			return 0;
+	}
+}
+
+static int _mali_convert_avx2_to_8bit( u8 *dst, const u8 *src, int count, enum mali_convert_pixel_format format )
+{
+	static const char l8[16] = { 0, 4, 8, 12, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z };
+	static const char a8[16] = { 3, 7, 11, 15, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z };
+	static const char la8[16] = { 0, 3, 4, 7, 8, 11, 12, 15, Z, Z, Z, Z, Z, Z, Z, Z };
+	static const char rgb8[16] = { 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, Z, Z, Z, Z };
+	int i = 0;
+
+	switch ( format )
+	{
+		case MALI_CONVERT_PIXEL_FORMAT_R8G8B8A8:
+			memcpy( dst, src, (size_t)count * 4 );
+			return count;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L8:
+		case MALI_CONVERT_PIXEL_FORMAT_A8:
+		{
+			/* The shuffle leaves 4 bytes in the first dword of each lane; the
+			 * unpacks collect them lane by lane and the permute restores
+			 * pixel order. */
+			__m256i mask = _mali_convert_avx2_mask( MALI_CONVERT_PIXEL_FORMAT_L8 == format ? l8 : a8 );
+			const __m256i order = _mm256_setr_epi32( 0, 4, 1, 5, 2, 6, 3, 7 );
+			for ( ; i + 32 <= count; i += 32 )
+			{
+				__m256i v0 = _mm256_shuffle_epi8( LOAD( src + i * 4 ), mask );
+				__m256i v1 = _mm256_shuffle_epi8( LOAD( src + i * 4 + 32 ), mask );
+				__m256i v2 = _mm256_shuffle_epi8( LOAD( src + i * 4 + 64 ), mask );
+				__m256i v3 = _mm256_shuffle_epi8( LOAD( src + i * 4 + 96 ), mask );
+				__m256i v01 = _mm256_unpacklo_epi32( v0, v1 );
+				__m256i v23 = _mm256_unpacklo_epi32( v2, v3 );
+				__m256i all = _mm256_unpacklo_epi64( v01, v23 );
+				STORE( dst + i, _mm256_permutevar8x32_epi32( all, order ) );
+			}
+			return i;
+		}
+
+		case MALI_CONVERT_PIXEL_FORMAT_L8A8:
+		{
+			__m256i mask = _mali_convert_avx2_mask( la8 );
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				__m256i v0 = _mm256_shuffle_epi8( LOAD( src + i * 4 ), mask );
+				__m256i v1 = _mm256_shuffle_epi8( LOAD( src + i * 4 + 32 ), mask );
+				__m256i all = _mm256_unpacklo_epi64( v0, v1 );
+				STORE( dst + i * 2, _mm256_permute4x64_epi64( all, 0xD8 ) );
+			}
+			return i;
+		}
+
+		case MALI_CONVERT_PIXEL_FORMAT_R8G8B8:
+		{
+			__m256i mask = _mali_convert_avx2_mask( rgb8 );
+			const __m256i order = _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, 3, 7 );
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				__m256i v = _mm256_permutevar8x32_epi32( _mm256_shuffle_epi8( LOAD( src + i * 4 ), mask ), order );
+				_mm_storeu_si128( (__m128i *)( dst + i * 3 ), _mm256_castsi256_si128( v ) );
+				_mm_storel_epi64( (__m128i *)( dst + i * 3 + 16 ), _mm256_extracti128_si256( v, 1 ) );
+			}
+			return i;
+		}
+
+		default:
+			return 0;
+	}
+}
+
+static int _mali_convert_avx2_to_16bit( u16 *dst, const u8 *src, int count, enum mali_convert_pixel_format format )
+{
+	int i = 0;
+
+	switch ( format )
+	{
+		case MALI_CONVERT_PIXEL_FORMAT_R5G6B5:
+		case MALI_CONVERT_PIXEL_FORMAT_R4G4B4A4:
+		case MALI_CONVERT_PIXEL_FORMAT_R5G5B5A1:
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				__m256i v[2], t[2];
+				int k;
+				for ( k = 0; k < 2; k++ )
+				{
+					v[k] = LOAD( src + i * 4 + k * 32 );
+					if ( MALI_CONVERT_PIXEL_FORMAT_R5G6B5 == format )
+					{
+						t[k] = _mm256_or_si256( _mm256_and_si256( _mm256_slli_epi32( v[k], 8 ), _mm256_set1_epi32( 0xF800 ) ),
+						       _mm256_or_si256( _mm256_and_si256( _mm256_srli_epi32( v[k], 5 ), _mm256_set1_epi32( 0x07E0 ) ),
+						                        _mm256_and_si256( _mm256_srli_epi32( v[k], 19 ), _mm256_set1_epi32( 0x001F ) ) ) );
+					}
+					else if ( MALI_CONVERT_PIXEL_FORMAT_R4G4B4A4 == format )
+					{
+						t[k] = _mm256_or_si256( _mm256_or_si256( _mm256_and_si256( _mm256_slli_epi32( v[k], 8 ), _mm256_set1_epi32( 0xF000 ) ),
+						                                         _mm256_and_si256( _mm256_srli_epi32( v[k], 4 ), _mm256_set1_epi32( 0x0F00 ) ) ),
+						                        _mm256_or_si256( _mm256_and_si256( _mm256_srli_epi32( v[k], 16 ), _mm256_set1_epi32( 0x00F0 ) ),
+						                                         _mm256_srli_epi32( v[k], 28 ) ) );
+					}
+					else
+					{
+						t[k] = _mm256_or_si256( _mm256_or_si256( _mm256_and_si256( _mm256_slli_epi32( v[k], 8 ), _mm256_set1_epi32( 0xF800 ) ),
+						                                         _mm256_and_si256( _mm256_srli_epi32( v[k], 5 ), _mm256_set1_epi32( 0x07C0 ) ) ),
+						                        _mm256_or_si256( _mm256_and_si256( _mm256_srli_epi32( v[k], 18 ), _mm256_set1_epi32( 0x003E ) ),
+						                                         _mm256_srli_epi32( v[k], 31 ) ) );
+					}
+				}
+				STORE( dst + i, _mali_convert_avx2_pack32( t[0], t[1] ) );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L16A16:
+		{
+			static const char la16[16] = { 0, 0, 3, 3, 4, 4, 7, 7, 8, 8, 11, 11, 12, 12, 15, 15 };
+			__m256i mask = _mali_convert_avx2_mask( la16 );
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				STORE( dst + i * 2, _mm256_shuffle_epi8( LOAD( src + i * 4 ), mask ) );
+			}
+			return i;
+		}
+
+		case MALI_CONVERT_PIXEL_FORMAT_R16G16B16A16:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				__m256i v = _mm256_permute4x64_epi64( LOAD( src + i * 4 ), 0xD8 );
+				STORE( dst + i * 4, _mm256_unpacklo_epi8( v, v ) );
+				STORE( dst + i * 4 + 16, _mm256_unpackhi_epi8( v, v ) );
+			}
+			return i;
+
+		default:
+			return 0;
+	}
+}
+
+const mali_convert_kernels _mali_convert_kernels_avx2 =
+{
+	"avx2",
+	_mali_convert_avx2_supported,
+	_mali_convert_avx2_from_8bit,
+	_mali_convert_avx2_from_16bit,
+	_mali_convert_avx2_to_8bit,
+	_mali_convert_avx2_to_16bit
+};
@@ -0,0 +1,220 @@
+/*
+ * Checks the vector RGBA8888 conversions against the scalar reference and
+ * measures them.
+ *
+ *   mali_convert_check         bit exact comparison of every kernel set the
+ *                              CPU supports, all formats and directions
+ *   mali_convert_check -b      also time a 2048x2048 conversion with each
+ *
+ * Every span length up to a few vector widths is tried at each source and
+ * destination misalignment, with guard bytes behind the destination, and
+ * the packed 16 bit formats are run over all 65536 texels.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mali_convert_simd.h"
+
+#define CHECK_MAX_COUNT 100
+#define CHECK_GUARD 64
+#define CHECK_FULL_COUNT 65536
+#define BENCH_PIXELS ( 2048 * 2048 )
+#define BENCH_RUNS 5
+
+typedef enum
+{
+	DIRECTION_FROM_8BIT,
+	DIRECTION_FROM_16BIT,
+	DIRECTION_TO_8BIT,
+	DIRECTION_TO_16BIT
+} check_direction;
+
+static const char * const direction_names[] = { "8bit->rgba8888", "16bit->rgba8888", "rgba8888->8bit", "rgba8888->16bit" };
+
+static const char * const format_names[] =
+{
+	"R5G6B5", "R4G4B4A4", "R5G5B5A1", "L16A16", "R16G16B16A16",
+	"R8G8B8", "R8G8B8A8", "L8", "L8A8", "A8"
+};
+
+static unsigned int check_seed = 12345;
+
+static u8 check_random_byte( void )
+{
+	check_seed = check_seed * 1103515245u + 12345u;
+	return (u8)( check_seed >> 16 );
+}
+
+static mali_bool check_direction_has_format( check_direction direction, enum mali_convert_pixel_format format )
+{
+	mali_bool is_8bit = MALI_CONVERT_8BITS == _mali_convert_pixel_format_get_convert_method( format );
+	return ( DIRECTION_FROM_8BIT == direction || DIRECTION_TO_8BIT == direction ) ? is_8bit : !is_8bit;
+}
+
+/* Source and destination sizes of count pixels. */
+static void check_sizes( check_direction direction, enum mali_convert_pixel_format format, int count, size_t *src_size, size_t *dst_size )
+{
+	size_t packed = (size_t)count * _mali_convert_pixel_format_get_size( format );
+	size_t rgba = (size_t)count * 4;
+	mali_bool from = DIRECTION_FROM_8BIT == direction || DIRECTION_FROM_16BIT == direction;
+	*src_size = from ? packed : rgba;
+	*dst_size = from ? rgba : packed;
+}
+
+/* 16 bit pointers are only ever offset by whole u16s. */
+static void check_run( check_direction direction, enum mali_convert_pixel_format format, mali_bool reference,
+                       void *dst, const void *src, int count )
+{
+	switch ( direction )
+	{
+		case DIRECTION_FROM_8BIT:
+			if ( reference ) _mali_convert_8bit_to_rgba8888_scalar( dst, src, count, format );
+			else _mali_convert_8bit_to_rgba8888( dst, src, count, format );
+			break;
+		case DIRECTION_FROM_16BIT:
+			if ( reference ) _mali_convert_16bit_to_rgba8888_scalar( dst, src, count, format );
+			else _mali_convert_16bit_to_rgba8888( dst, src, count, format );
+			break;
+		case DIRECTION_TO_8BIT:
+			if ( reference ) _mali_convert_rgba8888_to_8bit_scalar( dst, src, count, format );
+			else _mali_convert_rgba8888_to_8bit( dst, src, count, format );
+			break;
+		case DIRECTION_TO_16BIT:
+			if ( reference ) _mali_convert_rgba8888_to_16bit_scalar( dst, src, count, format );
+			else _mali_convert_rgba8888_to_16bit( dst, src, count, format );
+			break;
+	}
+}
+
+static mali_bool check_span( check_direction direction, enum mali_convert_pixel_format format, int count, int src_offset, int dst_offset )
+{
+	static u8 src[CHECK_FULL_COUNT * 8 + CHECK_GUARD];
+	static u8 expected[CHECK_FULL_COUNT * 8 + CHECK_GUARD];
+	static u8 actual[CHECK_FULL_COUNT * 8 + CHECK_GUARD];
+	size_t src_size, dst_size, i;
+	mali_bool full = count == CHECK_FULL_COUNT && DIRECTION_FROM_16BIT == direction;
+
+	check_sizes( direction, format, count, &src_size, &dst_size );
+	for ( i = 0; i < src_size + CHECK_GUARD; i++ ) src[i] = check_random_byte();
+	if ( full && MALI_CONVERT_PACKED == _mali_convert_pixel_format_get_convert_method( format ) )
+	{
+		for ( i = 0; i < (size_t)count; i++ ) memcpy( src + src_offset + i * 2, &(u16){ (u16)i }, 2 );
+	}
+	memset( expected, 0xA5, dst_size + dst_offset + CHECK_GUARD );
+	memset( actual, 0xA5, dst_size + dst_offset + CHECK_GUARD );
+
+	check_run( direction, format, MALI_TRUE, expected + dst_offset, src + src_offset, count );
+	check_run( direction, format, MALI_FALSE, actual + dst_offset, src + src_offset, count );
+	if ( 0 == memcmp( expected, actual, dst_size + dst_offset + CHECK_GUARD ) ) return MALI_TRUE;
+
+	for ( i = 0; i < dst_size + dst_offset + CHECK_GUARD && expected[i] == actual[i]; i++ );
+	printf( "  %d pixels, src +%d, dst +%d: byte %d is 0x%02X, expected 0x%02X%s\n", count, src_offset, dst_offset,
+	        (int)i - dst_offset, actual[i], expected[i], i >= dst_size + dst_offset ? " (past the end)" : "" );
+	return MALI_FALSE;
+}
+
+static mali_bool check_format( check_direction direction, enum mali_convert_pixel_format format )
+{
+	/* u16 data stays u16 aligned. */
+	int step_src = DIRECTION_FROM_16BIT == direction ? 2 : 1;
+	int step_dst = DIRECTION_TO_16BIT == direction ? 2 : 1;
+	int count, offset;
+
+	for ( count = 0; count <= CHECK_MAX_COUNT; count++ )
+	{
+		for ( offset = 0; offset < 4; offset++ )
+		{
+			if ( !check_span( direction, format, count, offset * step_src, ( 3 - offset ) * step_dst ) ) return MALI_FALSE;
+		}
+	}
+	return check_span( direction, format, CHECK_FULL_COUNT, 0, 0 );
+}
+
+static double check_clock_ms( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* Best of BENCH_RUNS, in megapixels per second. */
+static double check_bench( check_direction direction, enum mali_convert_pixel_format format, void *dst, const void *src )
+{
+	double best = 0.0;
+	int run;
+	for ( run = 0; run < BENCH_RUNS; run++ )
+	{
+		double start = check_clock_ms(), ms;
+		check_run( direction, format, MALI_FALSE, dst, src, BENCH_PIXELS );
+		ms = check_clock_ms() - start;
+		if ( 0 == run || BENCH_PIXELS / ( ms * 1000.0 ) > best ) best = BENCH_PIXELS / ( ms * 1000.0 );
+	}
+	return best;
+}
+
+int main( int argc, char **argv )
+{
+	mali_bool bench = argc > 1 && 0 == strcmp( argv[1], "-b" );
+	const mali_convert_kernels *chosen = _mali_convert_get_kernels();
+	int failures = 0;
+	int d, f, k;
+
+	printf( "kernels in use: %s\n", NULL != chosen ? chosen->name : "scalar" );
+	for ( k = 0; NULL != _mali_convert_kernel_list[k]; k++ )
+	{
+		const mali_convert_kernels *kernels = _mali_convert_kernel_list[k];
+		if ( !_mali_convert_set_kernels( kernels ) )
+		{
+			printf( "%s: not supported by this CPU, skipped\n", kernels->name );
+			continue;
+		}
+		for ( d = DIRECTION_FROM_8BIT; d <= DIRECTION_TO_16BIT; d++ )
+		{
+			for ( f = MALI_CONVERT_PIXEL_FORMAT_R5G6B5; f <= MALI_CONVERT_PIXEL_FORMAT_A8; f++ )
+			{
+				mali_bool ok;
+				if ( !check_direction_has_format( d, f ) ) continue;
+				ok = check_format( d, f );
+				printf( "%s %s %s: %s\n", kernels->name, direction_names[d], format_names[f], ok ? "exact" : "MISMATCH" );
+				if ( !ok ) failures++;
+			}
+		}
+	}
+
+	if ( bench )
+	{
+		void *src = malloc( (size_t)BENCH_PIXELS * 8 );
+		void *dst = malloc( (size_t)BENCH_PIXELS * 8 );
+		memset( src, 0x5A, (size_t)BENCH_PIXELS * 8 );
+		memset( dst, 0, (size_t)BENCH_PIXELS * 8 );
+		printf( "\n%-16s %-13s %10s", "direction", "format", "scalar" );
+		for ( k = 0; NULL != _mali_convert_kernel_list[k]; k++ ) printf( " %10s", _mali_convert_kernel_list[k]->name );
+		printf( "   (Mpixel/s, %dx%d)\n", 2048, 2048 );
+		for ( d = DIRECTION_FROM_8BIT; d <= DIRECTION_TO_16BIT; d++ )
+		{
+			for ( f = MALI_CONVERT_PIXEL_FORMAT_R5G6B5; f <= MALI_CONVERT_PIXEL_FORMAT_A8; f++ )
+			{
+				if ( !check_direction_has_format( d, f ) ) continue;
+				printf( "%-16s %-13s", direction_names[d], format_names[f] );
+				_mali_convert_set_kernels( NULL );
+				printf( " %10.0f", check_bench( d, f, dst, src ) );
+				for ( k = 0; NULL != _mali_convert_kernel_list[k]; k++ )
+				{
+					if ( _mali_convert_set_kernels( _mali_convert_kernel_list[k] ) ) printf( " %10.0f", check_bench( d, f, dst, src ) );
+					else printf( " %10s", "-" );
+				}
+				printf( "\n" );
+			}
+		}
+		free( src );
+		free( dst );
+	}
+
+	printf( "%s\n", failures ? "FAILED" : "all kernels bit exact" );
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,237 @@
+/*
+ * Generic and specialised span kernels, see mali_convert_kernels.h.
+ *
+ * The specialised kernels are the generic loop instantiated with constant
+ * surface specifiers and rules. Flattening inlines the unpack, rule and
+ * pack helpers of shared/mali_convert.h into each instance, where the
+ * compiler folds their switches down to the one path the kernel takes.
+ */
+
+#include <string.h>
+
+#include "mali_convert_kernels.h"
+#include "mali_convert_premult.h"
+
+#if defined(__GNUC__)
+#define MALI_CONVERT_FLATTEN __attribute__((flatten))
+#else
+#define MALI_CONVERT_FLATTEN
+#endif
+
+/* texel_format and the component order flags, which select a kernel */
+#define MALI_CONVERT_KEY( texel_format, red_blue_swap, reverse_order, alpha_to_one ) \
+	( (u32)(texel_format) | ( (red_blue_swap) ? 1u << 8 : 0 ) | ( (reverse_order) ? 1u << 9 : 0 ) | ( (alpha_to_one) ? 1u << 10 : 0 ) )
+
+/* component orders: PLAIN is the texel format's own, RGBA the GL byte order of ARGB_8888 */
+#define MALI_CONVERT_RBSWAP_PLAIN  MALI_FALSE
+#define MALI_CONVERT_REVERSE_PLAIN MALI_FALSE
+#define MALI_CONVERT_RBSWAP_RGBA   MALI_TRUE
+#define MALI_CONVERT_REVERSE_RGBA  MALI_TRUE
+
+#define MALI_CONVERT_RULES_GLES       MALI_CONVERT_NO_COLOR_CONVERSION
+#define MALI_CONVERT_RULES_VG         0
+#define MALI_CONVERT_RULES_VG_SRC_PRE MALI_CONVERT_SRC_PREMULT
+#define MALI_CONVERT_RULES_VG_DST_PRE MALI_CONVERT_DST_PREMULT
+#define MALI_CONVERT_RULES_VG_PRE_PRE ( MALI_CONVERT_SRC_PREMULT | MALI_CONVERT_DST_PREMULT )
+#define MALI_CONVERT_RULES_VG_SRC_LIN MALI_CONVERT_SRC_LINEAR
+#define MALI_CONVERT_RULES_VG_DST_LIN MALI_CONVERT_DST_LINEAR
+
+/* formats for which _mali_convert_setup_conversion_rules sets the luminance rules */
+#define MALI_CONVERT_LUMINANCE_L_8       1
+#define MALI_CONVERT_LUMINANCE_A_8       0
+#define MALI_CONVERT_LUMINANCE_I_8       0
+#define MALI_CONVERT_LUMINANCE_RGB_565   0
+#define MALI_CONVERT_LUMINANCE_ARGB_1555 0
+#define MALI_CONVERT_LUMINANCE_ARGB_4444 0
+#define MALI_CONVERT_LUMINANCE_AL_88     1
+#define MALI_CONVERT_LUMINANCE_RGB_888   0
+#define MALI_CONVERT_LUMINANCE_ARGB_8888 0
+#define MALI_CONVERT_LUMINANCE_xRGB_8888 0
+
+#define MALI_CONVERT_KERNEL_RULES( SRC, DST, RULES ) \
+	( MALI_CONVERT_RULES_##RULES | \
+	  ( MALI_CONVERT_LUMINANCE_##SRC ? MALI_CONVERT_SRC_LUMINANCE : 0 ) | \
+	  ( MALI_CONVERT_LUMINANCE_##DST ? MALI_CONVERT_DST_LUMINANCE : 0 ) )
+
+#define MALI_CONVERT_KERNEL_KEY( FORMAT, ORDER ) \
+	MALI_CONVERT_KEY( M200_TEXEL_FORMAT_##FORMAT, MALI_CONVERT_RBSWAP_##ORDER, MALI_CONVERT_REVERSE_##ORDER, MALI_FALSE )
+
+#define MALI_CONVERT_KERNEL_NAME( SRC, SRC_ORDER, DST, DST_ORDER, RULES ) \
+	_mali_convert_span_##SRC##_##SRC_ORDER##_to_##DST##_##DST_ORDER##_##RULES
+
+/* every destination from one source */
+#define MALI_CONVERT_KERNELS_FROM( SRC, SRC_ORDER, RULES ) \
+	MALI_CONVERT_KERNEL( SRC, SRC_ORDER, L_8, PLAIN, RULES ) \
+	MALI_CONVERT_KERNEL( SRC, SRC_ORDER, A_8, PLAIN, RULES ) \
+	MALI_CONVERT_KERNEL( SRC, SRC_ORDER, I_8, PLAIN, RULES ) \
+	MALI_CONVERT_KERNEL( SRC, SRC_ORDER, RGB_565, PLAIN, RULES ) \
+	MALI_CONVERT_KERNEL( SRC, SRC_ORDER, ARGB_1555, PLAIN, RULES ) \
+	MALI_CONVERT_KERNEL( SRC, SRC_ORDER, ARGB_4444, PLAIN, RULES ) \
+	MALI_CONVERT_KERNEL( SRC, SRC_ORDER, AL_88, PLAIN, RULES ) \
+	MALI_CONVERT_KERNEL( SRC, SRC_ORDER, RGB_888, PLAIN, RULES ) \
+	MALI_CONVERT_KERNEL( SRC, SRC_ORDER, ARGB_8888, PLAIN, RULES ) \
+	MALI_CONVERT_KERNEL( SRC, SRC_ORDER, xRGB_8888, PLAIN, RULES ) \
+	MALI_CONVERT_KERNEL( SRC, SRC_ORDER, ARGB_8888, RGBA, RULES )
+
+/*
+ * The combinations with a kernel of their own: every OpenGL ES upload and
+ * readback between the byte sized formats, and OpenVG conversions from
+ * ARGB_8888 with and without premultiplied alpha and linear colorspace.
+ */
+#define MALI_CONVERT_KERNEL_LIST \
+	MALI_CONVERT_KERNELS_FROM( L_8, PLAIN, GLES ) \
+	MALI_CONVERT_KERNELS_FROM( A_8, PLAIN, GLES ) \
+	MALI_CONVERT_KERNELS_FROM( I_8, PLAIN, GLES ) \
+	MALI_CONVERT_KERNELS_FROM( RGB_565, PLAIN, GLES ) \
+	MALI_CONVERT_KERNELS_FROM( ARGB_1555, PLAIN, GLES ) \
+	MALI_CONVERT_KERNELS_FROM( ARGB_4444, PLAIN, GLES ) \
+	MALI_CONVERT_KERNELS_FROM( AL_88, PLAIN, GLES ) \
+	MALI_CONVERT_KERNELS_FROM( RGB_888, PLAIN, GLES ) \
+	MALI_CONVERT_KERNELS_FROM( ARGB_8888, PLAIN, GLES ) \
+	MALI_CONVERT_KERNELS_FROM( xRGB_8888, PLAIN, GLES ) \
+	MALI_CONVERT_KERNELS_FROM( ARGB_8888, RGBA, GLES ) \
+	MALI_CONVERT_KERNELS_FROM( ARGB_8888, PLAIN, VG ) \
+	MALI_CONVERT_KERNELS_FROM( ARGB_8888, PLAIN, VG_SRC_PRE ) \
+	MALI_CONVERT_KERNELS_FROM( ARGB_8888, PLAIN, VG_DST_PRE ) \
+	MALI_CONVERT_KERNELS_FROM( ARGB_8888, PLAIN, VG_PRE_PRE ) \
+	MALI_CONVERT_KERNELS_FROM( ARGB_8888, PLAIN, VG_SRC_LIN ) \
+	MALI_CONVERT_KERNELS_FROM( ARGB_8888, PLAIN, VG_DST_LIN )
+
+typedef struct mali_convert_span_kernel
+{
+	u32 src_key;
+	u32 dst_key;
+	u32 span_rules;
+	mali_convert_span_proc proc;
+} mali_convert_span_kernel;
+
+/**
+ * _mali_convert_texel_internal, with the un-premultiply done through
+ * reciprocals.
+ */
+MALI_STATIC_FORCE_INLINE void _mali_convert_span_color( const mali_surface_specifier *dst_format, u32 span_rules, u32 *color )
+{
+	if ( span_rules & MALI_CONVERT_SRC_PREMULT )
+	{
+		u32 a = color[3];
+		color[0] = _mali_convert_from_premult_fast( color[0] < a ? color[0] : a, a );
+		color[1] = _mali_convert_from_premult_fast( color[1] < a ? color[1] : a, a );
+		color[2] = _mali_convert_from_premult_fast( color[2] < a ? color[2] : a, a );
+	}
+	_mali_convert_texel_internal( dst_format, span_rules & ~MALI_CONVERT_SRC_PREMULT, color );
+}
+
+/** _mali_convert_texel over a span, one texel at a time */
+MALI_STATIC_FORCE_INLINE void _mali_convert_span( u8 *dst, const u8 *src, u32 count,
+                                                  const mali_surface_specifier *src_format,
+                                                  const mali_surface_specifier *dst_format,
+                                                  u32 span_rules )
+{
+	int src_size = _mali_convert_texel_format_get_size( src_format->texel_format );
+	int dst_size = _mali_convert_texel_format_get_size( dst_format->texel_format );
+	u32 i;
+
+	for ( i = 0; i < count; i++ )
+	{
+		u32 color[4];
+
+		_mali_convert_texel_to_color_channels( src_format, _mali_convert_load_texel( src + i * src_size, src_size ), color );
+		if ( !( span_rules & MALI_CONVERT_NO_COLOR_CONVERSION ) ) _mali_convert_span_color( dst_format, span_rules, color );
+		_mali_convert_store_texel( dst + i * dst_size, dst_size, _mali_convert_color_channels_to_texel( dst_format, color ) );
+	}
+}
+
+/**
+ * ARGB_8888 to premultiplied ARGB_8888 keeps every byte but the color ones,
+ * which the vector premultiply handles in place.
+ */
+static void _mali_convert_span_premultiply_8888( u8 *dst, const u8 *src, u32 count,
+                                                 const mali_surface_specifier *src_format,
+                                                 const mali_surface_specifier *dst_format,
+                                                 u32 span_rules )
+{
+	MALI_IGNORE( src_format );
+	MALI_IGNORE( dst_format );
+	MALI_IGNORE( span_rules );
+	memmove( dst, src, count * 4 );
+	_mali_convert_premultiply_8888( dst, count );
+}
+
+#define MALI_CONVERT_KERNEL( SRC, SRC_ORDER, DST, DST_ORDER, RULES ) \
+	static MALI_CONVERT_FLATTEN void MALI_CONVERT_KERNEL_NAME( SRC, SRC_ORDER, DST, DST_ORDER, RULES )( \
+		u8 *dst, const u8 *src, u32 count, \
+		const mali_surface_specifier *src_format, const mali_surface_specifier *dst_format, u32 span_rules ) \
+	{ \
+		static const mali_surface_specifier src_constant = \
+			{ .texel_format = M200_TEXEL_FORMAT_##SRC, \
+			  .red_blue_swap = MALI_CONVERT_RBSWAP_##SRC_ORDER, .reverse_order = MALI_CONVERT_REVERSE_##SRC_ORDER }; \
+		static const mali_surface_specifier dst_constant = \
+			{ .texel_format = M200_TEXEL_FORMAT_##DST, \
+			  .red_blue_swap = MALI_CONVERT_RBSWAP_##DST_ORDER, .reverse_order = MALI_CONVERT_REVERSE_##DST_ORDER }; \
+		MALI_IGNORE( src_format ); \
+		MALI_IGNORE( dst_format ); \
+		MALI_IGNORE( span_rules ); \
+		_mali_convert_span( dst, src, count, &src_constant, &dst_constant, MALI_CONVERT_KERNEL_RULES( SRC, DST, RULES ) ); \
+	}
+MALI_CONVERT_KERNEL_LIST
+#undef MALI_CONVERT_KERNEL
+
+#define MALI_CONVERT_KERNEL( SRC, SRC_ORDER, DST, DST_ORDER, RULES ) \
+	{ MALI_CONVERT_KERNEL_KEY( SRC, SRC_ORDER ), MALI_CONVERT_KERNEL_KEY( DST, DST_ORDER ), \
+	  MALI_CONVERT_KERNEL_RULES( SRC, DST, RULES ), MALI_CONVERT_KERNEL_NAME( SRC, SRC_ORDER, DST, DST_ORDER, RULES ) },
+static const mali_convert_span_kernel _mali_convert_span_kernels[] =
+{
+	MALI_CONVERT_KERNEL_LIST
+};
+#undef MALI_CONVERT_KERNEL
+
+void _mali_convert_span_generic( u8 *dst, const u8 *src, u32 count,
+                                 const mali_surface_specifier *src_format,
+                                 const mali_surface_specifier *dst_format,
+                                 u32 span_rules )
+{
+	_mali_convert_span( dst, src, count, src_format, dst_format, span_rules );
+}
+
+u32 _mali_convert_get_span_rules( const mali_surface_specifier *src, const mali_surface_specifier *dest,
+                                  mali_convert_request_source source )
+{
+	u32 rules = _mali_convert_setup_conversion_rules( src, dest );
+
+	if ( MALI_CONVERT_SOURCE_OPENVG != source && MALI_CONVERT_SOURCE_SHARED != source )
+	{
+		rules = MALI_CONVERT_NO_COLOR_CONVERSION | ( rules & ( MALI_CONVERT_SRC_LUMINANCE | MALI_CONVERT_DST_LUMINANCE ) );
+	}
+	else if ( MALI_CONVERT_DST_LUMINANCE != ( rules & ( MALI_CONVERT_SRC_LUMINANCE | MALI_CONVERT_DST_LUMINANCE ) ) &&
+	          ( MALI_CONVERT_SRC_LINEAR | MALI_CONVERT_DST_LINEAR ) == ( rules & ( MALI_CONVERT_SRC_LINEAR | MALI_CONVERT_DST_LINEAR ) ) )
+	{
+		/* linear to linear is no conversion, except when computing luminance */
+		rules &= ~( MALI_CONVERT_SRC_LINEAR | MALI_CONVERT_DST_LINEAR );
+	}
+	return rules;
+}
+
+mali_convert_span_proc _mali_convert_get_span_proc( const mali_surface_specifier *src, const mali_surface_specifier *dest,
+                                                    u32 span_rules )
+{
+	u32 src_key = MALI_CONVERT_KEY( src->texel_format, src->red_blue_swap, src->reverse_order, src->alpha_to_one );
+	u32 dst_key = MALI_CONVERT_KEY( dest->texel_format, dest->red_blue_swap, dest->reverse_order, dest->alpha_to_one );
+	u32 i;
+
+	MALI_DEBUG_ASSERT( 0 != _mali_convert_texel_format_get_size( src->texel_format ) &&
+	                   0 != _mali_convert_texel_format_get_size( dest->texel_format ), ("unsupported formats") );
+
+	if ( MALI_CONVERT_KERNEL_KEY( ARGB_8888, PLAIN ) == src_key && src_key == dst_key && MALI_CONVERT_DST_PREMULT == span_rules )
+	{
+		return _mali_convert_span_premultiply_8888;
+	}
+	for ( i = 0; i < sizeof( _mali_convert_span_kernels ) / sizeof( _mali_convert_span_kernels[0] ); i++ )
+	{
+		const mali_convert_span_kernel *kernel = &_mali_convert_span_kernels[i];
+		if ( kernel->src_key == src_key && kernel->dst_key == dst_key && kernel->span_rules == span_rules )
+		{
+			return kernel->proc;
+		}
+	}
+	return _mali_convert_span_generic;
+}
@@ -0,0 +1,99 @@
+/*
+ * Span kernels behind the host _mali_convert_texture.
+ *
+ * A span kernel converts count texels between two linear buffers. The
+ * common (source, destination, rules) combinations have a kernel of their
+ * own, where the format switches and rule tests of _mali_convert_texel are
+ * resolved at compile time; everything else goes through the generic
+ * kernel, which makes those decisions per texel. The kernel is picked once
+ * per request with _mali_convert_get_span_proc.
+ */
+
+#ifndef MALI_CONVERT_KERNELS_H
+#define MALI_CONVERT_KERNELS_H
+
+#include <shared/mali_convert.h>
+
+/**
+ * Rule bit for requests whose texels are only repacked: colorspace and
+ * premultiplied alpha conversions are not defined for OpenGL ES.
+ */
+#define MALI_CONVERT_NO_COLOR_CONVERSION 0x80000000u
+
+typedef void (*mali_convert_span_proc)( u8 *dst, const u8 *src, u32 count,
+                                        const mali_surface_specifier *src_format,
+                                        const mali_surface_specifier *dst_format,
+                                        u32 span_rules );
+
+/**
+ * Size in bytes of a texel of the given format, 0 when the host conversion
+ * does not handle it.
+ */
+MALI_STATIC_INLINE int _mali_convert_texel_format_get_size( m200_texel_format format )
+{
+	switch ( format )
+	{
+		case M200_TEXEL_FORMAT_L_8:
+		case M200_TEXEL_FORMAT_A_8:
+		case M200_TEXEL_FORMAT_I_8:
+			return 1;
+		case M200_TEXEL_FORMAT_RGB_565:
+		case M200_TEXEL_FORMAT_ARGB_1555:
+		case M200_TEXEL_FORMAT_ARGB_4444:
+		case M200_TEXEL_FORMAT_AL_88:
+			return 2;
+		case M200_TEXEL_FORMAT_RGB_888:
+			return 3;
+		case M200_TEXEL_FORMAT_ARGB_8888:
+		case M200_TEXEL_FORMAT_xRGB_8888:
+			return 4;
+		default:
+			return 0;
+	}
+}
+
+/** Texels are stored little endian. */
+MALI_STATIC_FORCE_INLINE u32 _mali_convert_load_texel( const u8 *ptr, int size )
+{
+	switch ( size )
+	{
+		case 1: return ptr[0];
+		case 2: return ptr[0] | ( ptr[1] << 8 );
+		case 3: return ptr[0] | ( ptr[1] << 8 ) | ( ptr[2] << 16 );
+		default: return ptr[0] | ( ptr[1] << 8 ) | ( ptr[2] << 16 ) | ( (u32)ptr[3] << 24 );
+	}
+}
+
+MALI_STATIC_FORCE_INLINE void _mali_convert_store_texel( u8 *ptr, int size, u32 texel )
+{
+	switch ( size )
+	{
+		case 4: ptr[3] = (u8)( texel >> 24 ); /* fall through */
+		case 3: ptr[2] = (u8)( texel >> 16 ); /* fall through */
+		case 2: ptr[1] = (u8)( texel >> 8 ); /* fall through */
+		default: ptr[0] = (u8)texel;
+	}
+}
+
+/**
+ * Conversion rules of a request as the span kernels take them:
+ * _mali_convert_setup_conversion_rules, plus MALI_CONVERT_NO_COLOR_CONVERSION
+ * for OpenGL ES requests.
+ */
+u32 _mali_convert_get_span_rules( const mali_surface_specifier *src, const mali_surface_specifier *dest,
+                                  mali_convert_request_source source );
+
+/**
+ * Kernel for converting between the given formats under span_rules, never
+ * NULL. Formats must have a size.
+ */
+mali_convert_span_proc _mali_convert_get_span_proc( const mali_surface_specifier *src, const mali_surface_specifier *dest,
+                                                    u32 span_rules );
+
+/** The generic kernel, which handles every combination. */
+void _mali_convert_span_generic( u8 *dst, const u8 *src, u32 count,
+                                 const mali_surface_specifier *src_format,
+                                 const mali_surface_specifier *dst_format,
+                                 u32 span_rules );
+
+#endif /* MALI_CONVERT_KERNELS_H */
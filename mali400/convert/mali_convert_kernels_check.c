@@ -0,0 +1,223 @@
+/*
+ * Checks the span kernels against _mali_convert_texel and measures them.
+ *
+ *   mali_convert_kernels_check      compare the kernel _mali_convert_get_span_proc
+ *                                   picks, and the generic kernel, with
+ *                                   _mali_convert_texel for every pair of
+ *                                   host texel formats and component orders
+ *                                   under OpenGL ES and OpenVG rules
+ *   mali_convert_kernels_check -b   also time the generic and picked
+ *                                   kernels on every OpenGL ES format pair
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mali_convert_kernels.h"
+
+#define CHECK_COUNT 4096
+#define BENCH_COUNT ( 1024 * 1024 )
+#define BENCH_RUNS 3
+
+typedef struct
+{
+	const char *name;
+	m200_texel_format format;
+	mali_bool red_blue_swap;
+	mali_bool reverse_order;
+	mali_bool alpha_to_one;
+} check_format;
+
+static const check_format check_formats[] =
+{
+	{ "L_8", M200_TEXEL_FORMAT_L_8, MALI_FALSE, MALI_FALSE, MALI_FALSE },
+	{ "A_8", M200_TEXEL_FORMAT_A_8, MALI_FALSE, MALI_FALSE, MALI_FALSE },
+	{ "I_8", M200_TEXEL_FORMAT_I_8, MALI_FALSE, MALI_FALSE, MALI_FALSE },
+	{ "RGB_565", M200_TEXEL_FORMAT_RGB_565, MALI_FALSE, MALI_FALSE, MALI_FALSE },
+	{ "ARGB_1555", M200_TEXEL_FORMAT_ARGB_1555, MALI_FALSE, MALI_FALSE, MALI_FALSE },
+	{ "ARGB_4444", M200_TEXEL_FORMAT_ARGB_4444, MALI_FALSE, MALI_FALSE, MALI_FALSE },
+	{ "AL_88", M200_TEXEL_FORMAT_AL_88, MALI_FALSE, MALI_FALSE, MALI_FALSE },
+	{ "RGB_888", M200_TEXEL_FORMAT_RGB_888, MALI_FALSE, MALI_FALSE, MALI_FALSE },
+	{ "ARGB_8888", M200_TEXEL_FORMAT_ARGB_8888, MALI_FALSE, MALI_FALSE, MALI_FALSE },
+	{ "xRGB_8888", M200_TEXEL_FORMAT_xRGB_8888, MALI_FALSE, MALI_FALSE, MALI_FALSE },
+	{ "RGBA_8888", M200_TEXEL_FORMAT_ARGB_8888, MALI_TRUE, MALI_TRUE, MALI_FALSE },
+	{ "BGRA_4444", M200_TEXEL_FORMAT_ARGB_4444, MALI_FALSE, MALI_TRUE, MALI_FALSE },
+	{ "ABGR_8888+1", M200_TEXEL_FORMAT_ARGB_8888, MALI_TRUE, MALI_FALSE, MALI_TRUE }
+};
+
+#define CHECK_FORMAT_COUNT (int)( sizeof( check_formats ) / sizeof( check_formats[0] ) )
+
+/* the first formats are the ones without component order flags */
+#define CHECK_PLAIN_FORMAT_COUNT 10
+
+typedef struct
+{
+	const char *name;
+	mali_convert_request_source source;
+	mali_bool src_premult;
+	mali_bool dst_premult;
+	mali_surface_colorspace src_colorspace;
+	mali_surface_colorspace dst_colorspace;
+} check_rules;
+
+static const check_rules check_rule_sets[] =
+{
+	{ "gles", MALI_CONVERT_SOURCE_OPENGLES, MALI_FALSE, MALI_FALSE, MALI_SURFACE_COLORSPACE_sRGB, MALI_SURFACE_COLORSPACE_sRGB },
+	{ "vg", MALI_CONVERT_SOURCE_OPENVG, MALI_FALSE, MALI_FALSE, MALI_SURFACE_COLORSPACE_sRGB, MALI_SURFACE_COLORSPACE_sRGB },
+	{ "vg src pre", MALI_CONVERT_SOURCE_OPENVG, MALI_TRUE, MALI_FALSE, MALI_SURFACE_COLORSPACE_sRGB, MALI_SURFACE_COLORSPACE_sRGB },
+	{ "vg dst pre", MALI_CONVERT_SOURCE_OPENVG, MALI_FALSE, MALI_TRUE, MALI_SURFACE_COLORSPACE_sRGB, MALI_SURFACE_COLORSPACE_sRGB },
+	{ "vg pre pre", MALI_CONVERT_SOURCE_OPENVG, MALI_TRUE, MALI_TRUE, MALI_SURFACE_COLORSPACE_sRGB, MALI_SURFACE_COLORSPACE_sRGB },
+	{ "vg src lin", MALI_CONVERT_SOURCE_OPENVG, MALI_FALSE, MALI_FALSE, MALI_SURFACE_COLORSPACE_lRGB, MALI_SURFACE_COLORSPACE_sRGB },
+	{ "vg dst lin", MALI_CONVERT_SOURCE_OPENVG, MALI_FALSE, MALI_FALSE, MALI_SURFACE_COLORSPACE_sRGB, MALI_SURFACE_COLORSPACE_lRGB },
+	{ "vg pre lin", MALI_CONVERT_SOURCE_OPENVG, MALI_TRUE, MALI_TRUE, MALI_SURFACE_COLORSPACE_lRGB, MALI_SURFACE_COLORSPACE_sRGB },
+	{ "vg pre lin lin", MALI_CONVERT_SOURCE_OPENVG, MALI_TRUE, MALI_FALSE, MALI_SURFACE_COLORSPACE_lRGB, MALI_SURFACE_COLORSPACE_lRGB }
+};
+
+#define CHECK_RULE_SET_COUNT (int)( sizeof( check_rule_sets ) / sizeof( check_rule_sets[0] ) )
+
+static unsigned int check_seed = 12345;
+
+static u8 check_random_byte( void )
+{
+	check_seed = check_seed * 1103515245u + 12345u;
+	return (u8)( check_seed >> 16 );
+}
+
+static double check_clock_ms( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void check_specifier( mali_surface_specifier *spec, const check_format *format,
+                             mali_bool premult, mali_surface_colorspace colorspace )
+{
+	memset( spec, 0, sizeof( *spec ) );
+	spec->texel_format = format->format;
+	spec->texel_layout = M200_TEXTURE_ADDRESSING_MODE_LINEAR;
+	spec->red_blue_swap = format->red_blue_swap;
+	spec->reverse_order = format->reverse_order;
+	spec->alpha_to_one = format->alpha_to_one;
+	spec->premultiplied_alpha = premult;
+	spec->colorspace = colorspace;
+}
+
+/* Texels of a format only use the low bits of their storage. */
+static u32 check_texel_mask( m200_texel_format format )
+{
+	switch ( format )
+	{
+		case M200_TEXEL_FORMAT_RGB_888: return 0xFFFFFF;
+		case M200_TEXEL_FORMAT_ARGB_8888:
+		case M200_TEXEL_FORMAT_xRGB_8888: return 0xFFFFFFFF;
+		default: return ( 1u << ( 8 * _mali_convert_texel_format_get_size( format ) ) ) - 1;
+	}
+}
+
+/* Best of BENCH_RUNS, in megatexels per second. */
+static double check_bench( mali_convert_span_proc proc, u8 *dst, const u8 *src, const mali_surface_specifier *src_format,
+                           const mali_surface_specifier *dst_format, u32 span_rules )
+{
+	double best = 0.0;
+	int run;
+	for ( run = 0; run < BENCH_RUNS; run++ )
+	{
+		double start = check_clock_ms(), ms;
+		proc( dst, src, BENCH_COUNT, src_format, dst_format, span_rules );
+		ms = check_clock_ms() - start;
+		if ( 0 == run || BENCH_COUNT / ( ms * 1000.0 ) > best ) best = BENCH_COUNT / ( ms * 1000.0 );
+	}
+	return best;
+}
+
+int main( int argc, char **argv )
+{
+	mali_bool bench = argc > 1 && 0 == strcmp( argv[1], "-b" );
+	static u8 src[CHECK_COUNT * 4];
+	static u8 expected[CHECK_COUNT * 4];
+	static u8 actual[CHECK_COUNT * 4];
+	static u8 generic[CHECK_COUNT * 4];
+	int failures = 0, specialised = 0, checked = 0;
+	int r, s, d, i;
+
+	for ( r = 0; r < CHECK_RULE_SET_COUNT; r++ )
+	{
+		const check_rules *rules = &check_rule_sets[r];
+		for ( s = 0; s < CHECK_FORMAT_COUNT; s++ )
+		{
+			for ( d = 0; d < CHECK_FORMAT_COUNT; d++ )
+			{
+				mali_surface_specifier src_format, dst_format;
+				int src_size = _mali_convert_texel_format_get_size( check_formats[s].format );
+				int dst_size = _mali_convert_texel_format_get_size( check_formats[d].format );
+				u32 mask = check_texel_mask( check_formats[s].format );
+				u32 conv_rules, span_rules;
+				mali_convert_span_proc proc;
+
+				check_specifier( &src_format, &check_formats[s], rules->src_premult, rules->src_colorspace );
+				check_specifier( &dst_format, &check_formats[d], rules->dst_premult, rules->dst_colorspace );
+				conv_rules = _mali_convert_setup_conversion_rules( &src_format, &dst_format );
+				span_rules = _mali_convert_get_span_rules( &src_format, &dst_format, rules->source );
+				proc = _mali_convert_get_span_proc( &src_format, &dst_format, span_rules );
+
+				for ( i = 0; i < CHECK_COUNT * src_size; i++ ) src[i] = check_random_byte();
+				for ( i = 0; i < CHECK_COUNT; i++ )
+				{
+					u32 texel = _mali_convert_load_texel( src + i * src_size, src_size ) & mask;
+					_mali_convert_store_texel( src + i * src_size, src_size, texel );
+					_mali_convert_store_texel( expected + i * dst_size, dst_size,
+					                           _mali_convert_texel( &src_format, &dst_format, texel, conv_rules, rules->source ) );
+				}
+				proc( actual, src, CHECK_COUNT, &src_format, &dst_format, span_rules );
+				_mali_convert_span_generic( generic, src, CHECK_COUNT, &src_format, &dst_format, span_rules );
+
+				checked++;
+				if ( _mali_convert_span_generic != proc ) specialised++;
+				if ( 0 != memcmp( expected, actual, CHECK_COUNT * dst_size ) ||
+				     0 != memcmp( expected, generic, CHECK_COUNT * dst_size ) )
+				{
+					printf( "%s %s -> %s: MISMATCH\n", rules->name, check_formats[s].name, check_formats[d].name );
+					failures++;
+				}
+			}
+		}
+	}
+	printf( "%d combinations checked, %d with a specialised kernel\n", checked, specialised );
+
+	if ( bench )
+	{
+		u8 *bench_src = malloc( (size_t)BENCH_COUNT * 4 );
+		u8 *bench_dst = malloc( (size_t)BENCH_COUNT * 4 );
+		for ( i = 0; i < BENCH_COUNT * 4; i++ ) bench_src[i] = check_random_byte();
+		memset( bench_dst, 0, (size_t)BENCH_COUNT * 4 );
+
+		printf( "\n%-10s %-10s %10s %10s %8s   (Mtexel/s, gles rules)\n", "src", "dst", "generic", "kernel", "speedup" );
+		for ( s = 0; s < CHECK_PLAIN_FORMAT_COUNT; s++ )
+		{
+			for ( d = 0; d < CHECK_PLAIN_FORMAT_COUNT; d++ )
+			{
+				mali_surface_specifier src_format, dst_format;
+				u32 span_rules;
+				double slow, fast;
+
+				check_specifier( &src_format, &check_formats[s], MALI_FALSE, MALI_SURFACE_COLORSPACE_sRGB );
+				check_specifier( &dst_format, &check_formats[d], MALI_FALSE, MALI_SURFACE_COLORSPACE_sRGB );
+				span_rules = _mali_convert_get_span_rules( &src_format, &dst_format, MALI_CONVERT_SOURCE_OPENGLES );
+				slow = check_bench( _mali_convert_span_generic, bench_dst, bench_src, &src_format, &dst_format, span_rules );
+				fast = check_bench( _mali_convert_get_span_proc( &src_format, &dst_format, span_rules ),
+				                    bench_dst, bench_src, &src_format, &dst_format, span_rules );
+				printf( "%-10s %-10s %10.0f %10.0f %7.1fx\n", check_formats[s].name, check_formats[d].name, slow, fast, fast / slow );
+			}
+		}
+		free( bench_src );
+		free( bench_dst );
+	}
+
+	printf( "%s\n", failures ? "FAILED" : "all kernels match _mali_convert_texel" );
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,287 @@
+/*
+ * NEON kernels for the RGBA8888 conversions. The structure loads and
+ * stores (vld2/3/4, vst2/3/4) do the component (de)interleaving, so every
+ * format is a handful of instructions per 8 or 16 pixels. ARMv7 builds need
+ * -mfpu=neon for this file only; whether the CPU has NEON is checked at run
+ * time there, AArch64 always has it.
+ */
+
+#include <string.h>
+#include <arm_neon.h>
+
+#if defined(__arm__)
+#include <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+#endif
+
+#include "mali_convert_simd.h"
+
+static mali_bool _mali_convert_neon_supported( void )
+{
+#if defined(__arm__)
+	return ( getauxval( AT_HWCAP ) & HWCAP_NEON ) ? MALI_TRUE : MALI_FALSE;
+#else
+	return MALI_TRUE;
+#endif
+}
+
+/** Widens a 5 bit component by bit replication. */
+MALI_STATIC_FORCE_INLINE uint8x8_t _mali_convert_neon_expand5( uint16x8_t c )
+{
+	return vmovn_u16( vorrq_u16( vshlq_n_u16( c, 3 ), vshrq_n_u16( c, 2 ) ) );
+}
+
+static int _mali_convert_neon_from_8bit( u8 *dst, const u8 *src, int count, enum mali_convert_pixel_format format )
+{
+	const uint8x16_t ones = vdupq_n_u8( 0xFF ), zero = vdupq_n_u8( 0 );
+	int i = 0;
+
+	switch ( format )
+	{
+		case MALI_CONVERT_PIXEL_FORMAT_R8G8B8A8:
+			memcpy( dst, src, (size_t)count * 4 );
+			return count;
+
+		case MALI_CONVERT_PIXEL_FORMAT_R8G8B8:
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				uint8x16x3_t rgb = vld3q_u8( src + i * 3 );
+				uint8x16x4_t rgba;
+				rgba.val[0] = rgb.val[0];
+				rgba.val[1] = rgb.val[1];
+				rgba.val[2] = rgb.val[2];
+				rgba.val[3] = ones;
+				vst4q_u8( dst + i * 4, rgba );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L8:
+		case MALI_CONVERT_PIXEL_FORMAT_A8:
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				uint8x16_t v = vld1q_u8( src + i );
+				uint8x16x4_t rgba;
+				mali_bool lum = MALI_CONVERT_PIXEL_FORMAT_L8 == format;
+				rgba.val[0] = rgba.val[1] = rgba.val[2] = lum ? v : zero;
+				rgba.val[3] = lum ? ones : v;
+				vst4q_u8( dst + i * 4, rgba );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L8A8:
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				uint8x16x2_t la = vld2q_u8( src + i * 2 );
+				uint8x16x4_t rgba;
+				rgba.val[0] = rgba.val[1] = rgba.val[2] = la.val[0];
+				rgba.val[3] = la.val[1];
+				vst4q_u8( dst + i * 4, rgba );
+			}
+			return i;
+
+		default:
+			return 0;
+	}
+}
+
+static int _mali_convert_neon_from_16bit( u8 *dst, const u16 *src, int count, enum mali_convert_pixel_format format )
+{
+	const uint16x8_t mask4 = vdupq_n_u16( 0x0F ), mask5 = vdupq_n_u16( 0x1F ), mask6 = vdupq_n_u16( 0x3F );
+	int i = 0;
+
+	switch ( format )
+	{
+		case MALI_CONVERT_PIXEL_FORMAT_R5G6B5:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				uint16x8_t t = vld1q_u16( src + i );
+				uint16x8_t g = vandq_u16( vshrq_n_u16( t, 5 ), mask6 );
+				uint8x8x4_t rgba;
+				rgba.val[0] = _mali_convert_neon_expand5( vshrq_n_u16( t, 11 ) );
+				rgba.val[1] = vmovn_u16( vorrq_u16( vshlq_n_u16( g, 2 ), vshrq_n_u16( g, 4 ) ) );
+				rgba.val[2] = _mali_convert_neon_expand5( vandq_u16( t, mask5 ) );
+				rgba.val[3] = vdup_n_u8( 0xFF );
+				vst4_u8( dst + i * 4, rgba );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_R4G4B4A4:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				uint16x8_t t = vld1q_u16( src + i );
+				uint8x8x4_t rgba;
+				int c;
+				rgba.val[0] = vmovn_u16( vshrq_n_u16( t, 12 ) );
+				rgba.val[1] = vmovn_u16( vandq_u16( vshrq_n_u16( t, 8 ), mask4 ) );
+				rgba.val[2] = vmovn_u16( vandq_u16( vshrq_n_u16( t, 4 ), mask4 ) );
+				rgba.val[3] = vmovn_u16( vandq_u16( t, mask4 ) );
+				for ( c = 0; c < 4; c++ ) rgba.val[c] = vsli_n_u8( rgba.val[c], rgba.val[c], 4 );
+				vst4_u8( dst + i * 4, rgba );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_R5G5B5A1:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				uint16x8_t t = vld1q_u16( src + i );
+				uint8x8x4_t rgba;
+				rgba.val[0] = _mali_convert_neon_expand5( vshrq_n_u16( t, 11 ) );
+				rgba.val[1] = _mali_convert_neon_expand5( vandq_u16( vshrq_n_u16( t, 6 ), mask5 ) );
+				rgba.val[2] = _mali_convert_neon_expand5( vandq_u16( vshrq_n_u16( t, 1 ), mask5 ) );
+				rgba.val[3] = vmovn_u16( vreinterpretq_u16_s16( vshrq_n_s16( vreinterpretq_s16_u16( vshlq_n_u16( t, 15 ) ), 15 ) ) );
+				vst4_u8( dst + i * 4, rgba );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L16A16:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				uint16x8x2_t la = vld2q_u16( src + i * 2 );
+				uint8x8x4_t rgba;
+				rgba.val[0] = rgba.val[1] = rgba.val[2] = vshrn_n_u16( la.val[0], 8 );
+				rgba.val[3] = vshrn_n_u16( la.val[1], 8 );
+				vst4_u8( dst + i * 4, rgba );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_R16G16B16A16:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				uint16x8x4_t v = vld4q_u16( src + i * 4 );
+				uint8x8x4_t rgba;
+				int c;
+				for ( c = 0; c < 4; c++ ) rgba.val[c] = vshrn_n_u16( v.val[c], 8 );
+				vst4_u8( dst + i * 4, rgba );
+			}
+			return i;
+
+		default:
+			return 0;
+	}
+}
+
+static int _mali_convert_neon_to_8bit( u8 *dst, const u8 *src, int count, enum mali_convert_pixel_format format )
+{
+	int i = 0;
+
+	switch ( format )
+	{
+		case MALI_CONVERT_PIXEL_FORMAT_R8G8B8A8:
+			memcpy( dst, src, (size_t)count * 4 );
+			return count;
+
+		case MALI_CONVERT_PIXEL_FORMAT_R8G8B8:
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				uint8x16x4_t rgba = vld4q_u8( src + i * 4 );
+				uint8x16x3_t rgb;
+				rgb.val[0] = rgba.val[0];
+				rgb.val[1] = rgba.val[1];
+				rgb.val[2] = rgba.val[2];
+				vst3q_u8( dst + i * 3, rgb );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L8:
+		case MALI_CONVERT_PIXEL_FORMAT_A8:
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				uint8x16x4_t rgba = vld4q_u8( src + i * 4 );
+				vst1q_u8( dst + i, rgba.val[MALI_CONVERT_PIXEL_FORMAT_L8 == format ? 0 : 3] );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L8A8:
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				uint8x16x4_t rgba = vld4q_u8( src + i * 4 );
+				uint8x16x2_t la;
+				la.val[0] = rgba.val[0];
+				la.val[1] = rgba.val[3];
+				vst2q_u8( dst + i * 2, la );
+			}
+			return i;
+
+		default:
+			return 0;
+	}
+}
+
+static int _mali_convert_neon_to_16bit( u16 *dst, const u8 *src, int count, enum mali_convert_pixel_format format )
+{
+	int i = 0;
+
+	switch ( format )
+	{
+		case MALI_CONVERT_PIXEL_FORMAT_R5G6B5:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				uint8x8x4_t rgba = vld4_u8( src + i * 4 );
+				uint16x8_t t = vandq_u16( vshll_n_u8( rgba.val[0], 8 ), vdupq_n_u16( 0xF800 ) );
+				t = vorrq_u16( t, vandq_u16( vshlq_n_u16( vmovl_u8( rgba.val[1] ), 3 ), vdupq_n_u16( 0x07E0 ) ) );
+				t = vorrq_u16( t, vmovl_u8( vshr_n_u8( rgba.val[2], 3 ) ) );
+				vst1q_u16( dst + i, t );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_R4G4B4A4:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				uint8x8x4_t rgba = vld4_u8( src + i * 4 );
+				/* R and B take the high nibble, G and A slide in below them. */
+				uint8x8_t hi = vsri_n_u8( rgba.val[0], rgba.val[1], 4 );
+				uint8x8_t lo = vsri_n_u8( rgba.val[2], rgba.val[3], 4 );
+				vst1q_u16( dst + i, vorrq_u16( vshll_n_u8( hi, 8 ), vmovl_u8( lo ) ) );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_R5G5B5A1:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				uint8x8x4_t rgba = vld4_u8( src + i * 4 );
+				uint16x8_t t = vandq_u16( vshll_n_u8( rgba.val[0], 8 ), vdupq_n_u16( 0xF800 ) );
+				t = vorrq_u16( t, vandq_u16( vshlq_n_u16( vmovl_u8( rgba.val[1] ), 3 ), vdupq_n_u16( 0x07C0 ) ) );
+				t = vorrq_u16( t, vandq_u16( vshrq_n_u16( vmovl_u8( rgba.val[2] ), 2 ), vdupq_n_u16( 0x003E ) ) );
+				t = vorrq_u16( t, vmovl_u8( vshr_n_u8( rgba.val[3], 7 ) ) );
+				vst1q_u16( dst + i, t );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L16A16:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				uint8x8x4_t rgba = vld4_u8( src + i * 4 );
+				uint16x8x2_t la;
+				la.val[0] = vsliq_n_u16( vmovl_u8( rgba.val[0] ), vmovl_u8( rgba.val[0] ), 8 );
+				la.val[1] = vsliq_n_u16( vmovl_u8( rgba.val[3] ), vmovl_u8( rgba.val[3] ), 8 );
+				vst2q_u16( dst + i * 2, la );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_R16G16B16A16:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				uint8x8x4_t rgba = vld4_u8( src + i * 4 );
+				uint16x8x4_t v;
+				int c;
+				for ( c = 0; c < 4; c++ ) v.val[c] = vsliq_n_u16( vmovl_u8( rgba.val[c] ), vmovl_u8( rgba.val[c] ), 8 );
+				vst4q_u16( dst + i * 4, v );
+			}
+			return i;
+
+		default:
+			return 0;
+	}
+}
+
+const mali_convert_kernels _mali_convert_kernels_neon =
+{
+	"neon",
+	_mali_convert_neon_supported,
+	_mali_convert_neon_from_8bit,
+	_mali_convert_neon_from_16bit,
+	_mali_convert_neon_to_8bit,
+	_mali_convert_neon_to_16bit
+};
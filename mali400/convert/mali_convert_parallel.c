@@ -0,0 +1,184 @@
+/*
+ * Band parallel texture conversion on mali_worker threads, see
+ * mali_convert_parallel.h.
+ */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <base/mali_worker.h>
+
+#include "mali_convert_parallel.h"
+
+/* source plus destination bytes per band, half a typical L2 */
+#define MALI_CONVERT_BAND_BYTES ( 128 * 1024 )
+
+/* bands per thread, so that uneven threads still finish together */
+#define MALI_CONVERT_BANDS_PER_THREAD 4
+
+struct mali_convert_pool
+{
+	int worker_count;
+	mali_base_worker_handle *workers;
+};
+
+/**
+ * One parallel request. Threads claim bands from next_band until they run
+ * out; the last worker to finish signals the caller, which waits on done.
+ */
+typedef struct mali_convert_job
+{
+	const mali_convert_request *convert_request;
+	u32 band_rows;
+	u32 phase;
+	u32 band_count;
+	u32 next_band;
+
+	pthread_mutex_t lock;
+	pthread_cond_t done;
+	int pending;
+} mali_convert_job;
+
+mali_convert_pool *_mali_convert_pool_create( int worker_count )
+{
+	mali_convert_pool *pool;
+	int i;
+
+	if ( worker_count < 0 )
+	{
+		long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+		worker_count = cpus > 1 ? (int)cpus - 1 : 0;
+	}
+
+	pool = malloc( sizeof( *pool ) );
+	if ( NULL == pool ) return NULL;
+	pool->worker_count = 0;
+	pool->workers = malloc( sizeof( *pool->workers ) * ( worker_count > 0 ? worker_count : 1 ) );
+	if ( NULL == pool->workers )
+	{
+		free( pool );
+		return NULL;
+	}
+
+	for ( i = 0; i < worker_count; i++ )
+	{
+		pool->workers[i] = _mali_base_worker_create( MALI_FALSE );
+		if ( MALI_BASE_WORKER_NO_HANDLE == pool->workers[i] )
+		{
+			_mali_convert_pool_destroy( pool );
+			return NULL;
+		}
+		pool->worker_count++;
+	}
+	return pool;
+}
+
+void _mali_convert_pool_destroy( mali_convert_pool *pool )
+{
+	int i;
+
+	if ( NULL == pool ) return;
+	for ( i = 0; i < pool->worker_count; i++ ) _mali_base_worker_destroy( pool->workers[i] );
+	free( pool->workers );
+	free( pool );
+}
+
+/** Convert bands until none are left. */
+static void _mali_convert_job_run( mali_convert_job *job )
+{
+	u32 height = job->convert_request->rect.height;
+
+	for ( ;; )
+	{
+		u32 band = __sync_fetch_and_add( &job->next_band, 1 );
+		u32 first, last;
+
+		if ( band >= job->band_count ) break;
+		first = band * job->band_rows;
+		first = first > job->phase ? first - job->phase : 0;
+		last = ( band + 1 ) * job->band_rows - job->phase;
+		if ( last > height ) last = height;
+		_mali_convert_texture_rows( job->convert_request, first, last - first );
+	}
+}
+
+static void _mali_convert_job_task( void *param )
+{
+	mali_convert_job *job = param;
+
+	_mali_convert_job_run( job );
+
+	pthread_mutex_lock( &job->lock );
+	if ( 0 == --job->pending ) pthread_cond_signal( &job->done );
+	pthread_mutex_unlock( &job->lock );
+}
+
+mali_bool _mali_convert_texture_parallel( mali_convert_pool *pool, mali_convert_request *convert_request )
+{
+	const mali_convert_rectangle *rect = &convert_request->rect;
+	mali_bool blocked;
+	mali_convert_job job;
+	u32 texel_bytes, band_rows, min_rows;
+	int threads, i;
+
+	MALI_DEBUG_ASSERT_POINTER( convert_request );
+
+	if ( !_mali_convert_texture_supported( convert_request ) ) return MALI_FALSE;
+	if ( NULL == pool || 0 == pool->worker_count || 0 == rect->width || 0 == rect->height )
+	{
+		return _mali_convert_texture( convert_request );
+	}
+
+	/* bands of a blocked surface cover whole rows of 16x16 blocks */
+	blocked = M200_TEXTURE_ADDRESSING_MODE_16X16_BLOCKED == convert_request->dst_format.texel_layout ||
+	          M200_TEXTURE_ADDRESSING_MODE_16X16_BLOCKED == convert_request->src_format.texel_layout;
+	min_rows = blocked ? 16 : 1;
+	threads = pool->worker_count + 1;
+
+	texel_bytes = _mali_convert_texel_format_get_size( convert_request->src_format.texel_format ) +
+	              _mali_convert_texel_format_get_size( convert_request->dst_format.texel_format );
+	band_rows = MALI_CONVERT_BAND_BYTES / ( rect->width * texel_bytes );
+	if ( band_rows > rect->height / ( threads * MALI_CONVERT_BANDS_PER_THREAD ) )
+	{
+		band_rows = rect->height / ( threads * MALI_CONVERT_BANDS_PER_THREAD );
+	}
+	band_rows = MALI_ALIGN( band_rows > min_rows ? band_rows : min_rows, min_rows );
+	if ( band_rows >= rect->height ) return _mali_convert_texture( convert_request );
+
+	job.convert_request = convert_request;
+	job.band_rows = band_rows;
+	/* band edges fall on multiples of band_rows in the destination */
+	job.phase = blocked ? rect->dy % band_rows : 0;
+	job.band_count = ( rect->height + job.phase + band_rows - 1 ) / band_rows;
+	job.next_band = 0;
+	job.pending = 0;
+	pthread_mutex_init( &job.lock, NULL );
+	pthread_cond_init( &job.done, NULL );
+
+	for ( i = 0; i < pool->worker_count && (u32)i + 1 < job.band_count; i++ )
+	{
+		pthread_mutex_lock( &job.lock );
+		job.pending++;
+		pthread_mutex_unlock( &job.lock );
+		if ( MALI_ERR_NO_ERROR != _mali_base_worker_task_add( pool->workers[i], _mali_convert_job_task, &job ) )
+		{
+			pthread_mutex_lock( &job.lock );
+			job.pending--;
+			pthread_mutex_unlock( &job.lock );
+			break;
+		}
+	}
+
+	_mali_convert_job_run( &job );
+
+	pthread_mutex_lock( &job.lock );
+	while ( 0 != job.pending ) pthread_cond_wait( &job.done, &job.lock );
+	pthread_mutex_unlock( &job.lock );
+
+	pthread_cond_destroy( &job.done );
+	pthread_mutex_destroy( &job.lock );
+	return MALI_TRUE;
+}
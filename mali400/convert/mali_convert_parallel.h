@@ -0,0 +1,51 @@
+/*
+ * Host additions to the texture conversion in shared/mali_convert.h.
+ *
+ * _mali_convert_texture_parallel splits the request's rectangle into bands
+ * of rows and converts them on a pool of mali_worker threads
+ * (base/mali_worker.h), with the calling thread converting bands too. Bands
+ * are sized to keep their source and destination within the L2 cache and
+ * start on a 16 row boundary of a blocked surface, so no two threads write
+ * to the same 16x16 block. The result is identical to _mali_convert_texture.
+ */
+
+#ifndef MALI_CONVERT_PARALLEL_H
+#define MALI_CONVERT_PARALLEL_H
+
+#include "mali_convert_kernels.h"
+
+typedef struct mali_convert_pool mali_convert_pool;
+
+/**
+ * Whether _mali_convert_texture can handle the formats and layouts of the
+ * request.
+ */
+mali_bool _mali_convert_texture_supported( const mali_convert_request *convert_request );
+
+/**
+ * Convert rows [first_row, first_row + row_count) of the request's
+ * rectangle. The request must be supported.
+ */
+void _mali_convert_texture_rows( const mali_convert_request *convert_request, u32 first_row, u32 row_count );
+
+/**
+ * Create a pool of worker threads for parallel conversions.
+ * @param worker_count Number of threads besides the caller, or a negative
+ *                     value for one less than the number of online CPUs.
+ * @return The pool, or NULL if it could not be created.
+ */
+mali_convert_pool *_mali_convert_pool_create( int worker_count );
+
+/**
+ * Stop the pool's threads and free it. No conversion may be in progress.
+ */
+void _mali_convert_pool_destroy( mali_convert_pool *pool );
+
+/**
+ * Parallel _mali_convert_texture. Small requests, and any request when pool
+ * is NULL or has no workers, are converted on the calling thread. Returns
+ * once the whole rectangle is converted.
+ */
+mali_bool _mali_convert_texture_parallel( mali_convert_pool *pool, mali_convert_request *convert_request );
+
+#endif /* MALI_CONVERT_PARALLEL_H */
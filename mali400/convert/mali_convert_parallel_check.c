@@ -0,0 +1,169 @@
+/*
+ * Checks _mali_convert_texture_parallel against _mali_convert_texture and
+ * measures how it scales.
+ *
+ *   mali_convert_parallel_check      compare the parallel conversion with
+ *                                    the serial one for 1, 2, 4 and 8
+ *                                    threads on linear and blocked surfaces
+ *   mali_convert_parallel_check -b   also time a 4096x4096 conversion with
+ *                                    each thread count
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mali_convert_parallel.h"
+
+#define CHECK_SIZE 4096
+#define BENCH_RUNS 3
+
+typedef struct
+{
+	const char *name;
+	m200_texel_format src_texel_format;
+	m200_texture_addressing_mode src_layout;
+	mali_bool src_premult;
+	m200_texel_format dst_texel_format;
+	m200_texture_addressing_mode dst_layout;
+	mali_surface_colorspace dst_colorspace;
+	mali_convert_request_source source;
+	mali_convert_rectangle rect;
+} check_case;
+
+static const check_case check_cases[] =
+{
+	{ "ARGB8888 -> RGB565", M200_TEXEL_FORMAT_ARGB_8888, M200_TEXTURE_ADDRESSING_MODE_LINEAR, MALI_FALSE,
+	  M200_TEXEL_FORMAT_RGB_565, M200_TEXTURE_ADDRESSING_MODE_LINEAR, MALI_SURFACE_COLORSPACE_sRGB,
+	  MALI_CONVERT_SOURCE_OPENGLES, { 0, 0, 0, 0, CHECK_SIZE, CHECK_SIZE } },
+	{ "pre ARGB8888 -> lRGB ARGB8888 blocked", M200_TEXEL_FORMAT_ARGB_8888, M200_TEXTURE_ADDRESSING_MODE_LINEAR, MALI_TRUE,
+	  M200_TEXEL_FORMAT_ARGB_8888, M200_TEXTURE_ADDRESSING_MODE_16X16_BLOCKED, MALI_SURFACE_COLORSPACE_lRGB,
+	  MALI_CONVERT_SOURCE_OPENVG, { 0, 0, 0, 0, CHECK_SIZE, CHECK_SIZE } },
+	{ "RGB888 subrect -> ARGB4444 blocked", M200_TEXEL_FORMAT_RGB_888, M200_TEXTURE_ADDRESSING_MODE_LINEAR, MALI_FALSE,
+	  M200_TEXEL_FORMAT_ARGB_4444, M200_TEXTURE_ADDRESSING_MODE_16X16_BLOCKED, MALI_SURFACE_COLORSPACE_sRGB,
+	  MALI_CONVERT_SOURCE_OPENGLES, { 3, 1, 21, 5, CHECK_SIZE - 100, CHECK_SIZE - 37 } },
+	{ "AL88 blocked -> ARGB8888", M200_TEXEL_FORMAT_AL_88, M200_TEXTURE_ADDRESSING_MODE_16X16_BLOCKED, MALI_FALSE,
+	  M200_TEXEL_FORMAT_ARGB_8888, M200_TEXTURE_ADDRESSING_MODE_LINEAR, MALI_SURFACE_COLORSPACE_sRGB,
+	  MALI_CONVERT_SOURCE_OPENVG, { 40, 8, 0, 0, 1000, 999 } },
+};
+
+static const int check_threads[] = { 1, 2, 4, 8 };
+
+static double check_clock_ms( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void check_specifier( mali_surface_specifier *spec, m200_texel_format format, m200_texture_addressing_mode layout,
+                             mali_surface_colorspace colorspace, mali_bool premult )
+{
+	memset( spec, 0, sizeof( *spec ) );
+	spec->width = CHECK_SIZE;
+	spec->height = CHECK_SIZE;
+	spec->texel_format = format;
+	spec->texel_layout = layout;
+	spec->colorspace = colorspace;
+	spec->premultiplied_alpha = premult;
+}
+
+static void check_request( const check_case *c, mali_convert_request *request, void *dst, const void *src )
+{
+	mali_surface_specifier src_format, dst_format;
+	int src_size = _mali_convert_texel_format_get_size( c->src_texel_format );
+	int dst_size = _mali_convert_texel_format_get_size( c->dst_texel_format );
+
+	check_specifier( &src_format, c->src_texel_format, c->src_layout, MALI_SURFACE_COLORSPACE_sRGB, c->src_premult );
+	check_specifier( &dst_format, c->dst_texel_format, c->dst_layout, c->dst_colorspace, MALI_FALSE );
+	_mali_convert_request_initialize( request, dst, CHECK_SIZE * dst_size, &dst_format, src, CHECK_SIZE * src_size, &src_format,
+	                                  NULL, 0, &c->rect, MALI_FALSE, MALI_FALSE, MALI_FALSE, c->source );
+}
+
+int main( int argc, char **argv )
+{
+	mali_bool bench = argc > 1 && 0 == strcmp( argv[1], "-b" );
+	size_t bytes = (size_t)CHECK_SIZE * CHECK_SIZE * 4;
+	u8 *src = malloc( bytes );
+	u8 *expected = malloc( bytes );
+	u8 *actual = malloc( bytes );
+	unsigned int seed = 12345;
+	int failures = 0;
+	size_t i;
+	int c, t;
+
+	for ( i = 0; i < bytes; i++ )
+	{
+		seed = seed * 1103515245u + 12345u;
+		src[i] = (u8)( seed >> 16 );
+	}
+	printf( "online CPUs: %ld\n", sysconf( _SC_NPROCESSORS_ONLN ) );
+
+	for ( c = 0; c < (int)( sizeof( check_cases ) / sizeof( check_cases[0] ) ); c++ )
+	{
+		const check_case *cc = &check_cases[c];
+		mali_convert_request request;
+		double serial_ms = 0.0;
+
+		memset( expected, 0xA5, bytes );
+		check_request( cc, &request, expected, src );
+		if ( !_mali_convert_texture( &request ) )
+		{
+			printf( "%s: not supported\n", cc->name );
+			failures++;
+			continue;
+		}
+		if ( bench )
+		{
+			int run;
+			for ( run = 0; run < BENCH_RUNS; run++ )
+			{
+				double start = check_clock_ms(), ms;
+				_mali_convert_texture( &request );
+				ms = check_clock_ms() - start;
+				if ( 0 == run || ms < serial_ms ) serial_ms = ms;
+			}
+			printf( "%s: serial %.1f ms\n", cc->name, serial_ms );
+		}
+
+		for ( t = 0; t < (int)( sizeof( check_threads ) / sizeof( check_threads[0] ) ); t++ )
+		{
+			mali_convert_pool *pool = _mali_convert_pool_create( check_threads[t] - 1 );
+			mali_bool ok;
+
+			memset( actual, 0xA5, bytes );
+			check_request( cc, &request, actual, src );
+			ok = NULL != pool && _mali_convert_texture_parallel( pool, &request ) && 0 == memcmp( expected, actual, bytes );
+			if ( !ok ) failures++;
+
+			if ( bench && ok )
+			{
+				double best = 0.0;
+				int run;
+				for ( run = 0; run < BENCH_RUNS; run++ )
+				{
+					double start = check_clock_ms(), ms;
+					_mali_convert_texture_parallel( pool, &request );
+					ms = check_clock_ms() - start;
+					if ( 0 == run || ms < best ) best = ms;
+				}
+				printf( "  %d threads: exact, %.1f ms, %.2fx\n", check_threads[t], best, serial_ms / best );
+			}
+			else
+			{
+				printf( "  %s, %d threads: %s\n", cc->name, check_threads[t], ok ? "exact" : "MISMATCH" );
+			}
+			_mali_convert_pool_destroy( pool );
+		}
+	}
+
+	free( src );
+	free( expected );
+	free( actual );
+	printf( "%s\n", failures ? "FAILED" : "parallel conversion matches serial" );
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
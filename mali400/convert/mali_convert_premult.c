@@ -0,0 +1,103 @@
+/*
+ * Alpha premultiplication, see mali_convert_premult.h.
+ */
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "mali_convert_premult.h"
+
+const u32 _mali_convert_premult_reciprocal[256] =
+{
+	0x00000000, 0x01000000, 0x00800000, 0x00555556, 0x00400000, 0x00333334, 0x002AAAAB, 0x0024924A,
+	0x00200000, 0x001C71C8, 0x0019999A, 0x001745D2, 0x00155556, 0x0013B13C, 0x00124925, 0x00111112,
+	0x00100000, 0x000F0F10, 0x000E38E4, 0x000D7944, 0x000CCCCD, 0x000C30C4, 0x000BA2E9, 0x000B2165,
+	0x000AAAAB, 0x000A3D71, 0x0009D89E, 0x00097B43, 0x00092493, 0x0008D3DD, 0x00088889, 0x00084211,
+	0x00080000, 0x0007C1F1, 0x00078788, 0x00075076, 0x00071C72, 0x0006EB3F, 0x0006BCA2, 0x0006906A,
+	0x00066667, 0x00063E71, 0x00061862, 0x0005F418, 0x0005D175, 0x0005B05C, 0x000590B3, 0x00057263,
+	0x00055556, 0x00053979, 0x00051EB9, 0x00050506, 0x0004EC4F, 0x0004D488, 0x0004BDA2, 0x0004A791,
+	0x0004924A, 0x00047DC2, 0x000469EF, 0x000456C8, 0x00044445, 0x0004325D, 0x00042109, 0x00041042,
+	0x00040000, 0x0003F040, 0x0003E0F9, 0x0003D227, 0x0003C3C4, 0x0003B5CD, 0x0003A83B, 0x00039B0B,
+	0x00038E39, 0x000381C1, 0x000375A0, 0x000369D1, 0x00035E51, 0x0003531E, 0x00034835, 0x00033D92,
+	0x00033334, 0x00032917, 0x00031F39, 0x00031598, 0x00030C31, 0x00030304, 0x0002FA0C, 0x0002F14A,
+	0x0002E8BB, 0x0002E05D, 0x0002D82E, 0x0002D02E, 0x0002C85A, 0x0002C0B1, 0x0002B932, 0x0002B1DB,
+	0x0002AAAB, 0x0002A3A1, 0x00029CBD, 0x000295FB, 0x00028F5D, 0x000288E0, 0x00028283, 0x00027C46,
+	0x00027628, 0x00027028, 0x00026A44, 0x0002647D, 0x00025ED1, 0x00025940, 0x000253C9, 0x00024E6B,
+	0x00024925, 0x000243F7, 0x00023EE1, 0x000239E1, 0x000234F8, 0x00023024, 0x00022B64, 0x000226BA,
+	0x00022223, 0x00021D9F, 0x0002192F, 0x000214D1, 0x00021085, 0x00020C4A, 0x00020821, 0x00020409,
+	0x00020000, 0x0001FC08, 0x0001F820, 0x0001F447, 0x0001F07D, 0x0001ECC1, 0x0001E914, 0x0001E574,
+	0x0001E1E2, 0x0001DE5E, 0x0001DAE7, 0x0001D77C, 0x0001D41E, 0x0001D0CC, 0x0001CD86, 0x0001CA4C,
+	0x0001C71D, 0x0001C3F9, 0x0001C0E1, 0x0001BDD3, 0x0001BAD0, 0x0001B7D7, 0x0001B4E9, 0x0001B204,
+	0x0001AF29, 0x0001AC58, 0x0001A98F, 0x0001A6D1, 0x0001A41B, 0x0001A16E, 0x00019EC9, 0x00019C2E,
+	0x0001999A, 0x0001970F, 0x0001948C, 0x00019210, 0x00018F9D, 0x00018D31, 0x00018ACC, 0x0001886F,
+	0x00018619, 0x000183CA, 0x00018182, 0x00017F41, 0x00017D06, 0x00017AD3, 0x000178A5, 0x0001767E,
+	0x0001745E, 0x00017243, 0x0001702F, 0x00016E20, 0x00016C17, 0x00016A14, 0x00016817, 0x0001661F,
+	0x0001642D, 0x00016240, 0x00016059, 0x00015E76, 0x00015C99, 0x00015AC1, 0x000158EE, 0x0001571F,
+	0x00015556, 0x00015391, 0x000151D1, 0x00015016, 0x00014E5F, 0x00014CAC, 0x00014AFE, 0x00014954,
+	0x000147AF, 0x0001460D, 0x00014470, 0x000142D7, 0x00014142, 0x00013FB1, 0x00013E23, 0x00013C9A,
+	0x00013B14, 0x00013992, 0x00013814, 0x00013699, 0x00013522, 0x000133AF, 0x0001323F, 0x000130D2,
+	0x00012F69, 0x00012E03, 0x00012CA0, 0x00012B41, 0x000129E5, 0x0001288C, 0x00012736, 0x000125E3,
+	0x00012493, 0x00012346, 0x000121FC, 0x000120B5, 0x00011F71, 0x00011E2F, 0x00011CF1, 0x00011BB5,
+	0x00011A7C, 0x00011946, 0x00011812, 0x000116E1, 0x000115B2, 0x00011486, 0x0001135D, 0x00011236,
+	0x00011112, 0x00010FF0, 0x00010ED0, 0x00010DB3, 0x00010C98, 0x00010B7F, 0x00010A69, 0x00010954,
+	0x00010843, 0x00010733, 0x00010625, 0x0001051A, 0x00010411, 0x0001030A, 0x00010205, 0x00010102
+};
+
+void _mali_convert_premultiply_8888_scalar( u8 *colors, u32 count )
+{
+	u32 i;
+	for ( i = 0; i < count; i++, colors += 4 )
+	{
+		colors[0] = (u8)_mali_convert_to_premult( colors[0], colors[3] );
+		colors[1] = (u8)_mali_convert_to_premult( colors[1], colors[3] );
+		colors[2] = (u8)_mali_convert_to_premult( colors[2], colors[3] );
+	}
+}
+
+void _mali_convert_premultiply_8888( u8 *colors, u32 count )
+{
+	u32 i = 0;
+
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16( 128 );
+	const __m128i alpha_lanes = _mm_set_epi16( -1, 0, 0, 0, -1, 0, 0, 0 );
+
+	for ( ; i + 4 <= count; i += 4 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i *)( colors + i * 4 ) );
+		__m128i c[2];
+		int half;
+
+		c[0] = _mm_unpacklo_epi8( v, zero );
+		c[1] = _mm_unpackhi_epi8( v, zero );
+		for ( half = 0; half < 2; half++ )
+		{
+			__m128i a = _mm_shufflehi_epi16( _mm_shufflelo_epi16( c[half], 0xFF ), 0xFF );
+			__m128i ca = _mm_mullo_epi16( c[half], a );
+			/* ((ca >> 8) + ca + 128) >> 8, at most 65407 before the shift */
+			__m128i p = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( ca, _mm_srli_epi16( ca, 8 ) ), round ), 8 );
+			c[half] = _mm_or_si128( _mm_andnot_si128( alpha_lanes, p ), _mm_and_si128( alpha_lanes, c[half] ) );
+		}
+		_mm_storeu_si128( (__m128i *)( colors + i * 4 ), _mm_packus_epi16( c[0], c[1] ) );
+	}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	for ( ; i + 8 <= count; i += 8 )
+	{
+		uint8x8x4_t v = vld4_u8( colors + i * 4 );
+		int j;
+		for ( j = 0; j < 3; j++ )
+		{
+			uint16x8_t ca = vmull_u8( v.val[j], v.val[3] );
+			/* ((ca >> 8) + ca + 128) >> 8 */
+			v.val[j] = vrshrn_n_u16( vsraq_n_u16( ca, ca, 8 ), 8 );
+		}
+		vst4_u8( colors + i * 4, v );
+	}
+#endif
+
+	_mali_convert_premultiply_8888_scalar( colors + i * 4, count - i );
+}
@@ -0,0 +1,40 @@
+/*
+ * Division free alpha premultiplication for the host conversion, exact
+ * against _mali_convert_from_premult and _mali_convert_to_premult in
+ * shared/mali_convert.h.
+ *
+ * Un-premultiplying multiplies by a per alpha reciprocal from a 1 KiB
+ * table instead of dividing. _mali_convert_to_premult has no divide, but
+ * premultiplying a whole span of 8888 colors is done in 16 bit vector
+ * lanes where SSE2 or NEON is available; every intermediate of its
+ * rounding trick fits in 16 bits.
+ */
+
+#ifndef MALI_CONVERT_PREMULT_H
+#define MALI_CONVERT_PREMULT_H
+
+#include <shared/mali_convert.h>
+
+/** ceil(2^24 / alpha), 0 for alpha 0 */
+extern const u32 _mali_convert_premult_reciprocal[256];
+
+/**
+ * _mali_convert_from_premult without the divide. Exact for 8-bit
+ * components no greater than alpha, which is how the conversion clamps
+ * them; the product then stays below 2^32.
+ */
+MALI_STATIC_FORCE_INLINE u32 _mali_convert_from_premult_fast( u32 component, u32 alpha )
+{
+	return ( ( component * 0xFF + ( alpha / 2 ) ) * _mali_convert_premult_reciprocal[alpha] ) >> 24;
+}
+
+/**
+ * Premultiply the first three bytes of count 4 byte colors with the fourth,
+ * their alpha, as _mali_convert_to_premult does.
+ */
+void _mali_convert_premultiply_8888( u8 *colors, u32 count );
+
+/** Scalar reference of _mali_convert_premultiply_8888. */
+void _mali_convert_premultiply_8888_scalar( u8 *colors, u32 count );
+
+#endif /* MALI_CONVERT_PREMULT_H */
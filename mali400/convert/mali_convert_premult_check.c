@@ -0,0 +1,172 @@
+/*
+ * Checks the division free premultiplication against the formulas in
+ * shared/mali_convert.h and measures it.
+ *
+ *   mali_convert_premult_check      exhaustive comparison of
+ *                                   _mali_convert_from_premult_fast and of
+ *                                   _mali_convert_premultiply_8888
+ *   mali_convert_premult_check -b   also time them against the per component
+ *                                   formulas, and OpenVG premultiplied
+ *                                   conversions against _mali_convert_texel
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mali_convert_kernels.h"
+#include "mali_convert_premult.h"
+
+#define CHECK_GUARD 64
+#define BENCH_COUNT ( 1024 * 1024 )
+#define BENCH_RUNS 5
+
+static double check_clock_ms( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static mali_bool check_from_premult( void )
+{
+	u32 a, c;
+	for ( a = 0; a < 256; a++ )
+	{
+		for ( c = 0; c <= a; c++ )
+		{
+			if ( _mali_convert_from_premult_fast( c, a ) != _mali_convert_from_premult( c, a ) )
+			{
+				printf( "from_premult( %u, %u ): %u, expected %u\n", c, a,
+				        _mali_convert_from_premult_fast( c, a ), _mali_convert_from_premult( c, a ) );
+				return MALI_FALSE;
+			}
+		}
+	}
+	return MALI_TRUE;
+}
+
+/* Every component and alpha pair, at each span length up to a few vectors and each offset. */
+static mali_bool check_premultiply( void )
+{
+	static u8 src[65536 * 4 + CHECK_GUARD];
+	static u8 expected[65536 * 4 + CHECK_GUARD];
+	static u8 actual[65536 * 4 + CHECK_GUARD];
+	u32 i, count, offset;
+
+	for ( i = 0; i < 65536; i++ )
+	{
+		src[i * 4 + 0] = (u8)i;
+		src[i * 4 + 1] = (u8)( i * 7 );
+		src[i * 4 + 2] = (u8)( 255 - i );
+		src[i * 4 + 3] = (u8)( i >> 8 );
+	}
+	for ( i = 0; i < 65536; i++ )
+	{
+		if ( _mali_convert_to_premult( src[i * 4], src[i * 4 + 3] ) > 255 ) return MALI_FALSE;
+	}
+
+	for ( count = 0; count <= 65536; count = count < 40 ? count + 1 : count * 2 )
+	{
+		for ( offset = 0; offset < 4; offset++ )
+		{
+			u32 size = count * 4 + offset + CHECK_GUARD;
+			memcpy( expected, src, size );
+			memcpy( actual, src, size );
+			_mali_convert_premultiply_8888_scalar( expected + offset, count );
+			_mali_convert_premultiply_8888( actual + offset, count );
+			if ( 0 != memcmp( expected, actual, size ) )
+			{
+				for ( i = 0; i < size && expected[i] == actual[i]; i++ );
+				printf( "premultiply %u colors at +%u: byte %u is %u, expected %u\n", count, offset, i, actual[i], expected[i] );
+				return MALI_FALSE;
+			}
+		}
+	}
+	return MALI_TRUE;
+}
+
+/* Best of BENCH_RUNS, in milliseconds. */
+#define CHECK_TIME( best, statement ) \
+	do { \
+		int run_; \
+		for ( run_ = 0; run_ < BENCH_RUNS; run_++ ) \
+		{ \
+			double start_ = check_clock_ms(), ms_; \
+			statement; \
+			ms_ = check_clock_ms() - start_; \
+			if ( 0 == run_ || ms_ < best ) best = ms_; \
+		} \
+	} while ( 0 )
+
+static void check_bench( void )
+{
+	u8 *colors = malloc( (size_t)BENCH_COUNT * 4 );
+	u8 *src = malloc( (size_t)BENCH_COUNT * 4 );
+	u8 *dst = malloc( (size_t)BENCH_COUNT * 4 );
+	volatile u32 sink = 0;
+	double divide = 0.0, reciprocal = 0.0, scalar = 0.0, vector = 0.0;
+	u32 i;
+	int r;
+
+	for ( i = 0; i < BENCH_COUNT * 4; i++ ) src[i] = (u8)( i * 2654435761u >> 24 );
+	for ( i = 0; i < BENCH_COUNT; i++ ) if ( src[i * 4] > src[i * 4 + 3] ) src[i * 4] = src[i * 4 + 3];
+
+	CHECK_TIME( divide, { u32 acc = 0; for ( i = 0; i < BENCH_COUNT; i++ ) acc += _mali_convert_from_premult( src[i * 4], src[i * 4 + 3] ); sink += acc; } );
+	CHECK_TIME( reciprocal, { u32 acc = 0; for ( i = 0; i < BENCH_COUNT; i++ ) acc += _mali_convert_from_premult_fast( src[i * 4], src[i * 4 + 3] ); sink += acc; } );
+	CHECK_TIME( scalar, { memcpy( colors, src, (size_t)BENCH_COUNT * 4 ); _mali_convert_premultiply_8888_scalar( colors, BENCH_COUNT ); } );
+	CHECK_TIME( vector, { memcpy( colors, src, (size_t)BENCH_COUNT * 4 ); _mali_convert_premultiply_8888( colors, BENCH_COUNT ); } );
+	printf( "\n%-34s %10s %10s   (Mcomponent/s)\n", "", "formula", "new" );
+	printf( "%-34s %10.0f %10.0f\n", "un-premultiply", BENCH_COUNT / ( divide * 1000.0 ), BENCH_COUNT / ( reciprocal * 1000.0 ) );
+	printf( "%-34s %10.0f %10.0f   (including a copy)\n", "premultiply", 3 * BENCH_COUNT / ( scalar * 1000.0 ), 3 * BENCH_COUNT / ( vector * 1000.0 ) );
+
+	printf( "\n%-34s %10s %10s   (Mtexel/s)\n", "", "texel", "span" );
+	for ( r = 0; r < 3; r++ )
+	{
+		static const char * const names[] = { "vg ARGB_8888 pre -> ARGB_8888", "vg ARGB_8888 -> pre ARGB_8888", "vg ARGB_8888 pre -> pre RGB_565" };
+		mali_surface_specifier src_format, dst_format;
+		u32 conv_rules, span_rules;
+		mali_convert_span_proc proc;
+		double texel = 0.0, span = 0.0;
+
+		memset( &src_format, 0, sizeof( src_format ) );
+		src_format.texel_format = M200_TEXEL_FORMAT_ARGB_8888;
+		src_format.colorspace = MALI_SURFACE_COLORSPACE_sRGB;
+		dst_format = src_format;
+		if ( 2 == r ) dst_format.texel_format = M200_TEXEL_FORMAT_RGB_565;
+		src_format.premultiplied_alpha = 1 != r;
+		dst_format.premultiplied_alpha = 0 != r;
+		conv_rules = _mali_convert_setup_conversion_rules( &src_format, &dst_format );
+		span_rules = _mali_convert_get_span_rules( &src_format, &dst_format, MALI_CONVERT_SOURCE_OPENVG );
+		proc = _mali_convert_get_span_proc( &src_format, &dst_format, span_rules );
+
+		CHECK_TIME( texel, {
+			for ( i = 0; i < BENCH_COUNT; i++ )
+			{
+				u32 t = _mali_convert_texel( &src_format, &dst_format, ( (const u32 *)src )[i], conv_rules, MALI_CONVERT_SOURCE_OPENVG );
+				memcpy( dst + i * 4, &t, 4 );
+			}
+		} );
+		CHECK_TIME( span, proc( dst, src, BENCH_COUNT, &src_format, &dst_format, span_rules ) );
+		printf( "%-34s %10.0f %10.0f\n", names[r], BENCH_COUNT / ( texel * 1000.0 ), BENCH_COUNT / ( span * 1000.0 ) );
+	}
+
+	free( colors );
+	free( src );
+	free( dst );
+}
+
+int main( int argc, char **argv )
+{
+	mali_bool bench = argc > 1 && 0 == strcmp( argv[1], "-b" );
+	mali_bool from_ok = check_from_premult();
+	mali_bool to_ok = check_premultiply();
+
+	printf( "un-premultiply: %s\n", from_ok ? "exact" : "MISMATCH" );
+	printf( "premultiply: %s\n", to_ok ? "exact" : "MISMATCH" );
+	if ( bench ) check_bench();
+	return from_ok && to_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,289 @@
+/*
+ * Host implementation of the RGBA8888 conversions in shared/mali_convert.h:
+ * format descriptions, the scalar reference and the run time choice of
+ * vector kernels (mali_convert_simd.h).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mali_convert_simd.h"
+
+int _mali_convert_pixel_format_get_size( enum mali_convert_pixel_format format )
+{
+	switch ( format )
+	{
+		case MALI_CONVERT_PIXEL_FORMAT_R5G6B5:
+		case MALI_CONVERT_PIXEL_FORMAT_R4G4B4A4:
+		case MALI_CONVERT_PIXEL_FORMAT_R5G5B5A1:
+		case MALI_CONVERT_PIXEL_FORMAT_L8A8:
+			return 2;
+		case MALI_CONVERT_PIXEL_FORMAT_L16A16:
+		case MALI_CONVERT_PIXEL_FORMAT_R8G8B8A8:
+			return 4;
+		case MALI_CONVERT_PIXEL_FORMAT_R16G16B16A16:
+			return 8;
+		case MALI_CONVERT_PIXEL_FORMAT_R8G8B8:
+			return 3;
+		case MALI_CONVERT_PIXEL_FORMAT_L8:
+		case MALI_CONVERT_PIXEL_FORMAT_A8:
+			return 1;
+	}
+	MALI_DEBUG_ASSERT( 0, ("Invalid convert pixel format %d", format) );
+	return 0;
+}
+
+mali_convert_method _mali_convert_pixel_format_get_convert_method( enum mali_convert_pixel_format format )
+{
+	switch ( format )
+	{
+		case MALI_CONVERT_PIXEL_FORMAT_R5G6B5:
+		case MALI_CONVERT_PIXEL_FORMAT_R4G4B4A4:
+		case MALI_CONVERT_PIXEL_FORMAT_R5G5B5A1:
+			return MALI_CONVERT_PACKED;
+		case MALI_CONVERT_PIXEL_FORMAT_L16A16:
+		case MALI_CONVERT_PIXEL_FORMAT_R16G16B16A16:
+			return MALI_CONVERT_16BITS;
+		default:
+			return MALI_CONVERT_8BITS;
+	}
+}
+
+/**
+ * Byte of the pixel holding red, green, blue and alpha, -1 when absent.
+ * Luminance formats map red, green and blue to the same byte.
+ */
+void _mali_convert_get_8bit_byte_indices( int index[4], enum mali_convert_pixel_format format )
+{
+	static const int indices[][4] =
+	{
+		{  0,  1,  2, -1 }, /* R8G8B8 */
+		{  0,  1,  2,  3 }, /* R8G8B8A8 */
+		{  0,  0,  0, -1 }, /* L8 */
+		{  0,  0,  0,  1 }, /* L8A8 */
+		{ -1, -1, -1,  0 }  /* A8 */
+	};
+	MALI_DEBUG_ASSERT( format >= MALI_CONVERT_PIXEL_FORMAT_R8G8B8, ("Not a byte addressed format: %d", format) );
+	memcpy( index, indices[format - MALI_CONVERT_PIXEL_FORMAT_R8G8B8], sizeof(indices[0]) );
+}
+
+/**
+ * Bit position of each component in a packed texel. For the 16 bit per
+ * component formats it is the u16 within the pixel instead, shared by red,
+ * green and blue for luminance.
+ */
+void _mali_convert_get_16bit_shifts( int shift[4], enum mali_convert_pixel_format format )
+{
+	static const int shifts[][4] =
+	{
+		{ 11, 5, 0, 0 },    /* R5G6B5 */
+		{ 12, 8, 4, 0 },    /* R4G4B4A4 */
+		{ 11, 6, 1, 0 },    /* R5G5B5A1 */
+		{  0, 0, 0, 1 },    /* L16A16 */
+		{  0, 1, 2, 3 }     /* R16G16B16A16 */
+	};
+	MALI_DEBUG_ASSERT( format <= MALI_CONVERT_PIXEL_FORMAT_R16G16B16A16, ("Not a 16 bit format: %d", format) );
+	memcpy( shift, shifts[format], sizeof(shifts[0]) );
+}
+
+/**
+ * Bits per component, 0 when absent.
+ */
+void _mali_convert_get_16bit_component_size( int size[4], enum mali_convert_pixel_format format )
+{
+	static const int sizes[][4] =
+	{
+		{  5,  6,  5,  0 },
+		{  4,  4,  4,  4 },
+		{  5,  5,  5,  1 },
+		{ 16, 16, 16, 16 },
+		{ 16, 16, 16, 16 }
+	};
+	MALI_DEBUG_ASSERT( format <= MALI_CONVERT_PIXEL_FORMAT_R16G16B16A16, ("Not a 16 bit format: %d", format) );
+	memcpy( size, sizes[format], sizeof(sizes[0]) );
+}
+
+/** Widens a size bit component by bit replication. */
+MALI_STATIC_INLINE u32 _mali_convert_expand( u32 value, int size )
+{
+	switch ( size )
+	{
+		case 1: return value * 255;
+		case 4: return _mali_convert_replicate_4_bits( value );
+		case 5: return _mali_convert_replicate_5_bits( value );
+		case 6: return _mali_convert_replicate_6_bits( value );
+		default: return value;
+	}
+}
+
+void _mali_convert_8bit_to_rgba8888_scalar( u8 *dst, const u8 *src, int count, enum mali_convert_pixel_format src_format )
+{
+	int index[4];
+	int size = _mali_convert_pixel_format_get_size( src_format );
+	int i, c;
+
+	_mali_convert_get_8bit_byte_indices( index, src_format );
+	for ( i = 0; i < count; i++, dst += 4, src += size )
+	{
+		for ( c = 0; c < 4; c++ )
+		{
+			dst[c] = index[c] >= 0 ? src[index[c]] : ( c == 3 ? 0xFF : 0 );
+		}
+	}
+}
+
+void _mali_convert_16bit_to_rgba8888_scalar( u8 *dst, const u16 *src, int count, enum mali_convert_pixel_format src_format )
+{
+	int shift[4], size[4];
+	int i, c;
+
+	_mali_convert_get_16bit_shifts( shift, src_format );
+	_mali_convert_get_16bit_component_size( size, src_format );
+	if ( MALI_CONVERT_16BITS == _mali_convert_pixel_format_get_convert_method( src_format ) )
+	{
+		/* Keep the most significant byte. */
+		int components = _mali_convert_pixel_format_get_size( src_format ) / 2;
+		for ( i = 0; i < count; i++, dst += 4, src += components )
+		{
+			for ( c = 0; c < 4; c++ ) dst[c] = src[shift[c]] >> 8;
+		}
+		return;
+	}
+
+	for ( i = 0; i < count; i++, dst += 4 )
+	{
+		u32 texel = src[i];
+		for ( c = 0; c < 4; c++ )
+		{
+			dst[c] = size[c] ? _mali_convert_expand( ( texel >> shift[c] ) & ( ( 1u << size[c] ) - 1 ), size[c] ) : 0xFF;
+		}
+	}
+}
+
+/* Luminance is taken from red: components are stored from alpha down to red. */
+void _mali_convert_rgba8888_to_8bit_scalar( u8 *dst, const u8 *src, int count, enum mali_convert_pixel_format dst_format )
+{
+	int index[4];
+	int size = _mali_convert_pixel_format_get_size( dst_format );
+	int i, c;
+
+	_mali_convert_get_8bit_byte_indices( index, dst_format );
+	for ( i = 0; i < count; i++, dst += size, src += 4 )
+	{
+		for ( c = 3; c >= 0; c-- )
+		{
+			if ( index[c] >= 0 ) dst[index[c]] = src[c];
+		}
+	}
+}
+
+void _mali_convert_rgba8888_to_16bit_scalar( u16 *dst, const u8 *src, int count, enum mali_convert_pixel_format dst_format )
+{
+	int shift[4], size[4];
+	int i, c;
+
+	_mali_convert_get_16bit_shifts( shift, dst_format );
+	_mali_convert_get_16bit_component_size( size, dst_format );
+	if ( MALI_CONVERT_16BITS == _mali_convert_pixel_format_get_convert_method( dst_format ) )
+	{
+		/* Replicate the byte, so 0xFF becomes 0xFFFF. */
+		int components = _mali_convert_pixel_format_get_size( dst_format ) / 2;
+		for ( i = 0; i < count; i++, dst += components, src += 4 )
+		{
+			for ( c = 3; c >= 0; c-- ) dst[shift[c]] = src[c] * 257;
+		}
+		return;
+	}
+
+	for ( i = 0; i < count; i++, src += 4 )
+	{
+		u32 texel = 0;
+		for ( c = 0; c < 4; c++ )
+		{
+			if ( size[c] ) texel |= ( (u32)src[c] >> ( 8 - size[c] ) ) << shift[c];
+		}
+		dst[i] = (u16)texel;
+	}
+}
+
+const mali_convert_kernels * const _mali_convert_kernel_list[] =
+{
+#if defined(__x86_64__) || defined(__i386__)
+	&_mali_convert_kernels_sse2,
+	&_mali_convert_kernels_avx2,
+#endif
+#if defined(__arm__) || defined(__aarch64__)
+	&_mali_convert_kernels_neon,
+#endif
+	NULL
+};
+
+static const mali_convert_kernels *mali_convert_kernels_in_use;
+static mali_bool mali_convert_kernels_chosen;
+
+static const mali_convert_kernels *_mali_convert_choose_kernels( void )
+{
+	const mali_convert_kernels *best = NULL;
+	const char *name = getenv( "MALI_CONVERT_ISA" );
+	int i;
+
+	for ( i = 0; NULL != _mali_convert_kernel_list[i]; i++ )
+	{
+		const mali_convert_kernels *kernels = _mali_convert_kernel_list[i];
+		if ( !kernels->supported() ) continue;
+		if ( NULL != name && 0 == strcmp( name, kernels->name ) ) return kernels;
+		best = kernels;
+	}
+	return ( NULL != name && 0 == strcmp( name, "scalar" ) ) ? NULL : best;
+}
+
+/* Races only store the same value. */
+const mali_convert_kernels *_mali_convert_get_kernels( void )
+{
+	if ( !mali_convert_kernels_chosen )
+	{
+		mali_convert_kernels_in_use = _mali_convert_choose_kernels();
+		mali_convert_kernels_chosen = MALI_TRUE;
+	}
+	return mali_convert_kernels_in_use;
+}
+
+mali_bool _mali_convert_set_kernels( const mali_convert_kernels *kernels )
+{
+	if ( NULL != kernels && !kernels->supported() ) return MALI_FALSE;
+	mali_convert_kernels_in_use = kernels;
+	mali_convert_kernels_chosen = MALI_TRUE;
+	return MALI_TRUE;
+}
+
+void _mali_convert_8bit_to_rgba8888( u8 *dst, const u8 *src, int count, enum mali_convert_pixel_format src_format )
+{
+	const mali_convert_kernels *kernels = _mali_convert_get_kernels();
+	int done = NULL != kernels ? kernels->from_8bit( dst, src, count, src_format ) : 0;
+	_mali_convert_8bit_to_rgba8888_scalar( dst + done * 4, src + done * _mali_convert_pixel_format_get_size( src_format ),
+	                                       count - done, src_format );
+}
+
+void _mali_convert_16bit_to_rgba8888( u8 *dst, const u16 *src, int count, enum mali_convert_pixel_format src_format )
+{
+	const mali_convert_kernels *kernels = _mali_convert_get_kernels();
+	int done = NULL != kernels ? kernels->from_16bit( dst, src, count, src_format ) : 0;
+	_mali_convert_16bit_to_rgba8888_scalar( dst + done * 4, src + done * ( _mali_convert_pixel_format_get_size( src_format ) / 2 ),
+	                                        count - done, src_format );
+}
+
+void _mali_convert_rgba8888_to_8bit( u8 *dst, const u8 *src, int count, enum mali_convert_pixel_format src_format )
+{
+	const mali_convert_kernels *kernels = _mali_convert_get_kernels();
+	int done = NULL != kernels ? kernels->to_8bit( dst, src, count, src_format ) : 0;
+	_mali_convert_rgba8888_to_8bit_scalar( dst + done * _mali_convert_pixel_format_get_size( src_format ), src + done * 4,
+	                                       count - done, src_format );
+}
+
+void _mali_convert_rgba8888_to_16bit( u16 *dst, const u8 *src, int count, enum mali_convert_pixel_format src_format )
+{
+	const mali_convert_kernels *kernels = _mali_convert_get_kernels();
+	int done = NULL != kernels ? kernels->to_16bit( dst, src, count, src_format ) : 0;
+	_mali_convert_rgba8888_to_16bit_scalar( dst + done * ( _mali_convert_pixel_format_get_size( src_format ) / 2 ), src + done * 4,
+	                                        count - done, src_format );
+}
@@ -0,0 +1,65 @@
+/*
+ * Vector kernels behind the RGBA8888 entry points of shared/mali_convert.h.
+ *
+ * Pixel formats follow their GL counterparts: byte formats are stored in
+ * component order, the packed 16 bit formats have red in the most
+ * significant bits and the 16 bit per component formats hold one u16 per
+ * component. RGBA8888 is R, G, B, A in memory.
+ *
+ * Each instruction set provides a mali_convert_kernels table. A kernel
+ * converts the longest leading part of the span it has a vector loop for
+ * and returns the number of pixels it converted, 0 for formats it does not
+ * handle; the entry points finish the remainder with the scalar reference,
+ * which is what the vector kernels are checked against bit for bit.
+ */
+
+#ifndef MALI_CONVERT_SIMD_H
+#define MALI_CONVERT_SIMD_H
+
+#include <shared/mali_convert.h>
+
+typedef struct mali_convert_kernels
+{
+	const char *name;
+	mali_bool (*supported)( void );
+	int (*from_8bit)( u8 *dst, const u8 *src, int count, enum mali_convert_pixel_format format );
+	int (*from_16bit)( u8 *dst, const u16 *src, int count, enum mali_convert_pixel_format format );
+	int (*to_8bit)( u8 *dst, const u8 *src, int count, enum mali_convert_pixel_format format );
+	int (*to_16bit)( u16 *dst, const u8 *src, int count, enum mali_convert_pixel_format format );
+} mali_convert_kernels;
+
+#if defined(__x86_64__) || defined(__i386__)
+extern const mali_convert_kernels _mali_convert_kernels_sse2;
+extern const mali_convert_kernels _mali_convert_kernels_avx2;
+#endif
+#if defined(__arm__) || defined(__aarch64__)
+extern const mali_convert_kernels _mali_convert_kernels_neon;
+#endif
+
+/**
+ * Kernel tables built into this library, best last, NULL terminated. The
+ * ones the CPU does not support are still listed.
+ */
+extern const mali_convert_kernels * const _mali_convert_kernel_list[];
+
+/**
+ * The kernels the entry points use: the best supported ones, or the ones
+ * named by the MALI_CONVERT_ISA environment variable ("scalar" for none).
+ * @return NULL when running the scalar reference only
+ */
+const mali_convert_kernels *_mali_convert_get_kernels( void );
+
+/**
+ * Overrides the choice of _mali_convert_get_kernels.
+ * @param kernels kernels to use from now on, NULL for the scalar reference
+ * @return MALI_FALSE if the CPU does not support them
+ */
+mali_bool _mali_convert_set_kernels( const mali_convert_kernels *kernels );
+
+/* Scalar reference of each entry point. */
+void _mali_convert_8bit_to_rgba8888_scalar( u8 *dst, const u8 *src, int count, enum mali_convert_pixel_format src_format );
+void _mali_convert_16bit_to_rgba8888_scalar( u8 *dst, const u16 *src, int count, enum mali_convert_pixel_format src_format );
+void _mali_convert_rgba8888_to_8bit_scalar( u8 *dst, const u8 *src, int count, enum mali_convert_pixel_format dst_format );
+void _mali_convert_rgba8888_to_16bit_scalar( u16 *dst, const u8 *src, int count, enum mali_convert_pixel_format dst_format );
+
+#endif /* MALI_CONVERT_SIMD_H */
@@ -0,0 +1,281 @@
+/*
+ * SSE2 kernels for the RGBA8888 conversions, the x86 baseline. R8G8B8 has
+ * no cheap SSE2 shuffle and is left to the scalar path here; the AVX2
+ * kernels cover it.
+ */
+
+#include <string.h>
+#include <emmintrin.h>
+
+#include "mali_convert_simd.h"
+
+#define LOAD( p ) _mm_loadu_si128( (const __m128i *)(p) )
+#define STORE( p, v ) _mm_storeu_si128( (__m128i *)(p), (v) )
+
+static mali_bool _mali_convert_sse2_supported( void )
+{
+	return MALI_TRUE;
+}
+
+/** Packs two vectors of 32 bit lanes holding 16 bit values into one. */
+MALI_STATIC_FORCE_INLINE __m128i _mali_convert_sse2_pack32( __m128i lo, __m128i hi )
+{
+	/* packs_epi32 saturates signed values; sign extending the low half first
+	 * makes it exact for all 16 bit patterns. */
+	lo = _mm_srai_epi32( _mm_slli_epi32( lo, 16 ), 16 );
+	hi = _mm_srai_epi32( _mm_slli_epi32( hi, 16 ), 16 );
+	return _mm_packs_epi32( lo, hi );
+}
+
+/** Interleaves 16 bit lanes of (r | g << 8) and (b | a << 8) into RGBA8888. */
+MALI_STATIC_FORCE_INLINE void _mali_convert_sse2_store_rgba( u8 *dst, __m128i rg, __m128i ba )
+{
+	STORE( dst, _mm_unpacklo_epi16( rg, ba ) );
+	STORE( dst + 16, _mm_unpackhi_epi16( rg, ba ) );
+}
+
+/** Eight L8A8 pixels in the low 16 bytes of la to RGBA8888. */
+MALI_STATIC_FORCE_INLINE void _mali_convert_sse2_store_la( u8 *dst, __m128i la )
+{
+	__m128i l = _mm_and_si128( la, _mm_set1_epi16( 0x00FF ) );
+	_mali_convert_sse2_store_rgba( dst, _mm_or_si128( l, _mm_slli_epi16( l, 8 ) ), la );
+}
+
+static int _mali_convert_sse2_from_8bit( u8 *dst, const u8 *src, int count, enum mali_convert_pixel_format format )
+{
+	const __m128i alpha = _mm_set1_epi8( (char)0xFF );
+	const __m128i zero = _mm_setzero_si128();
+	int i = 0;
+
+	switch ( format )
+	{
+		case MALI_CONVERT_PIXEL_FORMAT_R8G8B8A8:
+			memcpy( dst, src, (size_t)count * 4 );
+			return count;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L8:
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				__m128i l = LOAD( src + i );
+				__m128i ll_lo = _mm_unpacklo_epi8( l, l ), ll_hi = _mm_unpackhi_epi8( l, l );
+				__m128i la_lo = _mm_unpacklo_epi8( l, alpha ), la_hi = _mm_unpackhi_epi8( l, alpha );
+				_mali_convert_sse2_store_rgba( dst + i * 4, ll_lo, la_lo );
+				_mali_convert_sse2_store_rgba( dst + i * 4 + 32, ll_hi, la_hi );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_A8:
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				__m128i a = LOAD( src + i );
+				_mali_convert_sse2_store_rgba( dst + i * 4, zero, _mm_unpacklo_epi8( zero, a ) );
+				_mali_convert_sse2_store_rgba( dst + i * 4 + 32, zero, _mm_unpackhi_epi8( zero, a ) );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L8A8:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				_mali_convert_sse2_store_la( dst + i * 4, LOAD( src + i * 2 ) );
+			}
+			return i;
+
+		default:
+			return 0;
+	}
+}
+
+static int _mali_convert_sse2_from_16bit( u8 *dst, const u16 *src, int count, enum mali_convert_pixel_format format )
+{
+	const __m128i mask4 = _mm_set1_epi16( 0x0F ), mask5 = _mm_set1_epi16( 0x1F ), mask6 = _mm_set1_epi16( 0x3F );
+	const __m128i alpha = _mm_set1_epi16( (short)0xFF00 );
+	int i = 0;
+
+	switch ( format )
+	{
+		case MALI_CONVERT_PIXEL_FORMAT_R5G6B5:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				__m128i t = LOAD( src + i );
+				__m128i r = _mm_srli_epi16( t, 11 );
+				__m128i g = _mm_and_si128( _mm_srli_epi16( t, 5 ), mask6 );
+				__m128i b = _mm_and_si128( t, mask5 );
+				r = _mm_or_si128( _mm_slli_epi16( r, 3 ), _mm_srli_epi16( r, 2 ) );
+				g = _mm_or_si128( _mm_slli_epi16( g, 2 ), _mm_srli_epi16( g, 4 ) );
+				b = _mm_or_si128( _mm_slli_epi16( b, 3 ), _mm_srli_epi16( b, 2 ) );
+				_mali_convert_sse2_store_rgba( dst + i * 4, _mm_or_si128( r, _mm_slli_epi16( g, 8 ) ), _mm_or_si128( b, alpha ) );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_R4G4B4A4:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				__m128i t = LOAD( src + i );
+				__m128i r = _mm_srli_epi16( t, 12 );
+				__m128i g = _mm_and_si128( _mm_srli_epi16( t, 8 ), mask4 );
+				__m128i b = _mm_and_si128( _mm_srli_epi16( t, 4 ), mask4 );
+				__m128i a = _mm_and_si128( t, mask4 );
+				__m128i rg = _mm_or_si128( r, _mm_slli_epi16( g, 8 ) );
+				__m128i ba = _mm_or_si128( b, _mm_slli_epi16( a, 8 ) );
+				/* Both nibbles of every byte at once. */
+				_mali_convert_sse2_store_rgba( dst + i * 4, _mm_or_si128( rg, _mm_slli_epi16( rg, 4 ) ), _mm_or_si128( ba, _mm_slli_epi16( ba, 4 ) ) );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_R5G5B5A1:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				__m128i t = LOAD( src + i );
+				__m128i r = _mm_srli_epi16( t, 11 );
+				__m128i g = _mm_and_si128( _mm_srli_epi16( t, 6 ), mask5 );
+				__m128i b = _mm_and_si128( _mm_srli_epi16( t, 1 ), mask5 );
+				__m128i a = _mm_slli_epi16( t, 15 );
+				r = _mm_or_si128( _mm_slli_epi16( r, 3 ), _mm_srli_epi16( r, 2 ) );
+				g = _mm_or_si128( _mm_slli_epi16( g, 3 ), _mm_srli_epi16( g, 2 ) );
+				b = _mm_or_si128( _mm_slli_epi16( b, 3 ), _mm_srli_epi16( b, 2 ) );
+				a = _mm_and_si128( _mm_srai_epi16( a, 15 ), alpha );
+				_mali_convert_sse2_store_rgba( dst + i * 4, _mm_or_si128( r, _mm_slli_epi16( g, 8 ) ), _mm_or_si128( b, a ) );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L16A16:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				__m128i lo = _mm_srli_epi16( LOAD( src + i * 2 ), 8 );
+				__m128i hi = _mm_srli_epi16( LOAD( src + i * 2 + 8 ), 8 );
+				_mali_convert_sse2_store_la( dst + i * 4, _mm_packus_epi16( lo, hi ) );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_R16G16B16A16:
+			for ( ; i + 4 <= count; i += 4 )
+			{
+				__m128i lo = _mm_srli_epi16( LOAD( src + i * 4 ), 8 );
+				__m128i hi = _mm_srli_epi16( LOAD( src + i * 4 + 8 ), 8 );
+				STORE( dst + i * 4, _mm_packus_epi16( lo, hi ) );
+			}
+			return i;
+
+		default:
+			return 0;
+	}
+}
+
+static int _mali_convert_sse2_to_8bit( u8 *dst, const u8 *src, int count, enum mali_convert_pixel_format format )
+{
+	const __m128i byte = _mm_set1_epi32( 0xFF );
+	int i = 0;
+
+	switch ( format )
+	{
+		case MALI_CONVERT_PIXEL_FORMAT_R8G8B8A8:
+			memcpy( dst, src, (size_t)count * 4 );
+			return count;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L8:
+		case MALI_CONVERT_PIXEL_FORMAT_A8:
+			for ( ; i + 16 <= count; i += 16 )
+			{
+				__m128i v[4];
+				int k;
+				for ( k = 0; k < 4; k++ )
+				{
+					v[k] = LOAD( src + i * 4 + k * 16 );
+					v[k] = MALI_CONVERT_PIXEL_FORMAT_L8 == format ? _mm_and_si128( v[k], byte ) : _mm_srli_epi32( v[k], 24 );
+				}
+				STORE( dst + i, _mm_packus_epi16( _mm_packs_epi32( v[0], v[1] ), _mm_packs_epi32( v[2], v[3] ) ) );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L8A8:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				__m128i v0 = LOAD( src + i * 4 ), v1 = LOAD( src + i * 4 + 16 );
+				const __m128i high = _mm_set1_epi32( 0xFF00 );
+				v0 = _mm_or_si128( _mm_and_si128( v0, byte ), _mm_and_si128( _mm_srli_epi32( v0, 16 ), high ) );
+				v1 = _mm_or_si128( _mm_and_si128( v1, byte ), _mm_and_si128( _mm_srli_epi32( v1, 16 ), high ) );
+				STORE( dst + i * 2, _mali_convert_sse2_pack32( v0, v1 ) );
+			}
+			return i;
+
+		default:
+			return 0;
+	}
+}
+
+/* Each 32 bit lane is R | G << 8 | B << 16 | A << 24; the shifts move the
+ * top bits of every component straight to their place in the texel. */
+static int _mali_convert_sse2_to_16bit( u16 *dst, const u8 *src, int count, enum mali_convert_pixel_format format )
+{
+	int i = 0;
+
+	switch ( format )
+	{
+		case MALI_CONVERT_PIXEL_FORMAT_R5G6B5:
+		case MALI_CONVERT_PIXEL_FORMAT_R4G4B4A4:
+		case MALI_CONVERT_PIXEL_FORMAT_R5G5B5A1:
+			for ( ; i + 8 <= count; i += 8 )
+			{
+				__m128i v[2], t[2];
+				int k;
+				for ( k = 0; k < 2; k++ )
+				{
+					v[k] = LOAD( src + i * 4 + k * 16 );
+					if ( MALI_CONVERT_PIXEL_FORMAT_R5G6B5 == format )
+					{
+						t[k] = _mm_or_si128( _mm_and_si128( _mm_slli_epi32( v[k], 8 ), _mm_set1_epi32( 0xF800 ) ),
+						       _mm_or_si128( _mm_and_si128( _mm_srli_epi32( v[k], 5 ), _mm_set1_epi32( 0x07E0 ) ),
+						                     _mm_and_si128( _mm_srli_epi32( v[k], 19 ), _mm_set1_epi32( 0x001F ) ) ) );
+					}
+					else if ( MALI_CONVERT_PIXEL_FORMAT_R4G4B4A4 == format )
+					{
+						t[k] = _mm_or_si128( _mm_or_si128( _mm_and_si128( _mm_slli_epi32( v[k], 8 ), _mm_set1_epi32( 0xF000 ) ),
+						                                   _mm_and_si128( _mm_srli_epi32( v[k], 4 ), _mm_set1_epi32( 0x0F00 ) ) ),
+						                     _mm_or_si128( _mm_and_si128( _mm_srli_epi32( v[k], 16 ), _mm_set1_epi32( 0x00F0 ) ),
+						                                   _mm_srli_epi32( v[k], 28 ) ) );
+					}
+					else
+					{
+						t[k] = _mm_or_si128( _mm_or_si128( _mm_and_si128( _mm_slli_epi32( v[k], 8 ), _mm_set1_epi32( 0xF800 ) ),
+						                                   _mm_and_si128( _mm_srli_epi32( v[k], 5 ), _mm_set1_epi32( 0x07C0 ) ) ),
+						                     _mm_or_si128( _mm_and_si128( _mm_srli_epi32( v[k], 18 ), _mm_set1_epi32( 0x003E ) ),
+						                                   _mm_srli_epi32( v[k], 31 ) ) );
+					}
+				}
+				STORE( dst + i, _mali_convert_sse2_pack32( t[0], t[1] ) );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_L16A16:
+			for ( ; i + 4 <= count; i += 4 )
+			{
+				__m128i v = LOAD( src + i * 4 );
+				__m128i la = _mm_or_si128( _mm_and_si128( v, _mm_set1_epi32( 0xFF ) ),
+				                           _mm_and_si128( _mm_srli_epi32( v, 8 ), _mm_set1_epi32( 0xFF0000 ) ) );
+				STORE( dst + i * 2, _mm_or_si128( la, _mm_slli_epi16( la, 8 ) ) );
+			}
+			return i;
+
+		case MALI_CONVERT_PIXEL_FORMAT_R16G16B16A16:
+			for ( ; i + 4 <= count; i += 4 )
+			{
+				__m128i v = LOAD( src + i * 4 );
+				STORE( dst + i * 4, _mm_unpacklo_epi8( v, v ) );
+				STORE( dst + i * 4 + 8, _mm_unpackhi_epi8( v, v ) );
+			}
+			return i;
+
+		default:
+			return 0;
+	}
+}
+
+const mali_convert_kernels _mali_convert_kernels_sse2 =
+{
+	"sse2",
+	_mali_convert_sse2_supported,
+	_mali_convert_sse2_from_8bit,
+	_mali_convert_sse2_from_16bit,
+	_mali_convert_sse2_to_8bit,
+	_mali_convert_sse2_to_16bit
+};
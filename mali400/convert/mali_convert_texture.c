@@ -0,0 +1,253 @@
+/*
+ * Host implementation of the generic texture conversion in
+ * shared/mali_convert.h: request setup, conversion rules and a span by
+ * span _mali_convert_texture over linear and 16x16 blocked surfaces,
+ * plus the lookup tables the inline helpers refer to.
+ *
+ * Only formats whose texels fill whole bytes are handled; texels are
+ * stored little endian, so RGB_888 keeps blue in the first byte.
+ */
+
+#include <string.h>
+
+#include "mali_convert_parallel.h"
+
+/* sRGB transfer function and its inverse, rounded to nearest */
+const u8 mali_convert_linear_to_nonlinear_lut[256] =
+{
+	  0,  13,  22,  28,  34,  38,  42,  46,  50,  53,  56,  59,  61,  64,  66,  69,
+	 71,  73,  75,  77,  79,  81,  83,  85,  86,  88,  90,  92,  93,  95,  96,  98,
+	 99, 101, 102, 104, 105, 106, 108, 109, 110, 112, 113, 114, 115, 117, 118, 119,
+	120, 121, 122, 124, 125, 126, 127, 128, 129, 130, 131, 132, 133, 134, 135, 136,
+	137, 138, 139, 140, 141, 142, 143, 144, 145, 146, 147, 148, 148, 149, 150, 151,
+	152, 153, 154, 155, 155, 156, 157, 158, 159, 159, 160, 161, 162, 163, 163, 164,
+	165, 166, 167, 167, 168, 169, 170, 170, 171, 172, 173, 173, 174, 175, 175, 176,
+	177, 178, 178, 179, 180, 180, 181, 182, 182, 183, 184, 185, 185, 186, 187, 187,
+	188, 189, 189, 190, 190, 191, 192, 192, 193, 194, 194, 195, 196, 196, 197, 197,
+	198, 199, 199, 200, 200, 201, 202, 202, 203, 203, 204, 205, 205, 206, 206, 207,
+	208, 208, 209, 209, 210, 210, 211, 212, 212, 213, 213, 214, 214, 215, 215, 216,
+	216, 217, 218, 218, 219, 219, 220, 220, 221, 221, 222, 222, 223, 223, 224, 224,
+	225, 226, 226, 227, 227, 228, 228, 229, 229, 230, 230, 231, 231, 232, 232, 233,
+	233, 234, 234, 235, 235, 236, 236, 237, 237, 238, 238, 238, 239, 239, 240, 240,
+	241, 241, 242, 242, 243, 243, 244, 244, 245, 245, 246, 246, 246, 247, 247, 248,
+	248, 249, 249, 250, 250, 251, 251, 251, 252, 252, 253, 253, 254, 254, 255, 255
+};
+
+const u8 mali_convert_nonlinear_to_linear_lut[256] =
+{
+	  0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+	  1,   1,   2,   2,   2,   2,   2,   2,   2,   2,   3,   3,   3,   3,   3,   3,
+	  4,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,   6,   7,   7,   7,
+	  8,   8,   8,   8,   9,   9,   9,  10,  10,  10,  11,  11,  12,  12,  12,  13,
+	 13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  17,  18,  18,  19,  19,  20,
+	 20,  21,  22,  22,  23,  23,  24,  24,  25,  25,  26,  27,  27,  28,  29,  29,
+	 30,  30,  31,  32,  32,  33,  34,  35,  35,  36,  37,  37,  38,  39,  40,  41,
+	 41,  42,  43,  44,  45,  45,  46,  47,  48,  49,  50,  51,  51,  52,  53,  54,
+	 55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,
+	 71,  72,  73,  74,  76,  77,  78,  79,  80,  81,  82,  84,  85,  86,  87,  88,
+	 90,  91,  92,  93,  95,  96,  97,  99, 100, 101, 103, 104, 105, 107, 108, 109,
+	111, 112, 114, 115, 116, 118, 119, 121, 122, 124, 125, 127, 128, 130, 131, 133,
+	134, 136, 138, 139, 141, 142, 144, 146, 147, 149, 151, 152, 154, 156, 157, 159,
+	161, 163, 164, 166, 168, 170, 171, 173, 175, 177, 179, 181, 183, 184, 186, 188,
+	190, 192, 194, 196, 198, 200, 202, 204, 206, 208, 210, 212, 214, 216, 218, 220,
+	222, 224, 226, 229, 231, 233, 235, 237, 239, 242, 244, 246, 248, 250, 253, 255
+};
+
+/*
+ * Offset of texel (x, y) in its 16x16 block, indexed by y * 16 + x. Each 2x2
+ * level is visited 0 1 / 3 2, giving a Z order with x flipped on odd rows.
+ */
+const u8 mali_convert_block_interleave_lut[16 * 16] =
+{
+	  0,   1,   4,   5,  16,  17,  20,  21,  64,  65,  68,  69,  80,  81,  84,  85,
+	  3,   2,   7,   6,  19,  18,  23,  22,  67,  66,  71,  70,  83,  82,  87,  86,
+	 12,  13,   8,   9,  28,  29,  24,  25,  76,  77,  72,  73,  92,  93,  88,  89,
+	 15,  14,  11,  10,  31,  30,  27,  26,  79,  78,  75,  74,  95,  94,  91,  90,
+	 48,  49,  52,  53,  32,  33,  36,  37, 112, 113, 116, 117,  96,  97, 100, 101,
+	 51,  50,  55,  54,  35,  34,  39,  38, 115, 114, 119, 118,  99,  98, 103, 102,
+	 60,  61,  56,  57,  44,  45,  40,  41, 124, 125, 120, 121, 108, 109, 104, 105,
+	 63,  62,  59,  58,  47,  46,  43,  42, 127, 126, 123, 122, 111, 110, 107, 106,
+	192, 193, 196, 197, 208, 209, 212, 213, 128, 129, 132, 133, 144, 145, 148, 149,
+	195, 194, 199, 198, 211, 210, 215, 214, 131, 130, 135, 134, 147, 146, 151, 150,
+	204, 205, 200, 201, 220, 221, 216, 217, 140, 141, 136, 137, 156, 157, 152, 153,
+	207, 206, 203, 202, 223, 222, 219, 218, 143, 142, 139, 138, 159, 158, 155, 154,
+	240, 241, 244, 245, 224, 225, 228, 229, 176, 177, 180, 181, 160, 161, 164, 165,
+	243, 242, 247, 246, 227, 226, 231, 230, 179, 178, 183, 182, 163, 162, 167, 166,
+	252, 253, 248, 249, 236, 237, 232, 233, 188, 189, 184, 185, 172, 173, 168, 169,
+	255, 254, 251, 250, 239, 238, 235, 234, 191, 190, 187, 186, 175, 174, 171, 170
+};
+
+void _mali_convert_request_initialize( mali_convert_request *convert_request,
+                                       void *dst_ptr, s32 dst_pitch, const mali_surface_specifier *dst_format,
+                                       const void *src_ptr, s32 src_pitch, const mali_surface_specifier *src_format,
+                                       void *dst_nonpre_ptr, s32 dst_nonpre_pitch,
+                                       const mali_convert_rectangle *rect,
+                                       mali_bool src_is_malimem, mali_bool dst_is_malimem,
+                                       mali_bool alpha_clamp, mali_convert_request_source source )
+{
+	MALI_DEBUG_ASSERT_POINTER( convert_request );
+	MALI_DEBUG_ASSERT_POINTER( dst_format );
+	MALI_DEBUG_ASSERT_POINTER( src_format );
+	MALI_DEBUG_ASSERT_POINTER( rect );
+
+	convert_request->dst_ptr = dst_ptr;
+	convert_request->dst_pitch = dst_pitch;
+	convert_request->dst_format = *dst_format;
+	convert_request->src_ptr = src_ptr;
+	convert_request->src_pitch = src_pitch;
+	convert_request->src_format = *src_format;
+	convert_request->dst_nonpre_ptr = dst_nonpre_ptr;
+	convert_request->dst_nonpre_pitch = dst_nonpre_pitch;
+	convert_request->rect = *rect;
+	convert_request->src_is_malimem = src_is_malimem;
+	convert_request->dst_is_malimem = dst_is_malimem;
+	convert_request->alpha_clamp = alpha_clamp;
+	convert_request->source = source;
+}
+
+MALI_STATIC_INLINE mali_bool _mali_convert_texel_format_is_luminance( m200_texel_format format )
+{
+	switch ( format )
+	{
+		case M200_TEXEL_FORMAT_L_1:
+		case M200_TEXEL_FORMAT_AL_11:
+		case M200_TEXEL_FORMAT_L_4:
+		case M200_TEXEL_FORMAT_AL_44:
+		case M200_TEXEL_FORMAT_L_8:
+		case M200_TEXEL_FORMAT_AL_88:
+			return MALI_TRUE;
+		default:
+			return MALI_FALSE;
+	}
+}
+
+u32 _mali_convert_setup_conversion_rules( const mali_surface_specifier *src, const mali_surface_specifier *dest )
+{
+	u32 rules = 0;
+
+	MALI_DEBUG_ASSERT_POINTER( src );
+	MALI_DEBUG_ASSERT_POINTER( dest );
+
+	if ( MALI_SURFACE_COLORSPACE_lRGB == src->colorspace ) rules |= MALI_CONVERT_SRC_LINEAR;
+	if ( MALI_SURFACE_COLORSPACE_lRGB == dest->colorspace ) rules |= MALI_CONVERT_DST_LINEAR;
+	if ( src->premultiplied_alpha ) rules |= MALI_CONVERT_SRC_PREMULT;
+	if ( dest->premultiplied_alpha ) rules |= MALI_CONVERT_DST_PREMULT;
+	if ( _mali_convert_texel_format_is_luminance( src->texel_format ) ) rules |= MALI_CONVERT_SRC_LUMINANCE;
+	if ( _mali_convert_texel_format_is_luminance( dest->texel_format ) ) rules |= MALI_CONVERT_DST_LUMINANCE;
+
+	return rules;
+}
+
+MALI_STATIC_INLINE mali_bool _mali_convert_layout_supported( m200_texture_addressing_mode layout )
+{
+	return M200_TEXTURE_ADDRESSING_MODE_LINEAR == layout || M200_TEXTURE_ADDRESSING_MODE_16X16_BLOCKED == layout;
+}
+
+mali_bool _mali_convert_texture_supported( const mali_convert_request *convert_request )
+{
+	MALI_DEBUG_ASSERT_POINTER( convert_request );
+
+	return 0 != _mali_convert_texel_format_get_size( convert_request->src_format.texel_format ) &&
+	       0 != _mali_convert_texel_format_get_size( convert_request->dst_format.texel_format ) &&
+	       _mali_convert_layout_supported( convert_request->src_format.texel_layout ) &&
+	       _mali_convert_layout_supported( convert_request->dst_format.texel_layout ) &&
+	       ( NULL == convert_request->dst_nonpre_ptr ||
+	         M200_TEXTURE_ADDRESSING_MODE_LINEAR == convert_request->dst_format.texel_layout );
+}
+
+/** Address of texel (x, y) of a linear or 16x16 blocked surface */
+MALI_STATIC_FORCE_INLINE u8 *_mali_convert_texel_address( u8 *base, s32 pitch, const mali_surface_specifier *format,
+                                                          int size, u32 x, u32 y )
+{
+	if ( M200_TEXTURE_ADDRESSING_MODE_16X16_BLOCKED == format->texel_layout )
+	{
+		return base + MALI_CONVERT_BLOCKED_ADDRESS( x, y, MALI_ALIGN( format->width, 16 ) ) * size;
+	}
+	return base + (s32)y * pitch + x * size;
+}
+
+/* texels converted at a time when either surface is blocked */
+#define MALI_CONVERT_CHUNK 64
+
+void _mali_convert_texture_rows( const mali_convert_request *convert_request, u32 first_row, u32 row_count )
+{
+	const mali_convert_rectangle *rect = &convert_request->rect;
+	const mali_surface_specifier *src_format = &convert_request->src_format;
+	const mali_surface_specifier *dst_format = &convert_request->dst_format;
+	int src_size = _mali_convert_texel_format_get_size( src_format->texel_format );
+	int dst_size = _mali_convert_texel_format_get_size( dst_format->texel_format );
+	mali_bool src_blocked = M200_TEXTURE_ADDRESSING_MODE_16X16_BLOCKED == src_format->texel_layout;
+	mali_bool dst_blocked = M200_TEXTURE_ADDRESSING_MODE_16X16_BLOCKED == dst_format->texel_layout;
+	u32 chunk = src_blocked || dst_blocked ? MALI_CONVERT_CHUNK : rect->width;
+	u32 rules = _mali_convert_get_span_rules( src_format, dst_format, convert_request->source );
+	u32 nonpre_rules = rules & ~MALI_CONVERT_DST_PREMULT;
+	mali_convert_span_proc proc = _mali_convert_get_span_proc( src_format, dst_format, rules );
+	mali_convert_span_proc nonpre_proc = NULL;
+	u8 src_chunk[MALI_CONVERT_CHUNK * 4];
+	u8 dst_chunk[MALI_CONVERT_CHUNK * 4];
+	u32 x, y, i;
+
+	if ( NULL != convert_request->dst_nonpre_ptr )
+	{
+		nonpre_proc = _mali_convert_get_span_proc( src_format, dst_format, nonpre_rules );
+	}
+
+	for ( y = first_row; y < first_row + row_count; y++ )
+	{
+		for ( x = 0; x < rect->width; x += chunk )
+		{
+			u32 count = rect->width - x < chunk ? rect->width - x : chunk;
+			const u8 *src = src_chunk;
+			u8 *dst = dst_chunk;
+
+			/* blocked texels are gathered into and scattered from linear chunks */
+			if ( src_blocked )
+			{
+				for ( i = 0; i < count; i++ )
+				{
+					memcpy( src_chunk + i * src_size,
+					        _mali_convert_texel_address( (u8 *)convert_request->src_ptr, 0, src_format, src_size,
+					                                     rect->sx + x + i, rect->sy + y ),
+					        src_size );
+				}
+			}
+			else
+			{
+				src = _mali_convert_texel_address( (u8 *)convert_request->src_ptr, convert_request->src_pitch,
+				                                   src_format, src_size, rect->sx + x, rect->sy + y );
+			}
+			if ( !dst_blocked )
+			{
+				dst = _mali_convert_texel_address( convert_request->dst_ptr, convert_request->dst_pitch,
+				                                   dst_format, dst_size, rect->dx + x, rect->dy + y );
+			}
+
+			proc( dst, src, count, src_format, dst_format, rules );
+
+			if ( dst_blocked )
+			{
+				for ( i = 0; i < count; i++ )
+				{
+					memcpy( _mali_convert_texel_address( convert_request->dst_ptr, 0, dst_format, dst_size,
+					                                     rect->dx + x + i, rect->dy + y ),
+					        dst_chunk + i * dst_size, dst_size );
+				}
+			}
+			if ( NULL != nonpre_proc )
+			{
+				u8 *nonpre = (u8 *)convert_request->dst_nonpre_ptr +
+				             (s32)( rect->dy + y ) * convert_request->dst_nonpre_pitch + ( rect->dx + x ) * dst_size;
+				nonpre_proc( nonpre, src, count, src_format, dst_format, nonpre_rules );
+			}
+		}
+	}
+}
+
+mali_bool _mali_convert_texture( mali_convert_request *convert_request )
+{
+	MALI_DEBUG_ASSERT_POINTER( convert_request );
+
+	if ( !_mali_convert_texture_supported( convert_request ) ) return MALI_FALSE;
+	_mali_convert_texture_rows( convert_request, 0, convert_request->rect.height );
+	return MALI_TRUE;
+}
@@ -0,0 +1,143 @@
+/*
+ * pthread implementation of base/mali_worker.h for host builds, where the
+ * driver's own worker threads are not available. One thread per worker,
+ * running its tasks in the order they were added.
+ */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#include <base/mali_worker.h>
+
+typedef struct mali_worker_task
+{
+	mali_base_worker_task_proc proc;
+	void *param;
+	struct mali_worker_task *next;
+} mali_worker_task;
+
+typedef struct mali_worker
+{
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	mali_worker_task *head;
+	mali_worker_task *tail;
+	mali_bool quit;
+	mali_bool joined;
+} mali_worker;
+
+static void *_mali_worker_main( void *param )
+{
+	mali_worker *worker = param;
+
+	pthread_mutex_lock( &worker->lock );
+	for ( ;; )
+	{
+		mali_worker_task *task;
+
+		while ( NULL == worker->head && !worker->quit ) pthread_cond_wait( &worker->wake, &worker->lock );
+		task = worker->head;
+		if ( NULL == task ) break;
+		worker->head = task->next;
+		if ( NULL == worker->head ) worker->tail = NULL;
+
+		pthread_mutex_unlock( &worker->lock );
+		task->proc( task->param );
+		free( task );
+		pthread_mutex_lock( &worker->lock );
+	}
+	pthread_mutex_unlock( &worker->lock );
+	return NULL;
+}
+
+mali_base_worker_handle _mali_base_worker_create( mali_bool idle_policy )
+{
+	mali_worker *worker = calloc( 1, sizeof( *worker ) );
+	pthread_attr_t attr;
+
+	if ( NULL == worker ) return MALI_BASE_WORKER_NO_HANDLE;
+	pthread_mutex_init( &worker->lock, NULL );
+	pthread_cond_init( &worker->wake, NULL );
+
+	pthread_attr_init( &attr );
+#ifdef SCHED_IDLE
+	if ( idle_policy )
+	{
+		struct sched_param param = { 0 };
+		pthread_attr_setinheritsched( &attr, PTHREAD_EXPLICIT_SCHED );
+		pthread_attr_setschedpolicy( &attr, SCHED_IDLE );
+		pthread_attr_setschedparam( &attr, &param );
+	}
+#endif
+	if ( 0 != pthread_create( &worker->thread, &attr, _mali_worker_main, worker ) )
+	{
+		pthread_attr_destroy( &attr );
+		pthread_cond_destroy( &worker->wake );
+		pthread_mutex_destroy( &worker->lock );
+		free( worker );
+		return MALI_BASE_WORKER_NO_HANDLE;
+	}
+	pthread_attr_destroy( &attr );
+	return worker;
+}
+
+mali_err_code _mali_base_worker_task_add( mali_base_worker_handle handle, mali_base_worker_task_proc task_proc, void *task_param )
+{
+	mali_worker *worker = handle;
+	mali_worker_task *task;
+
+	MALI_DEBUG_ASSERT_POINTER( worker );
+
+	task = malloc( sizeof( *task ) );
+	if ( NULL == task ) return MALI_ERR_OUT_OF_MEMORY;
+	task->proc = task_proc;
+	task->param = task_param;
+	task->next = NULL;
+
+	pthread_mutex_lock( &worker->lock );
+	if ( worker->quit )
+	{
+		pthread_mutex_unlock( &worker->lock );
+		free( task );
+		return MALI_ERR_FUNCTION_FAILED;
+	}
+	if ( NULL != worker->tail ) worker->tail->next = task;
+	else worker->head = task;
+	worker->tail = task;
+	pthread_cond_signal( &worker->wake );
+	pthread_mutex_unlock( &worker->lock );
+	return MALI_ERR_NO_ERROR;
+}
+
+void _mali_base_worker_quit( mali_base_worker_handle handle )
+{
+	mali_worker *worker = handle;
+
+	MALI_DEBUG_ASSERT_POINTER( worker );
+
+	pthread_mutex_lock( &worker->lock );
+	worker->quit = MALI_TRUE;
+	pthread_cond_signal( &worker->wake );
+	pthread_mutex_unlock( &worker->lock );
+
+	if ( !worker->joined )
+	{
+		pthread_join( worker->thread, NULL );
+		worker->joined = MALI_TRUE;
+	}
+}
+
+void _mali_base_worker_destroy( mali_base_worker_handle handle )
+{
+	mali_worker *worker = handle;
+
+	if ( NULL == worker ) return;
+	_mali_base_worker_quit( worker );
+	pthread_cond_destroy( &worker->wake );
+	pthread_mutex_destroy( &worker->lock );
+	free( worker );
+}
@@ -0,0 +1,148 @@
+// ---------------------------------------------------------------------------
+// FrameCapture.cpp
+// PBO ring readback, see FrameCapture.h.
+// ---------------------------------------------------------------------------
+#include "FrameCapture.h"
+
+#include <time.h>
+
+static double NowMs() {
+	timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+FrameCapture::FrameCapture()
+	: width( 0 ), height( 0 ), fbo( 0 ), colorBuffer( 0 ), head( 0 ), inFlight( 0 ),
+	  consumer( NULL ), user( NULL ), frames( 0 ), captured( 0 ), started( 0 ), finished( 0 ),
+	  latencyMs( 0 ), stallMs( 0 ), latencyFrames( 0 ) {
+}
+
+FrameCapture::~FrameCapture() {
+	for ( size_t i = 0; i < ring.size(); i++ ) {
+		if ( ring[ i ].fence )
+			glDeleteSync( ring[ i ].fence );
+		glDeleteBuffers( 1, &ring[ i ].pbo );
+	}
+	glDeleteRenderbuffers( 1, &colorBuffer );
+	glDeleteFramebuffers( 1, &fbo );
+}
+
+bool FrameCapture::Init( GLsizei width, GLsizei height, int ringSize, CaptureConsumer consumer, void *user ) {
+	this->width = width;
+	this->height = height;
+	this->consumer = consumer;
+	this->user = user;
+
+	// color target the scene renders into
+	glGenRenderbuffers( 1, &colorBuffer );
+	glBindRenderbuffer( GL_RENDERBUFFER, colorBuffer );
+	glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, width, height );
+	glGenFramebuffers( 1, &fbo );
+	glBindFramebuffer( GL_FRAMEBUFFER, fbo );
+	glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer );
+	bool complete = glCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+	if ( !complete ) {
+		cerr << "capture framebuffer incomplete" << endl;
+		return false;
+	}
+
+	// one frame per pixel buffer, read back by the CPU
+	ring.resize( ringSize < 3 ? 3 : ringSize );
+	for ( size_t i = 0; i < ring.size(); i++ ) {
+		glGenBuffers( 1, &ring[ i ].pbo );
+		glBindBuffer( GL_PIXEL_PACK_BUFFER, ring[ i ].pbo );
+		glBufferData( GL_PIXEL_PACK_BUFFER, width * height * 4, NULL, GL_STREAM_READ );
+		ring[ i ].fence = 0;
+	}
+	glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+	glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+	return true;
+}
+
+void FrameCapture::BeginFrame() {
+	glBindFramebuffer( GL_FRAMEBUFFER, fbo );
+	glViewport( 0, 0, width, height );
+}
+
+void FrameCapture::EndFrame() {
+	if ( frames == 0 )
+		started = NowMs();
+
+	// every buffer in flight: the oldest has to be waited for
+	if ( inFlight == (int) ring.size() )
+		Consume( ring[ head ], true );
+
+	// with a pack buffer bound glReadPixels only queues the copy
+	Slot &slot = ring[ head ];
+	glBindFramebuffer( GL_READ_FRAMEBUFFER, fbo );
+	glBindBuffer( GL_PIXEL_PACK_BUFFER, slot.pbo );
+	glReadPixels( 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0 );
+	glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+	slot.fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	slot.frame = frames++;
+	slot.issued = NowMs();
+	head = ( head + 1 ) % ring.size();
+	inFlight++;
+
+	// show the frame in the window as well
+	glBindFramebuffer( GL_DRAW_FRAMEBUFFER, 0 );
+	glBlitFramebuffer( 0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+	glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+
+	// hand over whatever has finished, oldest first, without blocking
+	while ( inFlight > 0 ) {
+		Slot &oldest = ring[ ( head + ring.size() - inFlight ) % ring.size() ];
+		if ( oldest.frame == slot.frame )
+			break;
+		GLenum status = glClientWaitSync( oldest.fence, 0, 0 );
+		if ( status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED )
+			break;
+		Consume( oldest, false );
+	}
+}
+
+void FrameCapture::Flush() {
+	while ( inFlight > 0 )
+		Consume( ring[ ( head + ring.size() - inFlight ) % ring.size() ], true );
+}
+
+// the slot must be the oldest one in flight
+void FrameCapture::Consume( Slot &slot, bool wait ) {
+	if ( wait ) {
+		double waitStart = NowMs();
+		while ( glClientWaitSync( slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000 ) == GL_TIMEOUT_EXPIRED )
+			;
+		stallMs += NowMs() - waitStart;
+	}
+	glDeleteSync( slot.fence );
+	slot.fence = 0;
+
+	glBindBuffer( GL_PIXEL_PACK_BUFFER, slot.pbo );
+	const void *pixels = glMapBufferRange( GL_PIXEL_PACK_BUFFER, 0, width * height * 4, GL_MAP_READ_BIT );
+	if ( pixels ) {
+		consumer( pixels, width, height, slot.frame, user );
+		glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+	}
+	glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+	inFlight--;
+
+	// a frame that could not be mapped was dropped, not captured
+	if ( !pixels )
+		return;
+	finished = NowMs();
+	latencyMs += finished - slot.issued;
+	latencyFrames += frames - 1 - slot.frame;
+	captured++;
+}
+
+void FrameCapture::Report( ostream &out ) const {
+	double seconds = ( finished - started ) / 1000.0;
+	double mb = captured * (double) width * height * 4 / ( 1024.0 * 1024.0 );
+	out << "capture: " << captured << " frames " << width << "x" << height
+	    << ", " << ( seconds > 0 ? mb / seconds : 0 ) << " MB/s"
+	    << ", latency " << ( captured ? latencyMs / captured : 0 ) << " ms / "
+	    << ( captured ? (double) latencyFrames / captured : 0 ) << " frames"
+	    << ", stalled " << stallMs << " ms" << endl;
+}
@@ -0,0 +1,58 @@
+#pragma once
+// ---------------------------------------------------------------------------
+// FrameCapture.h
+// Asynchronous readback of rendered frames. The scene is drawn into an FBO;
+// at the end of each frame glReadPixels goes into the next pixel buffer
+// object of a ring and a fence is inserted behind it. Buffers whose fence
+// has signalled are mapped and handed to the consumer as they are, so the
+// CPU never waits for the GPU unless the whole ring is still in flight.
+// ---------------------------------------------------------------------------
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+// pixels is only valid during the call: RGBA, bottom row first.
+typedef void (*CaptureConsumer)( const void *pixels, GLsizei width, GLsizei height,
+                                 unsigned long frame, void *user );
+
+class FrameCapture {
+public:
+	FrameCapture();
+	~FrameCapture();
+
+	// ringSize is clamped to at least 3
+	bool Init( GLsizei width, GLsizei height, int ringSize, CaptureConsumer consumer, void *user );
+	// redirects rendering into the capture FBO
+	void BeginFrame();
+	// starts the readback, shows the frame in the window and consumes every
+	// finished readback; call before swapping buffers
+	void EndFrame();
+	// waits for and consumes everything still in flight
+	void Flush();
+	void Report( ostream &out ) const;
+
+private:
+	struct Slot {
+		GLuint pbo;
+		GLsync fence;
+		unsigned long frame;
+		double issued;
+	};
+	void Consume( Slot &slot, bool wait );
+
+	GLsizei width, height;
+	GLuint fbo, colorBuffer;
+	vector<Slot> ring;
+	int head;		// next slot to read into
+	int inFlight;		// slots waiting to be consumed, oldest at head - inFlight
+	CaptureConsumer consumer;
+	void *user;
+
+	unsigned long frames, captured;
+	double started, finished;
+	double latencyMs, stallMs;
+	unsigned long latencyFrames;
+};
@@ -1,21 +1,61 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
+#include <cstdio>
+#include <cstring>
+#include <set>
 #include <vector>
 #include <iostream>
 
+#include "FrameCapture.h"
+
 struct Program
 {
     static GLuint Load(const char* vert, const char* geom, const char* frag) {
+        GLuint prog = Submit(vert, geom, frag);
+        Use(prog);
+        return prog;
+    }
+
+    // Compiles and links without querying any status, so the driver can work
+    // on several programs at once; errors are reported by the first Use().
+    static GLuint Submit(const char* vert, const char* geom, const char* frag) {
+        static bool threadsSet = false;
+        if (!threadsSet && GLEW_KHR_parallel_shader_compile)
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        threadsSet = true;
         GLuint prog = glCreateProgram();
         if (vert) AttachShader(prog, GL_VERTEX_SHADER, vert);
         if (geom) AttachShader(prog, GL_GEOMETRY_SHADER, geom);
         if (frag) AttachShader(prog, GL_FRAGMENT_SHADER, frag);
         glLinkProgram(prog);
-        CheckStatus(prog);
+        Pending().insert(prog);
         return prog;
     }
 
+    static bool Ready(GLuint prog) {
+        if (!Pending().count(prog) || !GLEW_KHR_parallel_shader_compile) return true;
+        GLint done = GL_TRUE;
+        glGetProgramiv(prog, GL_COMPLETION_STATUS_KHR, &done);
+        return done == GL_TRUE;
+    }
+
+    static void Use(GLuint prog) {
+        if (Pending().erase(prog)) {
+            GLuint shaders[3];
+            GLsizei count = 0;
+            glGetAttachedShaders(prog, 3, &count, shaders);
+            for (GLsizei i = 0; i < count; i++) CheckStatus(shaders[i]);
+            CheckStatus(prog);
+        }
+        glUseProgram(prog);
+    }
+
 private:
+    static std::set<GLuint>& Pending() {
+        static std::set<GLuint> pending;
+        return pending;
+    }
+
     static void CheckStatus(GLuint obj) {
         GLint status = GL_FALSE, len = 10;
         if (glIsShader(obj))   glGetShaderiv(obj, GL_COMPILE_STATUS, &status);
@@ -34,7 +74,6 @@ private:
         GLuint shader = glCreateShader(type);
         glShaderSource(shader, 1, &src, NULL);
         glCompileShader(shader);
-        CheckStatus(shader);
         glAttachShader(program, shader);
         glDeleteShader(shader);
     }
@@ -71,6 +110,29 @@ GLuint Buffers[NumBuffers];
 
 const GLuint NumVertices = 6;
 
+// --capture FILE writes raw RGBA frames ("-" for stdout), --frames N stops
+// after N frames
+FrameCapture capture;
+FILE* captureFile = NULL;
+unsigned long captureFrames = 0;
+unsigned long frameCount = 0;
+
+void WriteFrame(const void* pixels, GLsizei width, GLsizei height, unsigned long, void* user)
+{
+    fwrite(pixels, 4, width * height, (FILE*) user);
+}
+
+// drains the readback ring and reports; needs the context, so it runs from
+// display() or the close callback, never after glutMainLoop has returned
+void FinishCapture()
+{
+    if (!captureFile) return;
+    capture.Flush();
+    capture.Report(std::cerr);
+    if (captureFile != stdout) fclose(captureFile);
+    captureFile = NULL;
+}
+
 void init(void)
 {
     glGenVertexArrays(NumVAOs, VAOs);
@@ -89,8 +151,8 @@ void init(void)
     glBindBuffer(GL_ARRAY_BUFFER, Buffers[ArrayBuffer]);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-    GLuint program = Program::Load( vert, NULL, frag );
-    glUseProgram(program);
+    GLuint program = Program::Submit( vert, NULL, frag );
+    Program::Use(program);
 
     glVertexAttribPointer(vPosition, 2, GL_FLOAT, GL_FALSE, 0, (void*)(0) );
     glEnableVertexAttribArray(vPosition);
@@ -98,17 +160,40 @@ void init(void)
 
 void display(void)
 {
+    if (captureFile) capture.BeginFrame();
+
     glClear(GL_COLOR_BUFFER_BIT);
 
     glBindVertexArray(VAOs[Triangles]);
     glDrawArrays(GL_TRIANGLES, 0, NumVertices);
 
+    if (captureFile) capture.EndFrame();
     glutSwapBuffers();
+
+    if (captureFrames && ++frameCount >= captureFrames)
+    {
+        FinishCapture();
+        glutLeaveMainLoop();
+    }
 }
 
 int main(int argc, char** argv)
 {
      glutInit(&argc, argv);
+     for (int i = 1; i < argc - 1; i++)
+     {
+         if (!strcmp(argv[i], "--capture"))
+         {
+             captureFile = strcmp(argv[++i], "-") ? fopen(argv[i], "wb") : stdout;
+             if (!captureFile)
+             {
+                 perror(argv[i]);
+                 exit(EXIT_FAILURE);
+             }
+         }
+         else if (!strcmp(argv[i], "--frames"))
+             captureFrames = strtoul(argv[++i], NULL, 10);
+     }
      glutInitDisplayMode( GLUT_RGBA | GLUT_DOUBLE );
      glutInitWindowSize(512, 512);
      glutInitContextVersion(4, 3);
@@ -121,7 +206,13 @@ int main(int argc, char** argv)
 
      init();
 
+     if (captureFile && !capture.Init(512, 512, 3, WriteFrame, captureFile))
+         exit(EXIT_FAILURE);
+
+     glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
      glutDisplayFunc(display);
+     glutCloseFunc(FinishCapture);
+     if (captureFile || captureFrames) glutIdleFunc(glutPostRedisplay);
      glutMainLoop();
 }
 